@@ -0,0 +1,38 @@
+#pragma once
+
+#include "runtime.h"
+#include "runtime_defines.h"
+// Rigid block: __cpp, main.mrk:3
+    #include <iostream>
+MRK_NS_BEGIN_MODULE(runtime::generated)
+
+// Forward declarations
+struct __global____globalType_c413d31d;
+struct __global__mrk__web__HttpMethod_f4b483cb;
+struct __global__mrk__web__Http_cce7eba6;
+// Type: __global::__globalType, Token: 17
+struct __global____globalType_c413d31d {
+    // Function: __global::__globalType::testNative, Token: 1
+static __mrkprimitive_void testNative_437cccfc()    ;
+    // Function: __global::__globalType::main, Token: 2
+static __mrkprimitive_void main_7906604e()    ;
+    // Function: __global::__globalType::print, Token: 3
+static __mrkprimitive_void print_94b0981d(__mrkprimitive_string msg_48da70aa)    ;
+    // Function: __global::__globalType::readNumber, Token: 4
+static __mrkprimitive_int readNumber_cbe4455d()    ;
+    // Function: __global::__globalType::__globalFunction, Token: 5
+static __mrkprimitive_void __globalFunction_769c3b66()    ;
+};
+// Type: __global::mrk::web::HttpMethod, Token: 18
+struct __global__mrk__web__HttpMethod_f4b483cb {
+    // Variable: POST, Token: 1
+static     __mrkprimitive_int POST_656426ed;
+    // Variable: GET, Token: 2
+static     __mrkprimitive_int GET_bfbe9a35;
+};
+// Type: __global::mrk::web::Http, Token: 19
+struct __global__mrk__web__Http_cce7eba6 {
+    // Function: __global::mrk::web::Http::request, Token: 6
+static __mrkprimitive_bool request_bc91cba3(__mrkprimitive_string url_351a38c4, __mrkprimitive_int method_b305b042)    ;
+};
+MRK_NS_END
@@ -0,0 +1,72 @@
+#include "runtime_generated.h"
+
+MRK_NS_BEGIN_MODULE(runtime::generated)
+
+// Function: __global::mrk::web::Http::request, Token: 6
+#line 9 "examples/web.mrk"
+__mrkprimitive_bool __global__mrk__web__Http_cce7eba6::request_bc91cba3(__mrkprimitive_string url_351a38c4, __mrkprimitive_int method_b305b042) {
+#line 9 "runtime_generated_0.cpp"
+    // Native function: __global::mrk::web::Http::request
+return MRK_INVOKE_ICALL(6, __mrkprimitive_bool(__mrkprimitive_string, __mrkprimitive_int), url_351a38c4, method_b305b042);
+}
+// Function: __global::__globalType::readNumber, Token: 4
+#line 7 "examples/main.mrk"
+__mrkprimitive_int __global____globalType_c413d31d::readNumber_cbe4455d() {
+#line 8 "examples/main.mrk"
+    __mrkprimitive_int num;
+#line 10 "examples/main.mrk"
+    
+        std::cin >> num;
+    
+#line 14 "examples/main.mrk"
+    return num;
+#line 24 "runtime_generated_0.cpp"
+}
+// Function: __global::__globalType::print, Token: 3
+#line 17 "examples/main.mrk"
+__mrkprimitive_void __global____globalType_c413d31d::print_94b0981d(__mrkprimitive_string msg_48da70aa) {
+#line 18 "examples/main.mrk"
+    __mrkprimitive_string m = msg_48da70aa;
+#line 20 "examples/main.mrk"
+    
+        std::cout << m << std::endl;
+    
+#line 35 "runtime_generated_0.cpp"
+}
+inline constexpr __mrkprimitive_string __mrkliteral_09203907b5b5367a = MRK_STRING_LITERAL("NO", 2);
+inline constexpr __mrkprimitive_string __mrkliteral_1d2512c61828409c = MRK_STRING_LITERAL("NICE", 4);
+inline constexpr __mrkprimitive_string __mrkliteral_b5c8abe51e5ff11b = MRK_STRING_LITERAL("AMMAR MAGNUS.com", 16);
+// Function: __global::__globalType::main, Token: 2
+#line 25 "examples/main.mrk"
+__mrkprimitive_void __global____globalType_c413d31d::main_7906604e() {
+#line 26 "examples/main.mrk"
+    
+        std::cout << "hey there, enter number: ";
+    
+#line 30 "examples/main.mrk"
+    __mrkprimitive_int num = MRK_STATIC_MEMBER(__global____globalType_c413d31d, readNumber_cbe4455d)();
+#line 31 "examples/main.mrk"
+    
+        std::cout << "u entered: " << num << std::endl;
+    
+#line 35 "examples/main.mrk"
+    __mrkprimitive_bool res_4ee35b8a = __global__mrk__web__Http_cce7eba6::request_bc91cba3(__mrkliteral_b5c8abe51e5ff11b, __global__mrk__web__HttpMethod_f4b483cb::GET_bfbe9a35);
+#line 36 "examples/main.mrk"
+    MRK_STATIC_MEMBER(__global____globalType_c413d31d, print_94b0981d)(res_4ee35b8a ? __mrkliteral_1d2512c61828409c : __mrkliteral_09203907b5b5367a);
+#line 57 "runtime_generated_0.cpp"
+}
+// Function: __global::__globalType::testNative, Token: 1
+#line 39 "examples/main.mrk"
+__mrkprimitive_void __global____globalType_c413d31d::testNative_437cccfc() {
+#line 62 "runtime_generated_0.cpp"
+    // Native function: __global::__globalType::testNative
+MRK_INVOKE_ICALL(1, __mrkprimitive_void());
+}
+// Function: __global::__globalType::__globalFunction, Token: 5
+__mrkprimitive_void __global____globalType_c413d31d::__globalFunction_769c3b66() {
+#line 41 "examples/main.mrk"
+    __global____globalType_c413d31d::main_7906604e();
+    return;
+#line 71 "runtime_generated_0.cpp"
+}
+MRK_NS_END
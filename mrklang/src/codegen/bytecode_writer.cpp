@@ -0,0 +1,420 @@
+#include "bytecode_writer.h"
+#include "common/logging.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#define CAST(value) reinterpret_cast<const char*>(&value)
+#define CAST_PTR(value) reinterpret_cast<const char*>(value)
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace runtime::interpreter;
+
+BytecodeWriter::BytecodeWriter(const SymbolTable* symbolTable, const CompilerMetadataRegistration* metadataRegistration, const ir::Module* irModule)
+	: symbolTable_(symbolTable), metadataRegistration_(metadataRegistration), irModule_(irModule), methodCount_(0) {}
+
+bool BytecodeWriter::writeBytecode(std::ostream& stream) {
+	// Written in token order so the output only changes along with the program
+	Vec<std::pair<uint32_t, const FunctionSymbol*>> functions;
+	for (const auto& [function, token] : metadataRegistration_->methodTokenMap) {
+		functions.emplace_back(token, function);
+	}
+
+	std::sort(functions.begin(), functions.end());
+
+	Vec<MethodBytecode> methods;
+	for (const auto& [token, symbol] : functions) {
+		auto function = irModule_->getFunction(symbol);
+		if (!function) {
+			continue;
+		}
+
+		MethodBytecode bytecode{};
+		bytecode.header.token = token;
+		if (compileFunction(*function, bytecode)) {
+			methods.push_back(Move(bytecode));
+		}
+	}
+
+	uint32_t version = BYTECODE_VERSION;
+	uint32_t magic = BYTECODE_MAGIC;
+	uint32_t methodCount = static_cast<uint32_t>(methods.size());
+	stream.write(CAST(version), sizeof(version));
+	stream.write(CAST(magic), sizeof(magic));
+	stream.write(CAST(methodCount), sizeof(methodCount));
+
+	for (const auto& method : methods) {
+		writeMethod(stream, method);
+	}
+
+	writeStaticFieldValues(stream);
+
+	methodCount_ = methods.size();
+	return stream.good();
+}
+
+bool BytecodeWriter::compileFunction(const ir::Function& function, MethodBytecode& bytecode) const {
+	auto& header = bytecode.header;
+
+	// Registers are 16 bit operands
+	auto registerCount = function.slots.size() + function.valueTypes.size() - 1;
+	if (registerCount > std::numeric_limits<uint16_t>::max()) {
+		return false;
+	}
+
+	header.registerCount = static_cast<uint16_t>(registerCount);
+	header.parameterCount = static_cast<uint16_t>(function.symbol->parameters.size());
+
+	if (!function.symbol->isGlobal && !detail::isSTATIC(function.symbol->accessModifier)) {
+		header.flags |= BYTECODE_METHOD_INSTANCE;
+	}
+
+	if (!getValueKind(function.symbol->resolver.returnType, &header.returnKind)) {
+		return false;
+	}
+
+	for (uint16_t i = 0; i < header.parameterCount; i++) {
+		ValueKind kind;
+		if (i >= function.slots.size() || !function.slots[i].isParameter || !getValueKind(function.slots[i].type, &kind)) {
+			return false;
+		}
+
+		bytecode.parameterKinds.push_back(kind);
+	}
+
+	auto slotRegister = [&](ir::SlotId slot) {
+		return static_cast<uint16_t>(slot);
+	};
+
+	auto valueRegister = [&](ir::ValueId value) {
+		return static_cast<uint16_t>(function.slots.size() + value - 1);
+	};
+
+	auto valueKind = [&](ir::ValueId value, ValueKind* kind) {
+		return value != ir::NO_VALUE && value < function.valueTypes.size() && getValueKind(function.valueTypes[value], kind);
+	};
+
+	Dict<uint64_t, uint32_t> constantIndices;
+	Dict<const Symbol*, uint32_t> fieldIndices;
+
+	// Jumps are patched once every block has its offset, a jump to the next block falls through
+	Vec<uint32_t> blockOffsets(function.blocks.size(), 0);
+	Vec<std::pair<size_t, ir::BlockId>> jumps;
+
+	auto emit = [&](Opcode opcode, ValueKind kind, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0) -> Instruction& {
+		return bytecode.instructions.emplace_back(Instruction{ opcode, kind, a, b, c });
+	};
+
+	auto emitJump = [&](Opcode opcode, uint16_t condition, ir::BlockId target) {
+		jumps.emplace_back(bytecode.instructions.size(), target);
+		emit(opcode, opcode == Opcode::JUMP ? ValueKind::VOID : ValueKind::BOOL, condition);
+	};
+
+	for (ir::BlockId block = 0; block < function.blocks.size(); block++) {
+		blockOffsets[block] = static_cast<uint32_t>(bytecode.instructions.size());
+		auto nextBlock = block + 1;
+
+		for (const auto& instruction : function.blocks[block].instructions) {
+			ValueKind kind = ValueKind::VOID;
+			if (instruction.type && !getValueKind(instruction.type, &kind)) {
+				return false;
+			}
+
+			switch (instruction.opcode) {
+				case ir::Opcode::CONSTANT: {
+					auto bits = getConstantBits(instruction.constant);
+					auto [it, inserted] = constantIndices.try_emplace(bits, static_cast<uint32_t>(bytecode.constants.size()));
+					if (inserted) {
+						bytecode.constants.push_back(bits);
+					}
+
+					emit(Opcode::CONSTANT, kind, valueRegister(instruction.result)).setImmediate(it->second);
+					break;
+				}
+
+				case ir::Opcode::LOAD:
+					emit(Opcode::MOVE, kind, valueRegister(instruction.result), slotRegister(instruction.slot));
+					break;
+
+				case ir::Opcode::STORE:
+					emit(Opcode::MOVE, kind, slotRegister(instruction.slot), valueRegister(instruction.operands[0]));
+					break;
+
+				case ir::Opcode::LOAD_FIELD:
+				case ir::Opcode::STORE_FIELD: {
+					auto field = static_cast<const VariableSymbol*>(instruction.symbol);
+					auto token = metadataRegistration_->fieldTokenMap.find(field);
+					if (token == metadataRegistration_->fieldTokenMap.end()) {
+						return false;
+					}
+
+					auto isStatic = detail::isSTATIC(field->accessModifier);
+					auto [it, inserted] = fieldIndices.try_emplace(field, static_cast<uint32_t>(bytecode.fields.size()));
+					if (inserted) {
+						bytecode.fields.push_back(FieldReference{ token->second, isStatic });
+					}
+
+					if (instruction.opcode == ir::Opcode::LOAD_FIELD) {
+						emit(isStatic ? Opcode::LOAD_STATIC : Opcode::LOAD_FIELD, kind, valueRegister(instruction.result)).setImmediate(it->second);
+					}
+					else {
+						emit(isStatic ? Opcode::STORE_STATIC : Opcode::STORE_FIELD, kind, valueRegister(instruction.operands[0])).setImmediate(it->second);
+					}
+
+					break;
+				}
+
+				case ir::Opcode::CONVERT: {
+					ValueKind sourceKind;
+					if (!valueKind(instruction.operands[0], &sourceKind)) {
+						return false;
+					}
+
+					emit(Opcode::CONVERT, kind, valueRegister(instruction.result), valueRegister(instruction.operands[0]), static_cast<uint16_t>(sourceKind));
+					break;
+				}
+
+				case ir::Opcode::UNARY: {
+					Opcode opcode;
+					if (!getUnaryOpcode(instruction.op, kind, &opcode)) {
+						return false;
+					}
+
+					emit(opcode, kind, valueRegister(instruction.result), valueRegister(instruction.operands[0]));
+					break;
+				}
+
+				case ir::Opcode::BINARY: {
+					// Comparisons are typed by their operands, anything else by its result
+					ValueKind operandKind = kind;
+					if (ConstantEvaluator::isComparison(instruction.op) && !valueKind(instruction.operands[0], &operandKind)) {
+						return false;
+					}
+
+					Opcode opcode;
+					bool swapOperands;
+					if (!getBinaryOpcode(instruction.op, operandKind, &opcode, &swapOperands)) {
+						return false;
+					}
+
+					auto left = valueRegister(instruction.operands[0]);
+					auto right = valueRegister(instruction.operands[1]);
+					if (swapOperands) {
+						std::swap(left, right);
+					}
+
+					emit(opcode, operandKind, valueRegister(instruction.result), left, right);
+					break;
+				}
+
+				case ir::Opcode::CALL: {
+					auto callee = static_cast<const FunctionSymbol*>(instruction.symbol);
+					auto token = metadataRegistration_->methodTokenMap.find(callee);
+					if (token == metadataRegistration_->methodTokenMap.end()) {
+						return false;
+					}
+
+					CallSite call{ token->second, static_cast<uint32_t>(bytecode.arguments.size()), static_cast<uint32_t>(instruction.operands.size()) };
+					for (auto operand : instruction.operands) {
+						ValueKind argumentKind;
+						if (!valueKind(operand, &argumentKind)) {
+							return false;
+						}
+
+						bytecode.arguments.push_back(CallArgument{ valueRegister(operand), argumentKind, 0 });
+					}
+
+					// The result kind is the callee's return kind, void for calls whose result is dropped
+					auto returnKind = ValueKind::VOID;
+					if (instruction.result != ir::NO_VALUE && !valueKind(instruction.result, &returnKind)) {
+						return false;
+					}
+
+					auto result = instruction.result != ir::NO_VALUE ? valueRegister(instruction.result) : 0;
+					emit(Opcode::CALL, returnKind, result).setImmediate(static_cast<uint32_t>(bytecode.calls.size()));
+					bytecode.calls.push_back(call);
+					break;
+				}
+
+				case ir::Opcode::JUMP:
+					if (instruction.target != nextBlock) {
+						emitJump(Opcode::JUMP, 0, instruction.target);
+					}
+
+					break;
+
+				case ir::Opcode::BRANCH: {
+					auto condition = valueRegister(instruction.operands[0]);
+					if (instruction.target == nextBlock) {
+						emitJump(Opcode::JUMP_UNLESS, condition, instruction.elseTarget);
+					}
+					else {
+						emitJump(Opcode::JUMP_IF, condition, instruction.target);
+
+						if (instruction.elseTarget != nextBlock) {
+							emitJump(Opcode::JUMP, 0, instruction.elseTarget);
+						}
+					}
+
+					break;
+				}
+
+				case ir::Opcode::RETURN:
+					if (instruction.operands.empty()) {
+						emit(Opcode::RETURN_VOID, ValueKind::VOID);
+					}
+					else {
+						emit(Opcode::RETURN, header.returnKind, valueRegister(instruction.operands[0]));
+					}
+
+					break;
+			}
+		}
+	}
+
+	for (const auto& [index, target] : jumps) {
+		bytecode.instructions[index].setImmediate(blockOffsets[target]);
+	}
+
+	header.instructionCount = static_cast<uint32_t>(bytecode.instructions.size());
+	header.constantCount = static_cast<uint32_t>(bytecode.constants.size());
+	header.fieldCount = static_cast<uint32_t>(bytecode.fields.size());
+	header.callCount = static_cast<uint32_t>(bytecode.calls.size());
+	header.argumentCount = static_cast<uint32_t>(bytecode.arguments.size());
+	return true;
+}
+
+bool BytecodeWriter::getValueKind(const TypeSymbol* type, ValueKind* kind) const {
+	TypeKind typeKind;
+	if (!type || !symbolTable_->getTypeSystem()->getTypeKind(type, &typeKind) || typeKind > TypeKind::F64) {
+		return false;
+	}
+
+	// Value kinds follow the primitive type kinds
+	*kind = static_cast<ValueKind>(typeKind);
+	return true;
+}
+
+bool BytecodeWriter::getUnaryOpcode(TokenType op, ValueKind kind, Opcode* opcode) {
+	auto isFloating = kind == ValueKind::F32 || kind == ValueKind::F64;
+
+	switch (op) {
+		case TokenType::OP_PLUS:
+			*opcode = Opcode::MOVE;
+			return true;
+
+		case TokenType::OP_MINUS:
+			*opcode = isFloating ? Opcode::NEG_F : Opcode::NEG;
+			return true;
+
+		case TokenType::OP_NOT:
+			*opcode = Opcode::NOT;
+			return kind == ValueKind::BOOL;
+
+		case TokenType::OP_BNOT:
+			*opcode = Opcode::BIT_NOT;
+			return !isFloating && kind != ValueKind::BOOL;
+
+		default:
+			return false;
+	}
+}
+
+bool BytecodeWriter::getBinaryOpcode(TokenType op, ValueKind kind, Opcode* opcode, bool* swapOperands) {
+	auto isFloating = kind == ValueKind::F32 || kind == ValueKind::F64;
+	auto isUnsigned = kind == ValueKind::BOOL || kind == ValueKind::U8 || kind == ValueKind::U16 ||
+		kind == ValueKind::U32 || kind == ValueKind::U64;
+
+	// Greater than compares the other way around
+	*swapOperands = op == TokenType::OP_GT || op == TokenType::OP_GE;
+
+	switch (op) {
+		case TokenType::OP_PLUS: *opcode = isFloating ? Opcode::ADD_F : Opcode::ADD; return true;
+		case TokenType::OP_MINUS: *opcode = isFloating ? Opcode::SUB_F : Opcode::SUB; return true;
+		case TokenType::OP_ASTERISK: *opcode = isFloating ? Opcode::MUL_F : Opcode::MUL; return true;
+		case TokenType::OP_SLASH: *opcode = isFloating ? Opcode::DIV_F : isUnsigned ? Opcode::DIV_UN : Opcode::DIV; return true;
+		case TokenType::OP_MOD: *opcode = isUnsigned ? Opcode::REM_UN : Opcode::REM; return !isFloating;
+		case TokenType::OP_BAND: *opcode = Opcode::AND; return !isFloating;
+		case TokenType::OP_BOR: *opcode = Opcode::OR; return !isFloating;
+		case TokenType::OP_BXOR: *opcode = Opcode::XOR; return !isFloating;
+		case TokenType::OP_SHL: *opcode = Opcode::SHL; return !isFloating;
+		case TokenType::OP_SHR: *opcode = isUnsigned ? Opcode::SHR_UN : Opcode::SHR; return !isFloating;
+		case TokenType::OP_EQ_EQ: *opcode = isFloating ? Opcode::EQ_F : Opcode::EQ; return true;
+		case TokenType::OP_NOT_EQ: *opcode = isFloating ? Opcode::NE_F : Opcode::NE; return true;
+
+		case TokenType::OP_LT:
+		case TokenType::OP_GT:
+			*opcode = isFloating ? Opcode::LT_F : isUnsigned ? Opcode::LT_UN : Opcode::LT;
+			return true;
+
+		case TokenType::OP_LE:
+		case TokenType::OP_GE:
+			*opcode = isFloating ? Opcode::LE_F : isUnsigned ? Opcode::LE_UN : Opcode::LE;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+uint64_t BytecodeWriter::getConstantBits(const ConstantValue& value) {
+	if (value.kind == TypeKind::BOOL) {
+		return value.boolean ? 1 : 0;
+	}
+
+	// Integers are normalized to their width already, floats are doubles rounded to their precision
+	return value.isFloating() ? std::bit_cast<uint64_t>(value.floating) : value.unsignedInteger;
+}
+
+void BytecodeWriter::writeMethod(std::ostream& stream, const MethodBytecode& bytecode) const {
+	stream.write(CAST(bytecode.header), sizeof(bytecode.header));
+	stream.write(CAST_PTR(bytecode.parameterKinds.data()), bytecode.parameterKinds.size() * sizeof(ValueKind));
+	stream.write(CAST_PTR(bytecode.instructions.data()), bytecode.instructions.size() * sizeof(Instruction));
+	stream.write(CAST_PTR(bytecode.constants.data()), bytecode.constants.size() * sizeof(uint64_t));
+	stream.write(CAST_PTR(bytecode.fields.data()), bytecode.fields.size() * sizeof(FieldReference));
+	stream.write(CAST_PTR(bytecode.calls.data()), bytecode.calls.size() * sizeof(CallSite));
+	stream.write(CAST_PTR(bytecode.arguments.data()), bytecode.arguments.size() * sizeof(CallArgument));
+}
+
+void BytecodeWriter::writeStaticFieldValues(std::ostream& stream) const {
+	// Only needed where the generated code is not there to initialize the field
+	// Runtime initializers are only flagged, the interpreter cannot run them without the generated code
+	Vec<StaticFieldValue> values;
+	for (const auto& [field, token] : metadataRegistration_->fieldTokenMap) {
+		ValueKind kind;
+		if (!detail::isSTATIC(field->accessModifier) || !getValueKind(field->resolver.type, &kind)) {
+			continue;
+		}
+
+		auto initialValue = symbolTable_->getConstantEvaluator()->getInitialValue(field);
+		auto value = initialValue ? ConstantEvaluator::convert(*initialValue, static_cast<TypeKind>(kind)) : std::nullopt;
+
+		StaticFieldValue fieldValue{};
+		fieldValue.fieldToken = token;
+		fieldValue.kind = kind;
+
+		if (value) {
+			fieldValue.bits = getConstantBits(*value);
+		}
+		else {
+			auto varDecl = dynamic_cast<const ast::VarDeclStmt*>(field->declNode);
+			if (!varDecl || !varDecl->initializer) {
+				continue;
+			}
+
+			fieldValue.flags = STATIC_FIELD_RUNTIME_INITIALIZER;
+		}
+
+		values.push_back(fieldValue);
+	}
+
+	std::sort(values.begin(), values.end(), [](const auto& a, const auto& b) { return a.fieldToken < b.fieldToken; });
+
+	uint32_t count = static_cast<uint32_t>(values.size());
+	stream.write(CAST(count), sizeof(count));
+	stream.write(CAST_PTR(values.data()), values.size() * sizeof(StaticFieldValue));
+}
+
+MRK_NS_END
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "common/types.h"
+#include "ir/module.h"
+#include "metadata_writer.h"
+#include "mrk-bytecode.h"
+
+#include <ostream>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace semantic;
+
+/// Compiles the functions lowered into the IR to the register bytecode the runtime interprets
+/// A function's registers are its slots followed by its values, parameters are the first slots
+/// Functions the IR could not lower have no bytecode, they only run natively
+class BytecodeWriter {
+public:
+	static constexpr const char* BYTECODE_FILENAME = "runtime_bytecode.mrkbc";
+
+	BytecodeWriter(const SymbolTable* symbolTable, const CompilerMetadataRegistration* metadataRegistration, const ir::Module* irModule);
+
+	/// Serialize the bytecode of every lowered function, false if nothing could be written
+	bool writeBytecode(std::ostream& stream);
+
+	/// Functions written by the last writeBytecode
+	size_t getMethodCount() const { return methodCount_; }
+
+private:
+	struct MethodBytecode {
+		runtime::interpreter::MethodHeader header;
+		Vec<runtime::interpreter::ValueKind> parameterKinds;
+		Vec<runtime::interpreter::Instruction> instructions;
+		Vec<uint64_t> constants;
+		Vec<runtime::interpreter::FieldReference> fields;
+		Vec<runtime::interpreter::CallSite> calls;
+		Vec<runtime::interpreter::CallArgument> arguments;
+	};
+
+	const SymbolTable* symbolTable_;
+	const CompilerMetadataRegistration* metadataRegistration_;
+	const ir::Module* irModule_;
+	size_t methodCount_;
+
+	/// false if the function uses anything the bytecode cannot encode
+	bool compileFunction(const ir::Function& function, MethodBytecode& bytecode) const;
+
+	bool getValueKind(const TypeSymbol* type, runtime::interpreter::ValueKind* kind) const;
+
+	/// Opcode of a unary or binary operator evaluated in the given kind, false if there is none
+	static bool getUnaryOpcode(TokenType op, runtime::interpreter::ValueKind kind, runtime::interpreter::Opcode* opcode);
+	static bool getBinaryOpcode(TokenType op, runtime::interpreter::ValueKind kind, runtime::interpreter::Opcode* opcode, bool* swapOperands);
+
+	/// Value in its register representation
+	static uint64_t getConstantBits(const ConstantValue& value);
+
+	void writeMethod(std::ostream& stream, const MethodBytecode& bytecode) const;
+	void writeStaticFieldValues(std::ostream& stream) const;
+};
+
+MRK_NS_END
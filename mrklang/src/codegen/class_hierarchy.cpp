@@ -0,0 +1,197 @@
+#include "class_hierarchy.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+static const Vec<const FunctionSymbol*> EMPTY_VTABLE;
+
+static bool isDispatched(const FunctionSymbol* function) {
+	auto modifier = function->accessModifier;
+	return !function->isGlobal && !detail::isSTATIC(modifier) &&
+		(detail::isVIRTUAL(modifier) || detail::isABSTRACT(modifier) || detail::isOVERRIDE(modifier));
+}
+
+static bool hasSameParameters(const FunctionSymbol* a, const FunctionSymbol* b) {
+	return std::equal(a->parameters.begin(), a->parameters.end(), b->parameters.begin(), b->parameters.end(),
+		[](const auto& x, const auto& y) { return x.second->resolver.type == y.second->resolver.type; });
+}
+
+ClassHierarchy::ClassHierarchy(const SymbolTable* symbolTable) {
+	const auto& types = symbolTable->getTypes();
+
+	for (auto type : types) {
+		for (auto base : type->resolver.baseTypes) {
+			if (!base) {
+				continue;
+			}
+
+			derivedTypes_[base].push_back(type);
+
+			if (base->kind == SymbolKind::CLASS && !baseClasses_.contains(type)) {
+				baseClasses_[type] = base;
+			}
+		}
+	}
+
+	// Bases first, otherwise declaration order
+	std::unordered_set<const TypeSymbol*> visited;
+	auto visit = [&](auto& self, const TypeSymbol* type) -> void {
+		if (!visited.insert(type).second) {
+			return;
+		}
+
+		for (auto base : type->resolver.baseTypes) {
+			if (base) {
+				self(self, base);
+			}
+		}
+
+		types_.push_back(type);
+	};
+
+	for (auto type : types) {
+		visit(visit, type);
+	}
+
+	for (auto type : types_) {
+		layoutVTable(type);
+	}
+}
+
+void ClassHierarchy::layoutVTable(const TypeSymbol* type) {
+	if (type->kind != SymbolKind::CLASS) {
+		return;
+	}
+
+	// Inherited slots keep their position, so a base pointer dispatches the same way
+	Vec<const FunctionSymbol*> vtable;
+	if (auto base = getBaseClass(type)) {
+		vtable = getVTable(base);
+	}
+
+	// Members are unordered, new slots follow the declaration order
+	Vec<const FunctionSymbol*> functions;
+	for (const auto& [_, member] : type->members) {
+		if (member->kind == SymbolKind::FUNCTION && isDispatched(static_cast<const FunctionSymbol*>(member.get()))) {
+			functions.push_back(static_cast<const FunctionSymbol*>(member.get()));
+		}
+	}
+
+	std::sort(functions.begin(), functions.end(), [](auto a, auto b) {
+		return a->declNode->startToken.position.index < b->declNode->startToken.position.index;
+	});
+
+	for (auto function : functions) {
+		size_t slot = NO_SLOT;
+
+		if (detail::isOVERRIDE(function->accessModifier)) {
+			auto it = std::find_if(vtable.begin(), vtable.end(), [&](auto inherited) {
+				return inherited->name == function->name && hasSameParameters(inherited, function);
+			});
+
+			if (it != vtable.end()) {
+				slot = std::distance(vtable.begin(), it);
+				vtable[slot] = function;
+			}
+		}
+
+		// Nothing to override, it starts a slot of its own
+		if (slot == NO_SLOT) {
+			slot = vtable.size();
+			vtable.push_back(function);
+		}
+
+		slots_[function] = slot;
+	}
+
+	if (!vtable.empty()) {
+		vtables_[type] = Move(vtable);
+	}
+}
+
+const TypeSymbol* ClassHierarchy::getBaseClass(const TypeSymbol* type) const {
+	auto it = baseClasses_.find(type);
+	return it != baseClasses_.end() ? it->second : nullptr;
+}
+
+const Vec<const FunctionSymbol*>& ClassHierarchy::getVTable(const TypeSymbol* type) const {
+	auto it = vtables_.find(type);
+	return it != vtables_.end() ? it->second : EMPTY_VTABLE;
+}
+
+bool ClassHierarchy::isVTableRoot(const TypeSymbol* type) const {
+	if (getVTable(type).empty()) {
+		return false;
+	}
+
+	auto base = getBaseClass(type);
+	return !base || getVTable(base).empty();
+}
+
+size_t ClassHierarchy::getSlot(const FunctionSymbol* function) const {
+	auto it = slots_.find(function);
+	return it != slots_.end() ? it->second : NO_SLOT;
+}
+
+const FunctionSymbol* ClassHierarchy::getSlotDeclaration(const FunctionSymbol* function) const {
+	auto slot = getSlot(function);
+	if (slot == NO_SLOT) {
+		return nullptr;
+	}
+
+	// The highest base still having the slot declared it
+	auto type = static_cast<const TypeSymbol*>(function->parent);
+	for (auto base = getBaseClass(type); base && getVTable(base).size() > slot; base = getBaseClass(base)) {
+		type = base;
+	}
+
+	return getVTable(type)[slot];
+}
+
+const FunctionSymbol* ClassHierarchy::getDirectTarget(const FunctionSymbol* function, const TypeSymbol* receiverType) const {
+	auto slot = getSlot(function);
+	if (slot == NO_SLOT) {
+		return function;
+	}
+
+	if (!receiverType || getVTable(receiverType).size() <= slot) {
+		receiverType = static_cast<const TypeSymbol*>(function->parent);
+	}
+
+	auto target = getVTable(receiverType)[slot];
+	if (detail::isABSTRACT(target->accessModifier)) {
+		return nullptr;
+	}
+
+	if (detail::isSEALED(receiverType->accessModifier) || detail::isSEALED(target->accessModifier)) {
+		return target;
+	}
+
+	// Class hierarchy analysis, every type the receiver could be has to agree
+	bool single = forEachDerived(receiverType, [&](const TypeSymbol* derived) {
+		const auto& vtable = getVTable(derived);
+		return slot < vtable.size() && vtable[slot] == target;
+	});
+
+	return single ? target : nullptr;
+}
+
+template<typename Fn>
+bool ClassHierarchy::forEachDerived(const TypeSymbol* type, Fn&& fn) const {
+	auto it = derivedTypes_.find(type);
+	if (it == derivedTypes_.end()) {
+		return true;
+	}
+
+	for (auto derived : it->second) {
+		if (!fn(derived) || !forEachDerived(derived, fn)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+MRK_NS_END
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common/types.h"
+#include "semantic/symbol_table.h"
+
+#include <limits>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace semantic;
+
+/// Dispatch model of the generated classes
+/// Lays out a vtable per class from its resolved base types, and uses the whole hierarchy
+/// to tell which calls always land on the same method and can be made directly
+class ClassHierarchy {
+public:
+	static constexpr size_t NO_SLOT = std::numeric_limits<size_t>::max();
+
+	explicit ClassHierarchy(const SymbolTable* symbolTable);
+
+	/// Every type, bases before the types deriving from them
+	const Vec<const TypeSymbol*>& getTypes() const { return types_; }
+
+	/// Class the layout of a type starts with, only single class inheritance is laid out
+	const TypeSymbol* getBaseClass(const TypeSymbol* type) const;
+
+	/// Method each slot dispatches to for objects of exactly this type, empty if the type has no virtual methods
+	const Vec<const FunctionSymbol*>& getVTable(const TypeSymbol* type) const;
+
+	/// True if the type holds the vtable pointer, its bases have no virtual methods
+	bool isVTableRoot(const TypeSymbol* type) const;
+
+	/// Slot of a virtual, abstract or overriding method, NO_SLOT for any other
+	size_t getSlot(const FunctionSymbol* function) const;
+
+	/// Method declaring the slot, it fixes the signature every override is called with
+	const FunctionSymbol* getSlotDeclaration(const FunctionSymbol* function) const;
+
+	/// Method a call on a receiver of the given static type always ends up in, nullptr if it has to be dispatched
+	/// Non-virtual methods are their own target, virtual ones are when the receiver type is sealed,
+	/// the override is sealed, or no type deriving from the receiver type overrides it again
+	const FunctionSymbol* getDirectTarget(const FunctionSymbol* function, const TypeSymbol* receiverType) const;
+
+private:
+	Vec<const TypeSymbol*> types_;
+	Dict<const TypeSymbol*, const TypeSymbol*> baseClasses_;
+	Dict<const TypeSymbol*, Vec<const TypeSymbol*>> derivedTypes_;
+	Dict<const TypeSymbol*, Vec<const FunctionSymbol*>> vtables_;
+	Dict<const FunctionSymbol*, size_t> slots_;
+
+	void layoutVTable(const TypeSymbol* type);
+
+	/// Calls fn for every type directly or indirectly deriving from type, until it returns false
+	template<typename Fn>
+	bool forEachDerived(const TypeSymbol* type, Fn&& fn) const;
+};
+
+MRK_NS_END
@@ -1,26 +1,39 @@
 #include "code_generator.h"
 #include "function_generator.h"
+#include "ir_emitter.h"
 #include "common/declspecs.h"
+#include "common/parallel.h"
+#include "common/logging.h"
 
 #include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <unordered_set>
 
 MRK_NS_BEGIN_MODULE(codegen)
 
 CodeGenerator::CodeGenerator(const SymbolTable* symbolTable, const CompilerMetadataRegistration* metadataRegistration)
-	: symbolTable_(symbolTable), metadataRegistration_(metadataRegistration) {}
+	: symbolTable_(symbolTable), out_(nullptr), metadataRegistration_(metadataRegistration), parent_(nullptr) {}
 
-Str CodeGenerator::generateRuntimeCode() {
-	code_.clear();
+CodeGenerator::CodeGenerator(const CodeGenerator& parent, CodeWriter& out)
+	: symbolTable_(parent.symbolTable_), out_(&out), metadataRegistration_(parent.metadataRegistration_), parent_(&parent) {}
+
+void CodeGenerator::generateRuntimeCode(CodeOutput& output) {
+	// Every name is known before any code is written, workers only read them
+	prepare();
+
+	// Shared header first, declarations only
+	out_ = &output.open(HEADER_FILENAME);
+	writeLine("#pragma once\n");
 
 	// Generate includes
 	writeLine("#include \"runtime.h\"");
 	writeLine("#include \"runtime_defines.h\"");
 
-	// Write rigid c++ blocks
-	for (const auto& block : symbolTable_->getRigidLanguageBlocks()) {
-		writeLine("// Rigid block: ", block->language, (uintptr_t)block);
-		writeLine(block->rawCode);
-	}
+	// Includes and macros of rigid blocks, their code would be defined once per unit
+	generateRigidBlocks(true);
 
 	// Begin namespace
 	writeLine("MRK_NS_BEGIN_MODULE(runtime::generated)\n");
@@ -28,33 +41,280 @@ Str CodeGenerator::generateRuntimeCode() {
 	// Forward declare all types
 	generateForwardDeclarations();
 
-	// Generate types
-	for (const auto& type : symbolTable_->getTypes()) {
-		generateType(type);
+	// Each type is generated aside on its own so its code can be recorded, then written out
+	// Bases and embedded value types come first, the types using them need their definition
+	for (const auto& type : layoutEngine_->getTypes()) {
+		if (!isEmitted(type)) {
+			continue;
+		}
+
+		Str typeCode;
+		{
+			CodeWriter scratch(typeCode);
+			auto prevOut = std::exchange(out_, &scratch);
+			generateType(type);
+			out_ = prevOut;
+		}
+
+		recordSymbol(type->qualifiedName, typeCode);
+		out_->write(typeCode);
 	}
 
-	// Generate functions
+	// End namespace
+	writeLine("MRK_NS_END");
+	output.close();
+	out_ = nullptr;
+
+	// Generate functions, deferring the global function
 	auto globalFunction = symbolTable_->getGlobalFunction();
-	for (const auto& function : symbolTable_->getFunctions()) {
-		// Defer global function
-		if (function == globalFunction) continue;
+	auto functions = symbolTable_->getFunctions();
+	std::erase_if(functions, [&](const FunctionSymbol* function) { return !isEmitted(function); });
+	std::stable_partition(functions.begin(), functions.end(), [&](const FunctionSymbol* function) {
+		return function != globalFunction;
+	});
 
-		generateFunction(function);
+	// Bodies are independent of each other, generate them in parallel batches and write each batch out in order
+	// Only the bodies of one batch are held at a time, each is freed once written
+	auto batchSize = static_cast<size_t>(parallel::getWorkerCount()) * FUNCTIONS_PER_WORKER;
+	Vec<Str> functionCode(std::min(batchSize, functions.size()));
+	Vec<Dict<Str, Str>> functionLiterals(functionCode.size());
+
+	// A unit is only split between types once it is large enough, so small edits rarely move code across units
+	unitCount_ = 0;
+	const Symbol* unitType = nullptr;
+
+	for (size_t batch = 0; batch < functions.size(); batch += batchSize) {
+		auto count = std::min(batchSize, functions.size() - batch);
+		parallel::parallelFor(count, [&](size_t i) {
+			functionCode[i] = generateIsolatedFunction(functions[batch + i], &functionLiterals[i]);
+		});
+
+		for (size_t i = 0; i < count; i++) {
+			auto function = functions[batch + i];
+			auto enclosingType = symbolTable_->findAncestorOfKind(function, SymbolKind::TYPE);
+			recordSymbol(getFunctionSignature(function), functionCode[i]);
+
+			if (out_ && enclosingType != unitType && out_->getBytesWritten() >= unitSize_) {
+				writeLine("MRK_NS_END");
+				output.close();
+				out_ = nullptr;
+			}
+
+			if (!out_) {
+				beginUnit(output, getUnitFilename(unitCount_++));
+			}
+
+			unitType = enclosingType;
+
+			// Literals are defined in every unit using them, ahead of their first use
+			for (const auto& [name, value] : functionLiterals[i]) {
+				addStringLiteral(name, value);
+			}
+
+			generateStringLiterals();
+			writeUnitCode(functionCode[i]);
+
+			Str().swap(functionCode[i]);
+			functionLiterals[i].clear();
+		}
 	}
 
-	// Generate global function
-	generateFunction(globalFunction);
+	if (out_) {
+		writeLine("MRK_NS_END");
+		output.close();
+		out_ = nullptr;
+	}
+
+	// Static field initializers and metadata registration get their own unit
+	// The code of rigid blocks is defined here once, every unit sees their preprocessor lines through the header
+	beginUnit(output, REGISTRATION_FILENAME, true);
 
 	// Generate static field initializers
 	generateStaticFieldInitializers();
 
+	// Generate vtables
+	generateVTables();
+
+	// Check the native layout against the metadata
+	generateLayoutChecks();
+
 	// Generate metadata registration
 	generateMetadataRegistration();
 
 	// End namespace
 	writeLine("MRK_NS_END");
+	output.close();
+
+	out_ = &output.open(SOURCE_MAP_FILENAME);
+	generateSourceMap();
+	output.close();
 
-	return code_.str();
+	out_ = nullptr;
+}
+
+Str CodeGenerator::getUnitFilename(size_t index) {
+	return std::format("runtime_generated_{}.cpp", index);
+}
+
+void CodeGenerator::removeStaleUnits(const std::filesystem::path& directory, size_t unitCount) {
+	constexpr std::string_view prefix = "runtime_generated_";
+	constexpr std::string_view extension = ".cpp";
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		auto filename = entry.path().filename().string();
+		if (!filename.starts_with(prefix) || !filename.ends_with(extension)) {
+			continue;
+		}
+
+		// Only numbered units past the current count are left over from a previous build
+		auto digits = std::string_view(filename).substr(prefix.size(), filename.size() - prefix.size() - extension.size());
+
+		size_t index;
+		auto result = std::from_chars(digits.data(), digits.data() + digits.size(), index);
+		if (digits.empty() || result.ec != std::errc() || result.ptr != digits.data() + digits.size() || index < unitCount) {
+			continue;
+		}
+
+		std::filesystem::remove(entry.path(), error);
+	}
+}
+
+void CodeGenerator::recordSymbol(const Str& name, const Str& code) {
+	if (manifest_ && !code.empty()) {
+		manifest_->setSymbol(name, { utils::hashString(code), code.size() });
+	}
+}
+
+void CodeGenerator::beginUnit(CodeOutput& output, const Str& filename, bool rigidCode) {
+	out_ = &output.open(filename);
+	unitFilename_ = filename;
+	unitLiterals_.clear();
+
+	writeLine("#include \"", HEADER_FILENAME, "\"\n");
+	if (rigidCode) {
+		generateRigidBlocks(false);
+	}
+
+	writeLine("MRK_NS_BEGIN_MODULE(runtime::generated)\n");
+}
+
+void CodeGenerator::generateRigidBlocks(bool preprocessor) {
+	for (const auto& block : symbolTable_->getRigidLanguageBlocks()) {
+		// A directive continues onto the next line after a trailing backslash
+		Str code;
+		bool directive = false;
+
+		std::string_view rawCode = block->rawCode;
+		while (!rawCode.empty()) {
+			auto end = rawCode.find('\n');
+			auto line = rawCode.substr(0, end);
+			rawCode.remove_prefix(end == std::string_view::npos ? rawCode.size() : end + 1);
+
+			auto start = line.find_first_not_of(" \t\r");
+			if (start == std::string_view::npos) {
+				continue;
+			}
+
+			if (!directive) {
+				directive = line[start] == '#';
+			}
+
+			if (directive == preprocessor) {
+				code.append(line).push_back('\n');
+			}
+
+			auto last = line.find_last_not_of(" \t\r");
+			directive = directive && line[last] == '\\';
+		}
+
+		if (code.empty()) {
+			continue;
+		}
+
+		// File name only, the output should not depend on where the sources live
+		auto filename = block->sourceFile ? std::filesystem::path(block->sourceFile->filename).filename().string() : "<unknown>";
+		writeLine("// Rigid block: ", block->language, ", ", filename, ":", block->startToken.position.line);
+		write(code);
+	}
+}
+
+Str CodeGenerator::generateFunctionCode(const FunctionSymbol* function) {
+	// Instance calls dispatch through the class hierarchy, prepared the same as for the runtime code
+	prepare();
+	auto code = generateIsolatedFunction(function);
+
+	// Outside of a unit there is no generated line to return to
+	for (auto pos = code.find(LINE_RESET); pos != Str::npos; pos = code.find(LINE_RESET, pos)) {
+		code.erase(pos, LINE_RESET.size());
+	}
+
+	return code;
+}
+
+void CodeGenerator::writeUnitCode(std::string_view code) {
+	for (auto pos = code.find(LINE_RESET); pos != std::string_view::npos; pos = code.find(LINE_RESET)) {
+		out_->write(code.substr(0, pos));
+
+		// The directive names the line following it
+		out_->write("#line ");
+		out_->write(out_->getLineCount() + 2);
+		out_->write(" \"");
+		out_->write(unitFilename_);
+		out_->write("\"\n");
+		code.remove_prefix(pos + LINE_RESET.size());
+	}
+
+	out_->write(code);
+}
+
+Str CodeGenerator::generateIsolatedFunction(const FunctionSymbol* function, Dict<Str, Str>* stringLiterals) const {
+	// Generate into a scratch buffer through a worker, nothing shared is written
+	Str functionCode;
+	{
+		CodeWriter out(functionCode);
+		CodeGenerator worker(*this, out);
+		worker.generateFunction(function);
+
+		if (stringLiterals) {
+			*stringLiterals = Move(worker.stringLiterals_);
+		}
+	}
+
+	return functionCode;
+}
+
+Str CodeGenerator::getStringLiteral(const Str& value) {
+	// Named after the contents, workers agree on the name without sharing anything
+	auto name = std::format("__mrkliteral_{:016x}", utils::hashString(value));
+	addStringLiteral(name, value);
+	return name;
+}
+
+void CodeGenerator::addStringLiteral(const Str& name, const Str& value) {
+	auto [it, inserted] = stringLiterals_.try_emplace(name, value);
+	if (!inserted && it->second != value) {
+		MRK_ERROR("String literals \"{}\" and \"{}\" have the same name {}", it->second, value, name);
+	}
+}
+
+void CodeGenerator::generateStringLiterals() {
+	// Sorted, the unit must not depend on the order the literals were added in
+	Vec<std::pair<Str, Str>> literals(stringLiterals_.begin(), stringLiterals_.end());
+	std::sort(literals.begin(), literals.end());
+	stringLiterals_.clear();
+
+	for (const auto& [name, value] : literals) {
+		if (!unitLiterals_.insert(name).second) {
+			continue;
+		}
+
+		ConstantValue constant;
+		constant.kind = TypeKind::STRING;
+		constant.string = value;
+
+		writeLine("inline constexpr __mrkprimitive_string ", name, " = MRK_STRING_LITERAL(", getConstantLiteral(constant), ", ", value.size(), ");");
+	}
 }
 
 Str CodeGenerator::translateTypeName(const Str& typeName) const {
@@ -64,24 +324,108 @@ Str CodeGenerator::translateTypeName(const Str& typeName) const {
 	return result;
 }
 
-void CodeGenerator::generateForwardDeclarations() {
-	writeLine("// Forward declarations");
+/// Suffix derived from what identifies a declaration, so it is the same on every run
+static Str getNameSuffix(std::string_view identity) {
+	return std::format("{:08x}", static_cast<uint32_t>(utils::hashString(identity)));
+}
+
+Str CodeGenerator::mangleName(const Symbol* symbol) {
+	return utils::concat(symbol->name, "_", getNameSuffix(symbol->qualifiedName));
+}
+
+Str CodeGenerator::getFunctionSignature(const FunctionSymbol* function) {
+	auto params = utils::formatCollection(function->parameters, ",", [](const auto& param) {
+		return utils::concat(param.second->isParams ? "params " : "", param.second->type);
+	});
+
+	return utils::concat(function->qualifiedName, '(', params, ")->", function->returnType);
+}
+
+void CodeGenerator::prepare() {
+	mapNames();
+
+	if (!classHierarchy_) {
+		classHierarchy_ = MakeUnique<ClassHierarchy>(symbolTable_);
+		layoutEngine_ = MakeUnique<LayoutEngine>(symbolTable_, classHierarchy_.get(), target_);
+	}
+}
+
+void CodeGenerator::mapNames() {
+	if (namesMapped_) {
+		return;
+	}
 
 	for (const auto& type : symbolTable_->getTypes()) {
 		if (symbolTable_->getTypeSystem()->isPrimitiveType(type)) {
+			nameMap_[type] = utils::concat("__mrkprimitive_", type->name);
+			continue;
+		}
+
+		// The suffix keeps names distinct even if two qualified names translate to the same identifier
+		nameMap_[type] = utils::concat(translateTypeName(type->qualifiedName), "_", getNameSuffix(type->qualifiedName));
+
+		for (const auto& [_, member] : type->members) {
+			if (member->kind == SymbolKind::VARIABLE) {
+				nameMap_[member.get()] = mangleName(member.get());
+			}
+		}
+	}
+
+	for (const auto& function : symbolTable_->getFunctions()) {
+		// No overloads yet, the signature keeps names apart once there are
+		auto signature = getFunctionSignature(function);
+		nameMap_[function] = utils::concat(function->name, "_", getNameSuffix(signature));
+
+		// Parameters are not parented when their qualified name is built
+		for (const auto& [name, param] : function->parameters) {
+			nameMap_[param.get()] = utils::concat(name, "_", getNameSuffix(utils::concat(signature, "::", name)));
+		}
+
+		mapLocalNames(function);
+	}
+
+	namesMapped_ = true;
+}
+
+void CodeGenerator::mapLocalNames(const Symbol* scope) {
+	for (const auto& [_, member] : scope->members) {
+		if (member->kind == SymbolKind::BLOCK) {
+			mapLocalNames(member.get());
+			continue;
+		}
+
+		if (member->kind != SymbolKind::VARIABLE) {
 			continue;
 		}
 
-		auto generatedTypeName = utils::concat(translateTypeName(type->qualifiedName), "_", (uintptr_t)type);
-		nameMap_[type] = generatedTypeName;
+		// Mapped variables keep their name so raw c++ blocks can refer to them
+		auto* variable = static_cast<const VariableSymbol*>(member.get());
+		nameMap_[variable] = variable->declSpec == DECLSPEC_MAPPED ? variable->name : mangleName(variable);
+	}
+}
+
+void CodeGenerator::generateForwardDeclarations() {
+	writeLine("// Forward declarations");
+
+	for (const auto& type : symbolTable_->getTypes()) {
+		if (symbolTable_->getTypeSystem()->isPrimitiveType(type) || !isEmitted(type)) {
+			continue;
+		}
 
-		writeLine("struct ", generatedTypeName, ";");
+		writeLine("struct ", getMappedName(type), ";");
 	}
 }
 
 Str CodeGenerator::getReferenceTypeName(const TypeSymbol* type) const {
-	auto it = nameMap_.find(type);
-	if (it == nameMap_.end() || !it->first) {
+	// Arrays are a handle to their elements
+	if (auto elementType = symbolTable_->getTypeSystem()->getArrayElementType(type)) {
+		return utils::concat("__mrkarray<", getReferenceTypeName(elementType), ">");
+	}
+
+	const auto& nameMap = getNameMap();
+
+	auto it = nameMap.find(type);
+	if (it == nameMap.end() || !it->first) {
 		return "ERROR";
 	}
 
@@ -95,16 +439,17 @@ Str CodeGenerator::getReferenceTypeName(const TypeSymbol* type) const {
 	return result;
 }
 
-Str CodeGenerator::getMappedName(const Symbol* symbol) {
+Str CodeGenerator::getMappedName(const Symbol* symbol) const {
 	if (!symbol) {
 		return "ERROR";
 	}
-	
-	auto it = nameMap_.find(symbol);
-	if (it == nameMap_.end()) {
-		auto generatedName = utils::concat(symbol->name, "_", (uintptr_t)symbol);
-		nameMap_[symbol] = generatedName;
-		return generatedName;
+
+	// Anything mapNames did not reach gets the same name it would have been given
+	const auto& nameMap = getNameMap();
+
+	auto it = nameMap.find(symbol);
+	if (it == nameMap.end()) {
+		return mangleName(symbol);
 	}
 
 	return it->second;
@@ -114,22 +459,167 @@ void CodeGenerator::setMappedName(const Symbol* symbol, const Str& name) {
 	nameMap_[symbol] = name;
 }
 
+/// Escape the contents of a char or string literal, lexemes hold the unescaped text
+static Str escapeLiteral(const Str& text, char quote) {
+	Str result;
+	for (unsigned char c : text) {
+		switch (c) {
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+
+			default:
+				if (c == quote) {
+					result += '\\';
+					result += c;
+				}
+				else if (c < 0x20 || c == 0x7F) {
+					// Octal, unlike hex escapes it cannot swallow the next character
+					result += std::format("\\{:03o}", c);
+				}
+				else {
+					result += static_cast<char>(c);
+				}
+		}
+	}
+
+	return result;
+}
+
+Str CodeGenerator::getConstantLiteral(const ConstantValue& value) {
+	switch (value.kind) {
+		case TypeKind::BOOL:
+			return value.boolean ? "true" : "false";
+
+		case TypeKind::CHAR:
+			return utils::concat('\'', escapeLiteral(Str(1, static_cast<char>(value.integer)), '\''), '\'');
+
+		case TypeKind::STRING:
+			return utils::concat('"', escapeLiteral(value.string, '"'), '"');
+
+		case TypeKind::F32:
+		case TypeKind::F64: {
+			// Shortest round trip form, formatted as float so F32 values stay short
+			auto text = value.kind == TypeKind::F32
+				? std::format("{}", static_cast<float>(value.floating))
+				: std::format("{}", value.floating);
+
+			if (text.find_first_of(".e") == Str::npos) {
+				text += ".0";
+			}
+
+			if (value.kind == TypeKind::F32) {
+				text += 'f';
+			}
+
+			return value.floating < 0 ? utils::concat('(', text, ')') : text;
+		}
+
+		case TypeKind::U32:
+			return std::format("{}U", value.unsignedInteger);
+
+		case TypeKind::U64:
+			return std::format("{}ULL", value.unsignedInteger);
+
+		case TypeKind::I64:
+			// The minimum has no literal form, its magnitude does not fit
+			if (value.integer == std::numeric_limits<int64_t>::min()) {
+				return "(-9223372036854775807LL - 1)";
+			}
+
+			return value.integer < 0 ? std::format("({}LL)", value.integer) : std::format("{}LL", value.integer);
+
+		default:
+			if (value.kind == TypeKind::I32 && value.integer == std::numeric_limits<int32_t>::min()) {
+				return "(-2147483647 - 1)";
+			}
+
+			if (value.isSigned()) {
+				return value.integer < 0 ? std::format("({})", value.integer) : std::format("{}", value.integer);
+			}
+
+			return std::format("{}", value.unsignedInteger);
+	}
+}
+
+Str CodeGenerator::getLineReset() const {
+	bool enabled = parent_ ? parent_->lineDirectives_ : lineDirectives_;
+	return enabled ? Str(LINE_RESET) : Str();
+}
+
+Str CodeGenerator::getLineDirective(const ast::Node* node) const {
+	bool enabled = parent_ ? parent_->lineDirectives_ : lineDirectives_;
+	if (!enabled || !node || !node->sourceFile) {
+		return "";
+	}
+
+	// Injected sources such as <global> have no file the native compiler could show
+	if (node->sourceFile->filename.starts_with('<')) {
+		return "";
+	}
+
+	// Forward slashes on every platform, the path only needs its quotes escaped
+	auto filename = std::filesystem::path(node->sourceFile->filename).generic_string();
+	return std::format("#line {} \"{}\"\n", node->startToken.position.line, escapeLiteral(filename, '"'));
+}
+
+bool CodeGenerator::isEmitted(const Symbol* symbol) const {
+	if (symbol->kind == SymbolKind::FUNCTION) {
+		return metadataRegistration_->methodTokenMap.contains(static_cast<const FunctionSymbol*>(symbol));
+	}
+
+	if (symbol->kind == SymbolKind::VARIABLE) {
+		return metadataRegistration_->fieldTokenMap.contains(static_cast<const VariableSymbol*>(symbol));
+	}
+
+	if (detail::hasFlag(symbol->kind, SymbolKind::TYPE)) {
+		return metadataRegistration_->typeTokenMap.contains(static_cast<const TypeSymbol*>(symbol));
+	}
+
+	return true;
+}
+
 void CodeGenerator::generateType(const TypeSymbol* type) {
-	// Skip primitives
+	// Skip primitives, their names are mapped upfront
 	if (symbolTable_->getTypeSystem()->isPrimitiveType(type)) {
-		nameMap_[type] = utils::concat("__mrkprimitive_", type->name);
 		return;
 	}
 
 	// Generate type declaration
 	writeLine("// Type: ", type->qualifiedName, ", Token: ", metadataRegistration_->typeTokenMap.at(type));
-	writeLine("struct ", getMappedName(type), " {");
+	const auto& hierarchy = getClassHierarchy();
+	if (auto baseClass = hierarchy.getBaseClass(type)) {
+		writeLine("struct ", getMappedName(type), " : ", getMappedName(baseClass), " {");
+	}
+	else {
+		writeLine("struct ", getMappedName(type), " {");
+	}
 
 	// Generate members
 	indentLevel_++;
+
+	// Every object points at the vtable of its exact type, set by the innermost constructor
+	if (!hierarchy.getVTable(type).empty()) {
+		if (hierarchy.isVTableRoot(type)) {
+			writeLine("const void* const* __vtable;");
+		}
+
+		writeLine("static const void* const __vtableSlots[];");
+		writeLine(getMappedName(type), "() { __vtable = __vtableSlots; }");
+	}
+
+	if (type->kind == SymbolKind::ENUM) {
+		writeLine(getReferenceTypeName(symbolTable_->getTypeSystem()->getEnumUnderlyingType(type)), " __value;");
+	}
+
+	// Static fields and functions take no room in the object
 	for (const auto& [_, member] : type->members) {
-		// Generate only variables
-		if (member->kind == SymbolKind::VARIABLE) {
+		if (!isEmitted(member.get())) {
+			continue;
+		}
+
+		if (member->kind == SymbolKind::VARIABLE && detail::isSTATIC(member->accessModifier)) {
 			generateVariable(static_cast<const VariableSymbol*>(member.get()), type);
 		}
 		else if (member->kind == SymbolKind::FUNCTION) {
@@ -138,6 +628,17 @@ void CodeGenerator::generateType(const TypeSymbol* type) {
 			writeLine(";");
 		}
 	}
+
+	// Instance fields in storage order, the compiler lays them out at the offsets in the metadata
+	const auto& layout = getLayoutEngine().getLayout(type);
+	for (const auto& field : layout.fields) {
+		generateVariable(field.field, type);
+	}
+
+	// Spelled out so no derived type is placed in the tail padding, which only some ABIs do
+	if (!layout.fields.empty() && layout.size > layout.dataSize) {
+		writeLine("uint8_t __padding[", layout.size - layout.dataSize, "];");
+	}
 	indentLevel_--;
 
 	writeLine("};");
@@ -147,9 +648,13 @@ void CodeGenerator::generateFunctionDeclaration(const FunctionSymbol* function,
 	// Generate function declaration
 	writeLine("// Function: ", function->qualifiedName, ", Token: ", metadataRegistration_->methodTokenMap.at(function));
 
+	// Definitions are attributed to their declaration, the statements of the body to their own lines
+	if (external) {
+		write(getLineDirective(function->declNode));
+	}
+
 	Str params = utils::formatCollection(function->parameters, ", ", [&](const auto& param) {
-		auto generatedParamName = utils::concat(param.second->name, "_", (uintptr_t)param.second.get());
-		nameMap_[param.second.get()] = generatedParamName;
+		auto generatedParamName = getMappedName(param.second.get());
 
 		if (paramNames) {
 			paramNames->push_back(generatedParamName);
@@ -185,29 +690,25 @@ void CodeGenerator::generateFunction(const FunctionSymbol* function) {
 	generateFunctionDeclaration(function, true, &paramNames);
 	writeLine(" {");
 
-	// Mangle variable names
-	for (const auto& [_, var] : function->members) {
-		if (var->kind != SymbolKind::VARIABLE) {
-			continue;
-		}
-
-		auto* variable = static_cast<const VariableSymbol*>(var.get());
-		auto generatedVarName = variable->declSpec == DECLSPEC_MAPPED ? 
-			variable->name : utils::concat(variable->name, "_", (uintptr_t)variable);
-		nameMap_[variable] = generatedVarName;
-	}
-
 	// Generate function body
 	indentLevel_++;
 
 	if (function->declSpec == DECLSPEC_NATIVE) {
+		// The thunk is glue without a source line of its own
+		write(getLineReset());
 		writeLine("// Native function: ", function->qualifiedName);
 		
 		if (function->resolver.returnType->name != "void") {
 			write("return ");
 		}
 
-		write("MRK_INVOKE_ICALL(", metadataRegistration_->methodTokenMap.at(function));
+		// Typed thunk, the runtime checks the bound internal call against the same signature in the metadata
+		auto paramTypes = utils::formatCollection(function->parameters, ", ", [this](const auto& param) {
+			return getReferenceTypeName(param.second->resolver.type);
+		});
+
+		write("MRK_INVOKE_ICALL(", metadataRegistration_->methodTokenMap.at(function), ", ",
+			getReferenceTypeName(function->resolver.returnType), '(', paramTypes, ')');
 
 		if (!paramNames.empty()) {
 			write(", ", utils::formatCollection(paramNames, ", ", [](const auto& param) { return param; }));
@@ -215,6 +716,10 @@ void CodeGenerator::generateFunction(const FunctionSymbol* function) {
 
 		writeLine<false>(");");
 	}
+	else if (auto irFunction = getIrModule() ? getIrModule()->getFunction(function) : nullptr) {
+		IrEmitter emitter(this, irFunction);
+		emitter.generateFunctionBody();
+	}
 	else {
 		// Generate function body
 		FunctionGenerator generator(this, symbolTable_);
@@ -222,12 +727,16 @@ void CodeGenerator::generateFunction(const FunctionSymbol* function) {
 	}
 	indentLevel_--;
 
+	// Nothing after the body comes from the source, the closing brace and the code following the function included
+	if (function->declSpec != DECLSPEC_NATIVE) {
+		write(getLineReset());
+	}
+
 	writeLine("}");
 }
 
 void CodeGenerator::generateVariable(const VariableSymbol* variable, const TypeSymbol* enclosingType) {
-	auto generatedName = utils::concat(variable->name, "_", (uintptr_t)variable);
-	nameMap_[variable] = generatedName;
+	auto generatedName = getMappedName(variable);
 
 	// Generate variable declaration
 	writeLine("// Variable: ", variable->name, ", Token: ", metadataRegistration_->fieldTokenMap.at(variable));
@@ -247,22 +756,195 @@ void CodeGenerator::generateStaticFieldInitializers() {
 		writeLine("// Static field initializer: ", staticField->qualifiedName);
 
 		auto mappedTypeName = getReferenceTypeName(staticField->resolver.type);
-		
-		nativeInitializerMethod = utils::concat("staticFieldInit_", (uintptr_t)staticField);
-		writeLine(mappedTypeName, ' ', nativeInitializerMethod, "() {");
+		auto mappedFieldName = utils::concat(getMappedName(enclosingType), "::", getMappedName(staticField));
+
+		// Constant and default initialized fields are plain data, nothing to run at startup
+		auto constant = symbolTable_->getConstantEvaluator()->getInitialValue(staticField);
+		if (constant || !static_cast<const ast::VarDeclStmt*>(staticField->declNode)->initializer) {
+			if (!constant) {
+				writeLine(mappedTypeName, ' ', mappedFieldName, "{};");
+			}
+			else if (constant->kind == TypeKind::STRING) {
+				auto literal = getStringLiteral(constant->string);
+				generateStringLiterals();
+				writeLine("constinit ", mappedTypeName, ' ', mappedFieldName, " = ", literal, ";");
+			}
+			else {
+				writeLine("constinit ", mappedTypeName, ' ', mappedFieldName, " = ", getConstantLiteral(*constant), ";");
+			}
+
+			continue;
+		}
+
+		nativeInitializerMethod = utils::concat("staticFieldInit_", getMappedName(enclosingType), "_", getMappedName(staticField));
+
+		// Generated aside, the literals it uses are defined ahead of it
+		Str initializerCode;
+		{
+			CodeWriter scratch(initializerCode);
+			auto prevOut = std::exchange(out_, &scratch);
+
+			writeLine(mappedTypeName, ' ', nativeInitializerMethod, "() {");
+			indentLevel_++;
+
+			// Generate initializer code
+			FunctionGenerator generator(this, symbolTable_);
+			generator.generateFieldInitializer(staticField, enclosingType);
+
+			indentLevel_--;
+			writeLine("}");
+			out_ = prevOut;
+		}
+
+		generateStringLiterals();
+		out_->write(initializerCode);
+
+		// Assigned by the initialization table, never by dynamic initialization in unspecified order
+		writeLine(mappedTypeName, ' ', mappedFieldName, "{};");
+	}
+
+	writeLine("\n// Static field initialization, in dependency order");
+	writeLine("void initializeStaticFields() {");
+	indentLevel_++;
+
+	for (auto staticField : getStaticInitializationOrder()) {
+		writeLine(getMappedName(staticField->enclosingType), "::", getMappedName(staticField->variable), " = ",
+			staticField->nativeInitializerMethod, "();");
+	}
+
+	indentLevel_--;
+	writeLine("}");
+}
+
+Vec<const StaticFieldInfo*> CodeGenerator::getStaticInitializationOrder() const {
+	Dict<const Symbol*, size_t> initialized;
+	for (size_t i = 0; i < staticFields_.size(); i++) {
+		if (!staticFields_[i].nativeInitializerMethod.empty()) {
+			initialized[staticFields_[i].variable] = i;
+		}
+	}
+
+	// Fields an initializer reads, directly or through the functions it calls
+	const auto* dependencyGraph = symbolTable_->getDependencyGraph();
+	auto collectDependencies = [&](const Symbol* field) {
+		Vec<size_t> dependencies;
+		std::unordered_set<const Symbol*> visited{ field };
+		Vec<const Symbol*> pending{ field };
+
+		while (!pending.empty()) {
+			auto symbol = pending.back();
+			pending.pop_back();
+
+			for (auto dependency : dependencyGraph->getDependencies(symbol)) {
+				if (!visited.insert(dependency).second) {
+					continue;
+				}
+
+				if (auto it = initialized.find(dependency); it != initialized.end()) {
+					dependencies.push_back(it->second);
+				}
+				else if (dependency->kind == SymbolKind::FUNCTION) {
+					pending.push_back(dependency);
+				}
+			}
+		}
+
+		// Declaration order between independent fields
+		std::sort(dependencies.begin(), dependencies.end());
+		return dependencies;
+	};
+
+	enum class Mark { NONE, VISITING, DONE };
+	Vec<Mark> marks(staticFields_.size(), Mark::NONE);
+	Vec<const StaticFieldInfo*> order;
+
+	auto visit = [&](auto& self, size_t index) -> void {
+		marks[index] = Mark::VISITING;
+
+		for (auto dependency : collectDependencies(staticFields_[index].variable)) {
+			if (marks[dependency] == Mark::VISITING) {
+				MRK_WARN("Static fields {} and {} are initialized from each other",
+					staticFields_[index].variable->qualifiedName, staticFields_[dependency].variable->qualifiedName);
+			}
+			else if (marks[dependency] == Mark::NONE) {
+				self(self, dependency);
+			}
+		}
+
+		marks[index] = Mark::DONE;
+		order.push_back(&staticFields_[index]);
+	};
+
+	for (size_t i = 0; i < staticFields_.size(); i++) {
+		if (!staticFields_[i].nativeInitializerMethod.empty() && marks[i] == Mark::NONE) {
+			visit(visit, i);
+		}
+	}
+
+	return order;
+}
+
+void CodeGenerator::generateVTables() {
+	const auto& hierarchy = getClassHierarchy();
+
+	for (auto type : hierarchy.getTypes()) {
+		const auto& vtable = hierarchy.getVTable(type);
+		if (vtable.empty() || !isEmitted(type)) {
+			continue;
+		}
+
+		writeLine("// VTable: ", type->qualifiedName);
+		writeLine("const void* const ", getMappedName(type), "::__vtableSlots[] = {");
 		indentLevel_++;
 
-		// Generate initializer code
-		FunctionGenerator generator(this, symbolTable_);
-		generator.generateFieldInitializer(staticField, enclosingType);
+		for (auto function : vtable) {
+			// Abstract slots are never called, the type cannot be instantiated
+			if (detail::isABSTRACT(function->accessModifier)) {
+				writeLine("nullptr,");
+				continue;
+			}
+
+			auto enclosingType = static_cast<const TypeSymbol*>(function->parent);
+			writeLine("reinterpret_cast<const void*>(&", getMappedName(enclosingType), "::", getMappedName(function), "),");
+		}
 
 		indentLevel_--;
-		writeLine("}");
+		writeLine("};");
+	}
+}
+
+void CodeGenerator::generateLayoutChecks() {
+	const auto& layoutEngine = getLayoutEngine();
 
-		writeLine(mappedTypeName, ' ', getMappedName(enclosingType), "::", getMappedName(staticField), " = ", nativeInitializerMethod, "();");
+	// Every size below assumes the runtime is built for the target they were laid out for
+	writeLine("MRK_CHECK_TYPE_SIZE(void*, ", layoutEngine.getTarget().pointerSize, ");");
+	writeLine("MRK_CHECK_TYPE_SIZE(__mrkprimitive_string, ", layoutEngine.getTarget().stringSize, ");");
+
+	for (auto type : layoutEngine.getTypes()) {
+		if (symbolTable_->getTypeSystem()->isPrimitiveType(type) || !isEmitted(type)) {
+			continue;
+		}
+
+		const auto& layout = layoutEngine.getLayout(type);
+		auto mappedName = getMappedName(type);
+
+		writeLine("// Layout: ", type->qualifiedName);
+		writeLine("MRK_CHECK_TYPE_SIZE(", mappedName, ", ", layout.size, ");");
+
+		for (const auto& field : layout.fields) {
+			writeLine("MRK_CHECK_FIELD_OFFSET(", mappedName, ", ", getMappedName(field.field), ", ", field.offset, ");");
+		}
 	}
 }
 
+/// Token maps are keyed by pointer, registration is written in token order instead
+template<typename TokenMap>
+static Vec<std::pair<typename TokenMap::key_type, uint32_t>> sortByToken(const TokenMap& tokenMap) {
+	Vec<std::pair<typename TokenMap::key_type, uint32_t>> entries(tokenMap.begin(), tokenMap.end());
+	std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+	return entries;
+}
+
 void CodeGenerator::generateMetadataRegistration() {
 	writeLine("\n// Metadata registration");
 	writeLine("void registerMetadata() {");
@@ -270,16 +952,19 @@ void CodeGenerator::generateMetadataRegistration() {
 
 	// Register native methods
 	writeLine("// Register native methods");
-	for (const auto& [method, token] : metadataRegistration_->methodTokenMap) {
+	for (const auto& [method, token] : sortByToken(metadataRegistration_->methodTokenMap)) {
 		auto enclosingType = static_cast<TypeSymbol*>(symbolTable_->findAncestorOfKind(method, SymbolKind::TYPE));
-		writeLine("MRK_RUNTIME_REGISTER_CODE(", token, ", ", 
+
+		// Instance methods take their instance first, their invoker passes it from the caller rather than the arguments
+		auto hasInstance = !method->isGlobal && !detail::isSTATIC(method->accessModifier);
+		writeLine(hasInstance ? "MRK_RUNTIME_REGISTER_INSTANCE_CODE(" : "MRK_RUNTIME_REGISTER_CODE(", token, ", ",
 			getMappedName(enclosingType), "::", getMappedName(method), ");");
 	}
 
 	// Register types
 	writeLine("// Register types");
 
-	for (const auto& [type, token] : metadataRegistration_->typeTokenMap) {
+	for (const auto& [type, token] : sortByToken(metadataRegistration_->typeTokenMap)) {
 		writeLine("MRK_RUNTIME_REGISTER_TYPE(", token, ", ", getMappedName(type), ");");
 	}
 
@@ -290,8 +975,8 @@ void CodeGenerator::generateMetadataRegistration() {
 		auto mappedTypeName = getMappedName(staticField.enclosingType);
 		auto mappedFieldName = getMappedName(staticField.variable);
 
-		// Token - Native Field - Static Init
-		writeLine("MRK_RUNTIME_REGISTER_STATIC_FIELD(", token, ", ", mappedTypeName, "::", mappedFieldName, ", ", staticField.nativeInitializerMethod, ");");
+		// Token - Native Field
+		writeLine("MRK_RUNTIME_REGISTER_STATIC_FIELD(", token, ", ", mappedTypeName, "::", mappedFieldName, ");");
 	}
 
 	indentLevel_--;
@@ -299,4 +984,31 @@ void CodeGenerator::generateMetadataRegistration() {
 	writeLine("}");
 }
 
+// Format, one tab separated entry per line:
+//		type <generated name> <qualified name> <file>:<line>:<column>
+//		function <generated name> <signature> <file>:<line>:<column>
+// Generated names are qualified by their struct, as profilers show them inside the runtime::generated namespace
+void CodeGenerator::generateSourceMap() {
+	auto writeEntry = [this](const char* kind, const Str& generatedName, const Str& name, const ASTNode* declNode) {
+		auto location = declNode && declNode->sourceFile
+			? std::format("{}:{}:{}", std::filesystem::path(declNode->sourceFile->filename).generic_string(),
+				declNode->startToken.position.line, declNode->startToken.position.column)
+			: Str("<unknown>");
+
+		writeLine(kind, '\t', generatedName, '\t', name, '\t', location);
+	};
+
+	for (const auto& [type, _] : sortByToken(metadataRegistration_->typeTokenMap)) {
+		if (!symbolTable_->getTypeSystem()->isPrimitiveType(type)) {
+			writeEntry("type", getMappedName(type), type->qualifiedName, type->declNode);
+		}
+	}
+
+	for (const auto& [function, _] : sortByToken(metadataRegistration_->methodTokenMap)) {
+		auto enclosingType = symbolTable_->findAncestorOfKind(function, SymbolKind::TYPE);
+		writeEntry("function", utils::concat(getMappedName(enclosingType), "::", getMappedName(function)),
+			getFunctionSignature(function), function->declNode);
+	}
+}
+
 MRK_NS_END
@@ -4,8 +4,12 @@
 #include "semantic/symbol_table.h"
 #include "common/utils.h"
 #include "metadata_writer.h"
+#include "code_output.h"
+#include "class_hierarchy.h"
+#include "layout_engine.h"
+#include "ir/module.h"
 
-#include <sstream>
+#include <unordered_set>
 
 MRK_NS_BEGIN_MODULE(codegen)
 
@@ -21,67 +25,179 @@ class CodeGenerator {
 public:
 	CodeGenerator(const SymbolTable* symbolTable, const CompilerMetadataRegistration* metadataRegistration);
 
-	Str generateRuntimeCode();
+	CodeGenerator(const CodeGenerator&) = delete;
+	CodeGenerator& operator=(const CodeGenerator&) = delete;
+
+	/// Shared header with the forward declarations and type definitions
+	static constexpr const char* HEADER_FILENAME = "runtime_generated.h";
+
+	/// Unit holding the static field initializers and the metadata registration
+	static constexpr const char* REGISTRATION_FILENAME = "runtime_generated.cpp";
+
+	/// Generated symbols and the declarations they come from, for profilers and debuggers to resolve
+	static constexpr const char* SOURCE_MAP_FILENAME = "runtime_generated.map";
+
+	/// Generate the runtime as several translation units so the native build can compile them in parallel
+	/// Function bodies are split across units of roughly the configured size
+	void generateRuntimeCode(CodeOutput& output);
+
+	/// Approximate size in bytes after which a new function unit is started
+	void setUnitSize(size_t unitSize) { unitSize_ = unitSize; }
+
+	/// Function units written by the last generateRuntimeCode
+	size_t getUnitCount() const { return unitCount_; }
+
+	/// Record the hash of the code generated for every function and type
+	void setManifest(CodeManifest* manifest) { manifest_ = manifest; }
+
+	/// Point the native compiler back at the mrklang source of every function and statement, on by default
+	/// Code moved by an edit above it then changes along with its line numbers
+	void setLineDirectives(bool enabled) { lineDirectives_ = enabled; }
+
+	/// Generate the functions the module lowered from their optimized IR, nullptr generates every body from the AST
+	/// Bodies the IR does not model are generated from the AST either way
+	void setIrModule(const ir::Module* module) { irModule_ = module; }
+
+	/// Platform the types are laid out for, must match the metadata, x64 by default
+	void setTarget(const LayoutTarget& target) { target_ = target; }
+
+	static Str getUnitFilename(size_t index);
+
+	/// Delete function units left over from a build that produced more of them
+	static void removeStaleUnits(const std::filesystem::path& directory, size_t unitCount);
+
+	/// Generate the definition of a single function
+	Str generateFunctionCode(const FunctionSymbol* function);
 	Str getReferenceTypeName(const TypeSymbol* type) const;
-	Str getMappedName(const Symbol* symbol);
+	Str getMappedName(const Symbol* symbol) const;
 
 	void setMappedName(const Symbol* symbol, const Str& name);
 
-	template<bool indent = false>
-	void write(const Str& line) {
-		if constexpr (indent) {
-			code_ << Str(indentLevel_ * 4, ' ');
-		}
+	/// Dispatch model, built once names are mapped
+	const ClassHierarchy& getClassHierarchy() const { return parent_ ? *parent_->classHierarchy_ : *classHierarchy_; }
 
-		code_ << line;
-	}
+	/// Field layout of every type, built along with the dispatch model
+	const LayoutEngine& getLayoutEngine() const { return parent_ ? *parent_->layoutEngine_ : *layoutEngine_; }
 
-	template <bool indent, typename... Args>
-	void write(Args... args) {
-		write<indent>(utils::concat(args...));
-	}
+	/// C++ literal of a folded constant
+	static Str getConstantLiteral(const ConstantValue& value);
 
-	template<typename... Args>
-	void write(Args... args) {
-		write<false>(utils::concat(args...));
-	}
+	/// Name of the interned string literal holding the value, defined once in the shared header
+	Str getStringLiteral(const Str& value);
 
-	template<bool indent = false>
-	void writeLine(const Str& line) {
-		write<indent>(line, '\n');
-	}
+	/// #line directive attributing the following code to the node, empty if disabled or the node has no source
+	Str getLineDirective(const ast::Node* node) const;
+
+	/// Placeholder attributing the following code back to the generated unit, empty if disabled
+	/// Functions are generated before their position in a unit is known, it is resolved once they are written
+	Str getLineReset() const;
 
-	template <bool indent, typename... Args>
-	void writeLine(Args... args) {
-		writeLine<indent>(utils::concat(args...));
+	/// Write the arguments to the current sink, indented first if requested
+	template<bool indent = false, typename... Args>
+	void write(const Args&... args) {
+		if constexpr (indent) {
+			out_->fill(' ', indentLevel_ * 4);
+		}
+
+		(out_->write(args), ...);
 	}
 
-	template <typename... Args>
-	void writeLine(Args... args) {
-		writeLine<true>(utils::concat(args...));
+	template<bool indent = true, typename... Args>
+	void writeLine(const Args&... args) {
+		write<indent>(args..., '\n');
 	}
 
 	void indent() { indentLevel_++; }
 	void unindent() { indentLevel_--; }
 
 private:
+	/// Function bodies generated ahead of being written, per worker
+	/// Bounds the generated code held in memory at once
+	static constexpr size_t FUNCTIONS_PER_WORKER = 16;
+
+	/// Written by getLineReset, never valid C++ so one left unresolved fails to compile
+	static constexpr std::string_view LINE_RESET = "#line __mrk_reset\n";
+
 	const SymbolTable* symbolTable_;
-	std::stringstream code_;
+	CodeWriter* out_;
+	size_t unitSize_ = 256 * 1024;
+	size_t unitCount_ = 0;
+	Str unitFilename_;
+	CodeManifest* manifest_ = nullptr;
 	int indentLevel_ = 0;
+	bool namesMapped_ = false;
+	bool lineDirectives_ = true;
 	Dict<const Symbol*, Str> nameMap_;
 	const CompilerMetadataRegistration* metadataRegistration_;
+	UniquePtr<ClassHierarchy> classHierarchy_;
+	LayoutTarget target_ = LayoutTarget::x64();
+	UniquePtr<LayoutEngine> layoutEngine_;
+	const ir::Module* irModule_ = nullptr;
+
+	/// Set on workers, which share the names of the generator that created them
+	const CodeGenerator* parent_;
 
 	// Static Fields, and their enclosing types
 	Vec<StaticFieldInfo> staticFields_;
 
+	/// Interned string literals by name, used since they were last defined
+	Dict<Str, Str> stringLiterals_;
+
+	/// Names of the literals defined in the current unit
+	std::unordered_set<Str> unitLiterals_;
+
+	/// Worker generating a function into its own sink, safe to run alongside other workers
+	CodeGenerator(const CodeGenerator& parent, CodeWriter& out);
+
+	const Dict<const Symbol*, Str>& getNameMap() const { return parent_ ? parent_->nameMap_ : nameMap_; }
+
+	/// Optimized functions, nullptr if optimization is disabled
+	const ir::Module* getIrModule() const { return parent_ ? parent_->irModule_ : irModule_; }
+
 	Str translateTypeName(const Str& typeName) const;
+	static Str mangleName(const Symbol* symbol);
+	static Str getFunctionSignature(const FunctionSymbol* function);
+
+	/// Map the names of all types, members, functions, parameters and locals upfront
+	void mapNames();
+	void mapLocalNames(const Symbol* scope);
+
+	/// Map names and build the dispatch model and type layouts, once
+	void prepare();
+
+	Str generateIsolatedFunction(const FunctionSymbol* function, Dict<Str, Str>* stringLiterals = nullptr) const;
+	void addStringLiteral(const Str& name, const Str& value);
+
+	/// Define the literals used since the last call that the current unit does not define yet
+	/// Each unit has its own inline constexpr definition, the header only holds types and declarations
+	void generateStringLiterals();
+	void recordSymbol(const Str& name, const Str& code);
+	/// Only symbols given a token are generated, the metadata writer leaves out unreachable ones
+	bool isEmitted(const Symbol* symbol) const;
+
 	void generateForwardDeclarations();
 	void generateType(const TypeSymbol* type);
 	void generateFunctionDeclaration(const FunctionSymbol* function, bool external, Vec<Str>* paramNames = nullptr);
 	void generateFunction(const FunctionSymbol* function);
 	void generateVariable(const VariableSymbol* variable, const TypeSymbol* enclosingType);
 	void generateStaticFieldInitializers();
+	void generateVTables();
+	void generateLayoutChecks();
 	void generateMetadataRegistration();
+	void generateSourceMap();
+
+	/// Static fields with an initializer method, ordered so each runs after the fields it reads
+	Vec<const StaticFieldInfo*> getStaticInitializationOrder() const;
+
+	/// Open a function or registration unit, includes the shared header and opens the namespace
+	/// rigidCode also defines the code of rigid blocks in the unit, before the namespace
+	void beginUnit(CodeOutput& output, const Str& filename, bool rigidCode = false);
+
+	/// Write generated code to the current unit, resolving its line resets against the unit's line count
+	void writeUnitCode(std::string_view code);
+
+	/// Write the preprocessor lines of every rigid block, or everything else in them
+	void generateRigidBlocks(bool preprocessor);
 };
 
 MRK_NS_END
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "code_manifest.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+// Format, one entry per line:
+//		file <hash> <size> <filename>
+//		symbol <hash> <size> <name>
+// Names come last since signatures may contain spaces
+
+bool CodeManifest::load(const std::filesystem::path& directory) {
+	files_.clear();
+	symbols_.clear();
+
+	std::ifstream file(directory / FILENAME);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	Str line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+
+		Str kind;
+		Entry entry;
+		if (!(stream >> kind >> std::hex >> entry.hash >> std::dec >> entry.size)) {
+			continue;
+		}
+
+		Str name;
+		stream >> std::ws;
+		std::getline(stream, name);
+
+		if (kind == "file") {
+			files_[name] = entry;
+		}
+		else if (kind == "symbol") {
+			symbols_[name] = entry;
+		}
+	}
+
+	return true;
+}
+
+bool CodeManifest::save(const std::filesystem::path& directory) const {
+	std::ofstream file(directory / FILENAME, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	// Sorted so the manifest itself is deterministic
+	auto write = [&](const char* kind, const Dict<Str, Entry>& entries) {
+		Vec<const std::pair<const Str, Entry>*> sorted;
+		for (const auto& entry : entries) {
+			sorted.push_back(&entry);
+		}
+
+		std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->first < b->first; });
+
+		for (auto entry : sorted) {
+			file << std::format("{} {:016x} {} {}\n", kind, entry->second.hash, entry->second.size, entry->first);
+		}
+	};
+
+	write("file", files_);
+	write("symbol", symbols_);
+
+	return file.good();
+}
+
+const CodeManifest::Entry* CodeManifest::getFile(const Str& filename) const {
+	auto it = files_.find(filename);
+	return it != files_.end() ? &it->second : nullptr;
+}
+
+const CodeManifest::Entry* CodeManifest::getSymbol(const Str& name) const {
+	auto it = symbols_.find(name);
+	return it != symbols_.end() ? &it->second : nullptr;
+}
+
+void CodeManifest::keepUnwritten(const CodeManifest& previous) {
+	// insert leaves existing entries alone
+	files_.insert(previous.files_.begin(), previous.files_.end());
+	symbols_.insert(previous.symbols_.begin(), previous.symbols_.end());
+}
+
+size_t CodeManifest::countChangedSymbols(const CodeManifest& previous) const {
+	return std::count_if(symbols_.begin(), symbols_.end(), [&](const auto& symbol) {
+		auto entry = previous.getSymbol(symbol.first);
+		return !entry || *entry != symbol.second;
+	});
+}
+
+bool CodeManifest::isUpToDate(const std::filesystem::path& directory, const Str& filename, const Entry& entry) const {
+	auto recorded = getFile(filename);
+	if (!recorded || *recorded != entry) {
+		return false;
+	}
+
+	// The file could have been replaced since, a different size at least is cheap to catch
+	std::error_code error;
+	auto size = std::filesystem::file_size(directory / filename, error);
+	return !error && size == entry.size;
+}
+
+MRK_NS_END
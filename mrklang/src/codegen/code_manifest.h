@@ -0,0 +1,49 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <filesystem>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+/// Record of a previous code generation, kept next to the generated files
+/// Holds the hash of every generated file, and of the code generated for each function and type
+/// Files whose hash did not change are left untouched, so their timestamps do not trigger native rebuilds
+class CodeManifest {
+public:
+	static constexpr const char* FILENAME = "runtime_generated.manifest";
+
+	struct Entry {
+		uint64_t hash;
+		size_t size;
+
+		bool operator==(const Entry&) const = default;
+	};
+
+	/// Read the manifest of a directory, false if there is none or it is unreadable
+	bool load(const std::filesystem::path& directory);
+	bool save(const std::filesystem::path& directory) const;
+
+	void setFile(const Str& filename, Entry entry) { files_[filename] = entry; }
+	const Entry* getFile(const Str& filename) const;
+
+	/// Symbols are keyed by qualified name, functions by their signature
+	void setSymbol(const Str& name, Entry entry) { symbols_[name] = entry; }
+	const Entry* getSymbol(const Str& name) const;
+
+	/// Take over the files and symbols of a previous manifest that this one has no entry for
+	/// Used when a generation only rewrote some files and left the others in place
+	void keepUnwritten(const CodeManifest& previous);
+
+	/// Symbols that are new or whose code differs from a previous manifest
+	size_t countChangedSymbols(const CodeManifest& previous) const;
+
+	/// True if the file in the directory is still the one recorded with this entry
+	bool isUpToDate(const std::filesystem::path& directory, const Str& filename, const Entry& entry) const;
+
+private:
+	Dict<Str, Entry> files_;
+	Dict<Str, Entry> symbols_;
+};
+
+MRK_NS_END
@@ -0,0 +1,114 @@
+#include "code_output.h"
+#include "common/logging.h"
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+FileCodeOutput::FileCodeOutput(const std::filesystem::path& directory)
+	: directory_(directory), file_(nullptr), mirror_(nullptr), bytesWritten_(0), changedCount_(0), good_(true) {
+	// Dropped until this generation completes, an interrupted one must not vouch for files it replaced
+	if (previous_.load(directory_)) {
+		std::error_code error;
+		std::filesystem::remove(directory_ / CodeManifest::FILENAME, error);
+	}
+}
+
+FileCodeOutput::~FileCodeOutput() {
+	close();
+}
+
+CodeWriter& FileCodeOutput::open(const Str& filename) {
+	close();
+
+	filename_ = filename;
+	paths_.push_back((directory_ / filename).string());
+
+	auto temporaryPath = getTemporaryPath().string();
+	file_ = std::fopen(temporaryPath.c_str(), "wb");
+	if (!file_) {
+		MRK_ERROR("Failed to open {} for writing", temporaryPath);
+		good_ = false;
+	}
+
+	// A failed open still gets a writer, its output is dropped
+	writer_ = MakeUnique<CodeWriter>(file_);
+	writer_->setMirror(mirror_);
+
+	return *writer_;
+}
+
+void FileCodeOutput::close() {
+	if (!writer_) {
+		return;
+	}
+
+	writer_->flush();
+	bytesWritten_ += writer_->getBytesWritten();
+
+	CodeManifest::Entry entry{ writer_->getContentHash(), writer_->getBytesWritten() };
+	bool written = writer_->good();
+	writer_.reset();
+
+	if (!file_) {
+		return;
+	}
+
+	std::error_code error;
+	auto temporaryPath = getTemporaryPath();
+
+	if (std::fclose(file_) != 0 || !written) {
+		MRK_ERROR("Failed to write {}", paths_.back());
+		std::filesystem::remove(temporaryPath, error);
+		good_ = false;
+	}
+	else if (previous_.isUpToDate(directory_, filename_, entry)) {
+		// Same contents, keep the old file and its timestamp
+		std::filesystem::remove(temporaryPath, error);
+		manifest_.setFile(filename_, entry);
+	}
+	else {
+		std::filesystem::rename(temporaryPath, directory_ / filename_, error);
+		if (error) {
+			MRK_ERROR("Failed to replace {}: {}", paths_.back(), error.message());
+			good_ = false;
+		}
+		else {
+			manifest_.setFile(filename_, entry);
+			changedCount_++;
+		}
+	}
+
+	file_ = nullptr;
+}
+
+bool FileCodeOutput::saveManifest() {
+	if (!manifest_.save(directory_)) {
+		MRK_ERROR("Failed to write {}", (directory_ / CodeManifest::FILENAME).string());
+		return false;
+	}
+
+	return true;
+}
+
+std::filesystem::path FileCodeOutput::getTemporaryPath() const {
+	return directory_ / (filename_ + ".tmp");
+}
+
+StringCodeOutput::~StringCodeOutput() {
+	close();
+}
+
+CodeWriter& StringCodeOutput::open(const Str& filename) {
+	close();
+
+	// Nothing is appended to files_ while the writer is alive, so the target stays put
+	files_.push_back({ filename, "" });
+	writer_ = MakeUnique<CodeWriter>(files_.back().contents);
+
+	return *writer_;
+}
+
+void StringCodeOutput::close() {
+	writer_.reset();
+}
+
+MRK_NS_END
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "common/types.h"
+#include "code_writer.h"
+#include "code_manifest.h"
+
+#include <filesystem>
+#include <iosfwd>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+/// Destination of the generated files, one file is open at a time
+class CodeOutput {
+public:
+	virtual ~CodeOutput() = default;
+
+	/// Start a new file, closing the current one
+	/// The writer stays valid until the next open or close
+	virtual CodeWriter& open(const Str& filename) = 0;
+
+	/// Flush and finish the current file, if any
+	virtual void close() = 0;
+};
+
+/// Writes each file into a directory as it is generated
+/// Files are streamed to a temporary first and only replace the target if their contents changed
+/// according to the manifest of the previous generation
+class FileCodeOutput : public CodeOutput {
+public:
+	explicit FileCodeOutput(const std::filesystem::path& directory);
+	~FileCodeOutput() override;
+
+	CodeWriter& open(const Str& filename) override;
+	void close() override;
+
+	/// Record the files of this generation, call once everything is closed
+	bool saveManifest();
+
+	/// Also copy every file to a stream
+	void setMirror(std::ostream* mirror) { mirror_ = mirror; }
+
+	/// False if any file failed to open or write
+	bool good() const { return good_; }
+
+	size_t getBytesWritten() const { return bytesWritten_; }
+	const Vec<Str>& getPaths() const { return paths_; }
+
+	/// Files that replaced their target, the rest were identical
+	size_t getChangedCount() const { return changedCount_; }
+
+	CodeManifest& getManifest() { return manifest_; }
+	const CodeManifest& getPreviousManifest() const { return previous_; }
+
+private:
+	std::filesystem::path directory_;
+	std::FILE* file_;
+	UniquePtr<CodeWriter> writer_;
+	std::ostream* mirror_;
+	Str filename_;
+	Vec<Str> paths_;
+	size_t bytesWritten_;
+	size_t changedCount_;
+	bool good_;
+
+	CodeManifest previous_;
+	CodeManifest manifest_;
+
+	std::filesystem::path getTemporaryPath() const;
+};
+
+struct GeneratedFile {
+	Str filename;
+	Str contents;
+};
+
+/// Keeps every file in memory
+class StringCodeOutput : public CodeOutput {
+public:
+	~StringCodeOutput() override;
+
+	CodeWriter& open(const Str& filename) override;
+	void close() override;
+
+	/// Complete once closed
+	Vec<GeneratedFile>& getFiles() { return files_; }
+
+private:
+	Vec<GeneratedFile> files_;
+	UniquePtr<CodeWriter> writer_;
+};
+
+MRK_NS_END
@@ -0,0 +1,81 @@
+#include "code_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+CodeWriter::CodeWriter(std::FILE* file)
+	: buffer_(MakeUnique<char[]>(BLOCK_SIZE)), size_(0), flushed_(0), lines_(0), contentHash_(utils::HASH_SEED), file_(file), target_(nullptr),
+	mirror_(nullptr), good_(file != nullptr) {
+	// We already write in whole blocks, stdio buffering would only add a copy
+	if (file_) {
+		std::setvbuf(file_, nullptr, _IONBF, 0);
+	}
+}
+
+CodeWriter::CodeWriter(Str& target)
+	: buffer_(MakeUnique<char[]>(BLOCK_SIZE)), size_(0), flushed_(0), lines_(0), contentHash_(utils::HASH_SEED), file_(nullptr), target_(&target),
+	mirror_(nullptr), good_(true) {}
+
+CodeWriter::~CodeWriter() {
+	flush();
+}
+
+void CodeWriter::write(std::string_view text) {
+	lines_ += std::count(text.begin(), text.end(), '\n');
+
+	while (!text.empty()) {
+		if (size_ == BLOCK_SIZE) {
+			flush();
+		}
+
+		auto count = std::min(text.size(), BLOCK_SIZE - size_);
+		std::memcpy(buffer_.get() + size_, text.data(), count);
+		size_ += count;
+		text.remove_prefix(count);
+	}
+}
+
+void CodeWriter::fill(char c, size_t count) {
+	if (c == '\n') {
+		lines_ += count;
+	}
+
+	while (count > 0) {
+		if (size_ == BLOCK_SIZE) {
+			flush();
+		}
+
+		auto chunk = std::min(count, BLOCK_SIZE - size_);
+		std::memset(buffer_.get() + size_, c, chunk);
+		size_ += chunk;
+		count -= chunk;
+	}
+}
+
+void CodeWriter::flush() {
+	if (size_ == 0) {
+		return;
+	}
+
+	if (file_) {
+		if (std::fwrite(buffer_.get(), 1, size_, file_) != size_) {
+			good_ = false;
+		}
+	}
+	else if (target_) {
+		target_->append(buffer_.get(), size_);
+	}
+
+	if (mirror_) {
+		mirror_->write(buffer_.get(), size_);
+	}
+
+	contentHash_ = utils::hashString(std::string_view(buffer_.get(), size_), contentHash_);
+	flushed_ += size_;
+	size_ = 0;
+}
+
+MRK_NS_END
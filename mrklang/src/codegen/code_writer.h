@@ -0,0 +1,87 @@
+#pragma once
+
+#include "common/types.h"
+#include "common/utils.h"
+
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <iosfwd>
+#include <string_view>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+/// Buffered output sink for generated code
+/// Text is collected in a fixed block and handed to the target once the block is full,
+/// so memory stays flat no matter how much code is generated
+///
+/// Targets are either a file, written straight to its descriptor, or a string
+class CodeWriter {
+public:
+	static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+	/// Write to an open file, the file stays owned by the caller
+	explicit CodeWriter(std::FILE* file);
+
+	/// Append to a string
+	explicit CodeWriter(Str& target);
+
+	CodeWriter(const CodeWriter&) = delete;
+	CodeWriter& operator=(const CodeWriter&) = delete;
+
+	~CodeWriter();
+
+	void write(std::string_view text);
+
+	void write(char c) {
+		if (size_ == BLOCK_SIZE) {
+			flush();
+		}
+
+		buffer_[size_++] = c;
+		lines_ += c == '\n';
+	}
+
+	/// Integers are written without going through a temporary string
+	template<std::integral T>
+		requires (!std::same_as<T, char> && !std::same_as<T, bool>)
+	void write(T value) {
+		char digits[24];
+		auto result = std::to_chars(digits, digits + sizeof(digits), value);
+		write(std::string_view(digits, result.ptr - digits));
+	}
+
+	/// Write the same character count times
+	void fill(char c, size_t count);
+
+	/// Also copy everything written to a stream, e.g. to dump the generated code
+	void setMirror(std::ostream* mirror) { mirror_ = mirror; }
+
+	/// Hand the buffered block to the target
+	void flush();
+
+	/// False once a write to the file failed
+	bool good() const { return good_; }
+
+	/// Total bytes written so far, buffered included
+	size_t getBytesWritten() const { return flushed_ + size_; }
+
+	/// Line breaks written so far, the line being written is one past it
+	size_t getLineCount() const { return lines_; }
+
+	/// Hash of everything flushed so far, flush first to cover the whole output
+	uint64_t getContentHash() const { return contentHash_; }
+
+private:
+	UniquePtr<char[]> buffer_;
+	size_t size_;
+	size_t flushed_;
+	size_t lines_;
+	uint64_t contentHash_;
+	std::FILE* file_;
+	Str* target_;
+	std::ostream* mirror_;
+	bool good_;
+};
+
+MRK_NS_END
@@ -4,7 +4,7 @@
 MRK_NS_BEGIN_MODULE(codegen)
 
 FunctionGenerator::FunctionGenerator(CodeGenerator* cppGen, const SymbolTable* symbolTable)
-	: cppGen_(cppGen), symbolTable_(symbolTable), isGlobalFunction_(false),
+	: cppGen_(cppGen), symbolTable_(symbolTable), isGlobalFunction_(false), qualified_(false), prefixed_(false), foreachDepth_(0),
 	currentFunction_(nullptr), currentFunctionEnclosingType_(nullptr) {}
 
 void FunctionGenerator::generateFunctionBody(const FunctionSymbol* function) {
@@ -19,9 +19,7 @@ void FunctionGenerator::generateFunctionBody(const FunctionSymbol* function) {
 	auto astNode = static_cast<const FuncDeclStmt*>(function->declNode);
 	// We already printed our braces in the function declaration
 	for (const auto& stmt : astNode->body->statements) {
-		// Indent the statement
-		cppGen_->write<true>("");
-		stmt->accept(*this);
+		writeStatement(stmt.get());
 	}
 }
 
@@ -30,6 +28,9 @@ void FunctionGenerator::generateFieldInitializer(const VariableSymbol* field, co
 		return;
 	}
 
+	// Members of the enclosing type are accessed the same way as from its functions
+	currentFunctionEnclosingType_ = enclosingType;
+
 	auto* varNode = static_cast<const VarDeclStmt*>(field->declNode);
 	if (!varNode->initializer) {
 		// No initializer, return default
@@ -44,6 +45,18 @@ void FunctionGenerator::generateFieldInitializer(const VariableSymbol* field, co
 	cppGen_->writeLine(';');
 }
 
+void FunctionGenerator::writeStatement(StmtNode* node) {
+	// Attribute the statement to its source line, then indent it
+	// Unless it continues the line of the modifiers or declspec written in front of it
+	if (!prefixed_) {
+		cppGen_->write(cppGen_->getLineDirective(node));
+		cppGen_->write<true>("");
+	}
+
+	prefixed_ = dynamic_cast<AccessModifierStmt*>(node) || dynamic_cast<DeclSpecStmt*>(node);
+	node->accept(*this);
+}
+
 void FunctionGenerator::generateGlobalFunctionBody(const FunctionSymbol* function) {
 	isGlobalFunction_ = true;
 
@@ -56,14 +69,35 @@ void FunctionGenerator::generateGlobalFunctionBody(const FunctionSymbol* functio
 	}
 }
 
+bool FunctionGenerator::writeConstant(const ExprNode* node) {
+	auto value = symbolTable_->getConstantEvaluator()->getValue(node);
+	if (!value) {
+		return false;
+	}
+
+	// Strings are interned, every use refers to the same instance
+	if (value->kind == TypeKind::STRING) {
+		cppGen_->write(cppGen_->getStringLiteral(value->string));
+		return true;
+	}
+
+	cppGen_->write(CodeGenerator::getConstantLiteral(*value));
+	return true;
+}
+
 void FunctionGenerator::visit(Program* node) {
 	// None
 }
 
 void FunctionGenerator::visit(LiteralExpr* node) {
+	// Constant literals are written escaped
+	if (writeConstant(node)) {
+		return;
+	}
+
 	// Write the literal value
 	if (node->value.type == TokenType::LIT_STRING) {
-		cppGen_->write('"', node->value.lexeme, '"');
+		cppGen_->write(cppGen_->getStringLiteral(node->value.lexeme));
 	}
 	else if (node->value.type == TokenType::LIT_CHAR) {
 		cppGen_->write('\'', node->value.lexeme, '\'');
@@ -77,8 +111,51 @@ void FunctionGenerator::visit(LiteralExpr* node) {
 }
 
 void FunctionGenerator::visit(InterpolatedStringExpr* node) {
-	// Write the interpolated string
-	// TODO: Implement
+	// Literal segments are measured here, the builder reserves once for them and the longest form of every other part
+	ConstantValue literals;
+	literals.kind = TypeKind::STRING;
+
+	bool constant = true;
+	for (const auto& part : node->parts) {
+		auto literal = dynamic_cast<const LiteralExpr*>(part.get());
+		if (literal && literal->value.type == TokenType::LIT_STRING) {
+			literals.string += literal->value.lexeme;
+		}
+		else {
+			constant = false;
+		}
+	}
+
+	// Nothing to format
+	if (constant) {
+		cppGen_->write(cppGen_->getStringLiteral(literals.string));
+		return;
+	}
+
+	cppGen_->write("MRK_INTERPOLATE(", literals.string.size());
+
+	// Parts are not part of the qualified name
+	auto qualified = qualified_;
+	qualified_ = false;
+
+	for (const auto& part : node->parts) {
+		cppGen_->write(", ");
+
+		auto literal = dynamic_cast<const LiteralExpr*>(part.get());
+		if (literal && literal->value.type == TokenType::LIT_STRING) {
+			ConstantValue segment;
+			segment.kind = TypeKind::STRING;
+			segment.string = literal->value.lexeme;
+
+			cppGen_->write(CodeGenerator::getConstantLiteral(segment));
+		}
+		else {
+			part->accept(*this);
+		}
+	}
+
+	qualified_ = qualified;
+	cppGen_->write(')');
 }
 
 void FunctionGenerator::visit(InteropCallExpr* node) {
@@ -86,11 +163,17 @@ void FunctionGenerator::visit(InteropCallExpr* node) {
 }
 
 void FunctionGenerator::visit(IdentifierExpr* node) {
+	// Enum members and constants are inlined
+	if (writeConstant(node)) {
+		return;
+	}
+
 	auto sym = symbolTable_->getNodeResolvedSymbol(node);
 	if (sym) {
-		// Check if it's a member
-		bool isMember = currentFunctionEnclosingType_ == symbolTable_->findAncestorOfKind(sym, SymbolKind::TYPE)
-			&& currentFunctionEnclosingType_->getMember(sym->name);
+		// Check if it's a member, of the enclosing type or one it inherits from
+		auto owner = static_cast<const TypeSymbol*>(symbolTable_->findAncestorOfKind(sym, SymbolKind::TYPE));
+		bool isMember = !qualified_ && currentFunctionEnclosingType_ && owner && sym->parent == owner
+			&& (owner == currentFunctionEnclosingType_ || symbolTable_->getTypeSystem()->isDerivedFrom(currentFunctionEnclosingType_, owner));
 		if (isMember) {
 			// Static or instance?
 			if (detail::isSTATIC(sym->accessModifier)) {
@@ -126,11 +209,19 @@ void FunctionGenerator::visit(TypeReferenceExpr* node) {
 }
 
 void FunctionGenerator::visit(CallExpr* node) {
+	if (writeInstanceCall(node)) {
+		return;
+	}
+
 	// Write the target
 	node->target->accept(*this);
 
 	cppGen_->write('(');
 
+	// Arguments are not part of the qualified name
+	auto qualified = qualified_;
+	qualified_ = false;
+
 	// Write arguments
 	for (int i = 0; i < node->arguments.size(); i++) {
 		node->arguments[i]->accept(*this);
@@ -140,10 +231,75 @@ void FunctionGenerator::visit(CallExpr* node) {
 		}
 	}
 
+	qualified_ = qualified;
 	cppGen_->write(')');
 }
 
+bool FunctionGenerator::writeInstanceCall(CallExpr* node) {
+	auto function = symbolTable_->getNodeResolvedSymbol(node->target.get());
+	if (qualified_ || !function || function->kind != SymbolKind::FUNCTION) {
+		return false;
+	}
+
+	auto method = static_cast<const FunctionSymbol*>(function);
+	if (method->isGlobal || detail::isSTATIC(method->accessModifier)) {
+		return false;
+	}
+
+	// The receiver is the target of the member access, or implicitly the current instance
+	auto memberAccess = dynamic_cast<MemberAccessExpr*>(node->target.get());
+	const TypeSymbol* receiverType = currentFunctionEnclosingType_;
+	if (memberAccess) {
+		receiverType = symbolTable_->getTypeSystem()->getSymbolType(symbolTable_->getNodeResolvedSymbol(memberAccess->target.get()));
+	}
+
+	auto writeReceiver = [&]() {
+		if (memberAccess) {
+			memberAccess->target->accept(*this);
+		}
+		else {
+			cppGen_->write("__instance");
+		}
+	};
+
+	auto writeArguments = [&]() {
+		for (const auto& argument : node->arguments) {
+			cppGen_->write(", ");
+			argument->accept(*this);
+		}
+
+		cppGen_->write(')');
+	};
+
+	// Calls that always land on the same method are made directly, where the C++ compiler can inline them
+	const auto& hierarchy = cppGen_->getClassHierarchy();
+	if (auto target = hierarchy.getDirectTarget(method, receiverType)) {
+		auto enclosingType = static_cast<const TypeSymbol*>(target->parent);
+		cppGen_->write(cppGen_->getMappedName(enclosingType), "::", cppGen_->getMappedName(target), '(');
+		writeReceiver();
+		writeArguments();
+		return true;
+	}
+
+	// Through the vtable, with the signature of the method that declared the slot
+	auto declaration = hierarchy.getSlotDeclaration(method);
+	auto paramTypes = utils::formatCollection(declaration->parameters, "", [&](const auto& param) {
+		return utils::concat(", ", cppGen_->getReferenceTypeName(param.second->resolver.type));
+	});
+
+	cppGen_->write("MRK_VIRTUAL_CALL(", cppGen_->getReferenceTypeName(declaration->resolver.returnType), '(',
+		cppGen_->getReferenceTypeName(static_cast<const TypeSymbol*>(declaration->parent)), paramTypes, "), ",
+		hierarchy.getSlot(method), ", ");
+	writeReceiver();
+	writeArguments();
+	return true;
+}
+
 void FunctionGenerator::visit(BinaryExpr* node) {
+	if (writeConstant(node)) {
+		return;
+	}
+
 	// Write the left side
 	node->left->accept(*this);
 
@@ -155,6 +311,10 @@ void FunctionGenerator::visit(BinaryExpr* node) {
 }
 
 void FunctionGenerator::visit(UnaryExpr* node) {
+	if (writeConstant(node)) {
+		return;
+	}
+
 	// Write the operator
 	cppGen_->write(node->op.lexeme);
 
@@ -163,6 +323,18 @@ void FunctionGenerator::visit(UnaryExpr* node) {
 }
 
 void FunctionGenerator::visit(TernaryExpr* node) {
+	if (writeConstant(node)) {
+		return;
+	}
+
+	// Only the taken branch of a constant condition is written
+	if (auto condition = symbolTable_->getConstantEvaluator()->getValue(node->condition.get())) {
+		cppGen_->write('(');
+		(condition->boolean ? node->thenBranch : node->elseBranch)->accept(*this);
+		cppGen_->write(')');
+		return;
+	}
+
 	// Write the condition
 	node->condition->accept(*this);
 
@@ -187,9 +359,17 @@ void FunctionGenerator::visit(AssignmentExpr* node) {
 }
 
 void FunctionGenerator::visit(NamespaceAccessExpr* node) {
+	if (writeConstant(node)) {
+		return;
+	}
+
 	// Write the path
 	for (int i = 0; i < node->path.size(); i++) {
+		// Qualified members are written as is, even when they belong to the current type
+		qualified_ = i > 0;
 		node->path[i]->accept(*this);
+		qualified_ = false;
+
 		if (i < node->path.size() - 1) {
 			cppGen_->write("::");
 		}
@@ -197,19 +377,37 @@ void FunctionGenerator::visit(NamespaceAccessExpr* node) {
 }
 
 void FunctionGenerator::visit(MemberAccessExpr* node) {
+	if (writeConstant(node)) {
+		return;
+	}
+
 	// Write the target
 	node->target->accept(*this);
 
-	// Write the operator
-	cppGen_->write(node->op.lexeme);
+	// Objects of classes are referenced through pointers
+	auto target = symbolTable_->getNodeResolvedSymbol(node->target.get());
+	auto targetType = symbolTable_->getTypeSystem()->getSymbolType(target);
+	if (target && detail::hasFlag(target->kind, SymbolKind::TYPE)) {
+		cppGen_->write("::");
+	}
+	else if (targetType && detail::hasFlag(targetType->kind, SymbolKind::CLASS | SymbolKind::INTERFACE)) {
+		cppGen_->write("->");
+	}
+	else {
+		cppGen_->write(node->op.lexeme);
+	}
 
-	// Write the member
+	// Write the member, it belongs to the target and not to the enclosing type
+	auto qualified = std::exchange(qualified_, true);
 	node->member->accept(*this);
+	qualified_ = qualified;
 }
 
 void FunctionGenerator::visit(ArrayExpr* node) {
-	// Write the array
-	cppGen_->write('{');
+	// [a, b] -> __mrkarray<T>::of(a, b)
+	auto arrayType = symbolTable_->getTypeSystem()->getSymbolType(symbolTable_->getNodeResolvedSymbol(node));
+	cppGen_->write(cppGen_->getReferenceTypeName(arrayType), "::of(");
+
 	for (int i = 0; i < node->elements.size(); i++) {
 		node->elements[i]->accept(*this);
 
@@ -218,17 +416,26 @@ void FunctionGenerator::visit(ArrayExpr* node) {
 		}
 	}
 
-	cppGen_->write('}');
+	cppGen_->write(')');
 }
 
 void FunctionGenerator::visit(ArrayAccessExpr* node) {
+	auto typeSystem = symbolTable_->getTypeSystem();
+	auto targetType = typeSystem->getSymbolType(symbolTable_->getNodeResolvedSymbol(node->target.get()));
+
+	// Array elements are checked when bounds checks are enabled
+	bool isArray = typeSystem->getArrayElementType(targetType) != nullptr;
+	if (isArray) {
+		cppGen_->write("MRK_ARRAY_ELEMENT(");
+	}
+
 	// Write the target
 	node->target->accept(*this);
 
 	// Write the index
-	cppGen_->write('[');
+	cppGen_->write(isArray ? ", " : "[");
 	node->index->accept(*this);
-	cppGen_->write(']');
+	cppGen_->write(isArray ? ')' : ']');
 }
 
 void FunctionGenerator::visit(ExprStmt* node) {
@@ -242,8 +449,9 @@ void FunctionGenerator::visit(ExprStmt* node) {
 void FunctionGenerator::visit(VarDeclStmt* node) {
 	if (isGlobalFunction_) return;
 
-	// Write the type
-	node->typeName->accept(*this);
+	// Write the type, inferred types are only known by the symbol
+	auto variable = static_cast<const VariableSymbol*>(symbolTable_->getDeclarationSymbol(node));
+	cppGen_->write(cppGen_->getReferenceTypeName(variable ? variable->resolver.type : nullptr));
 
 	// Write the name
 	cppGen_->write(' ');
@@ -267,9 +475,7 @@ void FunctionGenerator::visit(BlockStmt* node) {
 	cppGen_->indent();
 
 	for (const auto& stmt : node->statements) {
-		// Indent the statement
-		cppGen_->write<true>("");
-		stmt->accept(*this);
+		writeStatement(stmt.get());
 	}
 
 	cppGen_->unindent();
@@ -327,16 +533,46 @@ void FunctionGenerator::visit(ForStmt* node) {
 }
 
 void FunctionGenerator::visit(ForeachStmt* node) {
-	// foreach (x in y) -> for (auto x : y)
-	cppGen_->write("for (auto ");
-	node->variable->accept(*this);
+	// foreach (x in y) -> an index loop over a copy of the array handle
+	// The body cannot swap the array from under the loop, so the loop condition is the only bounds check
+	// and elements are accessed unchecked, by reference
+	auto suffix = std::to_string(foreachDepth_);
+	auto array = "__mrkforeach" + suffix;
+	auto index = "__mrkindex" + suffix;
+	auto count = "__mrkcount" + suffix;
+
+	cppGen_->writeLine<false>('{');
+	cppGen_->indent();
 
-	cppGen_->write(" : ");
+	cppGen_->write<true>("auto ", array, " = ");
 	node->collection->accept(*this);
-	cppGen_->writeLine(")");
+	cppGen_->writeLine<false>(';');
+
+	cppGen_->writeLine("for (size_t ", index, " = 0, ", count, " = ", array, ".length(); ", index, " < ", count, "; ", index, "++)");
+	cppGen_->writeLine('{');
+	cppGen_->indent();
+
+	// Bind the element, copied only when it converts to the variable type
+	if (auto variable = static_cast<const VariableSymbol*>(symbolTable_->getDeclarationSymbol(node->variable.get()))) {
+		auto typeSystem = symbolTable_->getTypeSystem();
+		auto collectionType = typeSystem->getSymbolType(symbolTable_->getNodeResolvedSymbol(node->collection.get()));
+		bool byReference = variable->resolver.type == typeSystem->getArrayElementType(collectionType);
+
+		cppGen_->write<true>(cppGen_->getReferenceTypeName(variable->resolver.type), byReference ? "& " : " ");
+		node->variable->name->accept(*this);
+		cppGen_->writeLine<false>(" = ", array, '[', index, "];");
+	}
 
 	// Write the body
+	foreachDepth_++;
 	node->body->accept(*this);
+	foreachDepth_--;
+
+	cppGen_->unindent();
+	cppGen_->writeLine('}');
+
+	cppGen_->unindent();
+	cppGen_->writeLine('}');
 }
 
 void FunctionGenerator::visit(WhileStmt* node) {
@@ -352,14 +588,16 @@ void FunctionGenerator::visit(WhileStmt* node) {
 void FunctionGenerator::visit(LangBlockStmt* node) {
 	// For now, keep cpp blocks as is
 	if (node->language == "__cpp") {
-		const auto& blocks = symbolTable_->getRigidLanguageBlocks();
-		if (blocks.find(node) == blocks.end()) { // Not a rigid block
-			cppGen_->writeLine(node->rawCode);
+		if (!symbolTable_->isRigidLanguageBlock(node)) {
+			cppGen_->writeLine<false>(node->rawCode);
 		}
 	}
 }
 
 void FunctionGenerator::visit(AccessModifierStmt* node) {
+	// Modifiers of global declarations, those are generated on their own
+	if (isGlobalFunction_) return;
+
 	// Write the modifiers
 	for (const auto& mod : node->modifiers) {
 		cppGen_->write(mod.lexeme, ' ');
@@ -60,7 +60,25 @@ private:
 	const TypeSymbol* currentFunctionEnclosingType_;
 	bool isGlobalFunction_;
 
+	/// Visiting a name qualified by a namespace or type path, written without member access
+	bool qualified_;
+
+	/// The last statement written only prefixes the next one
+	bool prefixed_;
+
+	/// Foreach loops enclosing the current statement, names their locals apart
+	uint32_t foreachDepth_;
+
 	void generateGlobalFunctionBody(const FunctionSymbol* function);
+
+	/// Write a statement on its own lines, preceded by its #line directive
+	void writeStatement(StmtNode* node);
+
+	/// Write the folded value of an expression, false if it is not constant
+	bool writeConstant(const ExprNode* node);
+
+	/// Write a call to an instance method, directly when its target is known, false if it is not one
+	bool writeInstanceCall(CallExpr* node);
 };
 
 MRK_NS_END
\ No newline at end of file
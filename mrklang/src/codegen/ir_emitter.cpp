@@ -0,0 +1,207 @@
+#include "ir_emitter.h"
+#include "code_generator.h"
+#include "lexer/token_lookup.h"
+
+#include <unordered_set>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace ir;
+
+IrEmitter::IrEmitter(CodeGenerator* cppGen, const Function* function)
+	: cppGen_(cppGen), function_(function), constants_(function->valueTypes.size(), nullptr), source_(nullptr) {}
+
+void IrEmitter::generateFunctionBody() {
+	declareLocals();
+
+	// Only blocks jumped to from anywhere but the block before them need a label
+	std::unordered_set<BlockId> labels;
+	for (BlockId block = 0; block < function_->blocks.size(); block++) {
+		const auto& terminator = function_->blocks[block].getTerminator();
+		if (terminator.opcode == Opcode::JUMP && terminator.target != block + 1) {
+			labels.insert(terminator.target);
+		}
+		else if (terminator.opcode == Opcode::BRANCH) {
+			if (terminator.target != block + 1) {
+				labels.insert(terminator.target);
+			}
+
+			if (terminator.elseTarget != block + 1) {
+				labels.insert(terminator.elseTarget);
+			}
+		}
+	}
+
+	for (BlockId block = 0; block < function_->blocks.size(); block++) {
+		if (labels.contains(block)) {
+			cppGen_->unindent();
+			cppGen_->writeLine(getLabel(block), ":;");
+			cppGen_->indent();
+		}
+
+		for (const auto& instruction : function_->blocks[block].instructions) {
+			writeInstruction(instruction, block + 1);
+		}
+	}
+}
+
+void IrEmitter::declareLocals() {
+	// Parameters keep their names, copies of inlined locals are numbered apart
+	std::unordered_set<Str> names;
+	for (const auto& [_, parameter] : function_->symbol->parameters) {
+		names.insert(cppGen_->getMappedName(parameter.get()));
+	}
+
+	for (SlotId slot = 0; slot < function_->slots.size(); slot++) {
+		const auto& info = function_->slots[slot];
+		if (info.isParameter) {
+			slotNames_.push_back(cppGen_->getMappedName(info.symbol));
+			continue;
+		}
+
+		auto name = info.symbol ? cppGen_->getMappedName(info.symbol) : utils::concat("__mrktemp", slot);
+		for (int suffix = 2; names.contains(name); suffix++) {
+			name = utils::concat(cppGen_->getMappedName(info.symbol), '_', suffix);
+		}
+
+		names.insert(name);
+		slotNames_.push_back(name);
+
+		cppGen_->writeLine(cppGen_->getReferenceTypeName(info.type), ' ', name, "{};");
+	}
+
+	// Constants are written inline, everything else gets a variable
+	Vec<bool> used(function_->valueTypes.size(), false);
+	for (const auto& block : function_->blocks) {
+		for (const auto& instruction : block.instructions) {
+			if (instruction.opcode == Opcode::CONSTANT) {
+				constants_[instruction.result] = &instruction.constant;
+			}
+			else if (instruction.result != NO_VALUE) {
+				used[instruction.result] = true;
+			}
+		}
+	}
+
+	for (ValueId value = 1; value < used.size(); value++) {
+		if (used[value]) {
+			cppGen_->writeLine(cppGen_->getReferenceTypeName(function_->valueTypes[value]), ' ', getValue(value), ';');
+		}
+	}
+}
+
+void IrEmitter::writeInstruction(const Instruction& instruction, BlockId nextBlock) {
+	if (instruction.opcode == Opcode::CONSTANT) {
+		return;
+	}
+
+	// Statements on the same line, such as the parts of a for loop, share their directive
+	if (instruction.source && instruction.source != source_) {
+		source_ = instruction.source;
+
+		auto directive = cppGen_->getLineDirective(source_);
+		if (directive != lineDirective_) {
+			cppGen_->write(directive);
+			lineDirective_ = Move(directive);
+		}
+	}
+
+	const auto& operators = TokenLookup::operators();
+	auto result = instruction.result != NO_VALUE ? utils::concat(getValue(instruction.result), " = ") : Str();
+
+	switch (instruction.opcode) {
+		case Opcode::LOAD:
+			cppGen_->writeLine(result, slotNames_[instruction.slot], ';');
+			break;
+
+		case Opcode::STORE:
+			cppGen_->writeLine(slotNames_[instruction.slot], " = ", getValue(instruction.operands[0]), ';');
+			break;
+
+		case Opcode::LOAD_FIELD:
+			cppGen_->writeLine(result, getField(instruction.symbol), ';');
+			break;
+
+		case Opcode::STORE_FIELD:
+			cppGen_->writeLine(getField(instruction.symbol), " = ", getValue(instruction.operands[0]), ';');
+			break;
+
+		case Opcode::CONVERT:
+			cppGen_->writeLine(result, "static_cast<", cppGen_->getReferenceTypeName(instruction.type), ">(", getValue(instruction.operands[0]), ");");
+			break;
+
+		case Opcode::UNARY:
+			cppGen_->writeLine(result, operators.at(instruction.op), '(', getValue(instruction.operands[0]), ");");
+			break;
+
+		case Opcode::BINARY:
+			cppGen_->writeLine(result, getValue(instruction.operands[0]), ' ', operators.at(instruction.op), ' ', getValue(instruction.operands[1]), ';');
+			break;
+
+		case Opcode::CALL: {
+			auto function = static_cast<const FunctionSymbol*>(instruction.symbol);
+			auto owner = function_->symbolTable->findAncestorOfKind(function, SymbolKind::TYPE);
+			auto arguments = utils::formatCollection(instruction.operands, ", ", [this](ValueId value) { return getValue(value); });
+
+			cppGen_->writeLine(result, cppGen_->getMappedName(owner), "::", cppGen_->getMappedName(function), '(', arguments, ");");
+			break;
+		}
+
+		case Opcode::JUMP:
+			if (instruction.target != nextBlock) {
+				cppGen_->writeLine("goto ", getLabel(instruction.target), ';');
+			}
+			break;
+
+		case Opcode::BRANCH: {
+			auto condition = getValue(instruction.operands[0]);
+			if (instruction.target == nextBlock) {
+				cppGen_->writeLine("if (!", condition, ") goto ", getLabel(instruction.elseTarget), ';');
+				break;
+			}
+
+			cppGen_->writeLine("if (", condition, ") goto ", getLabel(instruction.target), ';');
+			if (instruction.elseTarget != nextBlock) {
+				cppGen_->writeLine("goto ", getLabel(instruction.elseTarget), ';');
+			}
+			break;
+		}
+
+		case Opcode::RETURN:
+			if (!instruction.operands.empty()) {
+				cppGen_->writeLine("return ", getValue(instruction.operands[0]), ';');
+			}
+			else {
+				// Falling off the end of a function returning a value, the result is unspecified
+				auto voidType = function_->symbolTable->getTypeSystem()->getBuiltinType(TypeKind::VOID);
+				cppGen_->writeLine(function_->symbol->resolver.returnType == voidType ? "return;" : "return {};");
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+Str IrEmitter::getValue(ValueId value) const {
+	if (auto constant = constants_[value]) {
+		return CodeGenerator::getConstantLiteral(*constant);
+	}
+
+	return utils::concat("__mrkv", value);
+}
+
+Str IrEmitter::getField(const Symbol* field) const {
+	auto name = cppGen_->getMappedName(field);
+	if (detail::isSTATIC(field->accessModifier)) {
+		return utils::concat("MRK_STATIC_MEMBER(", cppGen_->getMappedName(field->parent), ", ", name, ')');
+	}
+
+	return utils::concat("MRK_INSTANCE_MEMBER(", name, ')');
+}
+
+Str IrEmitter::getLabel(BlockId block) {
+	return utils::concat("__mrkblock", block);
+}
+
+MRK_NS_END
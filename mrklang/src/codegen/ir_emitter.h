@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common/types.h"
+#include "ir/ir.h"
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace semantic;
+
+class CodeGenerator;
+
+/// Generates the body of a function from its optimized IR, in place of the FunctionGenerator
+/// Slots and values are declared upfront so blocks can jump over each other, constants are written where they are used
+class IrEmitter {
+public:
+	IrEmitter(CodeGenerator* cppGen, const ir::Function* function);
+
+	void generateFunctionBody();
+
+private:
+	CodeGenerator* cppGen_;
+	const ir::Function* function_;
+	Vec<Str> slotNames_;
+	Vec<const ConstantValue*> constants_;
+
+	/// Statement of the last instruction written, and the last #line directive
+	const ast::Node* source_;
+	Str lineDirective_;
+
+	void declareLocals();
+	void writeInstruction(const ir::Instruction& instruction, ir::BlockId nextBlock);
+
+	Str getValue(ir::ValueId value) const;
+	Str getField(const Symbol* field) const;
+	static Str getLabel(ir::BlockId block);
+};
+
+MRK_NS_END
@@ -0,0 +1,164 @@
+#include "layout_engine.h"
+#include "common/declspecs.h"
+
+#include <algorithm>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+static const TypeLayout EMPTY_LAYOUT{ {}, 0, 1, 1 };
+
+static uint32_t alignTo(uint32_t offset, uint32_t alignment) {
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+static size_t getDeclarationIndex(const Symbol* symbol) {
+	return symbol->declNode ? symbol->declNode->startToken.position.index : 0;
+}
+
+bool LayoutTarget::fromName(const Str& name, LayoutTarget& target) {
+	if (name == "x64") {
+		target = x64();
+		return true;
+	}
+
+	if (name == "x86") {
+		target = x86();
+		return true;
+	}
+
+	return false;
+}
+
+LayoutEngine::LayoutEngine(const SymbolTable* symbolTable, const ClassHierarchy* classHierarchy, const LayoutTarget& target)
+	: symbolTable_(symbolTable), classHierarchy_(classHierarchy), target_(target) {
+	for (auto type : classHierarchy_->getTypes()) {
+		layoutType(type);
+	}
+}
+
+const TypeLayout& LayoutEngine::getLayout(const TypeSymbol* type) const {
+	auto it = layouts_.find(type);
+	return it != layouts_.end() ? it->second : EMPTY_LAYOUT;
+}
+
+uint32_t LayoutEngine::getFieldOffset(const VariableSymbol* field) const {
+	auto it = fieldOffsets_.find(field);
+	return it != fieldOffsets_.end() ? it->second : 0;
+}
+
+const TypeLayout& LayoutEngine::layoutType(const TypeSymbol* type) {
+	auto [it, inserted] = layouts_.try_emplace(type, EMPTY_LAYOUT);
+
+	// Taken before laying out the types this one depends on, which insert into the map
+	auto& slot = it->second;
+	if (!inserted) {
+		// Laid out already, or a value type embedding itself which cannot be generated anyway
+		return slot;
+	}
+
+	auto typeSystem = symbolTable_->getTypeSystem();
+	TypeLayout layout{ {}, 0, 0, 1 };
+
+	TypeKind kind;
+	if (typeSystem->isPrimitiveType(type, &kind)) {
+		switch (kind) {
+			case TypeKind::STRING:
+				layout.dataSize = target_.stringSize;
+				layout.alignment = target_.pointerSize;
+				break;
+
+			case TypeKind::OBJECT:
+			case TypeKind::PTR:
+				layout.dataSize = target_.pointerSize;
+				layout.alignment = target_.pointerSize;
+				break;
+
+			default:
+				layout.dataSize = static_cast<uint32_t>(typeSystem->getTypeSize(type));
+				layout.alignment = std::max(layout.dataSize, 1u);
+				break;
+		}
+	}
+	else if (type->kind == SymbolKind::ENUM) {
+		// Enums hold their underlying value
+		auto [size, alignment] = getStorage(typeSystem->getEnumUnderlyingType(type));
+		layout.dataSize = size;
+		layout.alignment = alignment;
+	}
+	else {
+		uint32_t offset = 0;
+
+		if (auto baseClass = classHierarchy_->getBaseClass(type)) {
+			const auto& baseLayout = layoutType(baseClass);
+
+			// An empty base takes no room
+			if (baseLayout.dataSize > 0) {
+				offset = baseLayout.size;
+			}
+
+			layout.alignment = baseLayout.alignment;
+		}
+
+		if (classHierarchy_->isVTableRoot(type)) {
+			offset = alignTo(offset, target_.pointerSize) + target_.pointerSize;
+			layout.alignment = std::max(layout.alignment, target_.pointerSize);
+		}
+
+		struct PendingField {
+			const VariableSymbol* field;
+			uint32_t size;
+			uint32_t alignment;
+		};
+
+		// Members are unordered, start from the declaration order
+		Vec<PendingField> fields;
+		for (const auto& [_, member] : type->members) {
+			if (member->kind != SymbolKind::VARIABLE || detail::isSTATIC(member->accessModifier)) {
+				continue;
+			}
+
+			auto field = static_cast<const VariableSymbol*>(member.get());
+			auto [size, alignment] = getStorage(field->resolver.type);
+			fields.push_back({ field, size, alignment });
+		}
+
+		std::sort(fields.begin(), fields.end(), [](const auto& a, const auto& b) {
+			return getDeclarationIndex(a.field) < getDeclarationIndex(b.field);
+		});
+
+		if (type->declSpec != DECLSPEC_SEQUENTIAL) {
+			std::stable_sort(fields.begin(), fields.end(), [](const auto& a, const auto& b) {
+				return a.alignment > b.alignment;
+			});
+		}
+
+		for (const auto& [field, size, alignment] : fields) {
+			offset = alignTo(offset, alignment);
+			layout.fields.push_back({ field, offset, size });
+			layout.alignment = std::max(layout.alignment, alignment);
+
+			fieldOffsets_[field] = offset;
+			offset += size;
+		}
+
+		layout.dataSize = offset;
+	}
+
+	// Like any C++ object, an empty one still takes a byte
+	layout.size = std::max(alignTo(layout.dataSize, layout.alignment), 1u);
+
+	types_.push_back(type);
+	return slot = Move(layout);
+}
+
+std::pair<uint32_t, uint32_t> LayoutEngine::getStorage(const TypeSymbol* type) {
+	if (!type || detail::hasFlag(type->kind, SymbolKind::CLASS | SymbolKind::INTERFACE) ||
+		symbolTable_->getTypeSystem()->getArrayElementType(type)) {
+		return { target_.pointerSize, target_.pointerSize };
+	}
+
+	const auto& layout = layoutType(type);
+	return { layout.size, layout.alignment };
+}
+
+MRK_NS_END
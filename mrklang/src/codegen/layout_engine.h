@@ -0,0 +1,73 @@
+#pragma once
+
+#include "common/types.h"
+#include "semantic/symbol_table.h"
+#include "class_hierarchy.h"
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace semantic;
+
+struct FieldLayout {
+	const VariableSymbol* field;
+	uint32_t offset;
+	uint32_t size;
+};
+
+/// Storage of an instance of a type, shared by the generated struct and the metadata
+struct TypeLayout {
+	/// Instance fields declared by the type itself, in storage order
+	Vec<FieldLayout> fields;
+
+	/// End of the last field, anything up to size is trailing padding
+	uint32_t dataSize;
+	uint32_t size;
+	uint32_t alignment;
+};
+
+/// Sizes of the runtime's platform that the layout depends on
+struct LayoutTarget {
+	uint32_t pointerSize;
+
+	/// Strings are stored inline, as large as the runtime's String
+	uint32_t stringSize;
+
+	static constexpr LayoutTarget x64() { return { 8, 32 }; }
+	static constexpr LayoutTarget x86() { return { 4, 24 }; }
+
+	/// Target by name, x64 or x86, false if there is no such target
+	static bool fromName(const Str& name, LayoutTarget& target);
+};
+
+/// Lays out the instance fields of every type
+/// Fields follow the base class and the vtable pointer, ordered by decreasing alignment so none of them
+/// needs padding, unless the type is declared SEQUENTIAL and keeps its declaration order
+class LayoutEngine {
+public:
+	LayoutEngine(const SymbolTable* symbolTable, const ClassHierarchy* classHierarchy, const LayoutTarget& target);
+
+	const LayoutTarget& getTarget() const { return target_; }
+
+	/// Every type, after its base class and the value types it embeds
+	const Vec<const TypeSymbol*>& getTypes() const { return types_; }
+
+	const TypeLayout& getLayout(const TypeSymbol* type) const;
+
+	/// Offset of an instance field from the start of its object, 0 for static fields
+	uint32_t getFieldOffset(const VariableSymbol* field) const;
+
+private:
+	const SymbolTable* symbolTable_;
+	const ClassHierarchy* classHierarchy_;
+	LayoutTarget target_;
+	Vec<const TypeSymbol*> types_;
+	Dict<const TypeSymbol*, TypeLayout> layouts_;
+	Dict<const VariableSymbol*, uint32_t> fieldOffsets_;
+
+	const TypeLayout& layoutType(const TypeSymbol* type);
+
+	/// Size and alignment taken by a field of the given type, references and arrays are a pointer
+	std::pair<uint32_t, uint32_t> getStorage(const TypeSymbol* type);
+};
+
+MRK_NS_END
@@ -1,5 +1,6 @@
 #include "metadata_writer.h"
 #include "common/logging.h"
+#include "common/declspecs.h"
 #include "mrk-metadata.h"
 
 #include <algorithm>
@@ -14,18 +15,46 @@ MRK_NS_BEGIN_MODULE(codegen)
 
 using namespace runtime::metadata;
 
-MetadataWriter::MetadataWriter(const SymbolTable* symbolTable) : symbolTable_(symbolTable) {}
+MetadataWriter::MetadataWriter(const SymbolTable* symbolTable)
+	: symbolTable_(symbolTable), stream_(nullptr), stripUnreachable_(false), target_(LayoutTarget::x64()) {}
 
 UniquePtr<CompilerMetadataRegistration> MetadataWriter::writeMetadataFile(const Str& path) {
-	file_.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+	std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
 
-	if (!file_.is_open()) {
+	if (!file.is_open()) {
 		MRK_ERROR("Failed to open metadata file: {}", path);
 		return nullptr;
 	}
 
+	auto registration = writeMetadata(file);
+	file.close();
+
+	MRK_INFO("Metadata written to {}", path);
+	return registration;
+}
+
+UniquePtr<CompilerMetadataRegistration> MetadataWriter::writeMetadata(std::ostream& stream) {
+	stream_ = &stream;
 	registration_ = MakeUnique<CompilerMetadataRegistration, false>();
 
+	// Same layout the generated types are given
+	classHierarchy_ = MakeUnique<ClassHierarchy>(symbolTable_);
+	layoutEngine_ = MakeUnique<LayoutEngine>(symbolTable_, classHierarchy_.get(), target_);
+
+	reachability_ = stripUnreachable_ ? MakeUnique<ReachabilityAnalysis>(symbolTable_, classHierarchy_.get()) : nullptr;
+	if (reachability_) {
+		MRK_INFO("{} types, functions and fields are reachable", reachability_->getReachableCount());
+	}
+
+	types_.clear();
+	typeHandles_.clear();
+	for (auto type : symbolTable_->getTypes()) {
+		if (isEmitted(type)) {
+			types_.push_back(type);
+			typeHandles_[type] = static_cast<TypeDefinitionHandle>(types_.size());
+		}
+	}
+
 	generateMetadataHeader();
 	generateStringTable();
 	generateTypeDefintions();
@@ -36,22 +65,29 @@ UniquePtr<CompilerMetadataRegistration> MetadataWriter::writeMetadataFile(const
 	generateImageDefinition();
 	generateReferenceTables();
 
-	file_.close();
-
-	MRK_INFO("Metadata written to {}", path);
+	stream_ = nullptr;
 
 	// Good time having you around, registration
 	return Move(registration_);
 }
 
+bool MetadataWriter::isEmitted(const Symbol* symbol) const {
+	return !reachability_ || reachability_->isReachable(symbol);
+}
+
+TypeDefinitionHandle MetadataWriter::getTypeHandle(const TypeSymbol* type) const {
+	auto it = typeHandles_.find(type);
+	return it != typeHandles_.end() ? it->second : static_cast<TypeDefinitionHandle>(types_.size() + 1);
+}
+
 void MetadataWriter::generateMetadataHeader() {
 	// 15/3/2025: Version 1
 	const uint32_t version = METADATA_VERSION;
-	file_.write(CAST(version), sizeof(uint32_t));
+	stream_->write(CAST(version), sizeof(uint32_t));
 
 	// Magic
 	const uint32_t magic = METADATA_MAGIC;
-	file_.write(CAST(magic), sizeof(uint32_t));
+	stream_->write(CAST(magic), sizeof(uint32_t));
 }
 
 void MetadataWriter::generateStringTable() {
@@ -62,7 +98,7 @@ void MetadataWriter::generateStringTable() {
 	set.insert("mrklang_runtime");
 
 	// Types and namespaces
-	for (const auto& type : symbolTable_->getTypes()) {
+	for (const auto& type : types_) {
 		auto pos = type->qualifiedName.find_last_of("::");
 		if (pos != Str::npos && pos > 1) {
 			// Extract namespace
@@ -73,13 +109,19 @@ void MetadataWriter::generateStringTable() {
 		set.insert(type->qualifiedName);
 
 		// Add member names
-		for (const auto& [name, _] : type->members) {
-			set.insert(name);
+		for (const auto& [name, member] : type->members) {
+			if (isEmitted(member.get())) {
+				set.insert(name);
+			}
 		}
 	}
 
 	// Add function names
 	for (const auto* func : symbolTable_->getFunctions()) {
+		if (!isEmitted(func)) {
+			continue;
+		}
+
 		set.insert(func->name);
 
 		// Add parameter names
@@ -90,6 +132,10 @@ void MetadataWriter::generateStringTable() {
 
 	// Add variable names
 	for (const auto* var : symbolTable_->getVariables()) {
+		if (!isEmitted(var)) {
+			continue;
+		}
+
 		set.insert(var->name);
 		set.insert(var->qualifiedName);
 	}
@@ -109,11 +155,11 @@ void MetadataWriter::generateStringTable() {
 	}
 
 	// Write string table size
-	file_.write(CAST(stringTableSize), sizeof(uint32_t));
+	stream_->write(CAST(stringTableSize), sizeof(uint32_t));
 
 	// Write count
 	const uint32_t stringCount = strings.size();
-	file_.write(CAST(stringCount), sizeof(uint32_t));
+	stream_->write(CAST(stringCount), sizeof(uint32_t));
 
 	// Write string data
 	uint32_t currentOffset = 0;
@@ -124,20 +170,20 @@ void MetadataWriter::generateStringTable() {
 		offsets[i] = currentOffset;
 
 		// Write the string with null terminator and update offset
-		file_.write(str.c_str(), str.size() + 1);
+		stream_->write(str.c_str(), str.size() + 1);
 		currentOffset += str.size() + 1;
 	}
 
 	// Write all offsets
-	file_.write(CAST_PTR(offsets.data()), stringCount * sizeof(uint32_t));
+	stream_->write(CAST_PTR(offsets.data()), stringCount * sizeof(uint32_t));
 }
 
 void MetadataWriter::generateTypeDefintions() {
-	const auto& types = symbolTable_->getTypes();
+	const auto& types = types_;
 
 	// Write type count
 	uint32_t typeCount = static_cast<uint32_t>(types.size());
-	file_.write(CAST(typeCount), sizeof(uint32_t));
+	stream_->write(CAST(typeCount), sizeof(uint32_t));
 
 	// First pass: Calculate field and method start positions for each type
 	Vec<uint32_t> fieldStarts(typeCount, 0);
@@ -158,6 +204,10 @@ void MetadataWriter::generateTypeDefintions() {
 
 		// Count members to update indices for the next type
 		for (const auto& [_, member] : type->members) {
+			if (!isEmitted(member.get())) {
+				continue;
+			}
+
 			if (member->kind == SymbolKind::VARIABLE) {
 				fieldIndex++;
 			}
@@ -196,10 +246,7 @@ void MetadataWriter::generateTypeDefintions() {
 		if (!type->resolver.baseTypes.empty()) {
 			// Use first base type as parent
 			const TypeSymbol* baseType = type->resolver.baseTypes[0];
-			typeDef.parentHandle = static_cast<uint32_t>(
-				std::distance(types.begin(),
-					std::find(types.begin(), types.end(), baseType)) + 1
-				);
+			typeDef.parentHandle = getTypeHandle(baseType);
 		}
 		else {
 			typeDef.parentHandle = 0; // No parent
@@ -210,6 +257,10 @@ void MetadataWriter::generateTypeDefintions() {
 		uint32_t methodCount = 0;
 
 		for (const auto& [_, member] : type->members) {
+			if (!isEmitted(member.get())) {
+				continue;
+			}
+
 			if (member->kind == SymbolKind::VARIABLE) {
 				fieldCount++;
 			}
@@ -234,11 +285,13 @@ void MetadataWriter::generateTypeDefintions() {
 			static_cast<TypeFlags>(1) :
 			static_cast<TypeFlags>(0);
 
+		typeDef.size = layoutEngine_->getLayout(type).size;
+
 		// Use index+1 as token (1-based)
 		typeDef.token = static_cast<uint32_t>(i + 1);
 
 		// Write type definition
-		file_.write(CAST(typeDef), sizeof(TypeDefinition));
+		stream_->write(CAST(typeDef), sizeof(TypeDefinition));
 
 		// Register type definition
 		registration_->typeTokenMap[type] = typeDef.token;
@@ -246,25 +299,25 @@ void MetadataWriter::generateTypeDefintions() {
 }
 
 void MetadataWriter::generateFieldDefinitions() {
-	const auto& types = symbolTable_->getTypes();
+	const auto& types = types_;
 
 	uint32_t totalFields = 0;
 	for (const auto& type : types) {
 		for (const auto& [_, member] : type->members) {
-			if (member->kind == SymbolKind::VARIABLE) {
+			if (member->kind == SymbolKind::VARIABLE && isEmitted(member.get())) {
 				totalFields++;
 			}
 		}
 	}
 
 	// Write field count
-	file_.write(CAST(totalFields), sizeof(uint32_t));
+	stream_->write(CAST(totalFields), sizeof(uint32_t));
 
 	// Types again..
 	uint32_t fieldIndex = 0;
 	for (const auto& type : types) {
 		for (const auto& [_, member] : type->members) {
-			if (member->kind == SymbolKind::VARIABLE) {
+			if (member->kind == SymbolKind::VARIABLE && isEmitted(member.get())) {
 				const auto* field = static_cast<const VariableSymbol*>(member.get());
 
 				// Create FieldDefinition
@@ -274,17 +327,15 @@ void MetadataWriter::generateFieldDefinitions() {
 				fieldDef.name = stringHandleMap_[field->name];
 
 				// Set type handle
-				fieldDef.typeHandle = static_cast<uint32_t>(
-					std::distance(symbolTable_->getTypes().begin(),
-						std::find(symbolTable_->getTypes().begin(), symbolTable_->getTypes().end(), field->resolver.type)) + 1
-					);
+				fieldDef.typeHandle = getTypeHandle(field->resolver.type);
 
 				// Flags
 				fieldDef.flags = static_cast<uint32_t>(field->accessModifier);
+				fieldDef.offset = layoutEngine_->getFieldOffset(field);
 				fieldDef.token = ++fieldIndex;
 
 				// Write field definition
-				file_.write(CAST(fieldDef), sizeof(FieldDefinition));
+				stream_->write(CAST(fieldDef), sizeof(FieldDefinition));
 
 				// Register field definition
 				registration_->fieldTokenMap[field] = fieldDef.token;
@@ -294,18 +345,18 @@ void MetadataWriter::generateFieldDefinitions() {
 }
 
 void MetadataWriter::generateMethodDefinitions() {
-	const auto& types = symbolTable_->getTypes();
+	const auto& types = types_;
 
 	uint32_t totalMethods = 0;
 	for (const auto& type : types) {
 		for (const auto& [_, member] : type->members) {
-			if (member->kind == SymbolKind::FUNCTION) {
+			if (member->kind == SymbolKind::FUNCTION && isEmitted(member.get())) {
 				totalMethods++;
 			}
 		}
 	}
 
-	file_.write(CAST(totalMethods), sizeof(uint32_t));
+	stream_->write(CAST(totalMethods), sizeof(uint32_t));
 
 	// Track parameter index for mapping methods to their parameters
 	uint32_t parameterStartIndex = 0;
@@ -313,7 +364,7 @@ void MetadataWriter::generateMethodDefinitions() {
 	uint32_t methodIndex = 0;
 	for (const auto& type : types) {
 		for (const auto& [_, member] : type->members) {
-			if (member->kind == SymbolKind::FUNCTION) {
+			if (member->kind == SymbolKind::FUNCTION && isEmitted(member.get())) {
 				const auto* func = static_cast<const FunctionSymbol*>(member.get());
 
 				// Generate MethodDefinition
@@ -323,10 +374,7 @@ void MetadataWriter::generateMethodDefinitions() {
 				methodDef.name = stringHandleMap_[func->name];
 
 				// Find return type handle (1-based index in the type table)
-				methodDef.returnTypeHandle = static_cast<uint32_t>(
-					std::distance(symbolTable_->getTypes().begin(),
-						std::find(symbolTable_->getTypes().begin(), symbolTable_->getTypes().end(), func->resolver.returnType)) + 1
-					);
+				methodDef.returnTypeHandle = getTypeHandle(func->resolver.returnType);
 
 				// Set parameter info
 				methodDef.parameterStart = parameterStartIndex;
@@ -337,13 +385,13 @@ void MetadataWriter::generateMethodDefinitions() {
 
 				// Set flags based on access modifiers
 				methodDef.flags = static_cast<uint32_t>(func->accessModifier);
-				methodDef.implFlags = 0; // Default implementation flags for now
+				methodDef.implFlags = func->declSpec == DECLSPEC_NATIVE ? METHOD_IMPL_INTERNAL_CALL : 0;
 
 				// Set token based on function index (1-based)
 				methodDef.token = ++methodIndex;
 
 				// Write method definition
-				file_.write(CAST(methodDef), sizeof(MethodDefinition));
+				stream_->write(CAST(methodDef), sizeof(MethodDefinition));
 
 				// Register method definition
 				registration_->methodTokenMap[func] = methodDef.token;
@@ -356,17 +404,19 @@ void MetadataWriter::generateParameterDefinitions() {
 	// Count total parameters across all functions
 	uint32_t totalParams = 0;
 	for (const auto* func : symbolTable_->getFunctions()) {
-		totalParams += static_cast<uint32_t>(func->parameters.size());
+		if (isEmitted(func)) {
+			totalParams += static_cast<uint32_t>(func->parameters.size());
+		}
 	}
 
 	// Write parameter count
-	file_.write(CAST(totalParams), sizeof(uint32_t));
+	stream_->write(CAST(totalParams), sizeof(uint32_t));
 
 	// Start from types again
-	const auto& types = symbolTable_->getTypes();
+	const auto& types = types_;
 	for (const auto& type : types) {
 		for (const auto& [_, member] : type->members) {
-			if (member->kind == SymbolKind::FUNCTION) {
+			if (member->kind == SymbolKind::FUNCTION && isEmitted(member.get())) {
 				const auto* func = static_cast<const FunctionSymbol*>(member.get());
 				for (const auto& [paramName, param] : func->parameters) {
 					// Create ParameterDefinition
@@ -376,16 +426,13 @@ void MetadataWriter::generateParameterDefinitions() {
 					paramDef.name = stringHandleMap_[paramName];
 
 					// Find type handle (1-based index in the type table)
-					paramDef.typeHandle = static_cast<uint32_t>(
-						std::distance(symbolTable_->getTypes().begin(),
-							std::find(symbolTable_->getTypes().begin(), symbolTable_->getTypes().end(), param->resolver.type)) + 1
-						);
+					paramDef.typeHandle = getTypeHandle(param->resolver.type);
 
 					// Set flags
 					paramDef.flags = 0; // TODO: impl params, etc
 
 					// Write parameter definition
-					file_.write(CAST(paramDef), sizeof(ParameterDefinition));
+					stream_->write(CAST(paramDef), sizeof(ParameterDefinition));
 				}
 			}
 		}
@@ -395,7 +442,7 @@ void MetadataWriter::generateParameterDefinitions() {
 void MetadataWriter::generateAssemblyDefinition() {
 	// Create a single assembly definition for the current compilation
 	const uint32_t assemblyCount = 1;
-	file_.write(CAST(assemblyCount), sizeof(uint32_t));
+	stream_->write(CAST(assemblyCount), sizeof(uint32_t));
 
 	AssemblyDefinition assemblyDef{};
 
@@ -407,13 +454,13 @@ void MetadataWriter::generateAssemblyDefinition() {
 	assemblyDef.imageIndex = 0;
 	assemblyDef.flags = 0;
 
-	file_.write(CAST(assemblyDef), sizeof(AssemblyDefinition));
+	stream_->write(CAST(assemblyDef), sizeof(AssemblyDefinition));
 }
 
 void MetadataWriter::generateImageDefinition() {
 	// Create a single image definition
 	const uint32_t imageCount = 1;
-	file_.write(CAST(imageCount), sizeof(uint32_t));
+	stream_->write(CAST(imageCount), sizeof(uint32_t));
 
 	ImageDefinition imageDef{};
 
@@ -421,24 +468,14 @@ void MetadataWriter::generateImageDefinition() {
 
 	// Set type information
 	imageDef.typeStart = 0;
-	imageDef.typeCount = static_cast<uint32_t>(symbolTable_->getTypes().size());
+	imageDef.typeCount = static_cast<uint32_t>(types_.size());
 
-	// Find entry point token if available
+	// Find entry point token if available, methods are numbered by their enclosing type
 	auto globalFunction = symbolTable_->getGlobalFunction();
-	if (globalFunction) {
-		auto it = std::find(symbolTable_->getFunctions().begin(), symbolTable_->getFunctions().end(), globalFunction);
-		if (it != symbolTable_->getFunctions().end()) {
-			imageDef.entryPointToken = static_cast<uint32_t>(std::distance(symbolTable_->getFunctions().begin(), it)) + 1;
-		}
-		else {
-			imageDef.entryPointToken = 0;
-		}
-	}
-	else {
-		imageDef.entryPointToken = 0;
-	}
+	auto entryPoint = globalFunction ? registration_->methodTokenMap.find(globalFunction) : registration_->methodTokenMap.end();
+	imageDef.entryPointToken = entryPoint != registration_->methodTokenMap.end() ? entryPoint->second : 0;
 
-	file_.write(CAST(imageDef), sizeof(ImageDefinition));
+	stream_->write(CAST(imageDef), sizeof(ImageDefinition));
 }
 
 void MetadataWriter::generateReferenceTables() {
@@ -450,7 +487,7 @@ void MetadataWriter::generateReferenceTables() {
 void MetadataWriter::generateInterfaceReferences() {
 	// Count total interface references
 	uint32_t totalInterfaces = 0;
-	for (const auto* type : symbolTable_->getTypes()) {
+	for (const auto* type : types_) {
 		// First base type is considered the parent, rest are interfaces
 		if (type->resolver.baseTypes.size() > 1) {
 			totalInterfaces += static_cast<uint32_t>(type->resolver.baseTypes.size() - 1);
@@ -458,13 +495,13 @@ void MetadataWriter::generateInterfaceReferences() {
 	}
 
 	// Write interface reference count
-	file_.write(CAST(totalInterfaces), sizeof(uint32_t));
+	stream_->write(CAST(totalInterfaces), sizeof(uint32_t));
 
 	// If no interfaces, we're done
 	if (totalInterfaces == 0) return;
 
 	// Generate interface references
-	for (const auto* type : symbolTable_->getTypes()) {
+	for (const auto* type : types_) {
 		if (type->resolver.baseTypes.size() <= 1) continue;
 
 		// Skip first base type (parent class)
@@ -472,13 +509,10 @@ void MetadataWriter::generateInterfaceReferences() {
 			const TypeSymbol* interfaceType = type->resolver.baseTypes[i];
 
 			// Find the interface's index in the type table (1-based)
-			TypeDefinitionHandle interfaceHandle = static_cast<uint32_t>(
-				std::distance(symbolTable_->getTypes().begin(),
-					std::find(symbolTable_->getTypes().begin(), symbolTable_->getTypes().end(), interfaceType)) + 1
-				);
+			TypeDefinitionHandle interfaceHandle = getTypeHandle(interfaceType);
 
 			// Write interface handle
-			file_.write(CAST(interfaceHandle), sizeof(TypeDefinitionHandle));
+			stream_->write(CAST(interfaceHandle), sizeof(TypeDefinitionHandle));
 		}
 	}
 }
@@ -486,13 +520,13 @@ void MetadataWriter::generateInterfaceReferences() {
 void MetadataWriter::generateNestedTypeReferences() {
 	// Empty for now
 	const uint32_t nestedTypeCount = 0;
-	file_.write(CAST(nestedTypeCount), sizeof(uint32_t));
+	stream_->write(CAST(nestedTypeCount), sizeof(uint32_t));
 }
 
 void MetadataWriter::generateGenericParamReferences() {
 	// Empty for now
 	const uint32_t genericParamCount = 0;
-	file_.write(CAST(genericParamCount), sizeof(uint32_t));
+	stream_->write(CAST(genericParamCount), sizeof(uint32_t));
 }
 
 MRK_NS_END
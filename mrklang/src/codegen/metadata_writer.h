@@ -3,6 +3,8 @@
 #include "common/types.h"
 #include "semantic/symbol_table.h"
 #include "mrk-metadata.h"
+#include "layout_engine.h"
+#include "reachability.h"
 
 #include <fstream>
 
@@ -16,14 +18,42 @@ using CompilerMetadataRegistration =
 
 class MetadataWriter {
 public:
+	static constexpr const char* METADATA_FILENAME = "runtime_metadata.mrkmeta";
+
 	MetadataWriter(const SymbolTable* symbolTable);
+
+	/// Leave out the types, functions and fields the program cannot reach, off by default
+	/// The generated code follows, it only emits what was given a token
+	void setStripUnreachable(bool strip) { stripUnreachable_ = strip; }
+
+	/// Platform the type sizes and field offsets are laid out for, x64 by default
+	void setTarget(const LayoutTarget& target) { target_ = target; }
+
 	UniquePtr<CompilerMetadataRegistration> writeMetadataFile(const Str& path);
 
+	/// Serialize the metadata image into a stream
+	UniquePtr<CompilerMetadataRegistration> writeMetadata(std::ostream& stream);
+
 private:
 	const SymbolTable* symbolTable_;
-	std::ofstream file_;
+	std::ostream* stream_;
+	bool stripUnreachable_;
+	LayoutTarget target_;
 	Dict<Str, uint32_t> stringHandleMap_;
 	UniquePtr<CompilerMetadataRegistration> registration_;
+	UniquePtr<ClassHierarchy> classHierarchy_;
+	UniquePtr<LayoutEngine> layoutEngine_;
+	UniquePtr<ReachabilityAnalysis> reachability_;
+
+	/// Types written to the metadata, a type's handle is its index + 1
+	Vec<const TypeSymbol*> types_;
+	Dict<const TypeSymbol*, runtime::metadata::TypeDefinitionHandle> typeHandles_;
+
+	/// False for symbols stripped as unreachable
+	bool isEmitted(const Symbol* symbol) const;
+
+	/// Past the end of the table for types without a definition, such as arrays
+	runtime::metadata::TypeDefinitionHandle getTypeHandle(const TypeSymbol* type) const;
 
 	void generateMetadataHeader();
 	void generateStringTable();
@@ -0,0 +1,137 @@
+#include "reachability.h"
+#include "common/declspecs.h"
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+static bool isRoot(const Symbol* symbol) {
+	return symbol->declSpec == DECLSPEC_NATIVE ||
+		symbol->declSpec == DECLSPEC_INJECT_GLOBAL ||
+		symbol->declSpec == DECLSPEC_KEEP;
+}
+
+static bool isLocal(const Symbol* symbol) {
+	return symbol->parent && detail::hasFlag(symbol->parent->kind, SymbolKind::FUNCTION | SymbolKind::BLOCK);
+}
+
+ReachabilityAnalysis::ReachabilityAnalysis(const SymbolTable* symbolTable, const ClassHierarchy* classHierarchy)
+	: symbolTable_(symbolTable), classHierarchy_(classHierarchy) {
+	for (auto variable : symbolTable->getVariables()) {
+		if (isLocal(variable)) {
+			auto function = symbolTable->findAncestorOfKind(variable, SymbolKind::FUNCTION);
+			localTypes_[function].push_back(variable->resolver.type);
+		}
+		else if (isRoot(variable)) {
+			markReachable(variable);
+		}
+	}
+
+	markReachable(symbolTable->getGlobalFunction());
+
+	for (auto function : symbolTable->getFunctions()) {
+		if (isRoot(function)) {
+			markReachable(function);
+		}
+	}
+
+	// Primitives are looked up by the runtime itself
+	for (auto type : symbolTable->getTypes()) {
+		if (isRoot(type) || symbolTable->getTypeSystem()->isPrimitiveType(type)) {
+			markReachable(type);
+		}
+	}
+
+	while (!worklist_.empty()) {
+		auto symbol = worklist_.back();
+		worklist_.pop_back();
+		visit(symbol);
+	}
+}
+
+bool ReachabilityAnalysis::isReachable(const Symbol* symbol) const {
+	if (symbol->kind == SymbolKind::ENUM_MEMBER) {
+		symbol = symbol->parent;
+	}
+	else if (symbol->kind == SymbolKind::FUNCTION_PARAMETER || (symbol->kind == SymbolKind::VARIABLE && isLocal(symbol))) {
+		symbol = symbolTable_->findAncestorOfKind(symbol, SymbolKind::FUNCTION);
+	}
+
+	return reachable_.contains(symbol);
+}
+
+void ReachabilityAnalysis::markReachable(const Symbol* symbol) {
+	if (!symbol) {
+		return;
+	}
+
+	// Arrays are not declared anywhere, they only need their element type
+	if (detail::hasFlag(symbol->kind, SymbolKind::TYPE)) {
+		auto elementType = symbolTable_->getTypeSystem()->getArrayElementType(static_cast<const TypeSymbol*>(symbol));
+		if (elementType) {
+			markReachable(elementType);
+			return;
+		}
+	}
+
+	if (reachable_.insert(symbol).second) {
+		worklist_.push_back(symbol);
+	}
+}
+
+void ReachabilityAnalysis::visit(const Symbol* symbol) {
+	// Everything the body, the initializer or the base type list refers to
+	for (auto dependency : symbolTable_->getDependencyGraph()->getDependencies(symbol)) {
+		markReachable(dependency);
+	}
+
+	if (symbol->kind == SymbolKind::FUNCTION) {
+		auto function = static_cast<const FunctionSymbol*>(symbol);
+		markReachable(symbolTable_->findAncestorOfKind(function, SymbolKind::TYPE));
+		markReachable(function->resolver.returnType);
+
+		for (const auto& [_, parameter] : function->parameters) {
+			markReachable(parameter->resolver.type);
+		}
+
+		auto it = localTypes_.find(function);
+		if (it != localTypes_.end()) {
+			for (auto type : it->second) {
+				markReachable(type);
+			}
+		}
+
+		return;
+	}
+
+	if (symbol->kind == SymbolKind::VARIABLE) {
+		auto variable = static_cast<const VariableSymbol*>(symbol);
+		markReachable(symbolTable_->findAncestorOfKind(variable, SymbolKind::TYPE));
+		markReachable(variable->resolver.type);
+		return;
+	}
+
+	auto type = static_cast<const TypeSymbol*>(symbol);
+	for (auto base : type->resolver.baseTypes) {
+		markReachable(base);
+	}
+
+	// Instance fields are part of the layout, static ones and methods only when used, unless the whole type is kept
+	bool keepMembers = type->declSpec == DECLSPEC_KEEP;
+	for (const auto& [_, member] : type->members) {
+		if (member->kind == SymbolKind::FUNCTION ||
+			(member->kind == SymbolKind::VARIABLE && detail::isSTATIC(member->accessModifier))) {
+			if (keepMembers) {
+				markReachable(member.get());
+			}
+		}
+		else if (member->kind == SymbolKind::VARIABLE) {
+			markReachable(member.get());
+		}
+	}
+
+	// Any slot may be called through a base reference
+	for (auto function : classHierarchy_->getVTable(type)) {
+		markReachable(function);
+	}
+}
+
+MRK_NS_END
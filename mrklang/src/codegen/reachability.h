@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common/types.h"
+#include "semantic/symbol_table.h"
+#include "class_hierarchy.h"
+
+#include <unordered_set>
+
+MRK_NS_BEGIN_MODULE(codegen)
+
+using namespace semantic;
+
+/// Types, functions and fields the program can use, starting from its roots
+/// Roots are the global function, native methods the runtime calls into, declarations injected as globals
+/// and anything declared KEEP, which also keeps every member of a type for reflection
+/// A reachable type keeps its bases, instance fields and vtable, since objects of it may be created and dispatched on
+class ReachabilityAnalysis {
+public:
+	ReachabilityAnalysis(const SymbolTable* symbolTable, const ClassHierarchy* classHierarchy);
+
+	/// Locals, parameters and enum members go along with their declaration
+	bool isReachable(const Symbol* symbol) const;
+
+	/// Reachable types, functions and fields
+	size_t getReachableCount() const { return reachable_.size(); }
+
+private:
+	const SymbolTable* symbolTable_;
+	const ClassHierarchy* classHierarchy_;
+	std::unordered_set<const Symbol*> reachable_;
+	Vec<const Symbol*> worklist_;
+
+	/// Types of the locals of every function, locals are not part of the dependency graph
+	Dict<const Symbol*, Vec<const TypeSymbol*>> localTypes_;
+
+	void markReachable(const Symbol* symbol);
+	void markReachableType(const TypeSymbol* type);
+	void visit(const Symbol* symbol);
+};
+
+MRK_NS_END
@@ -10,4 +10,10 @@
 #define DECLSPEC_INJECT_GLOBAL "INJECT_GLOBAL"
 
 // Internal call
-#define DECLSPEC_NATIVE "NATIVE"
\ No newline at end of file
+#define DECLSPEC_NATIVE "NATIVE"
+
+// Keep the declaration order of the fields
+#define DECLSPEC_SEQUENTIAL "SEQUENTIAL"
+
+// Never stripped, keeps all members of a type
+#define DECLSPEC_KEEP "KEEP"
\ No newline at end of file
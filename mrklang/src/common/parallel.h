@@ -0,0 +1,69 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+MRK_NS_BEGIN_MODULE(parallel)
+
+/// Number of workers used by parallelFor when none is specified
+inline uint32_t getWorkerCount() {
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// Invokes fn(i) for every i in [0, count) across a pool of worker threads
+/// Work items are handed out dynamically, so callers must not depend on execution order
+/// The first exception thrown by a work item is rethrown on the calling thread
+template<typename Fn>
+void parallelFor(size_t count, Fn&& fn, uint32_t maxWorkers = getWorkerCount()) {
+	auto workerCount = std::min<size_t>(count, maxWorkers);
+	if (workerCount <= 1) {
+		for (size_t i = 0; i < count; i++) {
+			fn(i);
+		}
+
+		return;
+	}
+
+	std::atomic<size_t> next = 0;
+	std::exception_ptr exception;
+	std::mutex exceptionMutex;
+
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+			try {
+				fn(i);
+			}
+			catch (...) {
+				std::lock_guard lock(exceptionMutex);
+				if (!exception) {
+					exception = std::current_exception();
+				}
+			}
+		}
+	};
+
+	// Calling thread participates as well
+	Vec<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	for (size_t i = 1; i < workerCount; i++) {
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
+
+MRK_NS_END
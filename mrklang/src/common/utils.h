@@ -3,6 +3,7 @@
 #include "common/types.h"
 
 #include <sstream>
+#include <string_view>
 #include <iomanip>
 #include <tuple>
 #include <utility>
@@ -69,6 +70,19 @@ inline Vec<Str> split(const Str& str, const Str& sep) {
 	return components;
 }
 
+constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+
+/// 64-bit FNV-1a, unlike std::hash the result is the same on every run and platform
+/// Pass the previous result as the seed to hash data that arrives in pieces
+inline uint64_t hashString(std::string_view str, uint64_t hash = HASH_SEED) {
+	for (unsigned char c : str) {
+		hash ^= c;
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
 // Concat impl (https://github.com/theypsilon/concat/blob/master/concat.hpp)
 template<typename CharT>
 struct separator_t { // this class shouldn't be explicitly invoked in client code, use "separator" instead
@@ -6,9 +6,13 @@
 #include "parser/parser.h"
 #include "semantic/symbol_table.h"
 #include "codegen/code_generator.h"
+#include "codegen/code_output.h"
 #include "codegen/metadata_writer.h"
+#include "codegen/bytecode_writer.h"
+#include "ir/module.h"
 
 #include <fstream>
+#include <sstream>
 
 MRK_NS_BEGIN
 
@@ -17,7 +21,7 @@ using namespace semantic;
 using namespace codegen;
 
 Core::Core(const Vec<Str>& files)
-	: errorReporter_(ErrorReporter::instance()) {
+	: errorReporter_(ErrorReporter::instance()), dumpGeneratedCode_(false), lineDirectives_(true), stripUnreachable_(false), optimize_(true), bytecodeOnly_(false), target_(LayoutTarget::x64()) {
 	readGlobalSymbolFile();
 	readSourceFiles(files);
 }
@@ -71,31 +75,93 @@ int Core::build() {
 		return 1;
 	}
 
+	// Generated files only replace their previous version if their contents changed
+	FileCodeOutput output(".");
+
 	// Metadata
 	MRK_INFO("Generating metadata...");
+	std::ostringstream metadata;
 	MetadataWriter metadataWriter(&symbolTable_);
-	auto registration = metadataWriter.writeMetadataFile("runtime_metadata.mrkmeta");
+	metadataWriter.setStripUnreachable(stripUnreachable_);
+	metadataWriter.setTarget(target_);
+	auto registration = metadataWriter.writeMetadata(metadata);
 	if (!registration) {
 		MRK_ERROR("Failed to generate metadata");
 		return 1;
 	}
 
+	output.open(MetadataWriter::METADATA_FILENAME).write(metadata.view());
+	output.close();
+
+	// Lowered and optimized as a whole once, callees are inlined before either backend reads a body
+	Vec<const FunctionSymbol*> functions;
+	for (const auto& [function, _] : registration->methodTokenMap) {
+		functions.push_back(function);
+	}
+
+	ir::Module irModule(&symbolTable_);
+	irModule.build(functions);
+	MRK_INFO("Optimized {} of {} functions", irModule.getFunctionCount(), functions.size());
+
+	// Bytecode
+	std::ostringstream bytecode;
+	BytecodeWriter bytecodeWriter(&symbolTable_, registration.get(), &irModule);
+	if (!bytecodeWriter.writeBytecode(bytecode)) {
+		MRK_ERROR("Failed to generate bytecode");
+		return 1;
+	}
+
+	output.open(BytecodeWriter::BYTECODE_FILENAME).write(bytecode.view());
+	output.close();
+	MRK_INFO("Compiled {} of {} functions to bytecode", bytecodeWriter.getMethodCount(), functions.size());
+
+	if (bytecodeOnly_) {
+		if (!output.good()) {
+			return 1;
+		}
+
+		// The generated code was left as is, its entries still describe it
+		output.getManifest().keepUnwritten(output.getPreviousManifest());
+		return output.saveManifest() ? 0 : 1;
+	}
+
 	// Codegen...
 	MRK_INFO("Generating code...");
+	if (dumpGeneratedCode_) {
+		MRK_INFO("Generated code:");
+		output.setMirror(&std::cerr);
+	}
+
+	// Each unit is streamed to its file as it is generated
 	CodeGenerator generator(&symbolTable_, registration.get());
-	auto code = generator.generateRuntimeCode();
+	generator.setManifest(&output.getManifest());
+	generator.setLineDirectives(lineDirectives_);
+	generator.setTarget(target_);
+	generator.setIrModule(optimize_ ? &irModule : nullptr);
+	generator.generateRuntimeCode(output);
+	output.close();
+
+	if (!output.good()) {
+		return 1;
+	}
 
-	MRK_INFO("Generated code:\n{}", code);
+	CodeGenerator::removeStaleUnits(".", generator.getUnitCount());
+	if (!output.saveManifest()) {
+		return 1;
+	}
 
-	// Write to file
-	std::ofstream out("runtime_generated.cpp");
-	out << code;
-	out.close();
+	MRK_INFO("Generated {} files, {} changed, {} bytes", output.getPaths().size(), output.getChangedCount(), output.getBytesWritten());
+	MRK_INFO("{} functions and types changed since the last build",
+		output.getManifest().countChangedSymbols(output.getPreviousManifest()));
 
 	return 0;
 }
 
 void Core::readGlobalSymbolFile() {
+	sourceFiles_.push_back(createGlobalSymbolFile());
+}
+
+UniquePtr<SourceFile> Core::createGlobalSymbolFile() {
 	// Injected
 	auto globalSyms = R"(
 		// Injected global symbols
@@ -104,14 +170,14 @@ void Core::readGlobalSymbolFile() {
 		}
 	)";
 
-	auto globalFile = MakeUnique<SourceFile>();
+	auto globalFile = MakeUnique<SourceFile, false>();
 	globalFile->filename = "<global>";
 	globalFile->contents.raw = globalSyms;
-	sourceFiles_.push_back(Move(globalFile));
+	return globalFile;
 }
 
 UniquePtr<SourceFile> Core::readSourceFile(const Str& filename) {
-	auto file = MakeUnique<SourceFile>();
+	auto file = MakeUnique<SourceFile, false>();
 	file->filename = filename;
 
 	std::ifstream src(filename);
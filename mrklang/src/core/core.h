@@ -3,6 +3,7 @@
 #include "parser/ast.h"
 #include "error_reporter.h"
 #include "semantic/symbol_table.h"
+#include "codegen/layout_engine.h"
 
 #define MRKLANG_COMPILER
 #include "mrk-metadata.h"
@@ -14,11 +15,39 @@ public:
 	Core(const Vec<Str>& files);
 	int build();
 
+	/// Also log the full generated source, off by default since it can be large
+	void setDumpGeneratedCode(bool dump) { dumpGeneratedCode_ = dump; }
+
+	/// Emit #line directives into the generated code, see CodeGenerator::setLineDirectives
+	void setLineDirectives(bool enabled) { lineDirectives_ = enabled; }
+
+	/// Leave unreachable declarations out of the output, see MetadataWriter::setStripUnreachable
+	void setStripUnreachable(bool strip) { stripUnreachable_ = strip; }
+
+	/// Generate functions from their optimized IR, see CodeGenerator::setIrModule
+	/// The bytecode is always compiled from the IR
+	void setOptimize(bool enabled) { optimize_ = enabled; }
+
+	/// Only write the metadata and bytecode, for running on a prebuilt runtime without a C++ toolchain
+	void setBytecodeOnly(bool enabled) { bytecodeOnly_ = enabled; }
+
+	/// Platform the runtime is built for, the metadata and generated types are laid out for it
+	void setTarget(const codegen::LayoutTarget& target) { target_ = target; }
+
+	/// Create the injected source file declaring the global type and function
+	static UniquePtr<SourceFile> createGlobalSymbolFile();
+
 private:
 	Vec<UniquePtr<SourceFile>> sourceFiles_;
-	Vec<UniquePtr<ast::Program>> programs_;
+	Vec<SharedPtr<ast::Program>> programs_;
 	ErrorReporter& errorReporter_;
 	semantic::SymbolTable symbolTable_;
+	bool dumpGeneratedCode_;
+	bool lineDirectives_;
+	bool stripUnreachable_;
+	bool optimize_;
+	bool bytecodeOnly_;
+	codegen::LayoutTarget target_;
 
 	void readGlobalSymbolFile();
 	UniquePtr<SourceFile> readSourceFile(const Str& filename);
@@ -76,6 +76,25 @@ size_t ErrorReporter::errorCount() const {
 	);
 }
 
+void ErrorReporter::clearErrors(CompilerError::Stage stage, const SourceFile* file) {
+	for (auto it = errors_.begin(); it != errors_.end();) {
+		if (file && it->first != file) {
+			++it;
+			continue;
+		}
+
+		auto& errors = it->second;
+		std::erase_if(errors, [stage](const auto& err) { return err->stage == stage; });
+
+		// hasErrors relies on empty files being removed
+		it = errors.empty() ? errors_.erase(it) : std::next(it);
+	}
+}
+
+void ErrorReporter::clearErrors() {
+	errors_.clear();
+}
+
 void ErrorReporter::addError(UniquePtr<CompilerError>&& error) {
 	if (!currentFile_) {
 		MRK_ERROR("Error reported without a current file");
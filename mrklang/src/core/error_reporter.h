@@ -44,6 +44,14 @@ public:
     void reportErrors() const;
     size_t errorCount() const;
 
+    /// Reported errors grouped by file
+    const Dict<const SourceFile*, Vec<UniquePtr<CompilerError>>>& getErrors() const { return errors_; }
+
+    /// Drop previously reported errors of a stage, for every file or a single one
+    /// Used when a stage is recomputed for warm, long-lived compilations
+    void clearErrors(CompilerError::Stage stage, const SourceFile* file = nullptr);
+    void clearErrors();
+
 private:
     const SourceFile* currentFile_;
 	Dict<const SourceFile*, Vec<UniquePtr<CompilerError>>> errors_;
@@ -0,0 +1,489 @@
+#include "query_engine.h"
+#include "core.h"
+#include "error_reporter.h"
+#include "common/logging.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "codegen/code_generator.h"
+#include "codegen/bytecode_writer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+MRK_NS_BEGIN
+
+using namespace ast;
+using namespace semantic;
+using namespace codegen;
+
+static bool tokensEqual(const Vec<Token>& a, const Vec<Token>& b) {
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Token& x, const Token& y) {
+		// Positions are part of the AST, and of every error reported against it
+		return x.type == y.type && x.lexeme == y.lexeme &&
+			x.position.line == y.position.line && x.position.column == y.position.column;
+	});
+}
+
+QueryEngine::QueryEngine()
+	: revision_(1), fileSetChangedAt_(1), stats_{}, analysisBuiltAt_(0), functionCodeRevision_(0) {
+	addSlot(Core::createGlobalSymbolFile());
+}
+
+QueryEngine::~QueryEngine() {
+	// Generated code references the analysis
+	functionGenerator_.reset();
+}
+
+bool QueryEngine::setFile(const Str& filename, Str contents) {
+	auto slot = getSlot(filename);
+	if (!slot) {
+		auto sourceFile = MakeUnique<SourceFile, false>();
+		sourceFile->filename = filename;
+		sourceFile->contents.raw = Move(contents);
+
+		revision_++;
+		fileSetChangedAt_ = revision_;
+		addSlot(Move(sourceFile));
+		return true;
+	}
+
+	if (slot->sourceFile->contents.raw == contents) {
+		return false;
+	}
+
+	revision_++;
+	slot->sourceFile->contents.raw = Move(contents);
+	slot->changedAt = revision_;
+	return true;
+}
+
+bool QueryEngine::loadFile(const Str& filename) {
+	std::ifstream src(filename);
+	if (!src.is_open()) {
+		MRK_ERROR("Failed to open file: {}", filename);
+		return false;
+	}
+
+	setFile(filename, Str((std::istreambuf_iterator<char>(src)), std::istreambuf_iterator<char>()));
+	return true;
+}
+
+bool QueryEngine::removeFile(const Str& filename) {
+	auto it = files_.find(filename);
+	if (it == files_.end() || it == files_.find(fileOrder_.front())) {
+		return false;
+	}
+
+	// The analysis and its errors reference the file, drop them before the file goes away
+	functionGenerator_.reset();
+	functionCode_.clear();
+	runtimeCode_ = {};
+	metadata_ = {};
+	analysis_ = {};
+
+	auto& reporter = ErrorReporter::instance();
+	reporter.clearErrors(CompilerError::Stage::SEMANTIC);
+	reporter.clearErrors(CompilerError::Stage::LEXICAL, it->second->sourceFile.get());
+	reporter.clearErrors(CompilerError::Stage::PARSER, it->second->sourceFile.get());
+
+	files_.erase(it);
+	std::erase(fileOrder_, filename);
+
+	revision_++;
+	fileSetChangedAt_ = revision_;
+	return true;
+}
+
+bool QueryEngine::hasFile(const Str& filename) const {
+	return files_.contains(filename);
+}
+
+Vec<Str> QueryEngine::getFiles() const {
+	return fileOrder_;
+}
+
+const Vec<Token>* QueryEngine::tokens(const Str& filename) {
+	auto slot = getSlot(filename);
+	if (!slot) {
+		return nullptr;
+	}
+
+	auto& memo = slot->tokens;
+	if (memo.computed && memo.verifiedAt >= slot->changedAt) {
+		stats_.hits++;
+		return slot->lexed ? &memo.value : nullptr;
+	}
+
+	auto& reporter = ErrorReporter::instance();
+	reporter.clearErrors(CompilerError::Stage::LEXICAL, slot->sourceFile.get());
+	reporter.setCurrentFile(slot->sourceFile.get());
+
+	auto errorCount = reporter.errorCount();
+
+	auto lexer = Lexer(slot->sourceFile->contents.raw);
+	lexer.tokenize();
+	auto tokens = Move(lexer.moveTokens());
+	stats_.lexes++;
+
+	auto lexed = reporter.errorCount() == errorCount;
+
+	// Early cutoff, identical tokens do not invalidate the AST
+	if (!memo.computed || lexed != slot->lexed || !tokensEqual(memo.value, tokens)) {
+		memo.value = Move(tokens);
+		memo.changedAt = revision_;
+	}
+
+	memo.computed = true;
+	memo.verifiedAt = revision_;
+	slot->lexed = lexed;
+
+	return lexed ? &memo.value : nullptr;
+}
+
+ast::Program* QueryEngine::ast(const Str& filename) {
+	auto tokens = this->tokens(filename);
+
+	auto slot = getSlot(filename);
+	if (!slot) {
+		return nullptr;
+	}
+
+	auto& memo = slot->ast;
+	if (memo.computed && memo.verifiedAt >= slot->tokens.changedAt) {
+		stats_.hits++;
+		memo.verifiedAt = revision_;
+		return memo.value.get();
+	}
+
+	auto& reporter = ErrorReporter::instance();
+	reporter.clearErrors(CompilerError::Stage::PARSER, slot->sourceFile.get());
+
+	SharedPtr<ast::Program> program;
+	if (tokens) {
+		reporter.setCurrentFile(slot->sourceFile.get());
+		auto errorCount = reporter.errorCount();
+
+		auto parser = Parser(Vec<Token>(*tokens));
+		auto parsed = parser.parseProgram(slot->sourceFile.get());
+		stats_.parses++;
+
+		if (reporter.errorCount() == errorCount) {
+			program = Move(parsed);
+		}
+	}
+
+	memo.value = Move(program);
+	memo.computed = true;
+	memo.changedAt = revision_;
+	memo.verifiedAt = revision_;
+
+	return memo.value.get();
+}
+
+semantic::SymbolTable* QueryEngine::symbolTable() {
+	auto inputsChangedAt = programsChangedAt();
+	if (analysis_.computed && analysis_.verifiedAt >= inputsChangedAt) {
+		stats_.hits++;
+		analysis_.verifiedAt = revision_;
+		return analysis_.value.get();
+	}
+
+	// Anything generated from the previous analysis is stale
+	functionGenerator_.reset();
+	functionCode_.clear();
+
+	if (applyEdit()) {
+		stats_.incrementalAnalyses++;
+	}
+	else {
+		Vec<SharedPtr<ast::Program>> programs;
+		for (const auto& filename : fileOrder_) {
+			auto slot = files_[filename].get();
+			if (slot->ast.value) {
+				programs.push_back(slot->ast.value);
+				slot->analyzedTokens = slot->tokens.value;
+			}
+		}
+
+		analysis_.value.reset();
+		ErrorReporter::instance().clearErrors(CompilerError::Stage::SEMANTIC);
+
+		if (!programs.empty()) {
+			analysis_.value = MakeUnique<SymbolTable>(Move(programs));
+			analysis_.value->build();
+			stats_.analyses++;
+		}
+
+		analysisBuiltAt_ = revision_;
+	}
+
+	analysis_.computed = true;
+	analysis_.changedAt = revision_;
+	analysis_.verifiedAt = revision_;
+
+	return analysis_.value.get();
+}
+
+Vec<const semantic::Symbol*> QueryEngine::symbolsOf(const Str& filename) {
+	auto table = symbolTable();
+
+	auto slot = getSlot(filename);
+	if (!slot || !table) {
+		return {};
+	}
+
+	auto& memo = slot->symbols;
+	if (memo.computed && memo.verifiedAt >= std::max(analysisBuiltAt_, slot->ast.changedAt)) {
+		stats_.hits++;
+		return memo.value;
+	}
+
+	auto sourceFile = slot->sourceFile.get();
+	auto declaredHere = [&](const Symbol* symbol) {
+		return symbol->declNode && symbol->declNode->sourceFile == sourceFile &&
+			DependencyGraph::getDeclaration(symbol) == symbol;
+	};
+
+	Vec<const Symbol*> symbols;
+	for (auto type : table->getTypes()) {
+		if (declaredHere(type)) symbols.push_back(type);
+	}
+
+	for (auto function : table->getFunctions()) {
+		if (declaredHere(function)) symbols.push_back(function);
+	}
+
+	for (auto variable : table->getVariables()) {
+		if (declaredHere(variable)) symbols.push_back(variable);
+	}
+
+	memo.value = Move(symbols);
+	memo.computed = true;
+	memo.changedAt = revision_;
+	memo.verifiedAt = revision_;
+
+	return memo.value;
+}
+
+const semantic::TypeSymbol* QueryEngine::typeOf(const ast::ExprNode* expr) {
+	auto table = symbolTable();
+	if (!table) {
+		return nullptr;
+	}
+
+	return table->getTypeSystem()->getSymbolType(table->getNodeResolvedSymbol(expr));
+}
+
+const codegen::CompilerMetadataRegistration* QueryEngine::metadata() {
+	auto table = symbolTable();
+
+	if (metadata_.computed && metadata_.verifiedAt >= analysis_.changedAt) {
+		stats_.hits++;
+		metadata_.verifiedAt = revision_;
+		return metadata_.value.get();
+	}
+
+	metadata_.value.reset();
+	metadataImage_.clear();
+
+	// Never emit anything for a program with errors
+	if (table && !ErrorReporter::instance().hasErrors()) {
+		std::ostringstream image;
+		MetadataWriter writer(table);
+		metadata_.value = writer.writeMetadata(image);
+		metadataImage_ = image.str();
+		stats_.metadataBuilds++;
+	}
+
+	metadata_.computed = true;
+	metadata_.changedAt = revision_;
+	metadata_.verifiedAt = revision_;
+
+	return metadata_.value.get();
+}
+
+const Str& QueryEngine::metadataImage() {
+	metadata();
+	return metadataImage_;
+}
+
+Str QueryEngine::codegen(const semantic::FunctionSymbol* function) {
+	auto registration = metadata();
+	if (!registration || !function) {
+		return "";
+	}
+
+	if (!functionGenerator_ || functionCodeRevision_ != metadata_.changedAt) {
+		functionGenerator_ = MakeUnique<CodeGenerator>(analysis_.value.get(), registration);
+		functionCode_.clear();
+		functionCodeRevision_ = metadata_.changedAt;
+	}
+
+	auto it = functionCode_.find(function);
+	if (it != functionCode_.end()) {
+		stats_.hits++;
+		return it->second;
+	}
+
+	auto code = functionGenerator_->generateFunctionCode(function);
+	stats_.functionCodegens++;
+
+	functionCode_[function] = code;
+	return code;
+}
+
+const Vec<GeneratedFile>& QueryEngine::runtimeCode() {
+	static const Vec<GeneratedFile> empty;
+
+	auto registration = metadata();
+	if (!registration) {
+		return empty;
+	}
+
+	if (runtimeCode_.computed && runtimeCode_.verifiedAt >= metadata_.changedAt) {
+		stats_.hits++;
+		runtimeCode_.verifiedAt = revision_;
+		return runtimeCode_.value;
+	}
+
+	Vec<const FunctionSymbol*> functions;
+	for (const auto& [function, _] : registration->methodTokenMap) {
+		functions.push_back(function);
+	}
+
+	ir::Module irModule(analysis_.value.get());
+	irModule.build(functions);
+
+	StringCodeOutput output;
+	CodeGenerator generator(analysis_.value.get(), registration);
+	generator.setIrModule(&irModule);
+	generator.generateRuntimeCode(output);
+	output.close();
+
+	// The runtime loads both, they have to agree on the metadata tokens
+	std::ostringstream bytecode;
+	BytecodeWriter bytecodeWriter(analysis_.value.get(), registration, &irModule);
+	bytecodeImage_ = bytecodeWriter.writeBytecode(bytecode) ? bytecode.str() : Str();
+
+	runtimeCode_.value = Move(output.getFiles());
+	runtimeCode_.computed = true;
+	runtimeCode_.changedAt = revision_;
+	runtimeCode_.verifiedAt = revision_;
+	stats_.runtimeCodegens++;
+
+	return runtimeCode_.value;
+}
+
+const Str& QueryEngine::bytecodeImage() {
+	// Stale without runtime code, e.g. once the program has errors
+	if (runtimeCode().empty()) {
+		bytecodeImage_.clear();
+	}
+
+	return bytecodeImage_;
+}
+
+const semantic::FunctionSymbol* QueryEngine::findFunction(const Str& qualifiedName) {
+	auto table = symbolTable();
+	if (!table) {
+		return nullptr;
+	}
+
+	for (auto function : table->getFunctions()) {
+		if (function->qualifiedName == qualifiedName) {
+			return function;
+		}
+	}
+
+	return nullptr;
+}
+
+bool QueryEngine::hasErrors() {
+	symbolTable();
+	return ErrorReporter::instance().hasErrors();
+}
+
+QueryEngine::FileSlot* QueryEngine::getSlot(const Str& filename) const {
+	auto it = files_.find(filename);
+	return it != files_.end() ? it->second.get() : nullptr;
+}
+
+void QueryEngine::addSlot(UniquePtr<SourceFile>&& sourceFile) {
+	auto slot = MakeUnique<FileSlot, false>();
+	slot->changedAt = revision_;
+	slot->lexed = false;
+	slot->sourceFile = Move(sourceFile);
+
+	auto filename = slot->sourceFile->filename;
+	fileOrder_.push_back(filename);
+	files_[filename] = Move(slot);
+}
+
+bool QueryEngine::applyEdit() {
+	auto table = analysis_.value.get();
+	if (!table || fileSetChangedAt_ > analysis_.verifiedAt) {
+		return false;
+	}
+
+	// Errors are reported once, declarations that are not resolved again would lose theirs
+	for (const auto& [_, errors] : ErrorReporter::instance().getErrors()) {
+		for (const auto& error : errors) {
+			if (error->stage == CompilerError::Stage::SEMANTIC) {
+				return false;
+			}
+		}
+	}
+
+	FileSlot* edited = nullptr;
+	for (const auto& filename : fileOrder_) {
+		auto slot = files_[filename].get();
+		if (slot->ast.changedAt <= analysis_.verifiedAt) {
+			continue;
+		}
+
+		// Edits across files, or of a file that no longer parses, are left to a rebuild
+		if (edited || !slot->ast.value) {
+			return false;
+		}
+
+		edited = slot;
+	}
+
+	if (!edited) {
+		return false;
+	}
+
+	const auto& programs = table->getPrograms();
+	auto it = std::find_if(programs.begin(), programs.end(), [&](const auto& program) {
+		return program->sourceFile == edited->sourceFile.get();
+	});
+
+	if (it == programs.end()) {
+		return false;
+	}
+
+	ProgramEdit edit(edited->analyzedTokens, edited->tokens.value);
+
+	Vec<const Symbol*> invalidated;
+	if (!table->applyEdit(it - programs.begin(), edit, edited->ast.value.get(), invalidated)) {
+		return false;
+	}
+
+	// The analyzed program now holds the edit, it stays the file's AST so that its nodes are the resolved ones
+	edited->ast.value = *it;
+	edited->analyzedTokens = edited->tokens.value;
+	return true;
+}
+
+QueryEngine::Revision QueryEngine::programsChangedAt() {
+	auto changedAt = fileSetChangedAt_;
+	for (const auto& filename : fileOrder_) {
+		ast(filename);
+		changedAt = std::max(changedAt, files_[filename]->ast.changedAt);
+	}
+
+	return changedAt;
+}
+
+MRK_NS_END
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "common/types.h"
+#include "source_file.h"
+#include "lexer/token.h"
+#include "parser/ast.h"
+#include "semantic/symbol_table.h"
+#include "codegen/metadata_writer.h"
+#include "codegen/code_output.h"
+
+MRK_NS_BEGIN
+
+namespace codegen {
+	class CodeGenerator;
+}
+
+/// Demand-driven compiler core
+/// Every stage is exposed as a memoized query over the source files (the inputs)
+/// Editing an input bumps the revision, queries recompute lazily and only when one of their inputs
+/// actually changed since they were last verified. A query whose recomputed value equals the
+/// previous one keeps its old change revision, so its dependents are not recomputed either
+///
+///		file -> tokens(file) -> ast(file) -> symbolTable() -> symbolsOf(file), typeOf(expr)
+///										   -> metadata() -> codegen(function), runtimeCode(), bytecodeImage()
+///
+/// An edit confined to a single function is applied to the current analysis in place, re-resolving
+/// only the function and whatever depends on it. Any other change rebuilds the analysis
+class QueryEngine {
+public:
+	using Revision = uint64_t;
+
+	struct Stats {
+		uint32_t lexes;
+		uint32_t parses;
+		uint32_t analyses;
+		uint32_t incrementalAnalyses;
+		uint32_t metadataBuilds;
+		uint32_t functionCodegens;
+		uint32_t runtimeCodegens;
+		uint32_t hits;
+	};
+
+	QueryEngine();
+	~QueryEngine();
+
+	QueryEngine(const QueryEngine&) = delete;
+	QueryEngine& operator=(const QueryEngine&) = delete;
+
+	/// Set the contents of a file, adding it if it does not exist
+	/// Returns true if anything changed
+	bool setFile(const Str& filename, Str contents);
+
+	/// Read a file from disk into the engine
+	bool loadFile(const Str& filename);
+
+	bool removeFile(const Str& filename);
+	bool hasFile(const Str& filename) const;
+
+	/// Files in compilation order, the injected global symbol file is always first
+	Vec<Str> getFiles() const;
+	Revision getRevision() const { return revision_; }
+	const Stats& getStats() const { return stats_; }
+
+	/// Tokens of a file, nullptr if the file does not exist or failed to lex
+	const Vec<Token>* tokens(const Str& filename);
+
+	/// AST of a file, nullptr if the file does not exist or failed to lex/parse
+	ast::Program* ast(const Str& filename);
+
+	/// The analyzed program, nullptr if no file could be parsed
+	semantic::SymbolTable* symbolTable();
+
+	/// Top level declarations (types, functions, fields) of a file
+	/// Recomputed when the file changes or the analysis is rebuilt, edits of other files applied in place keep it
+	Vec<const semantic::Symbol*> symbolsOf(const Str& filename);
+
+	/// Resolved type of an expression from the current analysis
+	const semantic::TypeSymbol* typeOf(const ast::ExprNode* expr);
+
+	/// Metadata registration and serialized image, nullptr on failure
+	const codegen::CompilerMetadataRegistration* metadata();
+	const Str& metadataImage();
+
+	/// Generated C++ for a single function
+	Str codegen(const semantic::FunctionSymbol* function);
+
+	/// The generated runtime, shared header first, then the function units and the registration unit
+	const Vec<codegen::GeneratedFile>& runtimeCode();
+
+	/// Serialized bytecode of the functions the runtime code was generated from, empty on failure
+	const Str& bytecodeImage();
+
+	/// Find a function by its qualified name in the current analysis
+	const semantic::FunctionSymbol* findFunction(const Str& qualifiedName);
+
+	/// Whether any stage reported errors for the current inputs
+	bool hasErrors();
+
+private:
+	template<typename T>
+	struct Memo {
+		T value{};
+		bool computed = false;
+
+		/// Revision at which the value was last computed or confirmed up to date
+		Revision verifiedAt = 0;
+
+		/// Revision at which the value last changed
+		Revision changedAt = 0;
+	};
+
+	struct FileSlot {
+		UniquePtr<SourceFile> sourceFile;
+		Revision changedAt;
+		Memo<Vec<Token>> tokens;
+		bool lexed;
+		Memo<SharedPtr<ast::Program>> ast;
+		Memo<Vec<const semantic::Symbol*>> symbols;
+
+		/// Tokens of the program in the current analysis, edits are diffed against them
+		Vec<Token> analyzedTokens;
+	};
+
+	Revision revision_;
+	Revision fileSetChangedAt_;
+	Vec<Str> fileOrder_;
+	Dict<Str, UniquePtr<FileSlot>> files_;
+	Stats stats_;
+
+	Memo<UniquePtr<semantic::SymbolTable>> analysis_;
+
+	/// Revision of the last full analysis, symbols from before it are gone
+	Revision analysisBuiltAt_;
+	Memo<UniquePtr<codegen::CompilerMetadataRegistration>> metadata_;
+	Str metadataImage_;
+	Memo<Vec<codegen::GeneratedFile>> runtimeCode_;
+
+	/// Compiled from the same optimized IR as the runtime code, along with it
+	Str bytecodeImage_;
+
+	/// Per function code, valid for the current metadata revision
+	UniquePtr<codegen::CodeGenerator> functionGenerator_;
+	Dict<const semantic::FunctionSymbol*, Str> functionCode_;
+	Revision functionCodeRevision_;
+
+	FileSlot* getSlot(const Str& filename) const;
+	void addSlot(UniquePtr<SourceFile>&& sourceFile);
+
+	/// Latest change revision among all parsed files and the file set itself
+	Revision programsChangedAt();
+
+	/// Apply the edit of a single file to the current analysis, false if it has to be rebuilt instead
+	bool applyEdit();
+};
+
+MRK_NS_END
@@ -0,0 +1,150 @@
+#include "ir.h"
+#include "lexer/token_lookup.h"
+
+#include <format>
+
+MRK_NS_BEGIN_MODULE(ir)
+
+bool Instruction::hasSideEffects() const {
+	switch (opcode) {
+		case Opcode::STORE:
+		case Opcode::STORE_FIELD:
+		case Opcode::CALL:
+		case Opcode::JUMP:
+		case Opcode::BRANCH:
+		case Opcode::RETURN:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+Vec<BlockId> BasicBlock::getSuccessors() const {
+	if (instructions.empty()) {
+		return {};
+	}
+
+	const auto& terminator = getTerminator();
+	switch (terminator.opcode) {
+		case Opcode::JUMP:
+			return { terminator.target };
+
+		case Opcode::BRANCH:
+			return { terminator.target, terminator.elseTarget };
+
+		default:
+			return {};
+	}
+}
+
+ValueId Function::addValue(const TypeSymbol* type) {
+	valueTypes.push_back(type);
+	return static_cast<ValueId>(valueTypes.size() - 1);
+}
+
+SlotId Function::addSlot(const Symbol* symbol, const TypeSymbol* type, bool isParameter) {
+	slots.push_back({ symbol, type, isParameter });
+	return static_cast<SlotId>(slots.size() - 1);
+}
+
+BlockId Function::addBlock() {
+	blocks.emplace_back();
+	return static_cast<BlockId>(blocks.size() - 1);
+}
+
+size_t Function::getInstructionCount() const {
+	size_t count = 0;
+	for (const auto& block : blocks) {
+		count += block.instructions.size();
+	}
+
+	return count;
+}
+
+bool Function::hasCalls() const {
+	for (const auto& block : blocks) {
+		for (const auto& instruction : block.instructions) {
+			if (instruction.opcode == Opcode::CALL) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+Str Function::toString() const {
+	std::stringstream ss;
+	ss << "func " << symbol->qualifiedName << "\n";
+
+	for (size_t i = 0; i < slots.size(); i++) {
+		const auto& slot = slots[i];
+		ss << "  s" << i << ": " << (slot.symbol ? slot.symbol->name : "<temp>") << " "
+			<< (slot.type ? slot.type->name : "?") << (slot.isParameter ? " (param)" : "") << "\n";
+	}
+
+	const auto& operators = TokenLookup::operators();
+
+	for (size_t i = 0; i < blocks.size(); i++) {
+		ss << "block" << i << ":\n";
+
+		for (const auto& instruction : blocks[i].instructions) {
+			ss << "  ";
+			if (instruction.result != NO_VALUE) {
+				ss << 'v' << instruction.result << " = ";
+			}
+
+			ss << ir::toString(instruction.opcode);
+
+			switch (instruction.opcode) {
+				case Opcode::CONSTANT:
+					ss << ' ' << instruction.constant.toString();
+					break;
+
+				case Opcode::LOAD:
+				case Opcode::STORE:
+					ss << " s" << instruction.slot;
+					break;
+
+				case Opcode::LOAD_FIELD:
+				case Opcode::STORE_FIELD:
+				case Opcode::CALL:
+					ss << ' ' << instruction.symbol->qualifiedName;
+					break;
+
+				case Opcode::UNARY:
+				case Opcode::BINARY: {
+					auto it = operators.find(instruction.op);
+					ss << ' ' << (it != operators.end() ? it->second : "?");
+					break;
+				}
+
+				case Opcode::JUMP:
+					ss << " block" << instruction.target;
+					break;
+
+				case Opcode::BRANCH:
+					ss << " block" << instruction.target << ", block" << instruction.elseTarget;
+					break;
+
+				default:
+					break;
+			}
+
+			for (auto operand : instruction.operands) {
+				ss << " v" << operand;
+			}
+
+			if (instruction.type) {
+				ss << " : " << instruction.type->name;
+			}
+
+			ss << "\n";
+		}
+	}
+
+	return ss.str();
+}
+
+MRK_NS_END
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "common/types.h"
+#include "semantic/symbol_table.h"
+#include "semantic/constant_evaluator.h"
+
+MRK_NS_BEGIN_MODULE(ir)
+
+using namespace semantic;
+
+/// Result of an instruction, every value is defined exactly once
+using ValueId = uint32_t;
+using SlotId = uint32_t;
+using BlockId = uint32_t;
+
+constexpr ValueId NO_VALUE = 0;
+
+#define IR_OPCODES \
+	X(CONSTANT)     /* result = constant */ \
+	X(LOAD)         /* result = slot */ \
+	X(STORE)        /* slot = operands[0] */ \
+	X(LOAD_FIELD)   /* result = field, a static or of the current instance */ \
+	X(STORE_FIELD)  /* field = operands[0] */ \
+	X(CONVERT)      /* result = (type)operands[0] */ \
+	X(UNARY)        /* result = op operands[0] */ \
+	X(BINARY)       /* result = operands[0] op operands[1] */ \
+	X(CALL)         /* result = function(operands...), result is NO_VALUE for void functions */ \
+	X(JUMP)         /* goto target */ \
+	X(BRANCH)       /* operands[0] ? target : elseTarget */ \
+	X(RETURN)       /* return operands[0], if any */
+
+enum class Opcode : uint8_t {
+	#define X(x) x,
+	IR_OPCODES
+	#undef X
+};
+
+constexpr std::string_view toString(Opcode opcode) {
+	switch (opcode) {
+		#define X(x) case Opcode::x: return #x;
+		IR_OPCODES
+		#undef X
+
+		default:
+			return "UNKNOWN";
+	}
+}
+
+#undef IR_OPCODES
+
+struct Instruction {
+	Opcode opcode;
+	ValueId result = NO_VALUE;
+
+	/// Type of the result, or of the stored value
+	const TypeSymbol* type = nullptr;
+
+	Vec<ValueId> operands;
+
+	/// UNARY, BINARY
+	TokenType op = TokenType::END_OF_FILE;
+
+	/// LOAD, STORE
+	SlotId slot = 0;
+
+	/// Field of LOAD_FIELD and STORE_FIELD, function of CALL
+	const Symbol* symbol = nullptr;
+
+	ConstantValue constant;
+
+	/// JUMP, BRANCH
+	BlockId target = 0;
+	BlockId elseTarget = 0;
+
+	/// Statement the instruction was lowered from
+	const ast::Node* source = nullptr;
+
+	bool isTerminator() const { return opcode == Opcode::JUMP || opcode == Opcode::BRANCH || opcode == Opcode::RETURN; }
+
+	/// Stores, calls and terminators, anything else can be dropped once its result is unused
+	bool hasSideEffects() const;
+};
+
+/// Storage of a parameter, a local or a temporary the lowering needed, read and written through LOAD and STORE
+struct Slot {
+	/// Parameter or local, nullptr for temporaries
+	const Symbol* symbol;
+	const TypeSymbol* type;
+	bool isParameter;
+};
+
+struct BasicBlock {
+	/// Always ends with a terminator once lowered
+	Vec<Instruction> instructions;
+
+	const Instruction& getTerminator() const { return instructions.back(); }
+	Instruction& getTerminator() { return instructions.back(); }
+
+	/// Blocks the terminator may continue in
+	Vec<BlockId> getSuccessors() const;
+};
+
+/// Typed mid level form of a function body, a control flow graph of basic blocks starting at block 0
+/// Values are in SSA form, locals and parameters live in slots and are only reached through loads and stores
+struct Function {
+	const FunctionSymbol* symbol;
+	const SymbolTable* symbolTable;
+	Vec<Slot> slots;
+	Vec<BasicBlock> blocks;
+
+	/// Type of every value, indexed by ValueId, NO_VALUE has none
+	Vec<const TypeSymbol*> valueTypes;
+
+	Function(const FunctionSymbol* symbol, const SymbolTable* symbolTable)
+		: symbol(symbol), symbolTable(symbolTable), valueTypes(1, nullptr) {}
+
+	ValueId addValue(const TypeSymbol* type);
+	SlotId addSlot(const Symbol* symbol, const TypeSymbol* type, bool isParameter = false);
+	BlockId addBlock();
+
+	/// Instructions across all blocks
+	size_t getInstructionCount() const;
+
+	/// True if the function calls any other function
+	bool hasCalls() const;
+
+	Str toString() const;
+};
+
+MRK_NS_END
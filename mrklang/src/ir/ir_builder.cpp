@@ -0,0 +1,770 @@
+#include "ir_builder.h"
+#include "common/declspecs.h"
+
+MRK_NS_BEGIN_MODULE(ir)
+
+IrBuilder::IrBuilder(const SymbolTable* symbolTable)
+	: symbolTable_(symbolTable), enclosingType_(nullptr), currentBlock_(0), result_(NO_VALUE), voidCall_(false), source_(nullptr), global_(false), failed_(false) {}
+
+UniquePtr<Function> IrBuilder::build(const FunctionSymbol* function) {
+	// Native bodies are replaced by their internal call
+	if (function->declSpec == DECLSPEC_NATIVE) {
+		return nullptr;
+	}
+
+	auto funcDecl = dynamic_cast<const FuncDeclStmt*>(function->declNode);
+	if (!funcDecl || !funcDecl->body) {
+		return nullptr;
+	}
+
+	// The global function's body is the top level statements of every program
+	global_ = function == symbolTable_->getGlobalFunction();
+	Vec<StmtNode*> statements;
+	if (global_) {
+		for (const auto& program : symbolTable_->getPrograms()) {
+			for (const auto& stmt : program->statements) {
+				statements.push_back(stmt.get());
+			}
+		}
+	}
+	else {
+		for (const auto& stmt : funcDecl->body->statements) {
+			statements.push_back(stmt.get());
+		}
+	}
+
+	auto voidType = symbolTable_->getTypeSystem()->getBuiltinType(TypeKind::VOID);
+	if (function->resolver.returnType != voidType && !isSupportedType(function->resolver.returnType)) {
+		return nullptr;
+	}
+
+	function_ = MakeUnique<Function>(function, symbolTable_);
+	enclosingType_ = static_cast<const TypeSymbol*>(symbolTable_->findAncestorOfKind(function, SymbolKind::TYPE));
+	currentBlock_ = function_->addBlock();
+	slots_.clear();
+	result_ = NO_VALUE;
+	source_ = funcDecl;
+	failed_ = false;
+
+	for (const auto& [_, parameter] : function->parameters) {
+		if (parameter->isParams || !isSupportedType(parameter->resolver.type)) {
+			return nullptr;
+		}
+
+		slots_[parameter.get()] = function_->addSlot(parameter.get(), parameter->resolver.type, true);
+	}
+
+	for (auto stmt : statements) {
+		lowerStatement(stmt);
+
+		if (failed_) {
+			return nullptr;
+		}
+	}
+
+	// Falling off the end returns, with an unspecified value if the function has one
+	auto& lastBlock = function_->blocks[currentBlock_];
+	if (lastBlock.instructions.empty() || !lastBlock.getTerminator().isTerminator()) {
+		source_ = nullptr;
+		emit(Opcode::RETURN);
+	}
+
+	return Move(function_);
+}
+
+bool IrBuilder::isSupportedType(const TypeSymbol* type) const {
+	TypeKind kind;
+	if (!type || !symbolTable_->getTypeSystem()->isPrimitiveType(type, &kind)) {
+		return false;
+	}
+
+	switch (kind) {
+		case TypeKind::BOOL:
+		case TypeKind::CHAR:
+		case TypeKind::I8:
+		case TypeKind::U8:
+		case TypeKind::I16:
+		case TypeKind::U16:
+		case TypeKind::I32:
+		case TypeKind::U32:
+		case TypeKind::I64:
+		case TypeKind::U64:
+		case TypeKind::F32:
+		case TypeKind::F64:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+const TypeSymbol* IrBuilder::getExpressionType(const ExprNode* node) const {
+	return symbolTable_->getTypeSystem()->getSymbolType(symbolTable_->getNodeResolvedSymbol(node));
+}
+
+const TypeSymbol* IrBuilder::getBoolType() const {
+	return symbolTable_->getTypeSystem()->getBuiltinType(TypeKind::BOOL);
+}
+
+ValueId IrBuilder::lowerExpression(ExprNode* node, const TypeSymbol* type) {
+	if (failed_) {
+		return NO_VALUE;
+	}
+
+	result_ = NO_VALUE;
+	voidCall_ = false;
+
+	// Folded by the ConstantEvaluator already
+	auto constant = symbolTable_->getConstantEvaluator()->getValue(node);
+	auto expressionType = getExpressionType(node);
+	if (constant && isSupportedType(expressionType)) {
+		result_ = emitConstant(*constant, expressionType);
+	}
+	else {
+		node->accept(*this);
+	}
+
+	// Only calls to void functions have no value, and only where it is discarded
+	if (failed_ || (result_ == NO_VALUE && (type || !voidCall_))) {
+		fail();
+		return NO_VALUE;
+	}
+
+	return type ? emitConvert(result_, type) : result_;
+}
+
+void IrBuilder::lowerStatement(StmtNode* node) {
+	if (failed_) {
+		return;
+	}
+
+	auto prevSource = std::exchange(source_, node);
+	node->accept(*this);
+	source_ = prevSource;
+}
+
+Instruction& IrBuilder::emit(Opcode opcode, const TypeSymbol* type) {
+	// Code following a return is unreachable, it goes into a block of its own that is dropped later
+	auto* block = &function_->blocks[currentBlock_];
+	if (!block->instructions.empty() && block->getTerminator().isTerminator()) {
+		currentBlock_ = function_->addBlock();
+		block = &function_->blocks[currentBlock_];
+	}
+
+	auto& instruction = block->instructions.emplace_back();
+	instruction.opcode = opcode;
+	instruction.type = type;
+	instruction.source = source_;
+
+	if (type && opcode != Opcode::STORE && opcode != Opcode::STORE_FIELD && opcode != Opcode::RETURN) {
+		instruction.result = function_->addValue(type);
+	}
+
+	return instruction;
+}
+
+ValueId IrBuilder::emitConstant(const ConstantValue& value, const TypeSymbol* type) {
+	TypeKind kind;
+	symbolTable_->getTypeSystem()->isPrimitiveType(type, &kind);
+
+	auto converted = ConstantEvaluator::convert(value, kind);
+	if (!converted) {
+		fail();
+		return NO_VALUE;
+	}
+
+	auto& instruction = emit(Opcode::CONSTANT, type);
+	instruction.constant = *converted;
+	return instruction.result;
+}
+
+ValueId IrBuilder::emitConvert(ValueId value, const TypeSymbol* type) {
+	if (value == NO_VALUE || function_->valueTypes[value] == type) {
+		return value;
+	}
+
+	if (!isSupportedType(type)) {
+		fail();
+		return NO_VALUE;
+	}
+
+	auto& instruction = emit(Opcode::CONVERT, type);
+	instruction.operands = { value };
+	return instruction.result;
+}
+
+ValueId IrBuilder::emitBinary(TokenType op, ValueId left, ValueId right, const TypeSymbol* type) {
+	auto& instruction = emit(Opcode::BINARY, type);
+	instruction.op = op;
+	instruction.operands = { left, right };
+	return instruction.result;
+}
+
+void IrBuilder::emitJump(BlockId target) {
+	emit(Opcode::JUMP).target = target;
+}
+
+void IrBuilder::emitBranch(ValueId condition, BlockId target, BlockId elseTarget) {
+	auto& instruction = emit(Opcode::BRANCH);
+	instruction.operands = { condition };
+	instruction.target = target;
+	instruction.elseTarget = elseTarget;
+}
+
+bool IrBuilder::getPlace(ExprNode* node, Place* place) {
+	auto identifier = dynamic_cast<IdentifierExpr*>(node);
+	auto symbol = identifier ? symbolTable_->getNodeResolvedSymbol(identifier) : nullptr;
+	if (!symbol) {
+		return false;
+	}
+
+	// Parameters and locals
+	auto it = slots_.find(symbol);
+	if (it != slots_.end()) {
+		*place = { it->second, nullptr, function_->slots[it->second].type };
+		return true;
+	}
+
+	// Fields, statics of any type or instance fields of the current object
+	auto owner = symbol->parent;
+	if (symbol->kind != SymbolKind::VARIABLE || !owner || !detail::hasFlag(owner->kind, SymbolKind::TYPE)) {
+		return false;
+	}
+
+	auto field = static_cast<const VariableSymbol*>(symbol);
+	if (!isSupportedType(field->resolver.type)) {
+		return false;
+	}
+
+	if (!detail::isSTATIC(field->accessModifier)) {
+		auto function = function_->symbol;
+		bool hasInstance = !function->isGlobal && !detail::isSTATIC(function->accessModifier);
+		auto ownerType = static_cast<const TypeSymbol*>(owner);
+
+		if (!hasInstance || !enclosingType_ ||
+			(ownerType != enclosingType_ && !symbolTable_->getTypeSystem()->isDerivedFrom(enclosingType_, ownerType))) {
+			return false;
+		}
+	}
+
+	*place = { 0, field, field->resolver.type };
+	return true;
+}
+
+ValueId IrBuilder::load(const Place& place) {
+	if (place.field) {
+		auto& instruction = emit(Opcode::LOAD_FIELD, place.type);
+		instruction.symbol = place.field;
+		return instruction.result;
+	}
+
+	auto& instruction = emit(Opcode::LOAD, place.type);
+	instruction.slot = place.slot;
+	return instruction.result;
+}
+
+void IrBuilder::store(const Place& place, ValueId value) {
+	auto& instruction = emit(place.field ? Opcode::STORE_FIELD : Opcode::STORE, place.type);
+	instruction.symbol = place.field;
+	instruction.slot = place.slot;
+	instruction.operands = { value };
+}
+
+void IrBuilder::visit(LiteralExpr* node) {
+	// Constant literals were lowered already, null and out of range literals are not modeled
+	fail();
+}
+
+void IrBuilder::visit(InterpolatedStringExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(InteropCallExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(IdentifierExpr* node) {
+	Place place;
+	if (!getPlace(node, &place)) {
+		fail();
+		return;
+	}
+
+	result_ = load(place);
+}
+
+void IrBuilder::visit(TypeReferenceExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(CallExpr* node) {
+	auto symbol = symbolTable_->getNodeResolvedSymbol(node->target.get());
+	if (!symbol || symbol->kind != SymbolKind::FUNCTION) {
+		fail();
+		return;
+	}
+
+	// Static functions only, named directly or through their namespace or type
+	auto function = static_cast<const FunctionSymbol*>(symbol);
+	if (!function->isGlobal && !detail::isSTATIC(function->accessModifier)) {
+		fail();
+		return;
+	}
+
+	auto memberAccess = dynamic_cast<MemberAccessExpr*>(node->target.get());
+	if (memberAccess) {
+		auto target = symbolTable_->getNodeResolvedSymbol(memberAccess->target.get());
+		if (!target || !detail::hasFlag(target->kind, SymbolKind::TYPE)) {
+			fail();
+			return;
+		}
+	}
+	else if (!dynamic_cast<IdentifierExpr*>(node->target.get()) && !dynamic_cast<NamespaceAccessExpr*>(node->target.get())) {
+		fail();
+		return;
+	}
+
+	if (node->arguments.size() != function->parameters.size()) {
+		fail();
+		return;
+	}
+
+	// Arguments are evaluated left to right, converted to their parameter types
+	Vec<ValueId> arguments;
+	for (size_t i = 0; i < node->arguments.size(); i++) {
+		const auto& parameter = function->parameters[i].second;
+		if (parameter->isParams || !isSupportedType(parameter->resolver.type)) {
+			fail();
+			return;
+		}
+
+		arguments.push_back(lowerExpression(node->arguments[i].get(), parameter->resolver.type));
+	}
+
+	if (failed_) {
+		return;
+	}
+
+	auto returnType = function->resolver.returnType;
+	bool returnsValue = returnType != symbolTable_->getTypeSystem()->getBuiltinType(TypeKind::VOID);
+	if (returnsValue && !isSupportedType(returnType)) {
+		fail();
+		return;
+	}
+
+	auto& instruction = emit(Opcode::CALL, returnsValue ? returnType : nullptr);
+	instruction.symbol = function;
+	instruction.operands = Move(arguments);
+
+	result_ = instruction.result;
+	voidCall_ = !returnsValue;
+}
+
+void IrBuilder::visit(BinaryExpr* node) {
+	auto op = node->op.type;
+	if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+		result_ = lowerShortCircuit(node);
+		return;
+	}
+
+	auto type = getExpressionType(node);
+	if (!isSupportedType(type)) {
+		fail();
+		return;
+	}
+
+	// Comparisons are evaluated in the common type of both operands
+	auto operandType = type;
+	if (ConstantEvaluator::isComparison(op)) {
+		auto typeSystem = symbolTable_->getTypeSystem();
+		operandType = typeSystem->getCommonType(getExpressionType(node->left.get()), getExpressionType(node->right.get()));
+
+		if (!isSupportedType(operandType)) {
+			fail();
+			return;
+		}
+	}
+
+	// Shift counts keep their own type
+	bool isShift = op == TokenType::OP_SHL || op == TokenType::OP_SHR;
+
+	auto left = lowerExpression(node->left.get(), operandType);
+	auto right = lowerExpression(node->right.get(), isShift ? nullptr : operandType);
+	if (failed_) {
+		return;
+	}
+
+	result_ = emitBinary(op, left, right, type);
+}
+
+ValueId IrBuilder::lowerShortCircuit(BinaryExpr* node) {
+	auto boolType = getBoolType();
+	auto slot = function_->addSlot(nullptr, boolType);
+
+	auto left = lowerExpression(node->left.get(), boolType);
+	if (failed_) {
+		return NO_VALUE;
+	}
+
+	emit(Opcode::STORE, boolType).slot = slot;
+	function_->blocks[currentBlock_].instructions.back().operands = { left };
+
+	auto rightBlock = function_->addBlock();
+	auto endBlock = function_->addBlock();
+
+	if (node->op.type == TokenType::OP_AND) {
+		emitBranch(left, rightBlock, endBlock);
+	}
+	else {
+		emitBranch(left, endBlock, rightBlock);
+	}
+
+	currentBlock_ = rightBlock;
+	auto right = lowerExpression(node->right.get(), boolType);
+	if (failed_) {
+		return NO_VALUE;
+	}
+
+	store({ slot, nullptr, boolType }, right);
+	emitJump(endBlock);
+
+	currentBlock_ = endBlock;
+	return load({ slot, nullptr, boolType });
+}
+
+void IrBuilder::visit(UnaryExpr* node) {
+	auto type = getExpressionType(node);
+	auto op = node->op.type;
+	if (!isSupportedType(type) || op == TokenType::OP_INCREMENT || op == TokenType::OP_DECREMENT) {
+		fail();
+		return;
+	}
+
+	auto operand = lowerExpression(node->right.get(), type);
+	if (failed_) {
+		return;
+	}
+
+	auto& instruction = emit(Opcode::UNARY, type);
+	instruction.op = op;
+	instruction.operands = { operand };
+	result_ = instruction.result;
+}
+
+void IrBuilder::visit(TernaryExpr* node) {
+	auto type = getExpressionType(node);
+	if (!isSupportedType(type)) {
+		fail();
+		return;
+	}
+
+	auto slot = function_->addSlot(nullptr, type);
+	auto condition = lowerExpression(node->condition.get(), getBoolType());
+	if (failed_) {
+		return;
+	}
+
+	auto thenBlock = function_->addBlock();
+	auto elseBlock = function_->addBlock();
+	auto endBlock = function_->addBlock();
+	emitBranch(condition, thenBlock, elseBlock);
+
+	currentBlock_ = thenBlock;
+	store({ slot, nullptr, type }, lowerExpression(node->thenBranch.get(), type));
+	emitJump(endBlock);
+
+	currentBlock_ = elseBlock;
+	store({ slot, nullptr, type }, lowerExpression(node->elseBranch.get(), type));
+	emitJump(endBlock);
+
+	currentBlock_ = endBlock;
+	result_ = load({ slot, nullptr, type });
+}
+
+void IrBuilder::visit(AssignmentExpr* node) {
+	Place place;
+	if (!getPlace(node->target.get(), &place)) {
+		fail();
+		return;
+	}
+
+	auto op = node->op.type;
+	if (op == TokenType::OP_EQ) {
+		auto value = lowerExpression(node->value.get(), place.type);
+		if (failed_) {
+			return;
+		}
+
+		store(place, value);
+		result_ = value;
+		return;
+	}
+
+	// x++ and x-- yield the value before the update
+	if (op == TokenType::OP_INCREMENT || op == TokenType::OP_DECREMENT) {
+		ConstantValue one;
+		one.kind = TypeKind::I32;
+		one.integer = 1;
+
+		auto value = load(place);
+		auto updated = emitBinary(op == TokenType::OP_INCREMENT ? TokenType::OP_PLUS : TokenType::OP_MINUS,
+			value, emitConstant(one, place.type), place.type);
+
+		store(place, updated);
+		result_ = value;
+		return;
+	}
+
+	// x op= y is x = (T)(x op y)
+	TokenType binaryOp;
+	switch (op) {
+		case TokenType::OP_PLUS_EQ: binaryOp = TokenType::OP_PLUS; break;
+		case TokenType::OP_MINUS_EQ: binaryOp = TokenType::OP_MINUS; break;
+		case TokenType::OP_MULT_EQ: binaryOp = TokenType::OP_ASTERISK; break;
+		case TokenType::OP_DIV_EQ: binaryOp = TokenType::OP_SLASH; break;
+
+		default:
+			fail();
+			return;
+	}
+
+	auto typeSystem = symbolTable_->getTypeSystem();
+	auto type = typeSystem->getBinaryExpressionType(binaryOp, place.type, getExpressionType(node->value.get()));
+	if (!isSupportedType(type)) {
+		fail();
+		return;
+	}
+
+	auto current = emitConvert(load(place), type);
+	auto value = lowerExpression(node->value.get(), type);
+	if (failed_) {
+		return;
+	}
+
+	auto updated = emitConvert(emitBinary(binaryOp, current, value, type), place.type);
+	store(place, updated);
+	result_ = updated;
+}
+
+void IrBuilder::visit(NamespaceAccessExpr* node) {
+	// Static members named through their namespace or type, constants were lowered already
+	auto member = node->path.back().get();
+	if (dynamic_cast<CallExpr*>(member)) {
+		member->accept(*this);
+		return;
+	}
+
+	Place place;
+	if (!getPlace(member, &place) || !place.field) {
+		fail();
+		return;
+	}
+
+	result_ = load(place);
+}
+
+void IrBuilder::visit(MemberAccessExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(ArrayExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(ArrayAccessExpr* node) {
+	fail();
+}
+
+void IrBuilder::visit(ExprStmt* node) {
+	lowerExpression(node->expr.get());
+}
+
+void IrBuilder::visit(VarDeclStmt* node) {
+	// Global variables are static fields, set by their initializers
+	if (global_) return;
+
+	auto variable = dynamic_cast<const VariableSymbol*>(symbolTable_->getDeclarationSymbol(node));
+	if (!variable || !isSupportedType(variable->resolver.type)) {
+		fail();
+		return;
+	}
+
+	auto type = variable->resolver.type;
+	auto slot = function_->addSlot(variable, type);
+	slots_[variable] = slot;
+
+	// Uninitialized locals start out zeroed
+	ConstantValue zero;
+	symbolTable_->getTypeSystem()->isPrimitiveType(type, &zero.kind);
+
+	auto value = node->initializer ? lowerExpression(node->initializer.get(), type) : emitConstant(zero, type);
+	if (failed_) {
+		return;
+	}
+
+	store({ slot, nullptr, type }, value);
+}
+
+void IrBuilder::visit(BlockStmt* node) {
+	for (const auto& stmt : node->statements) {
+		lowerStatement(stmt.get());
+	}
+}
+
+void IrBuilder::visit(ParamDeclStmt* node) {
+	fail();
+}
+
+void IrBuilder::visit(FuncDeclStmt* node) {
+	// Declarations at the top level are generated on their own
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(IfStmt* node) {
+	auto condition = lowerExpression(node->condition.get(), getBoolType());
+	if (failed_) {
+		return;
+	}
+
+	auto thenBlock = function_->addBlock();
+	auto elseBlock = node->elseBlock ? function_->addBlock() : 0;
+	auto endBlock = function_->addBlock();
+	emitBranch(condition, thenBlock, node->elseBlock ? elseBlock : endBlock);
+
+	currentBlock_ = thenBlock;
+	lowerStatement(node->thenBlock.get());
+	emitJump(endBlock);
+
+	if (node->elseBlock) {
+		currentBlock_ = elseBlock;
+		lowerStatement(node->elseBlock.get());
+		emitJump(endBlock);
+	}
+
+	currentBlock_ = endBlock;
+}
+
+void IrBuilder::visit(ForStmt* node) {
+	if (node->init) {
+		lowerStatement(node->init.get());
+	}
+
+	auto conditionBlock = function_->addBlock();
+	auto bodyBlock = function_->addBlock();
+	auto endBlock = function_->addBlock();
+	emitJump(conditionBlock);
+
+	currentBlock_ = conditionBlock;
+	if (node->condition) {
+		auto condition = lowerExpression(node->condition.get(), getBoolType());
+		if (failed_) {
+			return;
+		}
+
+		emitBranch(condition, bodyBlock, endBlock);
+	}
+	else {
+		emitJump(bodyBlock);
+	}
+
+	currentBlock_ = bodyBlock;
+	lowerStatement(node->body.get());
+
+	if (node->increment) {
+		lowerExpression(node->increment.get());
+	}
+
+	emitJump(conditionBlock);
+	currentBlock_ = endBlock;
+}
+
+void IrBuilder::visit(ForeachStmt* node) {
+	fail();
+}
+
+void IrBuilder::visit(WhileStmt* node) {
+	auto conditionBlock = function_->addBlock();
+	auto bodyBlock = function_->addBlock();
+	auto endBlock = function_->addBlock();
+	emitJump(conditionBlock);
+
+	currentBlock_ = conditionBlock;
+	auto condition = lowerExpression(node->condition.get(), getBoolType());
+	if (failed_) {
+		return;
+	}
+
+	emitBranch(condition, bodyBlock, endBlock);
+
+	currentBlock_ = bodyBlock;
+	lowerStatement(node->body.get());
+	emitJump(conditionBlock);
+
+	currentBlock_ = endBlock;
+}
+
+void IrBuilder::visit(LangBlockStmt* node) {
+	// Rigid blocks stay where they were declared, outside of the global function
+	if (global_ && symbolTable_->isRigidLanguageBlock(node)) {
+		return;
+	}
+
+	// Native code may touch any local by name
+	fail();
+}
+
+void IrBuilder::visit(AccessModifierStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(NamespaceDeclStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(DeclSpecStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(UseStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(ReturnStmt* node) {
+	auto returnType = function_->symbol->resolver.returnType;
+	if (!node->value) {
+		emit(Opcode::RETURN);
+		return;
+	}
+
+	auto value = lowerExpression(node->value.get(), returnType);
+	if (failed_) {
+		return;
+	}
+
+	auto& instruction = emit(Opcode::RETURN, returnType);
+	instruction.operands = { value };
+}
+
+void IrBuilder::visit(EnumDeclStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+void IrBuilder::visit(TypeDeclStmt* node) {
+	if (!global_) {
+		fail();
+	}
+}
+
+MRK_NS_END
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "common/types.h"
+#include "ir.h"
+
+MRK_NS_BEGIN_MODULE(ir)
+
+using namespace ast;
+
+/// Lowers the resolved AST of a function body into IR
+/// Covers primitive arithmetic, locals, fields, control flow and calls to static functions,
+/// a body using anything else is not lowered and keeps being generated from the AST
+/// Operands are converted to the type an operator is evaluated in, following the rules the ConstantEvaluator folds by
+class IrBuilder : public ASTVisitor {
+public:
+	explicit IrBuilder(const SymbolTable* symbolTable);
+
+	/// nullptr if the body uses anything the IR does not model
+	UniquePtr<Function> build(const FunctionSymbol* function);
+
+	/// Bools, chars, integers and floating point values, the only types values can have
+	bool isSupportedType(const TypeSymbol* type) const;
+
+	void visit(LiteralExpr* node) override;
+	void visit(InterpolatedStringExpr* node) override;
+	void visit(InteropCallExpr* node) override;
+	void visit(IdentifierExpr* node) override;
+	void visit(TypeReferenceExpr* node) override;
+	void visit(CallExpr* node) override;
+	void visit(BinaryExpr* node) override;
+	void visit(UnaryExpr* node) override;
+	void visit(TernaryExpr* node) override;
+	void visit(AssignmentExpr* node) override;
+	void visit(NamespaceAccessExpr* node) override;
+	void visit(MemberAccessExpr* node) override;
+	void visit(ArrayExpr* node) override;
+	void visit(ArrayAccessExpr* node) override;
+
+	void visit(ExprStmt* node) override;
+	void visit(VarDeclStmt* node) override;
+	void visit(BlockStmt* node) override;
+	void visit(ParamDeclStmt* node) override;
+	void visit(FuncDeclStmt* node) override;
+	void visit(IfStmt* node) override;
+	void visit(ForStmt* node) override;
+	void visit(ForeachStmt* node) override;
+	void visit(WhileStmt* node) override;
+	void visit(LangBlockStmt* node) override;
+	void visit(AccessModifierStmt* node) override;
+	void visit(NamespaceDeclStmt* node) override;
+	void visit(DeclSpecStmt* node) override;
+	void visit(UseStmt* node) override;
+	void visit(ReturnStmt* node) override;
+	void visit(EnumDeclStmt* node) override;
+	void visit(TypeDeclStmt* node) override;
+
+private:
+	/// Assignable storage, a slot or a field
+	struct Place {
+		SlotId slot;
+		const VariableSymbol* field;
+		const TypeSymbol* type;
+	};
+
+	const SymbolTable* symbolTable_;
+	UniquePtr<Function> function_;
+	const TypeSymbol* enclosingType_;
+	BlockId currentBlock_;
+	Dict<const Symbol*, SlotId> slots_;
+
+	/// Value of the last lowered expression
+	ValueId result_;
+
+	/// The last lowered expression was a call to a void function, it has no value
+	bool voidCall_;
+
+	/// Statement being lowered, the source of the instructions emitted for it
+	const Node* source_;
+
+	/// Lowering the top level statements, declarations among them are skipped
+	bool global_;
+
+	bool failed_;
+
+	/// Give up on the function, it is generated from the AST instead
+	void fail() { failed_ = true; }
+
+	const TypeSymbol* getExpressionType(const ExprNode* node) const;
+	const TypeSymbol* getBoolType() const;
+
+	/// Lower an expression, converted to the given type if there is one
+	ValueId lowerExpression(ExprNode* node, const TypeSymbol* type = nullptr);
+	void lowerStatement(StmtNode* node);
+
+	/// Append an instruction to the current block, defining a new value if it has a result type
+	Instruction& emit(Opcode opcode, const TypeSymbol* type = nullptr);
+	ValueId emitConstant(const ConstantValue& value, const TypeSymbol* type);
+	ValueId emitConvert(ValueId value, const TypeSymbol* type);
+	ValueId emitBinary(TokenType op, ValueId left, ValueId right, const TypeSymbol* type);
+	void emitJump(BlockId target);
+	void emitBranch(ValueId condition, BlockId target, BlockId elseTarget);
+
+	bool getPlace(ExprNode* node, Place* place);
+	ValueId load(const Place& place);
+	void store(const Place& place, ValueId value);
+
+	/// Lower a && or || without evaluating the right side when the left one decides
+	ValueId lowerShortCircuit(BinaryExpr* node);
+};
+
+MRK_NS_END
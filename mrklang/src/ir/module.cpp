@@ -0,0 +1,67 @@
+#include "module.h"
+#include "ir_builder.h"
+#include "common/parallel.h"
+
+MRK_NS_BEGIN_MODULE(ir)
+
+Module::Module(const SymbolTable* symbolTable) : symbolTable_(symbolTable) {}
+
+void Module::build(const Vec<const FunctionSymbol*>& functions) {
+	Vec<UniquePtr<Function>> lowered(functions.size());
+	parallel::parallelFor(functions.size(), [&](size_t i) {
+		IrBuilder builder(symbolTable_);
+		lowered[i] = builder.build(functions[i]);
+
+		if (lowered[i]) {
+			PassManager passManager;
+			addLocalPasses(passManager);
+			passManager.run(*lowered[i]);
+		}
+	});
+
+	for (size_t i = 0; i < functions.size(); i++) {
+		if (lowered[i]) {
+			functions_[functions[i]] = Move(lowered[i]);
+		}
+	}
+
+	// Only leaves are inlined, and only callers change while inlining
+	Dict<const FunctionSymbol*, const Function*> leaves;
+	Vec<Function*> callers;
+
+	for (const auto& [symbol, function] : functions_) {
+		if (function->hasCalls()) {
+			callers.push_back(function.get());
+		}
+		else {
+			leaves[symbol] = function.get();
+		}
+	}
+
+	auto lookup = [&leaves](const FunctionSymbol* function) -> const Function* {
+		auto it = leaves.find(function);
+		return it != leaves.end() ? it->second : nullptr;
+	};
+
+	parallel::parallelFor(callers.size(), [&](size_t i) {
+		PassManager passManager;
+		passManager.addPass(MakeUnique<InlinePass>(lookup));
+		addLocalPasses(passManager);
+		passManager.run(*callers[i]);
+	});
+}
+
+const Function* Module::getFunction(const FunctionSymbol* function) const {
+	auto it = functions_.find(function);
+	return it != functions_.end() ? it->second.get() : nullptr;
+}
+
+void Module::addLocalPasses(PassManager& passManager) {
+	passManager.addRepeatedPass(MakeUnique<ConstantFoldingPass, false>());
+	passManager.addRepeatedPass(MakeUnique<CopyPropagationPass, false>());
+	passManager.addRepeatedPass(MakeUnique<DeadStoreEliminationPass, false>());
+	passManager.addRepeatedPass(MakeUnique<DeadValueEliminationPass, false>());
+	passManager.addRepeatedPass(MakeUnique<SimplifyCfgPass, false>());
+}
+
+MRK_NS_END
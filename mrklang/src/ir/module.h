@@ -0,0 +1,30 @@
+#pragma once
+
+#include "common/types.h"
+#include "ir.h"
+#include "passes.h"
+
+MRK_NS_BEGIN_MODULE(ir)
+
+/// IR of every function that could be lowered, optimized as a whole
+/// Functions are optimized on their own first, then small leaf functions are inlined into their callers
+/// and the callers optimized again, leaves are only read at that point so both phases run in parallel
+class Module {
+public:
+	explicit Module(const SymbolTable* symbolTable);
+
+	void build(const Vec<const FunctionSymbol*>& functions);
+
+	/// nullptr if the function was not lowered, it is generated from the AST then
+	const Function* getFunction(const FunctionSymbol* function) const;
+
+	size_t getFunctionCount() const { return functions_.size(); }
+
+private:
+	const SymbolTable* symbolTable_;
+	Dict<const FunctionSymbol*, UniquePtr<Function>> functions_;
+
+	static void addLocalPasses(PassManager& passManager);
+};
+
+MRK_NS_END
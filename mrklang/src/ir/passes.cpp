@@ -0,0 +1,559 @@
+#include "passes.h"
+
+#include <iterator>
+#include <limits>
+
+MRK_NS_BEGIN_MODULE(ir)
+
+namespace {
+	Vec<bool> getReachableBlocks(const Function& function) {
+		Vec<bool> reachable(function.blocks.size(), false);
+		Vec<BlockId> worklist = { 0 };
+		reachable[0] = true;
+
+		while (!worklist.empty()) {
+			auto block = worklist.back();
+			worklist.pop_back();
+
+			for (auto successor : function.blocks[block].getSuccessors()) {
+				if (!reachable[successor]) {
+					reachable[successor] = true;
+					worklist.push_back(successor);
+				}
+			}
+		}
+
+		return reachable;
+	}
+
+	bool getKind(const Function& function, const TypeSymbol* type, TypeKind* kind) {
+		return type && function.symbolTable->getTypeSystem()->isPrimitiveType(type, kind);
+	}
+}
+
+void replaceUses(Function& function, const Dict<ValueId, ValueId>& replacements) {
+	if (replacements.empty()) {
+		return;
+	}
+
+	auto resolve = [&](ValueId value) {
+		for (auto it = replacements.find(value); it != replacements.end(); it = replacements.find(value)) {
+			value = it->second;
+		}
+
+		return value;
+	};
+
+	for (auto& block : function.blocks) {
+		for (auto& instruction : block.instructions) {
+			for (auto& operand : instruction.operands) {
+				operand = resolve(operand);
+			}
+		}
+	}
+}
+
+bool PassManager::run(Function& function) {
+	bool changed = false;
+	for (const auto& pass : passes_) {
+		changed |= pass->run(function);
+	}
+
+	for (int i = 0; i < MAX_ITERATIONS; i++) {
+		bool iterationChanged = false;
+		for (const auto& pass : repeatedPasses_) {
+			iterationChanged |= pass->run(function);
+		}
+
+		if (!iterationChanged) {
+			break;
+		}
+
+		changed = true;
+	}
+
+	return changed;
+}
+
+bool InlinePass::run(Function& function) {
+	bool changed = false;
+
+	for (BlockId block = 0; block < function.blocks.size(); block++) {
+		for (size_t i = 0; i < function.blocks[block].instructions.size(); i++) {
+			const auto& instruction = function.blocks[block].instructions[i];
+			if (instruction.opcode != Opcode::CALL) {
+				continue;
+			}
+
+			if (function.getInstructionCount() >= MAX_CALLER_INSTRUCTIONS) {
+				return changed;
+			}
+
+			auto callee = getInlineCandidate(function, instruction);
+			if (!callee) {
+				continue;
+			}
+
+			// The rest of the block moves to a continuation block, which is visited later on
+			inlineCall(function, block, i, *callee);
+			changed = true;
+			break;
+		}
+	}
+
+	return changed;
+}
+
+const Function* InlinePass::getInlineCandidate(const Function& caller, const Instruction& call) const {
+	auto calleeSymbol = static_cast<const FunctionSymbol*>(call.symbol);
+	if (calleeSymbol == caller.symbol) {
+		return nullptr;
+	}
+
+	auto callee = lookup_(calleeSymbol);
+	if (!callee || callee->hasCalls() || callee->getInstructionCount() > MAX_CALLEE_INSTRUCTIONS) {
+		return nullptr;
+	}
+
+	return callee;
+}
+
+void InlinePass::inlineCall(Function& caller, BlockId block, size_t index, const Function& callee) {
+	// Split the block at the call
+	Vec<Instruction> tail;
+	Instruction call;
+	{
+		auto& instructions = caller.blocks[block].instructions;
+		call = Move(instructions[index]);
+		tail.assign(std::make_move_iterator(instructions.begin() + index + 1), std::make_move_iterator(instructions.end()));
+		instructions.erase(instructions.begin() + index, instructions.end());
+	}
+
+	// Give the copy its own slots, values and blocks
+	auto slotBase = static_cast<SlotId>(caller.slots.size());
+	for (const auto& slot : callee.slots) {
+		caller.addSlot(slot.symbol, slot.type);
+	}
+
+	Vec<ValueId> values(callee.valueTypes.size(), NO_VALUE);
+	for (size_t i = 1; i < values.size(); i++) {
+		values[i] = caller.addValue(callee.valueTypes[i]);
+	}
+
+	auto blockBase = static_cast<BlockId>(caller.blocks.size());
+	for (size_t i = 0; i < callee.blocks.size(); i++) {
+		caller.addBlock();
+	}
+
+	auto continuation = caller.addBlock();
+	auto resultSlot = call.result != NO_VALUE ? caller.addSlot(nullptr, call.type) : 0;
+
+	// Arguments, in parameter order
+	auto& entry = caller.blocks[block].instructions;
+	size_t argument = 0;
+
+	for (SlotId slot = 0; slot < callee.slots.size(); slot++) {
+		if (!callee.slots[slot].isParameter) {
+			continue;
+		}
+
+		auto& store = entry.emplace_back();
+		store.opcode = Opcode::STORE;
+		store.type = callee.slots[slot].type;
+		store.slot = slotBase + slot;
+		store.operands = { call.operands[argument++] };
+		store.source = call.source;
+	}
+
+	auto& jump = entry.emplace_back();
+	jump.opcode = Opcode::JUMP;
+	jump.target = blockBase;
+	jump.source = call.source;
+
+	// Body, returns continue after the call
+	for (size_t i = 0; i < callee.blocks.size(); i++) {
+		auto& instructions = caller.blocks[blockBase + i].instructions;
+
+		for (const auto& calleeInstruction : callee.blocks[i].instructions) {
+			auto instruction = calleeInstruction;
+			instruction.result = values[instruction.result];
+			for (auto& operand : instruction.operands) {
+				operand = values[operand];
+			}
+
+			switch (instruction.opcode) {
+				case Opcode::LOAD:
+				case Opcode::STORE:
+					instruction.slot += slotBase;
+					break;
+
+				case Opcode::BRANCH:
+					instruction.elseTarget += blockBase;
+					[[fallthrough]];
+
+				case Opcode::JUMP:
+					instruction.target += blockBase;
+					break;
+
+				case Opcode::RETURN:
+					if (!instruction.operands.empty() && call.result != NO_VALUE) {
+						auto& store = instructions.emplace_back();
+						store.opcode = Opcode::STORE;
+						store.type = call.type;
+						store.slot = resultSlot;
+						store.operands = Move(instruction.operands);
+						store.source = instruction.source;
+					}
+
+					instruction.opcode = Opcode::JUMP;
+					instruction.type = nullptr;
+					instruction.operands.clear();
+					instruction.target = continuation;
+					break;
+
+				default:
+					break;
+			}
+
+			instructions.push_back(Move(instruction));
+		}
+	}
+
+	// The call result keeps its value id, loaded back from the return temporary
+	auto& rest = caller.blocks[continuation].instructions;
+	if (call.result != NO_VALUE) {
+		auto& load = rest.emplace_back();
+		load.opcode = Opcode::LOAD;
+		load.result = call.result;
+		load.type = call.type;
+		load.slot = resultSlot;
+		load.source = call.source;
+	}
+
+	rest.insert(rest.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+}
+
+bool ConstantFoldingPass::run(Function& function) {
+	bool changed = false;
+	Dict<ValueId, ConstantValue> constants;
+
+	auto getConstant = [&](ValueId value) -> const ConstantValue* {
+		auto it = constants.find(value);
+		return it != constants.end() ? &it->second : nullptr;
+	};
+
+	for (auto& block : function.blocks) {
+		for (auto& instruction : block.instructions) {
+			if (instruction.opcode == Opcode::CONSTANT) {
+				constants[instruction.result] = instruction.constant;
+				continue;
+			}
+
+			auto operand = !instruction.operands.empty() ? getConstant(instruction.operands[0]) : nullptr;
+			if (!operand) {
+				continue;
+			}
+
+			std::optional<ConstantValue> value;
+			TypeKind kind;
+
+			switch (instruction.opcode) {
+				case Opcode::CONVERT:
+					if (getKind(function, instruction.type, &kind)) {
+						value = ConstantEvaluator::convert(*operand, kind);
+					}
+					break;
+
+				case Opcode::UNARY:
+					if (getKind(function, instruction.type, &kind)) {
+						value = ConstantEvaluator::foldUnary(instruction.op, kind, *operand);
+					}
+					break;
+
+				case Opcode::BINARY: {
+					auto right = getConstant(instruction.operands[1]);
+
+					// Comparisons are evaluated in the type of their operands
+					auto type = ConstantEvaluator::isComparison(instruction.op) ? function.valueTypes[instruction.operands[0]] : instruction.type;
+					if (right && getKind(function, type, &kind)) {
+						value = ConstantEvaluator::foldBinary(instruction.op, kind, *operand, *right);
+					}
+					break;
+				}
+
+				case Opcode::BRANCH:
+					instruction.opcode = Opcode::JUMP;
+					instruction.target = operand->boolean ? instruction.target : instruction.elseTarget;
+					instruction.operands.clear();
+					changed = true;
+					break;
+
+				default:
+					break;
+			}
+
+			if (value) {
+				instruction.opcode = Opcode::CONSTANT;
+				instruction.constant = *value;
+				instruction.operands.clear();
+				constants[instruction.result] = Move(*value);
+				changed = true;
+			}
+		}
+	}
+
+	return changed;
+}
+
+bool CopyPropagationPass::run(Function& function) {
+	Dict<ValueId, ValueId> replacements;
+
+	for (auto& block : function.blocks) {
+		Dict<SlotId, ValueId> slotValues;
+		Dict<const Symbol*, ValueId> fieldValues;
+
+		std::erase_if(block.instructions, [&](const Instruction& instruction) {
+			switch (instruction.opcode) {
+				case Opcode::STORE:
+					slotValues[instruction.slot] = instruction.operands[0];
+					return false;
+
+				case Opcode::STORE_FIELD:
+					fieldValues[instruction.symbol] = instruction.operands[0];
+					return false;
+
+				case Opcode::LOAD: {
+					auto [it, inserted] = slotValues.emplace(instruction.slot, instruction.result);
+					if (!inserted) {
+						replacements[instruction.result] = it->second;
+					}
+
+					return !inserted;
+				}
+
+				case Opcode::LOAD_FIELD: {
+					auto [it, inserted] = fieldValues.emplace(instruction.symbol, instruction.result);
+					if (!inserted) {
+						replacements[instruction.result] = it->second;
+					}
+
+					return !inserted;
+				}
+
+				case Opcode::CALL:
+					fieldValues.clear();
+					return false;
+
+				default:
+					return false;
+			}
+		});
+	}
+
+	replaceUses(function, replacements);
+	return !replacements.empty();
+}
+
+bool DeadStoreEliminationPass::run(Function& function) {
+	bool changed = false;
+
+	Vec<bool> loaded(function.slots.size(), false);
+	for (const auto& block : function.blocks) {
+		for (const auto& instruction : block.instructions) {
+			if (instruction.opcode == Opcode::LOAD) {
+				loaded[instruction.slot] = true;
+			}
+		}
+	}
+
+	for (auto& block : function.blocks) {
+		auto& instructions = block.instructions;
+		Vec<bool> dead(instructions.size(), false);
+		Dict<SlotId, size_t> pendingSlots;
+		Dict<const Symbol*, size_t> pendingFields;
+
+		for (size_t i = 0; i < instructions.size(); i++) {
+			const auto& instruction = instructions[i];
+
+			switch (instruction.opcode) {
+				case Opcode::STORE: {
+					if (!loaded[instruction.slot]) {
+						dead[i] = true;
+						break;
+					}
+
+					auto [it, inserted] = pendingSlots.emplace(instruction.slot, i);
+					if (!inserted) {
+						dead[it->second] = true;
+						it->second = i;
+					}
+					break;
+				}
+
+				case Opcode::LOAD:
+					pendingSlots.erase(instruction.slot);
+					break;
+
+				case Opcode::STORE_FIELD: {
+					auto [it, inserted] = pendingFields.emplace(instruction.symbol, i);
+					if (!inserted) {
+						dead[it->second] = true;
+						it->second = i;
+					}
+					break;
+				}
+
+				case Opcode::LOAD_FIELD:
+					pendingFields.erase(instruction.symbol);
+					break;
+
+				case Opcode::CALL:
+					pendingFields.clear();
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		size_t i = 0;
+		auto removed = std::erase_if(instructions, [&](const Instruction&) { return dead[i++]; });
+		changed |= removed > 0;
+	}
+
+	return changed;
+}
+
+bool DeadValueEliminationPass::run(Function& function) {
+	bool changed = false;
+	size_t removed;
+
+	do {
+		Vec<uint32_t> uses(function.valueTypes.size(), 0);
+		for (const auto& block : function.blocks) {
+			for (const auto& instruction : block.instructions) {
+				for (auto operand : instruction.operands) {
+					uses[operand]++;
+				}
+			}
+		}
+
+		removed = 0;
+		for (auto& block : function.blocks) {
+			removed += std::erase_if(block.instructions, [&](const Instruction& instruction) {
+				return !instruction.hasSideEffects() && instruction.result != NO_VALUE && uses[instruction.result] == 0;
+			});
+		}
+
+		changed |= removed > 0;
+	} while (removed > 0);
+
+	return changed;
+}
+
+bool SimplifyCfgPass::run(Function& function) {
+	bool changed = false;
+	auto& blocks = function.blocks;
+
+	// Branches going the same way either way, and jumps through blocks holding nothing but a jump
+	auto resolve = [&](BlockId target) {
+		for (size_t hops = 0; hops < blocks.size(); hops++) {
+			const auto& instructions = blocks[target].instructions;
+			if (instructions.size() != 1 || instructions[0].opcode != Opcode::JUMP || instructions[0].target == target) {
+				break;
+			}
+
+			target = instructions[0].target;
+		}
+
+		return target;
+	};
+
+	for (auto& block : blocks) {
+		if (block.instructions.empty()) {
+			continue;
+		}
+
+		auto& terminator = block.getTerminator();
+		if (terminator.opcode != Opcode::JUMP && terminator.opcode != Opcode::BRANCH) {
+			continue;
+		}
+
+		auto target = resolve(terminator.target);
+		auto elseTarget = terminator.opcode == Opcode::BRANCH ? resolve(terminator.elseTarget) : 0;
+		if (target != terminator.target || elseTarget != terminator.elseTarget) {
+			terminator.target = target;
+			terminator.elseTarget = elseTarget;
+			changed = true;
+		}
+
+		if (terminator.opcode == Opcode::BRANCH && terminator.target == terminator.elseTarget) {
+			terminator.opcode = Opcode::JUMP;
+			terminator.operands.clear();
+			terminator.elseTarget = 0;
+			changed = true;
+		}
+	}
+
+	// Merge blocks into their only predecessor when it jumps straight to them
+	auto reachable = getReachableBlocks(function);
+	Vec<uint32_t> predecessors(blocks.size(), 0);
+
+	for (BlockId block = 0; block < blocks.size(); block++) {
+		if (reachable[block]) {
+			for (auto successor : blocks[block].getSuccessors()) {
+				predecessors[successor]++;
+			}
+		}
+	}
+
+	for (BlockId block = 0; block < blocks.size(); block++) {
+		if (!reachable[block]) {
+			continue;
+		}
+
+		auto& instructions = blocks[block].instructions;
+		while (!instructions.empty() && instructions.back().opcode == Opcode::JUMP) {
+			auto next = instructions.back().target;
+			if (next == block || next == 0 || predecessors[next] != 1) {
+				break;
+			}
+
+			auto& merged = blocks[next].instructions;
+			instructions.pop_back();
+			instructions.insert(instructions.end(), std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()));
+			merged.clear();
+			reachable[next] = false;
+			changed = true;
+		}
+	}
+
+	// Drop unreachable blocks, the entry block stays first
+	Vec<BlockId> remap(blocks.size(), std::numeric_limits<BlockId>::max());
+	Vec<BasicBlock> kept;
+
+	for (BlockId block = 0; block < blocks.size(); block++) {
+		if (reachable[block]) {
+			remap[block] = static_cast<BlockId>(kept.size());
+			kept.push_back(Move(blocks[block]));
+		}
+	}
+
+	if (kept.size() != blocks.size()) {
+		for (auto& block : kept) {
+			auto& terminator = block.getTerminator();
+			terminator.target = remap[terminator.target];
+			terminator.elseTarget = terminator.opcode == Opcode::BRANCH ? remap[terminator.elseTarget] : 0;
+		}
+
+		blocks = Move(kept);
+		changed = true;
+	}
+	else {
+		blocks = Move(kept);
+	}
+
+	return changed;
+}
+
+MRK_NS_END
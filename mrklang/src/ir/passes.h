@@ -0,0 +1,103 @@
+#pragma once
+
+#include "common/types.h"
+#include "ir.h"
+
+#include <functional>
+
+MRK_NS_BEGIN_MODULE(ir)
+
+class Pass {
+public:
+	virtual ~Pass() = default;
+
+	virtual const char* getName() const = 0;
+
+	/// True if the function was changed
+	virtual bool run(Function& function) = 0;
+};
+
+/// IR of another function, nullptr if it was not lowered
+using FunctionLookup = std::function<const Function*(const FunctionSymbol*)>;
+
+/// Replaces calls to small leaf functions with a copy of their body
+/// Arguments are stored into the parameter slots of the copy, returns store into a temporary the call result is loaded from
+class InlinePass : public Pass {
+public:
+	/// Callees larger than this are left as calls
+	static constexpr size_t MAX_CALLEE_INSTRUCTIONS = 24;
+
+	/// Inlining stops once the caller has grown past this
+	static constexpr size_t MAX_CALLER_INSTRUCTIONS = 512;
+
+	explicit InlinePass(FunctionLookup lookup) : lookup_(Move(lookup)) {}
+
+	const char* getName() const override { return "inline"; }
+	bool run(Function& function) override;
+
+private:
+	FunctionLookup lookup_;
+
+	/// Callee IR if the call can be inlined
+	const Function* getInlineCandidate(const Function& caller, const Instruction& call) const;
+	void inlineCall(Function& caller, BlockId block, size_t index, const Function& callee);
+};
+
+/// Evaluates operators and conversions of constants with the ConstantEvaluator rules, branches on a constant become jumps
+class ConstantFoldingPass : public Pass {
+public:
+	const char* getName() const override { return "constant-folding"; }
+	bool run(Function& function) override;
+};
+
+/// Forwards the value stored to a slot or field to the loads following it in the same block
+/// Slots are never aliased, fields are forgotten at calls which may store to them
+class CopyPropagationPass : public Pass {
+public:
+	const char* getName() const override { return "copy-propagation"; }
+	bool run(Function& function) override;
+};
+
+/// Removes stores to slots that are never loaded, and stores overwritten in the same block before being loaded
+class DeadStoreEliminationPass : public Pass {
+public:
+	const char* getName() const override { return "dead-store-elimination"; }
+	bool run(Function& function) override;
+};
+
+/// Removes instructions without side effects whose result is unused
+class DeadValueEliminationPass : public Pass {
+public:
+	const char* getName() const override { return "dead-value-elimination"; }
+	bool run(Function& function) override;
+};
+
+/// Removes unreachable blocks, threads jumps through empty blocks and merges a block into its only predecessor
+class SimplifyCfgPass : public Pass {
+public:
+	const char* getName() const override { return "simplify-cfg"; }
+	bool run(Function& function) override;
+};
+
+/// Runs passes in order, the repeated ones until none of them changes the function anymore
+class PassManager {
+public:
+	static constexpr int MAX_ITERATIONS = 8;
+
+	/// Run once, before the repeated passes
+	void addPass(UniquePtr<Pass> pass) { passes_.push_back(Move(pass)); }
+
+	void addRepeatedPass(UniquePtr<Pass> pass) { repeatedPasses_.push_back(Move(pass)); }
+
+	/// True if any pass changed the function
+	bool run(Function& function);
+
+private:
+	Vec<UniquePtr<Pass>> passes_;
+	Vec<UniquePtr<Pass>> repeatedPasses_;
+};
+
+/// Replace every use of the keys with their value, following chains of replacements
+void replaceUses(Function& function, const Dict<ValueId, ValueId>& replacements);
+
+MRK_NS_END
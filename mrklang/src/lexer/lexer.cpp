@@ -177,6 +177,7 @@ void Lexer::readNumberLiteral() {
 				}
 
 				advance();
+				ch = tolower(peek());
 			}
 
 			break;
@@ -2,14 +2,60 @@
 
 #include "common/types.h"
 #include "core/core.h"
+#include "server/compiler_server.h"
+
+#include <cstring>
 
 using namespace mrklang;
 
-int main() {
+int main(int argc, char** argv) {
+    // Long-running daemon, stdout is reserved for protocol messages
+    if (argc > 1 && std::strcmp(argv[1], "--server") == 0) {
+        server::CompilerServer server(std::cin, std::cout);
+        return server.run();
+    }
+
+    bool dumpGeneratedCode = false;
+    bool lineDirectives = true;
+    bool stripUnreachable = false;
+    bool optimize = true;
+    bool bytecodeOnly = false;
+    auto target = codegen::LayoutTarget::x64();
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--dump-code") == 0) {
+            dumpGeneratedCode = true;
+        }
+        else if (std::strcmp(argv[i], "--no-line-directives") == 0) {
+            lineDirectives = false;
+        }
+        else if (std::strcmp(argv[i], "--strip-unreachable") == 0) {
+            stripUnreachable = true;
+        }
+        else if (std::strcmp(argv[i], "--no-optimize") == 0) {
+            optimize = false;
+        }
+        else if (std::strcmp(argv[i], "--bytecode-only") == 0) {
+            bytecodeOnly = true;
+        }
+        else if (std::strncmp(argv[i], "--target=", 9) == 0) {
+            // Match the platform the runtime is built for, x64 or x86
+            if (!codegen::LayoutTarget::fromName(argv[i] + 9, target)) {
+                std::cerr << "Unknown target: " << (argv[i] + 9) << "\n";
+                return 1;
+            }
+        }
+    }
+
     std::cout << "mrklang codedom alpha\n";
 
     Vec<Str> sourceFilenames = { /*"examples/hello.mrk", */ "examples/web.mrk", "examples/main.mrk" };
     Core core(sourceFilenames);
+    core.setDumpGeneratedCode(dumpGeneratedCode);
+    core.setLineDirectives(lineDirectives);
+    core.setStripUnreachable(stripUnreachable);
+    core.setOptimize(optimize);
+    core.setBytecodeOnly(bytecodeOnly);
+    core.setTarget(target);
     int result = core.build();
 
     return result;
@@ -30,14 +30,15 @@ Str TypeReferenceExpr::getTypeName() const {
 		result += "*";
 	}
 
-	for (int i = 0; i < arrayRank; i++) {
-		result += "[]";
-	}
-
 	if (!genericArgs.empty()) {
 		result += Fmt("<{}>", utils::formatCollection(genericArgs));
 	}
 
+	// Arrays of the type written so far, see SymbolTable::resolveSymbol
+	for (int i = 0; i < arrayRank; i++) {
+		result += "[]";
+	}
+
 	return result;
 }
 
@@ -213,7 +214,7 @@ Str ForStmt::toString() const {
 
 Str ForeachStmt::toString() const {
 	return Fmt("ForeachStmt({}, {}, {})",
-		variable->toString(), collection->toString(), body->toString());
+		variable ? variable->toString() : "null", collection->toString(), body->toString());
 }
 
 Str WhileStmt::toString() const {
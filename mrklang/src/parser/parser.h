@@ -26,7 +26,7 @@ private:
 	Token previous_;
 
 	// Error handling
-	[[noreturn]] CompilerError* error(const Token& token, const Str& message);
+	CompilerError* error(const Token& token, const Str& message);
 	void synchronize();
 
 	// Token navigation
@@ -0,0 +1,695 @@
+#include "constant_evaluator.h"
+#include "symbol_table.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <limits>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+using namespace ast;
+
+/// Width in bits of an integral kind
+static int getIntegralWidth(TypeKind kind) {
+	switch (kind) {
+		case TypeKind::CHAR:
+		case TypeKind::I8:
+		case TypeKind::U8:
+			return 8;
+
+		case TypeKind::I16:
+		case TypeKind::U16:
+			return 16;
+
+		case TypeKind::I32:
+		case TypeKind::U32:
+			return 32;
+
+		default:
+			return 64;
+	}
+}
+
+bool ConstantValue::isIntegral() const {
+	switch (kind) {
+		case TypeKind::CHAR:
+		case TypeKind::I8:
+		case TypeKind::U8:
+		case TypeKind::I16:
+		case TypeKind::U16:
+		case TypeKind::I32:
+		case TypeKind::U32:
+		case TypeKind::I64:
+		case TypeKind::U64:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool ConstantValue::isSigned() const {
+	return kind == TypeKind::CHAR || kind == TypeKind::I8 || kind == TypeKind::I16 ||
+		kind == TypeKind::I32 || kind == TypeKind::I64;
+}
+
+bool ConstantValue::isFloating() const {
+	return kind == TypeKind::F32 || kind == TypeKind::F64;
+}
+
+Str ConstantValue::toString() const {
+	if (kind == TypeKind::BOOL) {
+		return boolean ? "true" : "false";
+	}
+
+	if (kind == TypeKind::STRING) {
+		return string;
+	}
+
+	if (kind == TypeKind::CHAR) {
+		return Str(1, static_cast<char>(integer));
+	}
+
+	if (isFloating()) {
+		return std::format("{}", floating);
+	}
+
+	return isSigned() ? std::format("{}", integer) : std::format("{}", unsignedInteger);
+}
+
+ConstantEvaluator::ConstantEvaluator(SymbolTable* symbolTable) : symbolTable_(symbolTable) {}
+
+void ConstantEvaluator::evaluate(const Vec<const ExprNode*>& expressions) {
+	// Enum members first, in declaration order, so their values are final before codegen reads them
+	for (auto type : symbolTable_->getTypes()) {
+		auto enumDecl = type->kind == SymbolKind::ENUM ? dynamic_cast<EnumDeclStmt*>(type->declNode) : nullptr;
+		if (!enumDecl) {
+			continue;
+		}
+
+		for (const auto& [name, value] : enumDecl->members) {
+			auto member = static_cast<EnumMemberSymbol*>(type->getMember(name->name));
+			if (!member || member->declNode != name.get()) {
+				continue; // Duplicate, already reported
+			}
+
+			if (auto& result = evaluateSymbol(member)) {
+				member->value = result->toString();
+			}
+		}
+	}
+
+	for (auto variable : symbolTable_->getVariables()) {
+		evaluateInitialValue(variable);
+	}
+
+	// Everything else in the order given
+	for (auto expr : expressions) {
+		evaluateExpression(expr);
+	}
+}
+
+void ConstantEvaluator::clear() {
+	expressions_.clear();
+	symbols_.clear();
+	initialValues_.clear();
+	evaluating_.clear();
+}
+
+const ConstantValue* ConstantEvaluator::getValue(const ExprNode* expr) const {
+	auto it = expressions_.find(expr);
+	return it != expressions_.end() && it->second ? &*it->second : nullptr;
+}
+
+const ConstantValue* ConstantEvaluator::getSymbolValue(const Symbol* symbol) const {
+	auto it = symbols_.find(symbol);
+	return it != symbols_.end() && it->second ? &*it->second : nullptr;
+}
+
+const ConstantValue* ConstantEvaluator::getInitialValue(const VariableSymbol* variable) const {
+	auto it = initialValues_.find(variable);
+	return it != initialValues_.end() && it->second ? &*it->second : nullptr;
+}
+
+const ConstantEvaluator::Result& ConstantEvaluator::evaluateExpression(const ExprNode* expr) {
+	auto it = expressions_.find(expr);
+	if (it != expressions_.end()) {
+		return it->second;
+	}
+
+	Result result;
+	if (auto literal = dynamic_cast<const LiteralExpr*>(expr)) {
+		result = evaluateLiteral(literal);
+	}
+	else if (auto unary = dynamic_cast<const UnaryExpr*>(expr)) {
+		result = evaluateUnary(unary);
+	}
+	else if (auto binary = dynamic_cast<const BinaryExpr*>(expr)) {
+		result = evaluateBinary(binary);
+	}
+	else if (auto ternary = dynamic_cast<const TernaryExpr*>(expr)) {
+		result = evaluateTernary(ternary);
+	}
+	else if (dynamic_cast<const IdentifierExpr*>(expr)) {
+		// The name of a declaration is not a use of it
+		auto symbol = symbolTable_->getNodeResolvedSymbol(expr);
+		auto varDecl = symbol ? dynamic_cast<const VarDeclStmt*>(symbol->declNode) : nullptr;
+
+		if (symbol && (!varDecl || varDecl->name.get() != expr)) {
+			result = evaluateSymbol(symbol);
+		}
+	}
+	else if (auto nsAccess = dynamic_cast<const NamespaceAccessExpr*>(expr)) {
+		// Calls along the path are never constant
+		bool isStaticPath = std::all_of(nsAccess->path.begin(), nsAccess->path.end(), [](const auto& segment) {
+			return dynamic_cast<const IdentifierExpr*>(segment.get()) != nullptr;
+		});
+
+		auto symbol = symbolTable_->getNodeResolvedSymbol(expr);
+		if (isStaticPath && symbol) {
+			result = evaluateSymbol(symbol);
+		}
+	}
+	else if (auto memberAccess = dynamic_cast<const MemberAccessExpr*>(expr)) {
+		// Only static access, an instance target still has to be evaluated
+		auto target = symbolTable_->getNodeResolvedSymbol(memberAccess->target.get());
+		auto symbol = symbolTable_->getNodeResolvedSymbol(expr);
+
+		if (target && symbol && (detail::hasFlag(target->kind, SymbolKind::TYPE) || target->kind == SymbolKind::NAMESPACE)) {
+			result = evaluateSymbol(symbol);
+		}
+	}
+
+	return expressions_.emplace(expr, Move(result)).first->second;
+}
+
+ConstantEvaluator::Result ConstantEvaluator::evaluateLiteral(const LiteralExpr* expr) {
+	TypeKind kind;
+	if (!getExpressionKind(expr, &kind)) {
+		return std::nullopt;
+	}
+
+	const auto& lexeme = expr->value.lexeme;
+	switch (expr->value.type) {
+		case TokenType::LIT_INT:
+		case TokenType::LIT_HEX: {
+			bool isHex = expr->value.type == TokenType::LIT_HEX;
+			auto begin = lexeme.data() + (isHex ? 2 : 0);
+			auto end = lexeme.data() + lexeme.size();
+
+			uint64_t bits = 0;
+			auto parsed = std::from_chars(begin, end, bits, isHex ? 16 : 10);
+			if (parsed.ec != std::errc() || parsed.ptr != end) {
+				return std::nullopt;
+			}
+
+			auto value = makeIntegral(kind, bits);
+
+			// Out of range literals are left to the C++ compiler
+			if (value.unsignedInteger != bits || (value.isSigned() && value.integer < 0)) {
+				return std::nullopt;
+			}
+
+			return value;
+		}
+
+		case TokenType::LIT_FLOAT: {
+			double value = 0;
+			auto parsed = std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+			if (parsed.ec != std::errc() || parsed.ptr != lexeme.data() + lexeme.size()) {
+				return std::nullopt;
+			}
+
+			return makeFloating(kind, value);
+		}
+
+		case TokenType::LIT_BOOL:
+			return makeBoolean(lexeme == "true");
+
+		case TokenType::LIT_STRING: {
+			ConstantValue value;
+			value.kind = TypeKind::STRING;
+			value.string = lexeme;
+			return value;
+		}
+
+		case TokenType::LIT_CHAR:
+			if (lexeme.size() != 1) {
+				return std::nullopt;
+			}
+
+			return makeIntegral(TypeKind::CHAR, static_cast<uint8_t>(lexeme[0]));
+
+		default:
+			// Null is not a constant we can emit
+			return std::nullopt;
+	}
+}
+
+ConstantEvaluator::Result ConstantEvaluator::evaluateUnary(const UnaryExpr* expr) {
+	auto& operand = evaluateExpression(expr->right.get());
+
+	TypeKind kind;
+	if (!operand || !getExpressionKind(expr, &kind)) {
+		return std::nullopt;
+	}
+
+	return foldUnary(expr->op.type, kind, *operand);
+}
+
+ConstantEvaluator::Result ConstantEvaluator::evaluateBinary(const BinaryExpr* expr) {
+	auto& left = evaluateExpression(expr->left.get());
+	auto& right = evaluateExpression(expr->right.get());
+
+	TypeKind kind;
+	if (!left || !right || !getExpressionKind(expr, &kind)) {
+		return std::nullopt;
+	}
+
+	auto op = expr->op.type;
+
+	// Comparisons are evaluated in the common type of both operands
+	if (isComparison(op)) {
+		auto typeSystem = symbolTable_->getTypeSystem();
+		auto commonType = typeSystem->getCommonType(
+			typeSystem->getSymbolType(symbolTable_->getNodeResolvedSymbol(expr->left.get())),
+			typeSystem->getSymbolType(symbolTable_->getNodeResolvedSymbol(expr->right.get()))
+		);
+
+		TypeKind commonKind;
+		if (!commonType || !typeSystem->getTypeKind(commonType, &commonKind)) {
+			return std::nullopt;
+		}
+
+		return foldBinary(op, commonKind, *left, *right);
+	}
+
+	if (op == TokenType::OP_SLASH || op == TokenType::OP_MOD) {
+		auto l = convert(*left, kind);
+		auto r = convert(*right, kind);
+
+		if (l && r && l->isIntegral() && r->unsignedInteger == 0) {
+			symbolTable_->error(expr, "Division by constant zero");
+			return std::nullopt;
+		}
+	}
+
+	return foldBinary(op, kind, *left, *right);
+}
+
+bool ConstantEvaluator::isComparison(TokenType op) {
+	return op == TokenType::OP_EQ_EQ || op == TokenType::OP_NOT_EQ ||
+		op == TokenType::OP_LT || op == TokenType::OP_LE ||
+		op == TokenType::OP_GT || op == TokenType::OP_GE;
+}
+
+ConstantEvaluator::Result ConstantEvaluator::foldUnary(TokenType op, TypeKind kind, const ConstantValue& operand) {
+	auto value = convert(operand, kind);
+	if (!value) {
+		return std::nullopt;
+	}
+
+	switch (op) {
+		case TokenType::OP_MINUS:
+			if (value->isFloating()) {
+				return makeFloating(kind, -value->floating);
+			}
+
+			if (value->isIntegral()) {
+				return makeIntegral(kind, 0 - value->unsignedInteger);
+			}
+
+			break;
+
+		case TokenType::OP_NOT:
+			if (kind == TypeKind::BOOL) {
+				return makeBoolean(!value->boolean);
+			}
+
+			break;
+
+		case TokenType::OP_BNOT:
+			if (value->isIntegral()) {
+				return makeIntegral(kind, ~value->unsignedInteger);
+			}
+
+			break;
+	}
+
+	return std::nullopt;
+}
+
+ConstantEvaluator::Result ConstantEvaluator::foldBinary(TokenType op, TypeKind kind, const ConstantValue& left, const ConstantValue& right) {
+	if (isComparison(op)) {
+		auto l = convert(left, kind);
+		auto r = convert(right, kind);
+		if (!l || !r) {
+			return std::nullopt;
+		}
+
+		int order;
+		if (kind == TypeKind::BOOL || kind == TypeKind::STRING) {
+			if (op != TokenType::OP_EQ_EQ && op != TokenType::OP_NOT_EQ) {
+				return std::nullopt;
+			}
+
+			order = kind == TypeKind::BOOL ? (l->boolean == r->boolean ? 0 : 1) : l->string.compare(r->string);
+		}
+		else if (l->isFloating()) {
+			// Unordered comparisons are left to runtime
+			if (std::isnan(l->floating) || std::isnan(r->floating)) {
+				return std::nullopt;
+			}
+
+			order = l->floating < r->floating ? -1 : l->floating > r->floating ? 1 : 0;
+		}
+		else if (l->isSigned()) {
+			order = l->integer < r->integer ? -1 : l->integer > r->integer ? 1 : 0;
+		}
+		else {
+			order = l->unsignedInteger < r->unsignedInteger ? -1 : l->unsignedInteger > r->unsignedInteger ? 1 : 0;
+		}
+
+		switch (op) {
+			case TokenType::OP_EQ_EQ: return makeBoolean(order == 0);
+			case TokenType::OP_NOT_EQ: return makeBoolean(order != 0);
+			case TokenType::OP_LT: return makeBoolean(order < 0);
+			case TokenType::OP_LE: return makeBoolean(order <= 0);
+			case TokenType::OP_GT: return makeBoolean(order > 0);
+			default: return makeBoolean(order >= 0);
+		}
+	}
+
+	if (op == TokenType::OP_AND || op == TokenType::OP_OR) {
+		if (left.kind != TypeKind::BOOL || right.kind != TypeKind::BOOL) {
+			return std::nullopt;
+		}
+
+		return makeBoolean(op == TokenType::OP_AND ? left.boolean && right.boolean : left.boolean || right.boolean);
+	}
+
+	// String concatenation, chars are appended as is
+	if (kind == TypeKind::STRING) {
+		if (op != TokenType::OP_PLUS) {
+			return std::nullopt;
+		}
+
+		auto toText = [](const ConstantValue& value) -> std::optional<Str> {
+			if (value.kind == TypeKind::STRING) return value.string;
+			if (value.kind == TypeKind::CHAR) return Str(1, static_cast<char>(value.integer));
+			return std::nullopt;
+		};
+
+		auto l = toText(left);
+		auto r = toText(right);
+		if (!l || !r) {
+			return std::nullopt;
+		}
+
+		ConstantValue value;
+		value.kind = TypeKind::STRING;
+		value.string = *l + *r;
+		return value;
+	}
+
+	auto l = convert(left, kind);
+	auto r = op == TokenType::OP_SHL || op == TokenType::OP_SHR ? convert(right, TypeKind::I64) : convert(right, kind);
+	if (!l || !r) {
+		return std::nullopt;
+	}
+
+	if (l->isFloating()) {
+		double result;
+		switch (op) {
+			case TokenType::OP_PLUS: result = l->floating + r->floating; break;
+			case TokenType::OP_MINUS: result = l->floating - r->floating; break;
+			case TokenType::OP_ASTERISK: result = l->floating * r->floating; break;
+			case TokenType::OP_SLASH: result = l->floating / r->floating; break;
+			case TokenType::OP_MOD: result = std::fmod(l->floating, r->floating); break;
+			default: return std::nullopt;
+		}
+
+		// Infinities and NaNs have no literal form
+		auto value = makeFloating(kind, result);
+		if (!std::isfinite(value.floating)) {
+			return std::nullopt;
+		}
+
+		return value;
+	}
+
+	if (!l->isIntegral()) {
+		return std::nullopt;
+	}
+
+	// Wrapping arithmetic is done on the raw bits, then truncated to the width of the kind
+	auto a = l->unsignedInteger;
+	auto b = r->unsignedInteger;
+
+	switch (op) {
+		case TokenType::OP_PLUS: return makeIntegral(kind, a + b);
+		case TokenType::OP_MINUS: return makeIntegral(kind, a - b);
+		case TokenType::OP_ASTERISK: return makeIntegral(kind, a * b);
+		case TokenType::OP_BAND: return makeIntegral(kind, a & b);
+		case TokenType::OP_BOR: return makeIntegral(kind, a | b);
+		case TokenType::OP_BXOR: return makeIntegral(kind, a ^ b);
+
+		case TokenType::OP_SLASH:
+		case TokenType::OP_MOD: {
+			// Left to runtime, it traps there
+			if (b == 0) {
+				return std::nullopt;
+			}
+
+			if (!l->isSigned()) {
+				return makeIntegral(kind, op == TokenType::OP_SLASH ? a / b : a % b);
+			}
+
+			// Overflows in 64 bits, narrower kinds wrap like any other result
+			if (l->integer == std::numeric_limits<int64_t>::min() && r->integer == -1) {
+				return op == TokenType::OP_MOD ? std::optional(makeIntegral(kind, 0)) : std::nullopt;
+			}
+
+			auto result = op == TokenType::OP_SLASH ? l->integer / r->integer : l->integer % r->integer;
+			return makeIntegral(kind, static_cast<uint64_t>(result));
+		}
+
+		case TokenType::OP_SHL:
+		case TokenType::OP_SHR: {
+			// Shift counts are masked to the width, as in C#
+			auto count = static_cast<int>(r->unsignedInteger & (getIntegralWidth(kind) - 1));
+
+			if (op == TokenType::OP_SHL) {
+				return makeIntegral(kind, a << count);
+			}
+
+			return l->isSigned() ? makeIntegral(kind, static_cast<uint64_t>(l->integer >> count)) : makeIntegral(kind, a >> count);
+		}
+	}
+
+	return std::nullopt;
+}
+
+ConstantEvaluator::Result ConstantEvaluator::evaluateTernary(const TernaryExpr* expr) {
+	auto& condition = evaluateExpression(expr->condition.get());
+
+	// Both branches are still evaluated so their own sub-expressions fold
+	auto& thenValue = evaluateExpression(expr->thenBranch.get());
+	auto& elseValue = evaluateExpression(expr->elseBranch.get());
+
+	TypeKind kind;
+	if (!condition || condition->kind != TypeKind::BOOL || !getExpressionKind(expr, &kind)) {
+		return std::nullopt;
+	}
+
+	auto& chosen = condition->boolean ? thenValue : elseValue;
+	if (!chosen) {
+		return std::nullopt;
+	}
+
+	return convert(*chosen, kind);
+}
+
+const ConstantEvaluator::Result& ConstantEvaluator::evaluateSymbol(const Symbol* symbol) {
+	auto it = symbols_.find(symbol);
+	if (it != symbols_.end()) {
+		return it->second;
+	}
+
+	Result result;
+	if (symbol->kind == SymbolKind::ENUM_MEMBER) {
+		result = evaluateEnumMember(symbol);
+	}
+	else if (symbol->kind == SymbolKind::VARIABLE) {
+		// Only values that can never change are propagated
+		auto modifiers = symbol->accessModifier;
+		if (detail::isCONST(modifiers) || (detail::isREADONLY(modifiers) && detail::isSTATIC(modifiers))) {
+			result = evaluateInitialValue(static_cast<const VariableSymbol*>(symbol));
+		}
+	}
+
+	return symbols_.emplace(symbol, Move(result)).first->second;
+}
+
+ConstantEvaluator::Result ConstantEvaluator::evaluateEnumMember(const Symbol* member) {
+	auto enumDecl = dynamic_cast<const EnumDeclStmt*>(member->parent->declNode);
+	if (!enumDecl) {
+		return std::nullopt;
+	}
+
+	if (!evaluating_.insert(member).second) {
+		symbolTable_->error(member->declNode, std::format("The evaluation of the constant value for '{}' involves a circular definition", member->qualifiedName));
+		return std::nullopt;
+	}
+
+	auto kind = TypeKind::I32;
+	symbolTable_->getTypeSystem()->getTypeKind(static_cast<const TypeSymbol*>(member->parent), &kind);
+
+	Result result;
+	for (size_t i = 0; i < enumDecl->members.size(); i++) {
+		const auto& [name, value] = enumDecl->members[i];
+		if (name.get() != member->declNode) {
+			continue;
+		}
+
+		if (value) {
+			if (auto& explicitValue = evaluateExpression(value.get())) {
+				result = convert(*explicitValue, kind);
+			}
+		}
+		else if (i == 0) {
+			result = makeIntegral(kind, 0);
+		}
+		else {
+			// Implicit values follow the previous member
+			auto previous = member->parent->getMember(enumDecl->members[i - 1].first->name);
+			if (previous) {
+				if (auto& previousValue = evaluateSymbol(previous)) {
+					result = makeIntegral(kind, previousValue->unsignedInteger + 1);
+				}
+			}
+		}
+
+		break;
+	}
+
+	evaluating_.erase(member);
+	return result;
+}
+
+const ConstantEvaluator::Result& ConstantEvaluator::evaluateInitialValue(const VariableSymbol* variable) {
+	auto it = initialValues_.find(variable);
+	if (it != initialValues_.end()) {
+		return it->second;
+	}
+
+	auto varDecl = dynamic_cast<const VarDeclStmt*>(variable->declNode);
+	if (!varDecl || !varDecl->initializer) {
+		return initialValues_.emplace(variable, std::nullopt).first->second;
+	}
+
+	if (!evaluating_.insert(variable).second) {
+		symbolTable_->error(variable->declNode, std::format("The evaluation of the constant value for '{}' involves a circular definition", variable->qualifiedName));
+
+		// Not memoized, the outermost evaluation records the result
+		static const Result none;
+		return none;
+	}
+
+	Result result;
+	TypeKind kind;
+	auto& value = evaluateExpression(varDecl->initializer.get());
+	if (value && symbolTable_->getTypeSystem()->getTypeKind(variable->resolver.type, &kind)) {
+		result = convert(*value, kind);
+	}
+
+	evaluating_.erase(variable);
+	return initialValues_.emplace(variable, Move(result)).first->second;
+}
+
+bool ConstantEvaluator::getExpressionKind(const ExprNode* expr, TypeKind* kind) const {
+	auto typeSystem = symbolTable_->getTypeSystem();
+	auto type = typeSystem->getSymbolType(symbolTable_->getNodeResolvedSymbol(expr));
+	return type && typeSystem->getTypeKind(type, kind);
+}
+
+ConstantEvaluator::Result ConstantEvaluator::convert(const ConstantValue& value, TypeKind kind) {
+	if (value.kind == kind) {
+		return value;
+	}
+
+	ConstantValue target;
+	target.kind = kind;
+
+	if (target.isIntegral()) {
+		if (value.isIntegral()) {
+			return makeIntegral(kind, value.unsignedInteger);
+		}
+
+		if (value.isFloating()) {
+			auto truncated = std::trunc(value.floating);
+
+			if (target.isSigned()) {
+				if (!(truncated >= -9223372036854775808.0 && truncated < 9223372036854775808.0)) {
+					return std::nullopt;
+				}
+
+				return makeIntegral(kind, static_cast<uint64_t>(static_cast<int64_t>(truncated)));
+			}
+
+			if (!(truncated >= 0 && truncated < 18446744073709551616.0)) {
+				return std::nullopt;
+			}
+
+			return makeIntegral(kind, static_cast<uint64_t>(truncated));
+		}
+	}
+	else if (target.isFloating()) {
+		if (value.isFloating()) {
+			return makeFloating(kind, value.floating);
+		}
+
+		if (value.isIntegral()) {
+			return makeFloating(kind, value.isSigned() ? static_cast<double>(value.integer) : static_cast<double>(value.unsignedInteger));
+		}
+	}
+
+	// Bools and strings never convert
+	return std::nullopt;
+}
+
+ConstantValue ConstantEvaluator::makeIntegral(TypeKind kind, uint64_t bits) {
+	ConstantValue value;
+	value.kind = kind;
+
+	auto width = getIntegralWidth(kind);
+	if (width < 64) {
+		bits &= (1ull << width) - 1;
+
+		// Sign extend so integer always holds the actual value
+		if (value.isSigned() && (bits >> (width - 1)) & 1) {
+			bits |= ~0ull << width;
+		}
+	}
+
+	value.unsignedInteger = bits;
+	return value;
+}
+
+ConstantValue ConstantEvaluator::makeFloating(TypeKind kind, double value) {
+	ConstantValue result;
+	result.kind = kind;
+	result.floating = kind == TypeKind::F32 ? static_cast<double>(static_cast<float>(value)) : value;
+	return result;
+}
+
+ConstantValue ConstantEvaluator::makeBoolean(bool value) {
+	ConstantValue result;
+	result.kind = TypeKind::BOOL;
+	result.boolean = value;
+	return result;
+}
+
+MRK_NS_END
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common/types.h"
+#include "parser/ast.h"
+#include "type_system.h"
+
+#include <optional>
+#include <unordered_set>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+struct Symbol;
+struct VariableSymbol;
+
+/// Compile time value of a constant expression
+struct ConstantValue {
+	/// Primitive kind of the value, integral values are normalized to its width
+	TypeKind kind;
+
+	union {
+		bool boolean;
+		int64_t integer; // Signed integrals and char, sign extended
+		uint64_t unsignedInteger; // Unsigned integrals, also the raw bits of signed ones
+		double floating; // F32 values are rounded to float precision
+	};
+
+	Str string;
+
+	ConstantValue() : kind(TypeKind::VOID), unsignedInteger(0) {}
+
+	bool isIntegral() const;
+	bool isSigned() const;
+	bool isFloating() const;
+
+	/// Human readable value, used for dumps and enum member values
+	Str toString() const;
+};
+
+/// Typed constant evaluation over the resolved AST
+/// Folds literal arithmetic, enum member values and const/readonly statics following the TypeSystem promotion rules
+/// Runs as a pass after expression resolution, afterwards the values are read only
+class ConstantEvaluator {
+public:
+	ConstantEvaluator(SymbolTable* symbolTable);
+
+	/// Evaluate enum members, variable initializers and the given expressions, in that order
+	/// Reports circular constant definitions and constant division by zero
+	void evaluate(const Vec<const ast::ExprNode*>& expressions);
+	void clear();
+
+	/// Value of an expression, nullptr if it is not constant
+	const ConstantValue* getValue(const ast::ExprNode* expr) const;
+
+	/// Value of an enum member or a const/readonly variable, nullptr if it is not constant
+	const ConstantValue* getSymbolValue(const Symbol* symbol) const;
+
+	/// Constant initial value of a variable, regardless of whether it is mutable
+	const ConstantValue* getInitialValue(const VariableSymbol* variable) const;
+
+	/// Apply an operator to constant operands, evaluated in the given kind following the same rules as the AST
+	/// Comparisons take the kind both operands are compared in and yield a bool
+	/// std::nullopt if the result is not representable, or is left to runtime like an integral division by zero
+	static std::optional<ConstantValue> foldUnary(TokenType op, TypeKind kind, const ConstantValue& operand);
+	static std::optional<ConstantValue> foldBinary(TokenType op, TypeKind kind, const ConstantValue& left, const ConstantValue& right);
+
+	/// Convert a value to another primitive kind, std::nullopt if not representable
+	static std::optional<ConstantValue> convert(const ConstantValue& value, TypeKind kind);
+
+	static bool isComparison(TokenType op);
+
+private:
+	using Result = std::optional<ConstantValue>;
+
+	SymbolTable* symbolTable_;
+	Dict<const ast::ExprNode*, Result> expressions_;
+	Dict<const Symbol*, Result> symbols_;
+	Dict<const VariableSymbol*, Result> initialValues_;
+
+	/// Symbols being evaluated, for cycle detection
+	std::unordered_set<const Symbol*> evaluating_;
+
+	const Result& evaluateExpression(const ast::ExprNode* expr);
+	Result evaluateLiteral(const ast::LiteralExpr* expr);
+	Result evaluateUnary(const ast::UnaryExpr* expr);
+	Result evaluateBinary(const ast::BinaryExpr* expr);
+	Result evaluateTernary(const ast::TernaryExpr* expr);
+
+	const Result& evaluateSymbol(const Symbol* symbol);
+	Result evaluateEnumMember(const Symbol* member);
+	const Result& evaluateInitialValue(const VariableSymbol* variable);
+
+	/// Kind of the resolved type of an expression
+	bool getExpressionKind(const ast::ExprNode* expr, TypeKind* kind) const;
+
+	/// Wrap an integral result to the width of its kind
+	static ConstantValue makeIntegral(TypeKind kind, uint64_t bits);
+	static ConstantValue makeFloating(TypeKind kind, double value);
+	static ConstantValue makeBoolean(bool value);
+};
+
+MRK_NS_END
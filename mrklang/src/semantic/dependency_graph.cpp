@@ -0,0 +1,123 @@
+#include "dependency_graph.h"
+
+#include <algorithm>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+static const Vec<const Symbol*> EMPTY_EDGES;
+
+void DependencyGraph::addDependency(const Symbol* dependent, const Symbol* dependency) {
+	dependent = getDeclaration(dependent);
+	dependency = getDeclaration(dependency);
+
+	if (!dependent || !dependency || dependent == dependency) {
+		return;
+	}
+
+	if (dependencies_[dependent].add(dependency)) {
+		dependents_[dependency].add(dependent);
+		edgeCount_++;
+	}
+}
+
+void DependencyGraph::clearDependencies(const Symbol* dependent) {
+	auto it = dependencies_.find(dependent);
+	if (it == dependencies_.end()) {
+		return;
+	}
+
+	for (auto dependency : it->second.list) {
+		auto depIt = dependents_.find(dependency);
+		if (depIt != dependents_.end()) {
+			depIt->second.remove(dependent);
+		}
+	}
+
+	edgeCount_ -= it->second.list.size();
+	dependencies_.erase(it);
+}
+
+const Vec<const Symbol*>& DependencyGraph::getDependencies(const Symbol* dependent) const {
+	auto it = dependencies_.find(dependent);
+	return it != dependencies_.end() ? it->second.list : EMPTY_EDGES;
+}
+
+const Vec<const Symbol*>& DependencyGraph::getDependents(const Symbol* dependency) const {
+	auto it = dependents_.find(dependency);
+	return it != dependents_.end() ? it->second.list : EMPTY_EDGES;
+}
+
+Vec<const Symbol*> DependencyGraph::collectInvalidated(const Symbol* changed, Change change) const {
+	Vec<const Symbol*> invalidated;
+
+	changed = getDeclaration(changed);
+	if (!changed) {
+		return invalidated;
+	}
+
+	// Types other than enums do not have bodies, but their dependents still need to be revisited
+	if (!detail::hasFlag(changed->kind, SymbolKind::TYPE) || changed->kind == SymbolKind::ENUM) {
+		invalidated.push_back(changed);
+	}
+
+	if (change == Change::SIGNATURE) {
+		for (auto dependent : getDependents(changed)) {
+			invalidated.push_back(dependent);
+		}
+	}
+
+	return invalidated;
+}
+
+void DependencyGraph::clear() {
+	dependencies_.clear();
+	dependents_.clear();
+	edgeCount_ = 0;
+}
+
+const Symbol* DependencyGraph::getDeclaration(const Symbol* symbol) {
+	if (!symbol) {
+		return nullptr;
+	}
+
+	switch (symbol->kind) {
+		case SymbolKind::FUNCTION:
+		case SymbolKind::CLASS:
+		case SymbolKind::STRUCT:
+		case SymbolKind::INTERFACE:
+		case SymbolKind::ENUM:
+			return symbol;
+
+		case SymbolKind::VARIABLE:
+			// Locals are part of their enclosing function
+			if (symbol->parent && detail::hasFlag(symbol->parent->kind, SymbolKind::FUNCTION | SymbolKind::BLOCK)) {
+				return nullptr;
+			}
+
+			return symbol;
+
+		case SymbolKind::ENUM_MEMBER:
+			return symbol->parent;
+
+		default:
+			// Namespaces, parameters, blocks and builtin types never change
+			return nullptr;
+	}
+}
+
+bool DependencyGraph::Edges::add(const Symbol* symbol) {
+	if (!set.insert(symbol).second) {
+		return false;
+	}
+
+	list.push_back(symbol);
+	return true;
+}
+
+void DependencyGraph::Edges::remove(const Symbol* symbol) {
+	if (set.erase(symbol)) {
+		list.erase(std::find(list.begin(), list.end(), symbol));
+	}
+}
+
+MRK_NS_END
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common/types.h"
+#include "symbols.h"
+
+#include <unordered_set>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+/// Declaration-level dependency graph
+/// Records which function bodies and variable initializers reference which declarations,
+/// as observed by the ExpressionResolver. Used to re-resolve only what an edit affects
+class DependencyGraph {
+public:
+	enum class Change {
+		/// A function body or a variable initializer changed
+		BODY,
+
+		/// The declaration's signature changed (type, return type, parameters, base types)
+		SIGNATURE
+	};
+
+	/// Record that dependent references dependency
+	/// Both ends are normalized to their declaration, locals and namespaces are not tracked
+	void addDependency(const Symbol* dependent, const Symbol* dependency);
+
+	/// Remove all outgoing edges of a dependent, used before re-resolving it
+	void clearDependencies(const Symbol* dependent);
+
+	const Vec<const Symbol*>& getDependencies(const Symbol* dependent) const;
+	const Vec<const Symbol*>& getDependents(const Symbol* dependency) const;
+
+	/// Collect the declarations that must be re-resolved after a change
+	/// A body change only invalidates the declaration itself,
+	/// a signature change invalidates the declaration and its direct dependents
+	Vec<const Symbol*> collectInvalidated(const Symbol* changed, Change change) const;
+
+	void clear();
+	size_t edgeCount() const { return edgeCount_; }
+
+	/// Map a symbol to the declaration that owns it, or nullptr if it is not tracked
+	static const Symbol* getDeclaration(const Symbol* symbol);
+
+private:
+	struct Edges {
+		Vec<const Symbol*> list; // Insertion order, keeps invalidation deterministic
+		std::unordered_set<const Symbol*> set;
+
+		bool add(const Symbol* symbol);
+		void remove(const Symbol* symbol);
+	};
+
+	Dict<const Symbol*, Edges> dependencies_;
+	Dict<const Symbol*, Edges> dependents_;
+	size_t edgeCount_ = 0;
+};
+
+MRK_NS_END
@@ -5,12 +5,39 @@
 MRK_NS_BEGIN_MODULE(semantic)
 
 ExpressionResolver::ExpressionResolver(SymbolTable* symbolTable)
-	: symbolTable_(symbolTable), currentFile_(nullptr), extraSearchScope_(nullptr) {}
+	: symbolTable_(symbolTable), currentFile_(nullptr), extraSearchScope_(nullptr), currentDeclaration_(nullptr) {}
 
 void ExpressionResolver::resolve(ast::Program* program) {
 	visit(program);
 }
 
+void ExpressionResolver::resolveDeclaration(Symbol* declaration) {
+	currentFile_ = declaration->declNode ? declaration->declNode->sourceFile : nullptr;
+
+	if (declaration == symbolTable_->getGlobalFunction()) {
+		// The global function's body is made of every top level statement
+		for (const auto& program : symbolTable_->getPrograms()) {
+			for (const auto& stmt : program->statements) {
+				if (auto ifStmt = dynamic_cast<IfStmt*>(stmt.get())) {
+					visit(ifStmt);
+				}
+			}
+		}
+
+		return;
+	}
+
+	if (auto funcDecl = dynamic_cast<FuncDeclStmt*>(declaration->declNode)) {
+		visit(funcDecl);
+	}
+	else if (auto varDecl = dynamic_cast<VarDeclStmt*>(declaration->declNode)) {
+		visit(varDecl);
+	}
+	else if (auto enumDecl = dynamic_cast<EnumDeclStmt*>(declaration->declNode)) {
+		visit(enumDecl);
+	}
+}
+
 void ExpressionResolver::visit(Program* node) {
 	currentFile_ = node->sourceFile;
 
@@ -66,6 +93,7 @@ void ExpressionResolver::visit(IdentifierExpr* node) {
 	}
 
 	symbolTable_->setNodeResolvedSymbol(node, symbol);
+	addDependency(node, symbol);
 }
 
 void ExpressionResolver::visit(TypeReferenceExpr* node) {
@@ -93,6 +121,7 @@ void ExpressionResolver::visit(TypeReferenceExpr* node) {
 
 	// Set the resolved type to the TypeSymbol itself
 	symbolTable_->setNodeResolvedSymbol(node, type);
+	addDependency(node, type);
 }
 
 void ExpressionResolver::visit(CallExpr* node) {
@@ -313,6 +342,7 @@ void ExpressionResolver::visit(NamespaceAccessExpr* node) {
 				}
 
 				symbolTable_->setNodeResolvedSymbol(ident, currentSymbol);
+				addDependency(ident, currentSymbol);
 			}
 		}
 		else {
@@ -360,6 +390,7 @@ void ExpressionResolver::visit(NamespaceAccessExpr* node) {
 				}
 
 				symbolTable_->setNodeResolvedSymbol(ident, currentSymbol);
+				addDependency(ident, currentSymbol);
 			}
 			else if (auto* call = dynamic_cast<CallExpr*>(expr)) {
 				// Current symbol should be the return type of the previous call
@@ -399,9 +430,9 @@ void ExpressionResolver::visit(MemberAccessExpr* node) {
 	// Find the member in the target type
 	Symbol* memberSymbol = nullptr;
 
-	// For types, look up in the type's members
-	if (targetType->kind == SymbolKind::TYPE) {
-		memberSymbol = targetType->getMember(node->member->name);
+	// For types, look up in the type's members and the ones it inherits
+	if (detail::hasFlag(targetType->kind, SymbolKind::TYPE)) {
+		memberSymbol = symbolTable_->getTypeSystem()->findMember(targetType, node->member->name);
 	}
 	// For namespaces, look up in the namespace's members
 	else if (targetSymbol->kind == SymbolKind::NAMESPACE) {
@@ -425,6 +456,7 @@ void ExpressionResolver::visit(MemberAccessExpr* node) {
 	// Set resolved symbol and type
 	symbolTable_->setNodeResolvedSymbol(node->member.get(), memberSymbol);
 	symbolTable_->setNodeResolvedSymbol(node, memberSymbol);
+	addDependency(node, memberSymbol);
 }
 
 void ExpressionResolver::visit(ArrayExpr* node) {
@@ -469,10 +501,7 @@ void ExpressionResolver::visit(ArrayExpr* node) {
 			);
 	}
 
-	// Create array type symbol
-	// TODO: Create proper array type based on element type
-	// For now, we'll just set the common element type as the resolved type
-	symbolTable_->setNodeResolvedSymbol(node, commonElementType);
+	symbolTable_->setNodeResolvedSymbol(node, symbolTable_->getTypeSystem()->getArrayType(commonElementType));
 }
 
 void ExpressionResolver::visit(ArrayAccessExpr* node) {
@@ -489,8 +518,7 @@ void ExpressionResolver::visit(ArrayAccessExpr* node) {
 		return;
 	}
 
-	// TODO: Implement proper array type checking
-	// For now, just check if it's marked as an array in some way
+	auto elementType = symbolTable_->getTypeSystem()->getArrayElementType(targetType);
 
 	// Check if index is a numeric type
 	auto indexSymbol = symbolTable_->getNodeResolvedSymbol(node->index.get());
@@ -504,10 +532,8 @@ void ExpressionResolver::visit(ArrayAccessExpr* node) {
 		);
 	}
 
-	// Set the resolved type to the element type of the array
-	// TODO: Get actual element type from array type
-	// For now, we'll just set it to the same type as the target
-	symbolTable_->setNodeResolvedSymbol(node, const_cast<TypeSymbol*>(targetType));
+	// Set the resolved type to the element type of the array, anything else indexes to its own type
+	symbolTable_->setNodeResolvedSymbol(node, const_cast<TypeSymbol*>(elementType ? elementType : targetType));
 }
 
 void ExpressionResolver::visit(ExprStmt* node) {
@@ -515,6 +541,13 @@ void ExpressionResolver::visit(ExprStmt* node) {
 }
 
 void ExpressionResolver::visit(VarDeclStmt* node) {
+	// Fields and globals own their initializer, locals belong to the enclosing function
+	auto prevDeclaration = currentDeclaration_;
+	auto declaration = symbolTable_->getDeclarationSymbol(node);
+	if (declaration && DependencyGraph::getDeclaration(declaration)) {
+		currentDeclaration_ = declaration;
+	}
+
 	if (node->typeName) {
 		node->typeName->accept(*this);
 	}
@@ -547,17 +580,14 @@ void ExpressionResolver::visit(VarDeclStmt* node) {
 			// Infer the variable type if not explicitly declared
 			if (!varType || 
 				varType == symbolTable_->getTypeSystem()->getBuiltinType(TypeKind::OBJECT)) {
+				// The inferred type lives on the symbol only, the AST is left untouched
+				// so that it can be collected and resolved again
 				varType = initType;
-
-				// Update decl node too
-				// HACK: set empty, but manually resolve
-				node->typeName = MakeUnique<TypeReferenceExpr>(node->startToken);
-
-				// Resolve the type again
-				symbolTable_->setNodeResolvedSymbol(node->typeName.get(), const_cast<TypeSymbol*>(initType));
 			}
 		}
 	}
+
+	currentDeclaration_ = prevDeclaration;
 }
 
 void ExpressionResolver::visit(BlockStmt* node) {
@@ -601,9 +631,14 @@ void ExpressionResolver::visit(ParamDeclStmt* node) {
 }
 
 void ExpressionResolver::visit(FuncDeclStmt* node) {
+	auto prevDeclaration = currentDeclaration_;
+	currentDeclaration_ = symbolTable_->getDeclarationSymbol(node);
+
 	if (node->body) {
 		node->body->accept(*this);
 	}
+
+	currentDeclaration_ = prevDeclaration;
 }
 
 void ExpressionResolver::visit(IfStmt* node) {
@@ -630,8 +665,40 @@ void ExpressionResolver::visit(ForStmt* node) {
 }
 
 void ExpressionResolver::visit(ForeachStmt* node) {
-	node->variable->accept(*this);
+	if (node->variable) {
+		node->variable->accept(*this);
+	}
+
 	node->collection->accept(*this);
+
+	auto typeSystem = symbolTable_->getTypeSystem();
+	auto collectionType = getSymbolType(symbolTable_->getNodeResolvedSymbol(node->collection.get()));
+	auto elementType = typeSystem->getArrayElementType(collectionType);
+
+	if (!elementType) {
+		if (collectionType && collectionType != typeSystem->getErrorType()) {
+			symbolTable_->error(
+				node->collection.get(),
+				std::format("Cannot iterate over '{}', array expected", collectionType->qualifiedName)
+			);
+		}
+	}
+	else if (auto variable = static_cast<VariableSymbol*>(symbolTable_->getDeclarationSymbol(node->variable.get()))) {
+		auto& varType = variable->resolver.type;
+
+		// Infer the variable type like an initialized declaration would
+		if (!varType || varType == typeSystem->getBuiltinType(TypeKind::OBJECT)) {
+			varType = elementType;
+		}
+		else if (!typeSystem->isAssignable(varType, elementType)) {
+			symbolTable_->error(
+				node->variable.get(),
+				std::format("Cannot implicitly convert type '{}' to '{}'",
+					elementType->qualifiedName, varType->qualifiedName)
+			);
+		}
+	}
+
 	node->body->accept(*this);
 }
 
@@ -644,7 +711,11 @@ void ExpressionResolver::visit(LangBlockStmt* node) {}
 
 void ExpressionResolver::visit(AccessModifierStmt* node) {}
 
-void ExpressionResolver::visit(NamespaceDeclStmt* node) {}
+void ExpressionResolver::visit(NamespaceDeclStmt* node) {
+	if (node->body) {
+		node->body->accept(*this);
+	}
+}
 
 void ExpressionResolver::visit(DeclSpecStmt* node) {}
 
@@ -712,42 +783,45 @@ void ExpressionResolver::visit(ReturnStmt* node) {
 }
 
 void ExpressionResolver::visit(EnumDeclStmt* node) {
-	if (node->name) {
-		node->name->accept(*this);
-	}
-
 	if (node->type) {
 		node->type->accept(*this);
 	}
 
-	auto* enumSymbol = symbolTable_->resolveSymbol(
-		SymbolKind::ENUM,
-		node->name->name,
-		symbolTable_->getNodeScope(node)
-	);
+	auto* enumSymbol = static_cast<EnumSymbol*>(symbolTable_->getDeclarationSymbol(node));
+	if (!enumSymbol) {
+		return;
+	}
+
+	auto typeSystem = symbolTable_->getTypeSystem();
+	auto underlyingType = typeSystem->getEnumUnderlyingType(enumSymbol);
+
+	if (node->type && !typeSystem->isIntegralType(underlyingType)) {
+		symbolTable_->error(node->type.get(), "Enum underlying type must be an integral type");
+		return;
+	}
 
-	// Visit enum members and their values
+	auto prevDeclaration = currentDeclaration_;
+	currentDeclaration_ = enumSymbol;
+
+	// Visit enum member values, members are values of the underlying type
 	for (const auto& [memberName, memberValue] : node->members) {
-		if (memberName) {
-			memberName->accept(*this);
+		if (!memberValue) {
+			continue;
 		}
 
-		if (memberValue) {
-			memberValue->accept(*this);
+		memberValue->accept(*this);
 
-			if (enumSymbol && enumSymbol->kind == SymbolKind::ENUM) {
-				auto* enumType = static_cast<EnumSymbol*>(enumSymbol);
-				auto* valueType = getSymbolType(symbolTable_->getNodeResolvedSymbol(memberValue.get()));
-				if (enumType && valueType && !symbolTable_->getTypeSystem()->isAssignable(enumType, valueType)) {
-					symbolTable_->error(
-						memberValue.get(),
-						std::format("Cannot implicitly convert type '{}' to '{}'",
-							valueType->qualifiedName, enumType->qualifiedName)
-					);
-				}
-			}
+		auto* valueType = getSymbolType(symbolTable_->getNodeResolvedSymbol(memberValue.get()));
+		if (valueType && !typeSystem->isAssignable(underlyingType, valueType)) {
+			symbolTable_->error(
+				memberValue.get(),
+				std::format("Cannot implicitly convert type '{}' to '{}'",
+					valueType->qualifiedName, underlyingType->qualifiedName)
+			);
 		}
 	}
+
+	currentDeclaration_ = prevDeclaration;
 }
 
 void ExpressionResolver::visit(TypeDeclStmt* node) {
@@ -761,25 +835,23 @@ void ExpressionResolver::setNodeAsError(const ExprNode* node) {
 }
 
 const TypeSymbol* ExpressionResolver::getSymbolType(const Symbol* symbol) {
-	if (symbol) {
-		if (detail::hasFlag(symbol->kind, SymbolKind::TYPE)) {
-			return static_cast<const TypeSymbol*>(symbol);
-		}
-
-		if (detail::hasFlag(symbol->kind, SymbolKind::FUNCTION)) {
-			return static_cast<const FunctionSymbol*>(symbol)->resolver.returnType;
-		}
+	return symbolTable_->getTypeSystem()->getSymbolType(symbol);
+}
 
-		if (detail::hasFlag(symbol->kind, SymbolKind::VARIABLE)) {
-			return static_cast<const VariableSymbol*>(symbol)->resolver.type;
+void ExpressionResolver::addDependency(const ast::Node* node, const Symbol* symbol) {
+	auto dependent = currentDeclaration_;
+	if (!dependent) {
+		// Top level statements are owned by the global function
+		auto scope = symbolTable_->getNodeScope(node);
+		if (scope && scope->kind != SymbolKind::FUNCTION) {
+			scope = symbolTable_->findAncestorOfKind(scope, SymbolKind::FUNCTION);
 		}
 
-		if (detail::hasFlag(symbol->kind, SymbolKind::FUNCTION_PARAMETER)) {
-			return static_cast<const FunctionParameterSymbol*>(symbol)->resolver.type;
-		}
+		// Statements directly in a namespace are scoped to it, not to the global function
+		dependent = scope ? const_cast<Symbol*>(scope) : symbolTable_->getGlobalFunction();
 	}
 
-	return symbolTable_->getTypeSystem()->getErrorType();
+	symbolTable_->getDependencyGraph()->addDependency(dependent, symbol);
 }
 
 bool ExpressionResolver::isErrorNode(const ExprNode* node) const {
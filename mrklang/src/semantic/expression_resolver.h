@@ -16,6 +16,9 @@ public:
 	ExpressionResolver(SymbolTable* symbolTable);
 	void resolve(ast::Program* program);
 
+	/// Re-resolve the body of a function or the initializer of a variable
+	void resolveDeclaration(Symbol* declaration);
+
 	void visit(Program* node) override;
 	void visit(LiteralExpr* node) override;
 	void visit(InterpolatedStringExpr* node) override;
@@ -57,6 +60,12 @@ private:
 	// For use with qualified expressions
 	Symbol* extraSearchScope_;
 
+	// Function or variable whose body/initializer is being resolved
+	Symbol* currentDeclaration_;
+
+	/// Record that the current declaration references a symbol
+	void addDependency(const ast::Node* node, const Symbol* symbol);
+
 	void setNodeAsError(const ExprNode* node);
 	const TypeSymbol* getSymbolType(const Symbol* symbol);
 	bool isErrorNode(const ExprNode* node) const;
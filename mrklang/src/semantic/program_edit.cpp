@@ -0,0 +1,298 @@
+#include "program_edit.h"
+#include "common/declspecs.h"
+
+#include <algorithm>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+using namespace ast;
+
+static constexpr size_t npos = static_cast<size_t>(-1);
+
+/// Collects every node of a subtree in preorder
+class NodeCollector : public ASTVisitor {
+public:
+	Vec<Node*> nodes;
+
+	template<typename T>
+	void collect(const UniquePtr<T>& node) {
+		if (node) {
+			node->accept(*this);
+		}
+	}
+
+	template<typename T>
+	void collect(const Vec<UniquePtr<T>>& list) {
+		for (const auto& node : list) {
+			collect(node);
+		}
+	}
+
+	void visit(LiteralExpr* node) override { nodes.push_back(node); }
+	void visit(InterpolatedStringExpr* node) override { nodes.push_back(node); collect(node->parts); }
+	void visit(InteropCallExpr* node) override { nodes.push_back(node); collect(node->method); collect(node->args); }
+	void visit(IdentifierExpr* node) override { nodes.push_back(node); }
+	void visit(TypeReferenceExpr* node) override { nodes.push_back(node); collect(node->identifiers); collect(node->genericArgs); }
+	void visit(CallExpr* node) override { nodes.push_back(node); collect(node->target); collect(node->arguments); }
+	void visit(BinaryExpr* node) override { nodes.push_back(node); collect(node->left); collect(node->right); }
+	void visit(UnaryExpr* node) override { nodes.push_back(node); collect(node->right); }
+
+	void visit(TernaryExpr* node) override {
+		nodes.push_back(node);
+		collect(node->condition);
+		collect(node->thenBranch);
+		collect(node->elseBranch);
+	}
+
+	void visit(AssignmentExpr* node) override { nodes.push_back(node); collect(node->target); collect(node->value); }
+	void visit(NamespaceAccessExpr* node) override { nodes.push_back(node); collect(node->path); }
+	void visit(MemberAccessExpr* node) override { nodes.push_back(node); collect(node->target); collect(node->member); }
+	void visit(ArrayExpr* node) override { nodes.push_back(node); collect(node->elements); }
+	void visit(ArrayAccessExpr* node) override { nodes.push_back(node); collect(node->target); collect(node->index); }
+
+	void visit(ExprStmt* node) override { nodes.push_back(node); collect(node->expr); }
+
+	void visit(VarDeclStmt* node) override {
+		nodes.push_back(node);
+		collect(node->typeName);
+		collect(node->name);
+		collect(node->initializer);
+	}
+
+	void visit(BlockStmt* node) override { nodes.push_back(node); collect(node->statements); }
+
+	void visit(ParamDeclStmt* node) override {
+		nodes.push_back(node);
+		collect(node->type);
+		collect(node->name);
+		collect(node->initializer);
+	}
+
+	void visit(FuncDeclStmt* node) override {
+		nodes.push_back(node);
+		collect(node->name);
+		collect(node->parameters);
+		collect(node->returnType);
+		collect(node->body);
+	}
+
+	void visit(IfStmt* node) override {
+		nodes.push_back(node);
+		collect(node->condition);
+		collect(node->thenBlock);
+		collect(node->elseBlock);
+	}
+
+	void visit(ForStmt* node) override {
+		nodes.push_back(node);
+		collect(node->init);
+		collect(node->condition);
+		collect(node->increment);
+		collect(node->body);
+	}
+
+	void visit(ForeachStmt* node) override {
+		nodes.push_back(node);
+		collect(node->variable);
+		collect(node->collection);
+		collect(node->body);
+	}
+
+	void visit(WhileStmt* node) override { nodes.push_back(node); collect(node->condition); collect(node->body); }
+	void visit(LangBlockStmt* node) override { nodes.push_back(node); }
+	void visit(AccessModifierStmt* node) override { nodes.push_back(node); }
+	void visit(NamespaceDeclStmt* node) override { nodes.push_back(node); collect(node->path); collect(node->body); }
+	void visit(DeclSpecStmt* node) override { nodes.push_back(node); collect(node->spec); }
+
+	void visit(UseStmt* node) override {
+		nodes.push_back(node);
+		for (const auto& path : node->paths) {
+			collect(path);
+		}
+
+		collect(node->file);
+	}
+
+	void visit(ReturnStmt* node) override { nodes.push_back(node); collect(node->value); }
+
+	void visit(EnumDeclStmt* node) override {
+		nodes.push_back(node);
+		collect(node->name);
+		collect(node->type);
+
+		for (const auto& [name, value] : node->members) {
+			collect(name);
+			collect(value);
+		}
+	}
+
+	void visit(TypeDeclStmt* node) override {
+		nodes.push_back(node);
+		collect(node->name);
+		collect(node->aliases);
+		collect(node->baseTypes);
+		collect(node->body);
+	}
+};
+
+/// Functions are only declared at the top level, within namespaces and within types
+static void collectFunctions(const Vec<UniquePtr<StmtNode>>& statements, Vec<FuncDeclStmt*>& functions) {
+	for (const auto& stmt : statements) {
+		if (auto function = dynamic_cast<FuncDeclStmt*>(stmt.get())) {
+			functions.push_back(function);
+		}
+		else if (auto ns = dynamic_cast<NamespaceDeclStmt*>(stmt.get())) {
+			collectFunctions(ns->body->statements, functions);
+		}
+		else if (auto type = dynamic_cast<TypeDeclStmt*>(stmt.get())) {
+			collectFunctions(type->body->statements, functions);
+		}
+	}
+}
+
+/// Index of a node's start token, npos if the token is not part of the program
+static size_t findToken(const Vec<Token>& tokens, const Token& token) {
+	auto it = std::lower_bound(tokens.begin(), tokens.end(), token.position.index, [](const Token& t, uint32_t index) {
+		return t.position.index < index;
+	});
+
+	if (it == tokens.end() || it->position.index != token.position.index || it->type != token.type) {
+		return npos;
+	}
+
+	return it - tokens.begin();
+}
+
+static size_t findClosingBrace(const Vec<Token>& tokens, size_t open) {
+	if (open == npos) {
+		return npos;
+	}
+
+	size_t depth = 0;
+	for (auto i = open; i < tokens.size(); i++) {
+		if (tokens[i].type == TokenType::LBRACE) {
+			depth++;
+		}
+		else if (tokens[i].type == TokenType::RBRACE && --depth == 0) {
+			return i;
+		}
+	}
+
+	return npos;
+}
+
+/// Whether collecting the function again only declares locals, anything else lives outside of it
+/// Rigid blocks are hoisted out of their function as well
+static bool declaresOnlyLocals(FuncDeclStmt* function) {
+	for (auto node : ProgramEdit::collectFunctionNodes(function)) {
+		if (dynamic_cast<FuncDeclStmt*>(node) || dynamic_cast<TypeDeclStmt*>(node) || dynamic_cast<EnumDeclStmt*>(node) ||
+			dynamic_cast<NamespaceDeclStmt*>(node) || dynamic_cast<UseStmt*>(node)) {
+			return false;
+		}
+
+		auto declSpec = dynamic_cast<DeclSpecStmt*>(node);
+		if (declSpec && declSpec->spec->name == DECLSPEC_NO_MOVE) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+ProgramEdit::ProgramEdit(const Vec<Token>& analyzedTokens, const Vec<Token>& editedTokens)
+	: analyzedTokens_(analyzedTokens), editedTokens_(editedTokens), prefix_(0), suffix_(0) {
+	auto same = [](const Token& a, const Token& b) {
+		return a.type == b.type && a.lexeme == b.lexeme;
+	};
+
+	auto shared = std::min(analyzedTokens_.size(), editedTokens_.size());
+	while (prefix_ < shared && same(analyzedTokens_[prefix_], editedTokens_[prefix_])) {
+		prefix_++;
+	}
+
+	while (suffix_ < shared - prefix_ &&
+		same(analyzedTokens_[analyzedTokens_.size() - suffix_ - 1], editedTokens_[editedTokens_.size() - suffix_ - 1])) {
+		suffix_++;
+	}
+}
+
+bool ProgramEdit::findFunctionEdit(Program* analyzed, Program* edited, FunctionEdit& edit) const {
+	// Tokens that only moved, e.g. whitespace edits, leave every declaration as it is
+	if (prefix_ == analyzedEnd() && prefix_ == editedEnd()) {
+		edit = { nullptr, nullptr, DependencyGraph::Change::BODY };
+		return true;
+	}
+
+	Vec<FuncDeclStmt*> analyzedFunctions;
+	collectFunctions(analyzed->statements, analyzedFunctions);
+
+	for (auto function : analyzedFunctions) {
+		// The function keyword and the closing brace are kept, so is everything around them
+		auto start = findToken(analyzedTokens_, function->startToken);
+		auto open = findToken(analyzedTokens_, function->body->startToken);
+		auto close = findClosingBrace(analyzedTokens_, open);
+		if (start == npos || close == npos || prefix_ <= start || analyzedEnd() > close) {
+			continue;
+		}
+
+		Vec<FuncDeclStmt*> editedFunctions;
+		collectFunctions(edited->statements, editedFunctions);
+
+		auto it = std::find_if(editedFunctions.begin(), editedFunctions.end(), [&](FuncDeclStmt* candidate) {
+			return findToken(editedTokens_, candidate->startToken) == start;
+		});
+
+		if (it == editedFunctions.end() || (*it)->name->name != function->name->name) {
+			return false;
+		}
+
+		auto editedClose = findClosingBrace(editedTokens_, findToken(editedTokens_, (*it)->body->startToken));
+		if (editedClose == npos || editedEnd() > editedClose || mapIndex(close) != editedClose) {
+			return false;
+		}
+
+		if (!declaresOnlyLocals(function) || !declaresOnlyLocals(*it)) {
+			return false;
+		}
+
+		edit = { function, *it, prefix_ > open ? DependencyGraph::Change::BODY : DependencyGraph::Change::SIGNATURE };
+		return true;
+	}
+
+	return false;
+}
+
+void ProgramEdit::movePositions(Program* analyzed) const {
+	NodeCollector collector;
+	collector.collect(analyzed->statements);
+
+	for (auto node : collector.nodes) {
+		auto index = mapIndex(findToken(analyzedTokens_, node->startToken));
+		if (index != npos) {
+			node->startToken.position = editedTokens_[index].position;
+		}
+	}
+}
+
+Vec<Node*> ProgramEdit::collectFunctionNodes(FuncDeclStmt* function) {
+	NodeCollector collector;
+	collector.collect(function->parameters);
+	collector.collect(function->returnType);
+	collector.collect(function->body);
+
+	return Move(collector.nodes);
+}
+
+size_t ProgramEdit::mapIndex(size_t index) const {
+	if (index < prefix_) {
+		return index;
+	}
+
+	if (index != npos && index >= analyzedEnd()) {
+		return index - analyzedEnd() + editedEnd();
+	}
+
+	return npos;
+}
+
+MRK_NS_END
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common/types.h"
+#include "lexer/token.h"
+#include "parser/ast.h"
+#include "dependency_graph.h"
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+/// An edit confined to a single function
+struct FunctionEdit {
+	/// The function in the analyzed and in the edited program, both null if tokens only moved
+	ast::FuncDeclStmt* analyzed;
+	ast::FuncDeclStmt* edited;
+
+	/// BODY if only the body changed, SIGNATURE if the parameters or the return type did
+	DependencyGraph::Change change;
+};
+
+/// Token-level diff between the analyzed and the edited version of a program
+/// Everything before the first and after the last differing token is unchanged, the edit is what lies in between
+class ProgramEdit {
+public:
+	ProgramEdit(const Vec<Token>& analyzedTokens, const Vec<Token>& editedTokens);
+
+	/// Find the function the edit is confined to
+	/// Returns false if the edit reaches outside of a function, renames it, or declares anything but locals within it
+	bool findFunctionEdit(ast::Program* analyzed, ast::Program* edited, FunctionEdit& edit) const;
+
+	/// Move the nodes of the analyzed program outside of the edit to their position in the edited program
+	/// Only start tokens are moved, they are the only positions anything reads
+	void movePositions(ast::Program* analyzed) const;
+
+	/// The nodes an edit of a function replaces, its parameters, return type and body
+	static Vec<ast::Node*> collectFunctionNodes(ast::FuncDeclStmt* function);
+
+private:
+	const Vec<Token>& analyzedTokens_;
+	const Vec<Token>& editedTokens_;
+	size_t prefix_;
+	size_t suffix_;
+
+	/// End of the edit in each version, exclusive
+	size_t analyzedEnd() const { return analyzedTokens_.size() - suffix_; }
+	size_t editedEnd() const { return editedTokens_.size() - suffix_; }
+
+	/// Index of an analyzed token in the edited program, npos if it lies within the edit
+	size_t mapIndex(size_t index) const;
+};
+
+MRK_NS_END
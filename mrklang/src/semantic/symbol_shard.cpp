@@ -0,0 +1,133 @@
+#include "symbol_shard.h"
+#include "symbol_table.h"
+#include "symbol_visitor.h"
+
+#include <format>
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+SymbolShard::SymbolShard(const SymbolTable* symbolTable, ast::Program* program, uint32_t fileIndex)
+	: symbolTable_(symbolTable), program_(program), fileIndex_(fileIndex) {
+	// Shard-local global namespace
+	globalNamespace_ = declareNamespace("__global");
+
+	// Proxies for the injected global type and function
+	// Their qualified names match the real ones, which are only known after the <global> file is merged
+	globalType_ = MakeUnique<ClassSymbol>("__globalType", Vec<Str>{}, globalNamespace_, nullptr);
+	globalFunction_ = MakeUnique<FunctionSymbol>("__globalFunction", "void", FunctionSymbol::ParameterList{}, false, globalType_.get(), nullptr);
+}
+
+SymbolShard::~SymbolShard() = default;
+
+NamespaceSymbol* SymbolShard::declareNamespace(const Str& nsName, NamespaceSymbol* parent, ASTNode* declNode) {
+	auto namespaceFullname = nsName;
+	if (parent) {
+		namespaceFullname = parent->qualifiedName + "::" + nsName;
+	}
+
+	auto it = namespaces_.find(namespaceFullname);
+	if (it != namespaces_.end())
+		return it->second.get();
+
+	auto nsSymbol = MakeUnique<NamespaceSymbol>(nsName, parent, declNode);
+	NamespaceSymbol* ptr = nsSymbol.get();
+	namespaces_[namespaceFullname] = Move(nsSymbol);
+	namespaceOrder_.push_back(ptr);
+
+	if (parent) {
+		parent->namespaces[ptr->name] = ptr;
+	}
+
+	return ptr;
+}
+
+bool SymbolShard::declare(Symbol* scope, UniquePtr<Symbol>&& symbol) {
+	auto it = scope->members.find(symbol->name);
+	if (it != scope->members.end()) {
+		// Locals may shadow each other, keep the latest one
+		if (detail::hasFlag(scope->kind, SymbolKind::FUNCTION | SymbolKind::BLOCK)) {
+			park(Move(it->second));
+			it->second = Move(symbol);
+			return true;
+		}
+
+		error(symbol->declNode, std::format("Duplicate declaration of '{}'", symbol->name));
+		park(Move(symbol));
+		return false;
+	}
+
+	auto name = symbol->name;
+	scope->members[name] = Move(symbol);
+
+	if (isMergeRoot(scope)) {
+		declarations_.push_back({ scope, Move(name) });
+	}
+
+	return true;
+}
+
+void SymbolShard::addType(TypeSymbol* type) {
+	types_.push_back(type);
+}
+
+void SymbolShard::addVariable(VariableSymbol* variable) {
+	variables_.push_back(variable);
+}
+
+void SymbolShard::addFunction(FunctionSymbol* function) {
+	functions_.push_back(function);
+}
+
+void SymbolShard::addImport(ImportEntry&& entry) {
+	imports_.push_back(Move(entry));
+}
+
+void SymbolShard::addRigidLanguageBlock(ast::LangBlockStmt* block) {
+	rigidLanguageBlocks_.push_back(block);
+}
+
+void SymbolShard::error(const ASTNode* node, const Str& message) {
+	// Buffered, reported in program order during the merge
+	errors_.push_back({ node, message });
+}
+
+void SymbolShard::setNodeScope(const ASTNode* node, const Symbol* scope) {
+	nodeScopes_.emplace_back(node, scope);
+}
+
+const Symbol* SymbolShard::findFirstNonImplicitParent(const Symbol* symbol, bool includeMe) const {
+	return symbolTable_->findFirstNonImplicitParent(symbol, includeMe);
+}
+
+Symbol* SymbolShard::findAncestorOfKind(const Symbol* symbol, SymbolKind kind) const {
+	return symbolTable_->findAncestorOfKind(symbol, kind);
+}
+
+void SymbolShard::collect() {
+	SymbolVisitor collector(this);
+	collector.visit(program_);
+}
+
+void SymbolShard::collectFunction(FunctionSymbol* function, Symbol* scope) {
+	SymbolVisitor collector(this);
+	collector.collectFunction(function, scope);
+}
+
+bool SymbolShard::isMergeRoot(const Symbol* symbol) const {
+	if (symbol == globalType_.get() || symbol == globalFunction_.get()) {
+		return true;
+	}
+
+	if (symbol->kind != SymbolKind::NAMESPACE) {
+		return false;
+	}
+
+	auto it = namespaces_.find(symbol->qualifiedName);
+	return it != namespaces_.end() && it->second.get() == symbol;
+}
+
+void SymbolShard::park(UniquePtr<Symbol>&& symbol) {
+	parked_.push_back(Move(symbol));
+}
+
+MRK_NS_END
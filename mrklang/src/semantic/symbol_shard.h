@@ -0,0 +1,113 @@
+#pragma once
+
+#include "common/types.h"
+#include "parser/ast.h"
+#include "symbols.h"
+
+MRK_NS_BEGIN_MODULE(semantic)
+
+class SymbolTable;
+struct ImportEntry;
+
+/// Per-file symbol collection output
+/// Each program is collected into its own shard, independently of all other files,
+/// so that collection can run in parallel. Shards are merged into the symbol table afterwards
+///
+///				__global (shard)
+///				/		\
+///		   mrkstl	 __globalType (proxy)
+///			  /				\
+///		   sym1			 __globalFunction (proxy)
+///
+/// Namespaces and the injected global type/function are shard-local stand-ins with the
+/// same qualified names as their symbol table counterparts, they are unified during the merge
+class SymbolShard {
+public:
+	/// A symbol declared directly within a namespace or a global proxy
+	struct Declaration {
+		Symbol* container;
+		Str name;
+	};
+
+	struct Error {
+		const ASTNode* node;
+		Str message;
+	};
+
+	/// fileIndex is the program's position in the symbol table, it keeps shard-local names unique across files
+	SymbolShard(const SymbolTable* symbolTable, ast::Program* program, uint32_t fileIndex);
+	~SymbolShard();
+
+	/// Declare a shard-local namespace symbol, reusing an existing one with the same qualified name
+	NamespaceSymbol* declareNamespace(const Str& nsName, NamespaceSymbol* parent = nullptr, ASTNode* declNode = nullptr);
+
+	/// Add a symbol to a scope
+	/// Returns false if the symbol is a duplicate declaration within a namespace or a type
+	/// Duplicates are kept alive in the shard, since AST nodes may still reference them
+	bool declare(Symbol* scope, UniquePtr<Symbol>&& symbol);
+
+	void addType(TypeSymbol* type);
+	void addVariable(VariableSymbol* variable);
+	void addFunction(FunctionSymbol* function);
+	void addImport(ImportEntry&& entry);
+	void addRigidLanguageBlock(ast::LangBlockStmt* block);
+	void error(const ASTNode* node, const Str& message);
+	void setNodeScope(const ASTNode* node, const Symbol* scope);
+
+	/// Read-only helpers forwarded to the symbol table
+	const Symbol* findFirstNonImplicitParent(const Symbol* symbol, bool includeMe = false) const;
+	Symbol* findAncestorOfKind(const Symbol* symbol, SymbolKind kind) const;
+
+	/// Collect symbols from the shard's program
+	void collect();
+
+	/// Collect the parameters and body of a function of the shard's program again, after they were edited
+	/// Its locals are declared straight into the function, there is nothing to merge
+	void collectFunction(FunctionSymbol* function, Symbol* scope);
+
+	/// Whether the symbol is a shard-local namespace or global proxy
+	/// Members of such symbols are moved into their symbol table counterparts during the merge
+	bool isMergeRoot(const Symbol* symbol) const;
+
+	ast::Program* getProgram() const { return program_; }
+	uint32_t getFileIndex() const { return fileIndex_; }
+	NamespaceSymbol* getGlobalNamespace() const { return globalNamespace_; }
+	TypeSymbol* getGlobalType() const { return globalType_.get(); }
+	FunctionSymbol* getGlobalFunction() const { return globalFunction_.get(); }
+
+	const Vec<NamespaceSymbol*>& getNamespaces() const { return namespaceOrder_; }
+	const Vec<Declaration>& getDeclarations() const { return declarations_; }
+	const Vec<TypeSymbol*>& getTypes() const { return types_; }
+	const Vec<VariableSymbol*>& getVariables() const { return variables_; }
+	const Vec<FunctionSymbol*>& getFunctions() const { return functions_; }
+	Vec<ImportEntry>& getImports() { return imports_; }
+	const Vec<ast::LangBlockStmt*>& getRigidLanguageBlocks() const { return rigidLanguageBlocks_; }
+	const Vec<std::pair<const ASTNode*, const Symbol*>>& getNodeScopes() const { return nodeScopes_; }
+	const Vec<Error>& getErrors() const { return errors_; }
+
+	/// Take ownership of symbols that could not be merged into the symbol table
+	void park(UniquePtr<Symbol>&& symbol);
+
+private:
+	const SymbolTable* symbolTable_;
+	ast::Program* program_;
+	uint32_t fileIndex_;
+	Dict<Str, UniquePtr<NamespaceSymbol>> namespaces_;
+	Vec<NamespaceSymbol*> namespaceOrder_;
+	NamespaceSymbol* globalNamespace_;
+	UniquePtr<TypeSymbol> globalType_;
+	UniquePtr<FunctionSymbol> globalFunction_;
+	Vec<Declaration> declarations_;
+	Vec<TypeSymbol*> types_;
+	Vec<VariableSymbol*> variables_;
+	Vec<FunctionSymbol*> functions_;
+	Vec<ImportEntry> imports_;
+	Vec<ast::LangBlockStmt*> rigidLanguageBlocks_;
+	Vec<std::pair<const ASTNode*, const Symbol*>> nodeScopes_;
+	Vec<Error> errors_;
+
+	/// Duplicate or displaced symbols, owned here so that nothing dangles
+	Vec<UniquePtr<Symbol>> parked_;
+};
+
+MRK_NS_END
@@ -1,10 +1,10 @@
 #include "symbol_table.h"
 #include "common/utils.h"
 #include "common/logging.h"
-#include "symbol_visitor.h"
 #include "expression_resolver.h"
 #include "core/error_reporter.h"
 #include "common/declspecs.h"
+#include "common/parallel.h"
 
 #include <iostream>
 #include <format>
@@ -20,7 +20,7 @@ MRK_NS_BEGIN_MODULE(semantic)
 //          /			    \
 //		  sym1			    sym2
 
-SymbolTable::SymbolTable(Vec<UniquePtr<ast::Program>>&& programs)
+SymbolTable::SymbolTable(Vec<SharedPtr<ast::Program>>&& programs)
 	: programs_(Move(programs)), globalNamespace_(nullptr), globalType_(nullptr), globalFunction_(nullptr) {}
 
 void SymbolTable::build() {
@@ -29,15 +29,21 @@ void SymbolTable::build() {
 
 	// Initialize type system
 	typeSystem_ = MakeUnique<TypeSystem>(this);
+	constantEvaluator_ = MakeUnique<ConstantEvaluator>(this);
 
-	SymbolVisitor collector(this);
+	// Collect symbols per file, shards do not touch the table so files are collected in parallel
+	shards_.clear();
+	for (size_t i = 0; i < programs_.size(); i++) {
+		shards_.push_back(MakeUnique<SymbolShard>(this, programs_[i].get(), static_cast<uint32_t>(i)));
+	}
 
-	for (const auto& program : programs_) {
-		// Set current file for error reporting
-		ErrorReporter::instance().setCurrentFile(program->sourceFile);
+	parallel::parallelFor(shards_.size(), [this](size_t i) {
+		shards_[i]->collect();
+	});
 
-		// Collect symbols
-		collector.visit(program.get());
+	// Merge in program order, keeps declaration order and error reporting deterministic
+	for (auto& shard : shards_) {
+		mergeShard(shard.get());
 	}
 
 	// Validate imports
@@ -133,6 +139,7 @@ NamespaceSymbol* SymbolTable::declareNamespace(const Str& nsName, NamespaceSymbo
 
 void SymbolTable::addType(TypeSymbol* type) {
 	types_.push_back(type);
+	if (type->declNode) declarationSymbols_[type->declNode] = type;
 
 	if (type->declSpec == DECLSPEC_INJECT_GLOBAL) {
 		globalType_ = type;
@@ -141,10 +148,12 @@ void SymbolTable::addType(TypeSymbol* type) {
 
 void SymbolTable::addVariable(VariableSymbol* variable) {
 	variables_.push_back(variable);
+	if (variable->declNode) declarationSymbols_[variable->declNode] = variable;
 }
 
 void SymbolTable::addFunction(FunctionSymbol* function) {
 	functions_.push_back(function);
+	if (function->declNode) declarationSymbols_[function->declNode] = function;
 
 	if (function->declSpec == DECLSPEC_INJECT_GLOBAL) {
 		globalFunction_ = function;
@@ -156,7 +165,9 @@ void SymbolTable::addImport(const SourceFile* file, ImportEntry&& entry) {
 }
 
 void SymbolTable::addRigidLanguageBlock(LangBlockStmt* block) {
-	rigidLanguageBlocks_.insert(block);
+	if (rigidLanguageBlockSet_.insert(block).second) {
+		rigidLanguageBlocks_.push_back(block);
+	}
 }
 
 void SymbolTable::error(const ASTNode* node, const Str& message) {
@@ -170,6 +181,113 @@ void SymbolTable::error(const ASTNode* node, const Str& message) {
 	ErrorReporter::instance().semanticError(message, node);
 }
 
+void SymbolTable::mergeShard(SymbolShard* shard) {
+	// Set current file for error reporting
+	ErrorReporter::instance().setCurrentFile(shard->getProgram()->sourceFile);
+
+	for (const auto& err : shard->getErrors()) {
+		error(err.node, err.message);
+	}
+
+	// Shard symbol -> table symbol
+	Dict<const Symbol*, Symbol*> roots;
+
+	// Namespaces are in declaration order, so parents are always mapped first
+	for (auto ns : shard->getNamespaces()) {
+		if (ns == shard->getGlobalNamespace()) {
+			roots[ns] = globalNamespace_;
+			continue;
+		}
+
+		auto parent = static_cast<NamespaceSymbol*>(roots[ns->parent]);
+		auto tableNs = declareNamespace(ns->name, parent, ns->declNode);
+		if (!ns->declSpec.empty()) {
+			tableNs->declSpec = ns->declSpec;
+		}
+
+		roots[ns] = tableNs;
+	}
+
+	// The global type and function only exist once the <global> file has been merged
+	roots[shard->getGlobalType()] = globalType_;
+	roots[shard->getGlobalFunction()] = globalFunction_;
+
+	// Move declarations into their table containers
+	std::unordered_set<const Symbol*> rejected;
+	for (const auto& decl : shard->getDeclarations()) {
+		auto target = roots[decl.container];
+		auto node = decl.container->members.extract(decl.name);
+		auto& symbol = node.mapped();
+
+		if (!target) {
+			error(symbol->declNode, std::format("Global symbol '{}' declared before the global symbol file", symbol->name));
+			rejected.insert(symbol.get());
+			shard->park(Move(symbol));
+			continue;
+		}
+
+		auto existing = target->members.find(decl.name);
+		if (existing != target->members.end()) {
+			if (!detail::hasFlag(target->kind, SymbolKind::FUNCTION)) {
+				error(symbol->declNode, std::format("Duplicate declaration of '{}'", symbol->qualifiedName));
+				rejected.insert(symbol.get());
+
+				// Keep it alive, AST nodes may still be scoped to it
+				symbol->parent = target;
+				shard->park(Move(symbol));
+				continue;
+			}
+
+			// Locals of the global function may shadow each other
+			shard->park(Move(existing->second));
+			target->members.erase(existing);
+		}
+
+		symbol->parent = target;
+		target->members[decl.name] = Move(symbol);
+	}
+
+	auto accepted = [&](const Symbol* symbol) {
+		if (rejected.empty()) {
+			return true;
+		}
+
+		// Anything nested within a rejected declaration is dropped as well
+		for (auto s = symbol; s; s = s->parent) {
+			if (rejected.contains(s)) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	for (auto type : shard->getTypes()) {
+		if (accepted(type)) addType(type);
+	}
+
+	for (auto variable : shard->getVariables()) {
+		if (accepted(variable)) addVariable(variable);
+	}
+
+	for (auto function : shard->getFunctions()) {
+		if (accepted(function)) addFunction(function);
+	}
+
+	for (auto& entry : shard->getImports()) {
+		addImport(shard->getProgram()->sourceFile, Move(entry));
+	}
+
+	for (auto block : shard->getRigidLanguageBlocks()) {
+		addRigidLanguageBlock(block);
+	}
+
+	for (const auto& [node, scope] : shard->getNodeScopes()) {
+		auto it = roots.find(scope);
+		setNodeScope(node, it != roots.end() ? it->second : scope);
+	}
+}
+
 const Symbol* SymbolTable::findFirstNonImplicitParent(const Symbol* symbol, bool includeMe) const {
 	// Since we have removed file scopes, only block scopes are considered implicit
 
@@ -195,11 +313,17 @@ Symbol* SymbolTable::findAncestorOfKind(const Symbol* symbol, SymbolKind kind) c
 }
 
 bool SymbolTable::isLValue(ast::ExprNode* expr) {
+	// Constants and readonly fields are only assigned by their initializer
+	auto isAssignableVariable = [](const Symbol* symbol) {
+		return symbol->kind == SymbolKind::VARIABLE &&
+			!detail::isCONST(symbol->accessModifier) && !detail::isREADONLY(symbol->accessModifier);
+	};
+
 	// Variables are l-values
 	if (auto* identExpr = dynamic_cast<ast::IdentifierExpr*>(expr)) {
 		auto it = resolvedSymbols_.find(identExpr);
 		if (it != resolvedSymbols_.end() &&
-			(it->second->kind == SymbolKind::VARIABLE ||
+			(isAssignableVariable(it->second) ||
 				it->second->kind == SymbolKind::FUNCTION_PARAMETER)) {
 			return true;
 		}
@@ -208,7 +332,7 @@ bool SymbolTable::isLValue(ast::ExprNode* expr) {
 	// Member access can be l-value if it's a field
 	if (auto* memberAccess = dynamic_cast<ast::MemberAccessExpr*>(expr)) {
 		auto it = resolvedSymbols_.find(memberAccess->member.get());
-		if (it != resolvedSymbols_.end() && it->second->kind == SymbolKind::VARIABLE) {
+		if (it != resolvedSymbols_.end() && isAssignableVariable(it->second)) {
 			return true;
 		}
 	}
@@ -252,6 +376,11 @@ Symbol* SymbolTable::getNodeResolvedSymbol(const ast::ExprNode* node) const {
 	return it != resolvedSymbols_.end() ? it->second : nullptr;
 }
 
+Symbol* SymbolTable::getDeclarationSymbol(const ASTNode* node) const {
+	auto it = declarationSymbols_.find(node);
+	return it != declarationSymbols_.end() ? it->second : nullptr;
+}
+
 void SymbolTable::setupGlobals() {
 	// Create global namespace
 	globalNamespace_ = declareNamespace("__global");
@@ -273,6 +402,12 @@ void SymbolTable::validateImports() {
 }
 
 Symbol* SymbolTable::resolveSymbol(SymbolKind kind, const Str& symbolText, const Symbol* scope, SymbolResolveFlags flags) {
+	// Array types are not declared, they are made from their element type on use
+	if (kind == SymbolKind::TYPE && symbolText.ends_with("[]")) {
+		auto elementType = resolveSymbol(kind, symbolText.substr(0, symbolText.size() - 2), scope, flags);
+		return elementType ? typeSystem_->getArrayType(static_cast<TypeSymbol*>(elementType)) : nullptr;
+	}
+
 	// First try to resolve in the scope and its ancestors
 	Symbol* symbol = nullptr;
 
@@ -339,8 +474,10 @@ Symbol* SymbolTable::resolveSymbolInternal(SymbolKind kind, const Str& symbolTex
 		return resolveSymbolInternal(kind, realSymbolName, current, requestor);
 	}
 
-	// Unqualified name
-	symbol = scope->getMember(symbolText);
+	// Unqualified name, members of a type include the inherited ones
+	symbol = detail::hasFlag(scope->kind, SymbolKind::TYPE) && scope != globalType_
+		? typeSystem_->findMember(static_cast<const TypeSymbol*>(scope), symbolText)
+		: scope->getMember(symbolText);
 	if (symbol && detail::hasFlag(symbol->kind, kind)) {
 		return symbol;
 	}
@@ -350,63 +487,255 @@ exit:
 }
 
 void SymbolTable::resolve() {
-	// Resolve types
 	for (auto type : types_) {
-		// Resolve base types
-		Vec<const TypeSymbol*> resolvedBaseTypes;
-		for (auto& baseType : type->baseTypes) {
-			auto baseTypeSymbol = resolveSymbol(SymbolKind::TYPE, baseType, type->parent);
-			if (!baseTypeSymbol) {
-				error(type->declNode, std::format("Could not resolve base type '{}'", baseType));
-				continue;
-			}
+		resolveTypeSignature(type);
+	}
 
-			resolvedBaseTypes.push_back(dynamic_cast<const TypeSymbol*>(baseTypeSymbol));
-		}
+	for (auto variable : variables_) {
+		resolveVariableSignature(variable);
+	}
 
-		type->resolver.resolve(Move(resolvedBaseTypes));
+	for (auto function : functions_) {
+		resolveFunctionSignature(function);
 	}
 
-	// Resolve variables
-	for (auto variable : variables_) {
-		auto typeSymbol = resolveSymbol(SymbolKind::TYPE, variable->type, variable->parent);
-		if (!typeSymbol) {
-			error(variable->declNode, std::format("Could not resolve variable type '{}'", variable->type));
+	// Resolve expressions..
+	dependencyGraph_.clear();
+
+	ExpressionResolver exprResolver(this);
+	for (const auto& program : programs_) {
+		exprResolver.visit(program.get());
+	}
+
+	evaluateConstants();
+}
+
+Vec<const Symbol*> SymbolTable::invalidate(Symbol* declaration, DependencyGraph::Change change) {
+	if (change == DependencyGraph::Change::SIGNATURE) {
+		resolveSignature(declaration);
+	}
+
+	Vec<const Symbol*> invalidated;
+	std::unordered_set<const Symbol*> seen;
+
+	// Declarations waiting to be re-resolved, one may be queued again if a type it uses changes after it was
+	Vec<const Symbol*> pending = dependencyGraph_.collectInvalidated(declaration, change);
+	std::unordered_set<const Symbol*> queued(pending.begin(), pending.end());
+
+	ExpressionResolver exprResolver(this);
+	for (size_t i = 0; i < pending.size(); i++) {
+		auto symbol = const_cast<Symbol*>(pending[i]);
+		queued.erase(symbol);
+
+		if (seen.insert(symbol).second) {
+			invalidated.push_back(symbol);
+		}
+
+		// Inferred types are sticky, start over from the declared ones
+		auto variable = symbol->kind == SymbolKind::VARIABLE ? static_cast<VariableSymbol*>(symbol) : nullptr;
+		auto previousType = variable ? variable->resolver.type : nullptr;
+		resetInferredTypes(symbol);
+
+		dependencyGraph_.clearDependencies(symbol);
+		exprResolver.resolveDeclaration(symbol);
+
+		// var x = f(); changes type along with f, and so do the users of x
+		if (!variable || variable->resolver.type == previousType) {
 			continue;
 		}
 
-		variable->resolver.resolve(dynamic_cast<const TypeSymbol*>(typeSymbol));
+		for (auto dependent : dependencyGraph_.getDependents(variable)) {
+			if (queued.insert(dependent).second) {
+				pending.push_back(dependent);
+			}
+		}
 	}
 
+	// A changed constant affects every use of it, folding is cheap so just redo it all
+	evaluateConstants();
 
-	// Resolve functions
-	for (auto function : functions_) {
-		// Resolve return type
-		auto returnTypeSymbol = resolveSymbol(SymbolKind::TYPE, function->returnType, function->parent);
-		if (!returnTypeSymbol) {
-			error(function->declNode, std::format("Could not resolve return type '{}'", function->returnType));
-			continue;
+	return invalidated;
+}
+
+bool SymbolTable::applyEdit(size_t programIndex, const ProgramEdit& edit, ast::Program* edited, Vec<const Symbol*>& invalidated) {
+	auto program = programs_[programIndex].get();
+
+	FunctionEdit functionEdit;
+	if (!edit.findFunctionEdit(program, edited, functionEdit)) {
+		return false;
+	}
+
+	FunctionSymbol* function = nullptr;
+	if (functionEdit.analyzed) {
+		function = dynamic_cast<FunctionSymbol*>(getDeclarationSymbol(functionEdit.analyzed));
+		if (!function) {
+			return false;
 		}
+	}
 
-		function->resolver.resolve(returnTypeSymbol);
+	edit.movePositions(program);
+	invalidated.clear();
 
-		// Resolve parameters
-		for (auto& [name, param] : function->parameters) {
-			auto paramTypeSymbol = resolveSymbol(SymbolKind::TYPE, param->type, function->parent);
-			if (!paramTypeSymbol) {
-				error(param->declNode, std::format("Could not resolve parameter type '{}'", param->type));
-				continue;
-			}
+	if (!function) {
+		return true;
+	}
+
+	// Drop everything known about the replaced parts, the function symbol itself is kept for its dependents
+	for (auto node : ProgramEdit::collectFunctionNodes(functionEdit.analyzed)) {
+		nodeScopes_.erase(node);
+		declarationSymbols_.erase(node);
 
-			param->resolver.resolve(paramTypeSymbol);
+		if (auto expr = dynamic_cast<const ast::ExprNode*>(node)) {
+			resolvedSymbols_.erase(expr);
 		}
 	}
 
-	// Resolve expressions..
-	ExpressionResolver exprResolver(this);
+	// Keep the locals where they were among the variables
+	auto isLocal = [&](const VariableSymbol* variable) { return variable->parent == function; };
+	auto localsAt = std::find_if(variables_.begin(), variables_.end(), isLocal) - variables_.begin();
+	std::erase_if(variables_, isLocal);
+	function->members.clear();
+
+	auto node = functionEdit.analyzed;
+	node->parameters = Move(functionEdit.edited->parameters);
+	node->returnType = Move(functionEdit.edited->returnType);
+	node->body = Move(functionEdit.edited->body);
+
+	// The shard owns the locals that got shadowed, it lives as long as the table like the others
+	auto shard = MakeUnique<SymbolShard>(this, program, static_cast<uint32_t>(programIndex));
+	shard->collectFunction(function, const_cast<Symbol*>(getNodeScope(node)));
+
+	for (const auto& err : shard->getErrors()) {
+		error(err.node, err.message);
+	}
+
+	Vec<VariableSymbol*> locals(shard->getVariables().begin(), shard->getVariables().end());
+	variables_.insert(variables_.begin() + localsAt, locals.begin(), locals.end());
+
+	for (auto local : locals) {
+		if (local->declNode) declarationSymbols_[local->declNode] = local;
+	}
+
+	for (const auto& [scopedNode, scope] : shard->getNodeScopes()) {
+		setNodeScope(scopedNode, scope);
+	}
+
+	shards_.push_back(Move(shard));
+
+	// The parameters are new symbols, a signature change resolves them along with its dependents
+	if (functionEdit.change == DependencyGraph::Change::BODY) {
+		resolveFunctionSignature(function);
+	}
+
+	invalidated = invalidate(function, functionEdit.change);
+	return true;
+}
+
+void SymbolTable::evaluateConstants() {
+	Vec<const ast::ExprNode*> expressions;
+	expressions.reserve(resolvedSymbols_.size());
+
+	for (const auto& [expr, symbol] : resolvedSymbols_) {
+		expressions.push_back(expr);
+	}
+
+	// The map's order changes from run to run, errors are reported in declaration order instead
+	Dict<const SourceFile*, size_t> fileOrder;
 	for (const auto& program : programs_) {
-		exprResolver.visit(program.get());
+		fileOrder.emplace(program->sourceFile, fileOrder.size());
+	}
+
+	auto getFileIndex = [&](const ast::ExprNode* expr) {
+		auto it = fileOrder.find(expr->sourceFile);
+		return it != fileOrder.end() ? it->second : fileOrder.size();
+	};
+
+	std::sort(expressions.begin(), expressions.end(), [&](const ast::ExprNode* a, const ast::ExprNode* b) {
+		auto ai = getFileIndex(a);
+		auto bi = getFileIndex(b);
+
+		if (ai != bi) return ai < bi;
+		return a->startToken.position.index < b->startToken.position.index;
+	});
+
+	constantEvaluator_->clear();
+	constantEvaluator_->evaluate(expressions);
+}
+
+void SymbolTable::resetInferredTypes(Symbol* declaration) {
+	if (declaration->kind == SymbolKind::VARIABLE) {
+		resolveVariableSignature(static_cast<VariableSymbol*>(declaration));
+		return;
+	}
+
+	// Locals are members of their function, blocks do not open a scope of their own
+	if (declaration->kind == SymbolKind::FUNCTION) {
+		for (const auto& [_, member] : declaration->members) {
+			if (member->kind == SymbolKind::VARIABLE) {
+				resolveVariableSignature(static_cast<VariableSymbol*>(member.get()));
+			}
+		}
+	}
+}
+
+void SymbolTable::resolveSignature(Symbol* symbol) {
+	if (detail::hasFlag(symbol->kind, SymbolKind::TYPE)) {
+		resolveTypeSignature(static_cast<TypeSymbol*>(symbol));
+	}
+	else if (symbol->kind == SymbolKind::VARIABLE) {
+		resolveVariableSignature(static_cast<VariableSymbol*>(symbol));
+	}
+	else if (symbol->kind == SymbolKind::FUNCTION) {
+		resolveFunctionSignature(static_cast<FunctionSymbol*>(symbol));
+	}
+}
+
+void SymbolTable::resolveTypeSignature(TypeSymbol* type) {
+	// Resolve base types
+	Vec<const TypeSymbol*> resolvedBaseTypes;
+	for (auto& baseType : type->baseTypes) {
+		auto baseTypeSymbol = resolveSymbol(SymbolKind::TYPE, baseType, type->parent);
+		if (!baseTypeSymbol) {
+			error(type->declNode, std::format("Could not resolve base type '{}'", baseType));
+			continue;
+		}
+
+		resolvedBaseTypes.push_back(dynamic_cast<const TypeSymbol*>(baseTypeSymbol));
+	}
+
+	type->resolver.resolve(Move(resolvedBaseTypes));
+}
+
+void SymbolTable::resolveVariableSignature(VariableSymbol* variable) {
+	auto typeSymbol = resolveSymbol(SymbolKind::TYPE, variable->type, variable->parent);
+	if (!typeSymbol) {
+		error(variable->declNode, std::format("Could not resolve variable type '{}'", variable->type));
+		return;
+	}
+
+	variable->resolver.resolve(dynamic_cast<const TypeSymbol*>(typeSymbol));
+}
+
+void SymbolTable::resolveFunctionSignature(FunctionSymbol* function) {
+	// Resolve return type
+	auto returnTypeSymbol = resolveSymbol(SymbolKind::TYPE, function->returnType, function->parent);
+	if (!returnTypeSymbol) {
+		error(function->declNode, std::format("Could not resolve return type '{}'", function->returnType));
+		return;
+	}
+
+	function->resolver.resolve(returnTypeSymbol);
+
+	// Resolve parameters
+	for (auto& [name, param] : function->parameters) {
+		auto paramTypeSymbol = resolveSymbol(SymbolKind::TYPE, param->type, function->parent);
+		if (!paramTypeSymbol) {
+			error(param->declNode, std::format("Could not resolve parameter type '{}'", param->type));
+			continue;
+		}
+
+		param->resolver.resolve(paramTypeSymbol);
 	}
 }
 
-MRK_NS_END
+MRK_NS_END
\ No newline at end of file
@@ -4,7 +4,11 @@
 #include "optional"
 #include "parser/ast.h"
 #include "symbols.h"
+#include "symbol_shard.h"
+#include "dependency_graph.h"
 #include "type_system.h"
+#include "constant_evaluator.h"
+#include "program_edit.h"
 
 #include <unordered_set>
 
@@ -28,7 +32,7 @@ IMPLEMENT_FLAGS_OPERATORS_INLINE(SymbolResolveFlags);
 class SymbolTable {
 public:
 	SymbolTable() = default;
-	SymbolTable(Vec<UniquePtr<ast::Program>>&& programs);
+	SymbolTable(Vec<SharedPtr<ast::Program>>&& programs);
 	void build();
 	void resolve();
 	void dump() const;
@@ -48,6 +52,21 @@ public:
 	void addRigidLanguageBlock(ast::LangBlockStmt* block);
 	void error(const ASTNode* node, const Str& message);
 
+	/// Invalidate a declaration after an edit and re-resolve everything it affects
+	/// Body changes re-resolve the declaration only, signature changes also re-resolve its dependents
+	/// A re-resolved variable whose inferred type changed has its own dependents re-resolved in turn
+	/// Returns the re-resolved declarations
+	Vec<const Symbol*> invalidate(Symbol* declaration, DependencyGraph::Change change);
+
+	/// Apply an edit of a program in place, re-resolving only what it affects
+	/// The edit has to be confined to a single function, whose parameters, return type and body are taken from the edited program
+	/// Returns false without touching the table if the edit reaches further, the table has to be rebuilt then
+	bool applyEdit(size_t programIndex, const ProgramEdit& edit, ast::Program* edited, Vec<const Symbol*>& invalidated);
+
+	/// Merge a collected shard into the table
+	/// Unifies shard namespaces and global proxies with their table counterparts, reports duplicate declarations
+	void mergeShard(SymbolShard* shard);
+
 	/// Find the first non-implicit parent of a symbol
 	/// Implicit symbols are either file scopes or blocks
 	const Symbol* findFirstNonImplicitParent(const Symbol* symbol, bool includeMe = false) const;
@@ -71,19 +90,28 @@ public:
 	void setNodeResolvedSymbol(const ast::ExprNode* node, Symbol* symbol);
 	Symbol* getNodeResolvedSymbol(const ast::ExprNode* node) const;
 
+	/// Get the type, variable or function symbol declared by an AST node
+	Symbol* getDeclarationSymbol(const ASTNode* node) const;
+
 	/// Resolve a symbol within a scope, its ancestors and imports
 	Symbol* resolveSymbol(SymbolKind kind, const Str& symbolText, const Symbol* scope, SymbolResolveFlags flags = SymbolResolveFlags::ALL);
 
-	const Vec<UniquePtr<ast::Program>>& getPrograms() const { return programs_; }
+	const Vec<SharedPtr<ast::Program>>& getPrograms() const { return programs_; }
 	const Vec<TypeSymbol*>& getTypes() const { return types_; }
 	const Vec<VariableSymbol*>& getVariables() const { return variables_; }
 	const Vec<FunctionSymbol*>& getFunctions() const { return functions_; }
 	TypeSymbol* getGlobalType() const { return globalType_; }
 	FunctionSymbol* getGlobalFunction() const { return globalFunction_; }
-	const std::unordered_set<ast::LangBlockStmt*>& getRigidLanguageBlocks() const { return rigidLanguageBlocks_; }
+	/// In program and source order
+	const Vec<ast::LangBlockStmt*>& getRigidLanguageBlocks() const { return rigidLanguageBlocks_; }
+	bool isRigidLanguageBlock(const ast::LangBlockStmt* block) const { return rigidLanguageBlockSet_.contains(block); }
+	DependencyGraph* getDependencyGraph() { return &dependencyGraph_; }
+	const DependencyGraph* getDependencyGraph() const { return &dependencyGraph_; }
+	const ConstantEvaluator* getConstantEvaluator() const { return constantEvaluator_.get(); }
 
 private:
-	Vec<UniquePtr<ast::Program>> programs_;
+	Vec<SharedPtr<ast::Program>> programs_;
+	Vec<UniquePtr<SymbolShard>> shards_;
 	Dict<Str, UniquePtr<NamespaceSymbol>> namespaces_;
 	Vec<TypeSymbol*> types_;
 	Vec<VariableSymbol*> variables_;
@@ -96,7 +124,8 @@ private:
 
 	/// Rigid language blocks are marked by __declspec(NO_MOVE)
 	/// These blocks are not allowed to be moved
-	std::unordered_set<ast::LangBlockStmt*> rigidLanguageBlocks_;
+	Vec<ast::LangBlockStmt*> rigidLanguageBlocks_;
+	std::unordered_set<const ast::LangBlockStmt*> rigidLanguageBlockSet_;
 
 	/// Keep track of the scope for each AST node
 	Dict<const ASTNode*, const Symbol*> nodeScopes_;
@@ -104,9 +133,30 @@ private:
 	/// Keep track of resolved symbols for each expr node
 	Dict<const ast::ExprNode*, Symbol*> resolvedSymbols_;
 
+	/// Declaration node to declared type/variable/function
+	Dict<const ASTNode*, Symbol*> declarationSymbols_;
+
+	/// Which declarations reference which, filled by the ExpressionResolver
+	DependencyGraph dependencyGraph_;
+
+	/// Folded values of constant expressions, recomputed after every resolve
+	UniquePtr<ConstantEvaluator> constantEvaluator_;
+
 	/// Setup global symbols
 	void setupGlobals();
 
+	/// Resolve the declared types of a declaration
+	void resolveSignature(Symbol* symbol);
+	void resolveTypeSignature(TypeSymbol* type);
+	void resolveVariableSignature(VariableSymbol* variable);
+	void resolveFunctionSignature(FunctionSymbol* function);
+
+	/// Fold every resolved expression
+	void evaluateConstants();
+
+	/// Reset the types inferred for a variable, or for the locals of a function, to their declared ones
+	void resetInferredTypes(Symbol* declaration);
+
 	void validateImport(const ImportEntry& entry);
 	void validateImports();
 
@@ -1,4 +1,5 @@
 #include "symbol_visitor.h"
+#include "symbol_shard.h"
 #include "symbol_table.h"
 #include "common/utils.h"
 #include "common/declspecs.h"
@@ -7,14 +8,14 @@
 
 MRK_NS_BEGIN_MODULE(semantic)
 
-SymbolVisitor::SymbolVisitor(SymbolTable* symbolTable)
-	: symbolTable_(symbolTable), currentNamespace_(nullptr), currentScope_(nullptr),
+SymbolVisitor::SymbolVisitor(SymbolShard* shard)
+	: shard_(shard), currentNamespace_(nullptr), currentScope_(nullptr),
 	currentModifiers_(AccessModifier::NONE), currentFile_(nullptr) {}
 
 /// Visit a Program node - entry point for processing a file
 void SymbolVisitor::visit(Program* node) {
 	// Update namespace
-	currentNamespace_ = symbolTable_->getGlobalNamespace();
+	currentNamespace_ = shard_->getGlobalNamespace();
 	currentScope_ = currentNamespace_;
 	currentFile_ = node->sourceFile;
 
@@ -145,7 +146,7 @@ void SymbolVisitor::visit(VarDeclStmt* node) {
 
 	// Check for const initialization
 	if (detail::isCONST(currentModifiers_) && !node->initializer) {
-		symbolTable_->error(node, "Const variable must be initialized");
+		shard_->error(node, "Const variable must be initialized");
 		resetModifiers();
 		return;
 	}
@@ -154,7 +155,7 @@ void SymbolVisitor::visit(VarDeclStmt* node) {
 	bool isGlobal = currentScope_->kind == SymbolKind::NAMESPACE;
 	if (isGlobal) {
 		// Push global type scope
-		pushScope(symbolTable_->getGlobalType());
+		pushScope(shard_->getGlobalType());
 		currentModifiers_ |= AccessModifier::STATIC;
 	}
 
@@ -173,10 +174,11 @@ void SymbolVisitor::visit(VarDeclStmt* node) {
 	varSymbol->declSpec = currentDeclSpec_;
 	resetModifiers();
 
-	symbolTable_->addVariable(varSymbol.get());
-
 	// Add to current scope
-	currentScope_->members[varName] = Move(varSymbol);
+	auto varPtr = varSymbol.get();
+	if (shard_->declare(currentScope_, Move(varSymbol))) {
+		shard_->addVariable(varPtr);
+	}
 
 	// uhhhhhh
 	node->name->accept(*this);
@@ -200,7 +202,9 @@ void SymbolVisitor::visit(VarDeclStmt* node) {
 void SymbolVisitor::visit(BlockStmt* node) {
 	preprocessNode(node);
 
-	auto blockName = "block_" + std::to_string(reinterpret_cast<uintptr_t>(node));
+	// The name is a member key, it must not depend on addresses or on edits elsewhere in the file
+	// Namespaces are reopened across files, so the file index keeps blocks of different files apart
+	auto blockName = std::format("block_{}_{}", shard_->getFileIndex(), currentScope_->members.size());
 	auto blockSymbol = MakeUnique<BlockSymbol>(Move(blockName), currentScope_, node);
 
 	// Add modifiers
@@ -209,7 +213,7 @@ void SymbolVisitor::visit(BlockStmt* node) {
 	resetModifiers();
 
 	BlockSymbol* blockPtr = blockSymbol.get();
-	currentScope_->members[blockPtr->name] = Move(blockSymbol);
+	shard_->declare(currentScope_, Move(blockSymbol));
 
 	// Push block scope
 	//pushScope(blockPtr);
@@ -231,18 +235,43 @@ void SymbolVisitor::visit(ParamDeclStmt* node) {
 	// Processed by FuncDeclStmt
 }
 
-void SymbolVisitor::visit(FuncDeclStmt* node) {
-	preprocessNode(node);
+void SymbolVisitor::collectFunction(FunctionSymbol* function, Symbol* scope) {
+	auto node = static_cast<FuncDeclStmt*>(function->declNode);
+	currentFile_ = node->sourceFile;
+	currentNamespace_ = nullptr;
+	resetModifiers();
 
-	// Collect parameters
+	// Parameters are visited from where the function is declared, as on the first collection
+	pushScope(scope);
+
+	FunctionSymbol::ParameterList params;
+	bool collected = collectParameters(node, params);
+	popScope();
+
+	if (!collected) {
+		return;
+	}
+
+	function->returnType = node->returnType ? node->returnType->getTypeName() : "void";
+	function->parameters = Move(params);
+
+	for (auto& param : function->parameters) {
+		param.second->parent = function;
+	}
+
+	pushScope(function);
+	node->body->accept(*this);
+	popScope();
+}
+
+bool SymbolVisitor::collectParameters(FuncDeclStmt* node, FunctionSymbol::ParameterList& params) {
 	bool hasVarargs = false; // Varargs must be last parameter
 
-	Dict<Str, UniquePtr<FunctionParameterSymbol>> params;
 	for (const auto& param : node->parameters) {
 		if (hasVarargs) {
-			symbolTable_->error(param.get(), "Varargs must be the last parameter");
+			shard_->error(param.get(), "Varargs must be the last parameter");
 			resetModifiers();
-			return;
+			return false;
 		}
 
 		if (param->isParams) {
@@ -257,17 +286,35 @@ void SymbolVisitor::visit(FuncDeclStmt* node) {
 			param.get()
 		);
 
-		params[param->name->name] = Move(paramSymbol);
+		auto duplicate = std::find_if(params.begin(), params.end(), [&](const auto& entry) { return entry.first == param->name->name; });
+		if (duplicate != params.end()) {
+			shard_->error(param.get(), std::format("Duplicate parameter '{}'", param->name->name));
+		}
+		else {
+			params.emplace_back(param->name->name, Move(paramSymbol));
+		}
 
 		// Bind param source files
 		param->accept(*this);
 	}
 
+	return true;
+}
+
+void SymbolVisitor::visit(FuncDeclStmt* node) {
+	preprocessNode(node);
+
+	// Collect parameters
+	FunctionSymbol::ParameterList params;
+	if (!collectParameters(node, params)) {
+		return;
+	}
+
 	// Check if function is global
 	bool isGlobal = currentScope_->kind == SymbolKind::NAMESPACE;
 	if (isGlobal) {
 		// Push global type scope
-		pushScope(symbolTable_->getGlobalType());
+		pushScope(shard_->getGlobalType());
 		currentModifiers_ |= AccessModifier::STATIC;
 	}
 
@@ -279,7 +326,7 @@ void SymbolVisitor::visit(FuncDeclStmt* node) {
 
 	// Check for duplicate function
 	if (currentScope_->members.find(node->name->name) != currentScope_->members.end()) {
-		symbolTable_->error(node, "Duplicate function declaration");
+		shard_->error(node, "Duplicate function declaration");
 		resetModifiers();
 
 		if (isGlobal) {
@@ -310,10 +357,10 @@ void SymbolVisitor::visit(FuncDeclStmt* node) {
 		param.second->parent = funcPtr;
 	}
 
-	currentScope_->members[node->name->name] = Move(funcSymbol);
+	shard_->declare(currentScope_, Move(funcSymbol));
 
 	// Register to function list
-	symbolTable_->addFunction(funcPtr);
+	shard_->addFunction(funcPtr);
 
 	// Push function scope
 	pushScope(funcPtr);
@@ -337,7 +384,7 @@ void SymbolVisitor::visit(IfStmt* node) {
 	bool isGlobal = currentScope_->kind == SymbolKind::NAMESPACE;
 	if (isGlobal) {
 		// Push global function scope
-		pushScope(symbolTable_->getGlobalFunction());
+		pushScope(shard_->getGlobalFunction());
 	}
 
 	node->condition->accept(*this);
@@ -372,7 +419,10 @@ void SymbolVisitor::visit(ForStmt* node) {
 void SymbolVisitor::visit(ForeachStmt* node) {
 	preprocessNode(node);
 
-	node->variable->accept(*this);
+	if (node->variable) {
+		node->variable->accept(*this);
+	}
+
 	node->collection->accept(*this);
 	node->body->accept(*this);
 }
@@ -389,7 +439,7 @@ void SymbolVisitor::visit(LangBlockStmt* node) {
 
 	// Check if it's a rigid block
 	if (currentDeclSpec_ == DECLSPEC_NO_MOVE) {
-		symbolTable_->addRigidLanguageBlock(node);
+		shard_->addRigidLanguageBlock(node);
 	}
 
 	// Reset modifiers
@@ -448,7 +498,7 @@ void SymbolVisitor::visit(AccessModifierStmt* node) {
 
 	// Report error if any, and reset modifiers
 	if (hasError) {
-		symbolTable_->error(node, errorMsg);
+		shard_->error(node, errorMsg);
 		resetModifiers();
 
 		currentModifiers_ = AccessModifier::NONE;
@@ -461,8 +511,8 @@ void SymbolVisitor::visit(NamespaceDeclStmt* node) {
 
 	// Namespaces may only be declared at global scope or within another namespace
 	if (currentScope_->kind != SymbolKind::NAMESPACE &&
-		symbolTable_->findFirstNonImplicitParent(currentScope_)->kind != SymbolKind::NAMESPACE) {
-		symbolTable_->error(node, "Namespace can only be declared at global scope or within another namespace");
+		shard_->findFirstNonImplicitParent(currentScope_)->kind != SymbolKind::NAMESPACE) {
+		shard_->error(node, "Namespace can only be declared at global scope or within another namespace");
 		resetModifiers();
 		return;
 	}
@@ -472,7 +522,7 @@ void SymbolVisitor::visit(NamespaceDeclStmt* node) {
 
 	// Declare new namespace and mark as current
 	auto nsLocalName = utils::formatCollection(node->path, "::", [](const auto& item) { return item->name; });
-	currentNamespace_ = symbolTable_->declareNamespace(nsLocalName, currentNamespace_, node);
+	currentNamespace_ = shard_->declareNamespace(nsLocalName, currentNamespace_, node);
 
 	// Namespaces may have declspec
 	currentNamespace_->declSpec = currentDeclSpec_;
@@ -506,8 +556,8 @@ void SymbolVisitor::visit(UseStmt* node) {
 
 	// Use statements may only appear as a top level decl
 	// Check if our current scope the global namespace
-	if (!currentScope_ || currentScope_ != symbolTable_->getGlobalNamespace()) {
-		symbolTable_->error(node, "Use statements may only appear as top level statements");
+	if (!currentScope_ || currentScope_ != shard_->getGlobalNamespace()) {
+		shard_->error(node, "Use statements may only appear as top level statements");
 		return;
 	}
 
@@ -518,7 +568,7 @@ void SymbolVisitor::visit(UseStmt* node) {
 			node
 		};
 
-		symbolTable_->addImport(node->sourceFile, Move(entry));
+		shard_->addImport(Move(entry));
 	}
 }
 
@@ -536,8 +586,8 @@ void SymbolVisitor::visit(EnumDeclStmt* node) {
 	// Enums may not exist within a function or an interface
 	// Ali is bronze
 	if (detail::hasFlag(currentScope_->kind, SymbolKind::FUNCTION | SymbolKind::INTERFACE) ||
-		symbolTable_->findAncestorOfKind(currentScope_, SymbolKind::FUNCTION | SymbolKind::INTERFACE)) {
-		symbolTable_->error(node, "Enums may not exist within a function or an interface");
+		shard_->findAncestorOfKind(currentScope_, SymbolKind::FUNCTION | SymbolKind::INTERFACE)) {
+		shard_->error(node, "Enums may not exist within a function or an interface");
 		resetModifiers();
 		return;
 	}
@@ -559,12 +609,19 @@ void SymbolVisitor::visit(EnumDeclStmt* node) {
 	enumSymbol->declSpec = currentDeclSpec_;
 	resetModifiers();
 
-	// Resolve enum members
+	if (node->type) {
+		node->type->accept(*this);
+	}
+
+	// Member values may reference earlier members, they are resolved within the enum
+	pushScope(enumSymbol.get());
+
 	for (const auto& member : node->members) {
+		preprocessNode(member.first.get());
 		auto memberName = member.first->name;
 
-		// TODO: Resolve member value at compile time
-		auto memberValue = member.second ? member.second->toString() : "null";
+		// Folded by the ConstantEvaluator once resolved
+		auto memberValue = member.second ? member.second->toString() : "";
 		auto memberSymbol = MakeUnique<EnumMemberSymbol>(
 			memberName,
 			Move(memberValue),
@@ -572,12 +629,19 @@ void SymbolVisitor::visit(EnumDeclStmt* node) {
 			member.first.get());
 
 		enumSymbol->members[Move(memberName)] = Move(memberSymbol);
+
+		if (member.second) {
+			member.second->accept(*this);
+		}
 	}
 
-	currentScope_->members[node->name->name] = Move(enumSymbol);
+	popScope();
 
-	// Add to type list
-	symbolTable_->addType(static_cast<TypeSymbol*>(enumSymbol.get()));
+	// Add to current scope, and to type list
+	auto enumPtr = enumSymbol.get();
+	if (shard_->declare(currentScope_, Move(enumSymbol))) {
+		shard_->addType(enumPtr);
+	}
 }
 
 void SymbolVisitor::visit(TypeDeclStmt* node) {
@@ -629,11 +693,10 @@ void SymbolVisitor::visit(TypeDeclStmt* node) {
 	typePtr->declSpec = currentDeclSpec_;
 	resetModifiers();
 
-	// Add to current scope
-	currentScope_->members[node->name->getTypeName()] = Move(typeSymbol);
-
-	// Add to type list
-	symbolTable_->addType(static_cast<TypeSymbol*>(typePtr));
+	// Add to current scope, and to type list
+	if (shard_->declare(currentScope_, Move(typeSymbol))) {
+		shard_->addType(static_cast<TypeSymbol*>(typePtr));
+	}
 
 	// Push type scope
 	pushScope(typePtr);
@@ -648,7 +711,7 @@ void SymbolVisitor::visit(TypeDeclStmt* node) {
 void SymbolVisitor::preprocessNode(ast::Node* node) {
 	// Bind source file, and set current scope
 	node->sourceFile = currentFile_;
-	symbolTable_->setNodeScope(node, currentScope_);
+	shard_->setNodeScope(node, currentScope_);
 }
 
 void SymbolVisitor::pushScope(Symbol* scope) {
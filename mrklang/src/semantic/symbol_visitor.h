@@ -9,20 +9,26 @@
 
 MRK_NS_BEGIN_MODULE(semantic)
 
-class SymbolTable;
+class SymbolShard;
 struct Symbol;
 struct NamespaceSymbol;
+struct FunctionSymbol;
+struct FunctionParameterSymbol;
 
 using namespace ast;
 
-/// Collects symbols from an AST and populates a symbol table
+/// Collects symbols from an AST and populates a per-file symbol shard
 /// Also binds AST nodes to their source files
 class SymbolVisitor : public ASTVisitor {
 public:
-	SymbolVisitor(SymbolTable* symbolTable);
+	SymbolVisitor(SymbolShard* shard);
 
 	void visit(Program* node) override;
 
+	/// Collect the parameters and body of an already declared function again, keeping its symbol
+	/// Scope is where the function is declared
+	void collectFunction(FunctionSymbol* function, Symbol* scope);
+
 	void visit(LiteralExpr* node) override;
 	void visit(InterpolatedStringExpr* node) override;
 	void visit(InteropCallExpr* node) override;
@@ -57,7 +63,7 @@ public:
 	void visit(TypeDeclStmt* node) override;
 
 private:
-	SymbolTable* symbolTable_;
+	SymbolShard* shard_;
 	Symbol* currentScope_;
 	NamespaceSymbol* currentNamespace_;
 	const SourceFile* currentFile_;
@@ -65,6 +71,9 @@ private:
 	Str currentDeclSpec_;
 	std::stack<Symbol*> scopeStack_;
 
+	/// Collect the parameter symbols of a function, false if they are malformed
+	bool collectParameters(FuncDeclStmt* node, Vec<std::pair<Str, UniquePtr<FunctionParameterSymbol>>>& params);
+
 	/// Preprocess a node before visiting its children
 	void preprocessNode(ast::Node* node);
 	void pushScope(Symbol* scope);
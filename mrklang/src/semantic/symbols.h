@@ -4,6 +4,8 @@
 #include "parser/ast.h"
 #include "access_modifier.h"
 
+#include <algorithm>
+
 MRK_NS_BEGIN_MODULE(semantic)
 
 #define DECLARE_RESOLVABLE_MEMBERS(...) struct { \
@@ -101,6 +103,8 @@ struct Symbol {
 		qualifiedName = (parent ? (parent->qualifiedName + "::" + this->name) : this->name);
 	}
 
+	virtual ~Symbol() = default;
+
 	virtual Str toString() const { return qualifiedName; }
 	virtual Symbol* getMember(const Str& name) const {
 		auto it = members.find(name);
@@ -144,21 +148,22 @@ struct FunctionParameterSymbol : Symbol {
 };
 
 struct FunctionSymbol : Symbol {
-	using ParameterDict = Dict<Str, UniquePtr<FunctionParameterSymbol>>;
+	/// Declaration order, it is the order of the generated signature
+	using ParameterList = Vec<std::pair<Str, UniquePtr<FunctionParameterSymbol>>>;
 
 	Str returnType;
-	ParameterDict parameters; // name, type
+	ParameterList parameters; // name, type
 	bool isGlobal;
 
 	DECLARE_RESOLVABLE_MEMBERS(const TypeSymbol* returnType;);
 
-	FunctionSymbol(Str name, Str returnType, ParameterDict&& parameters, bool isGlobal,
+	FunctionSymbol(Str name, Str returnType, ParameterList&& parameters, bool isGlobal,
 		Symbol* parent, ASTNode* declNode)
 		: Symbol(SymbolKind::FUNCTION, Move(name), parent, declNode),
 		returnType(Move(returnType)), parameters(Move(parameters)), isGlobal(isGlobal) {}
 
 	virtual Symbol* getMember(const Str& name) const override {
-		auto it = parameters.find(name);
+		auto it = std::find_if(parameters.begin(), parameters.end(), [&](const auto& param) { return param.first == name; });
 		if (it != parameters.end()) {
 			return it->second.get();
 		}
@@ -118,8 +118,28 @@ bool TypeSystem::isDerivedFrom(const TypeSymbol* type, const TypeSymbol* baseTyp
 		return true;
 	}
 
-	const auto& bases = type->resolver.baseTypes;
-	return std::find(bases.begin(), bases.end(), baseType) != bases.end();
+	for (auto base : type->resolver.baseTypes) {
+		if (base == baseType || (base && isDerivedFrom(base, baseType))) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+Symbol* TypeSystem::findMember(const TypeSymbol* type, const Str& name) const {
+	if (auto member = type->getMember(name)) {
+		return member;
+	}
+
+	// Bases in declaration order, the first one declaring the name wins
+	for (auto base : type->resolver.baseTypes) {
+		if (auto member = base ? findMember(base, name) : nullptr) {
+			return member;
+		}
+	}
+
+	return nullptr;
 }
 
 bool TypeSystem::isAssignable(const TypeSymbol* target, const TypeSymbol* source) const {
@@ -324,6 +344,67 @@ TypeSymbol* TypeSystem::resolveTypeFromLiteral(ast::LiteralExpr* literalExpr) co
 	}
 }
 
+const TypeSymbol* TypeSystem::getSymbolType(const Symbol* symbol) const {
+	if (symbol) {
+		if (detail::hasFlag(symbol->kind, SymbolKind::TYPE)) {
+			return static_cast<const TypeSymbol*>(symbol);
+		}
+
+		if (detail::hasFlag(symbol->kind, SymbolKind::FUNCTION)) {
+			return static_cast<const FunctionSymbol*>(symbol)->resolver.returnType;
+		}
+
+		if (detail::hasFlag(symbol->kind, SymbolKind::VARIABLE)) {
+			return static_cast<const VariableSymbol*>(symbol)->resolver.type;
+		}
+
+		if (detail::hasFlag(symbol->kind, SymbolKind::FUNCTION_PARAMETER)) {
+			return static_cast<const FunctionParameterSymbol*>(symbol)->resolver.type;
+		}
+
+		// Enum members are values of the underlying type for now
+		if (detail::hasFlag(symbol->kind, SymbolKind::ENUM_MEMBER)) {
+			return getEnumUnderlyingType(static_cast<const TypeSymbol*>(symbol->parent));
+		}
+	}
+
+	return errorType_;
+}
+
+const TypeSymbol* TypeSystem::getEnumUnderlyingType(const TypeSymbol* enumType) const {
+	if (enumType && enumType->resolver.isResolved && !enumType->resolver.baseTypes.empty()) {
+		return enumType->resolver.baseTypes.front();
+	}
+
+	return getBuiltinType(TypeKind::I32);
+}
+
+bool TypeSystem::getTypeKind(const TypeSymbol* type, TypeKind* kind) const {
+	if (type && type->kind == SymbolKind::ENUM) {
+		type = getEnumUnderlyingType(type);
+	}
+
+	return isPrimitiveType(type, kind);
+}
+
+TypeSymbol* TypeSystem::getArrayType(const TypeSymbol* elementType) {
+	auto& arrayType = arrayTypes_[elementType];
+	if (!arrayType) {
+		// Arrays are not declared anywhere, they live next to their element type without being its sibling
+		arrayType = MakeUnique<TypeSymbol>(SymbolKind::PRIMITIVE_TYPE, elementType->name + "[]", Vec<Str>(), elementType->parent, nullptr);
+		arrayType->resolver.resolve(decltype(TypeSymbol::resolver.baseTypes)());
+
+		arrayElementTypes_[arrayType.get()] = elementType;
+	}
+
+	return arrayType.get();
+}
+
+const TypeSymbol* TypeSystem::getArrayElementType(const TypeSymbol* type) const {
+	auto it = arrayElementTypes_.find(type);
+	return it != arrayElementTypes_.end() ? it->second : nullptr;
+}
+
 void TypeSystem::initializeBuiltinTypes() {
 	using BaseTypesVec = decltype(TypeSymbol::resolver.baseTypes);
 	const auto& globalNamespace = symbolTable_->getGlobalNamespace();
@@ -7,6 +7,7 @@
 
 MRK_NS_BEGIN_MODULE(semantic)
 
+struct Symbol;
 struct TypeSymbol;
 class SymbolTable;
 
@@ -53,6 +54,7 @@ public:
 
 	size_t getTypeSize(const TypeSymbol* type) const;
 
+	/// True if baseType is a direct or indirect base of type
 	bool isDerivedFrom(const TypeSymbol* type, const TypeSymbol* baseType) const;
 	bool isAssignable(const TypeSymbol* target, const TypeSymbol* source) const;
 
@@ -68,11 +70,31 @@ public:
 	/// Literal types are always valid
 	TypeSymbol* resolveTypeFromLiteral(ast::LiteralExpr* literalExpr) const;
 
+	/// Get the type of a resolved symbol, the error type if it has none
+	const TypeSymbol* getSymbolType(const Symbol* symbol) const;
+
+	/// Get the underlying integral type of an enum, int unless specified
+	const TypeSymbol* getEnumUnderlyingType(const TypeSymbol* enumType) const;
+
+	/// Find a member of a type or, failing that, of its base types
+	Symbol* findMember(const TypeSymbol* type, const Str& name) const;
+
+	/// Get the kind of a primitive or enum type, false for any other type
+	bool getTypeKind(const TypeSymbol* type, TypeKind* kind) const;
+
+	/// Get the single dimensional array type of an element type, created on first use
+	TypeSymbol* getArrayType(const TypeSymbol* elementType);
+
+	/// Get the element type of an array type, nullptr for any other type
+	const TypeSymbol* getArrayElementType(const TypeSymbol* type) const;
+
 private:
 	SymbolTable* symbolTable_;
 	Dict<TypeKind, TypeSymbol*> builtinTypes_;
 	TypeSymbol* errorType_;
 	TypeSymbol* namespaceType_;
+	Dict<const TypeSymbol*, UniquePtr<TypeSymbol>> arrayTypes_;
+	Dict<const TypeSymbol*, const TypeSymbol*> arrayElementTypes_;
 
 	void initializeBuiltinTypes();
 };
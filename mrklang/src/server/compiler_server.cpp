@@ -0,0 +1,374 @@
+#include "compiler_server.h"
+#include "core/error_reporter.h"
+#include "common/logging.h"
+#include "codegen/code_generator.h"
+#include "codegen/bytecode_writer.h"
+
+#include <algorithm>
+#include <filesystem>
+
+MRK_NS_BEGIN_MODULE(server)
+
+static const char* toString(CompilerError::Stage stage) {
+	switch (stage) {
+		case CompilerError::Stage::LEXICAL: return "lexical";
+		case CompilerError::Stage::PARSER: return "parser";
+		case CompilerError::Stage::SEMANTIC: return "semantic";
+		case CompilerError::Stage::CODEGEN: return "codegen";
+	}
+
+	return "unknown";
+}
+
+CompilerServer::CompilerServer(std::istream& input, std::ostream& output)
+	: input_(input), output_(output), running_(false) {}
+
+int CompilerServer::run() {
+	MRK_INFO("Compiler server listening on stdio");
+
+	running_ = true;
+
+	Str line;
+	while (running_ && std::getline(input_, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+
+		if (line.empty()) {
+			continue;
+		}
+
+		auto response = handleMessage(line);
+		if (!response.empty()) {
+			output_ << response << '\n';
+			output_.flush();
+		}
+	}
+
+	MRK_INFO("Compiler server stopped");
+	return 0;
+}
+
+Str CompilerServer::handleMessage(const Str& message) {
+	JsonValue request;
+	try {
+		request = JsonValue::parse(message);
+	}
+	catch (const std::exception& e) {
+		return createErrorResponse(nullptr, PARSE_ERROR, e.what()).toString();
+	}
+
+	auto id = request.get("id");
+	auto method = request.get("method");
+
+	if (!request.isObject() || !method || !method->isString()) {
+		return createErrorResponse(id ? *id : nullptr, INVALID_REQUEST, "Expected a request object with a method").toString();
+	}
+
+	auto params = request.get("params");
+
+	JsonValue response;
+	try {
+		auto result = dispatch(method->asString(), params ? *params : JsonValue(JsonValue::Object{}));
+		response = createResponse(id ? *id : nullptr, Move(result));
+	}
+	catch (const RequestError& err) {
+		response = createErrorResponse(id ? *id : nullptr, err.code, err.message);
+	}
+	catch (const std::exception& e) {
+		MRK_ERROR("Request '{}' failed: {}", method->asString(), e.what());
+		response = createErrorResponse(id ? *id : nullptr, INTERNAL_ERROR, e.what());
+	}
+
+	// Notifications never get a response
+	return id ? response.toString() : "";
+}
+
+JsonValue CompilerServer::dispatch(const Str& method, const JsonValue& params) {
+	if (!params.isObject()) {
+		throw RequestError{ INVALID_PARAMS, "Expected params to be an object" };
+	}
+
+	if (method == "setFile") return handleSetFile(params);
+	if (method == "removeFile") return handleRemoveFile(params);
+	if (method == "check") return handleCheck(params);
+	if (method == "emit") return handleEmit(params);
+	if (method == "compile") return handleCompile(params);
+	if (method == "stats") return handleStats();
+	if (method == "shutdown") return handleShutdown();
+
+	throw RequestError{ METHOD_NOT_FOUND, std::format("Unknown method '{}'", method) };
+}
+
+JsonValue CompilerServer::handleSetFile(const JsonValue& params) {
+	auto& path = getStringParam(params, "path");
+
+	bool changed;
+	if (auto contents = params.get("contents")) {
+		if (!contents->isString()) {
+			throw RequestError{ INVALID_PARAMS, "Expected 'contents' to be a string" };
+		}
+
+		changed = engine_.setFile(path, contents->asString());
+	}
+	else {
+		auto revision = engine_.getRevision();
+		if (!engine_.loadFile(path)) {
+			throw RequestError{ INVALID_PARAMS, std::format("Failed to open file: {}", path) };
+		}
+
+		changed = engine_.getRevision() != revision;
+	}
+
+	JsonValue result(JsonValue::Object{});
+	result.set("changed", changed);
+	result.set("revision", engine_.getRevision());
+	return result;
+}
+
+JsonValue CompilerServer::handleRemoveFile(const JsonValue& params) {
+	JsonValue result(JsonValue::Object{});
+	result.set("removed", engine_.removeFile(getStringParam(params, "path")));
+	result.set("revision", engine_.getRevision());
+	return result;
+}
+
+JsonValue CompilerServer::handleCheck(const JsonValue& params) {
+	syncFiles(params);
+	return createCheckResult();
+}
+
+JsonValue CompilerServer::handleEmit(const JsonValue& params) {
+	syncFiles(params);
+
+	auto result = createCheckResult();
+	if (engine_.hasErrors()) {
+		return result;
+	}
+
+	if (params.get("function")) {
+		auto& name = getStringParam(params, "function");
+
+		auto function = engine_.findFunction(name);
+		if (!function) {
+			throw RequestError{ INVALID_PARAMS, std::format("Unknown function '{}'", name) };
+		}
+
+		result.set("code", engine_.codegen(function));
+	}
+	else {
+		JsonValue::Array files;
+		for (const auto& file : engine_.runtimeCode()) {
+			JsonValue entry(JsonValue::Object{});
+			entry.set("filename", file.filename);
+			entry.set("code", file.contents);
+			files.push_back(Move(entry));
+		}
+
+		result.set("files", Move(files));
+	}
+
+	return result;
+}
+
+JsonValue CompilerServer::handleCompile(const JsonValue& params) {
+	syncFiles(params);
+
+	auto result = createCheckResult();
+	if (engine_.hasErrors()) {
+		return result;
+	}
+
+	std::filesystem::path outputDirectory = ".";
+	if (params.get("outputDirectory")) {
+		outputDirectory = getStringParam(params, "outputDirectory");
+	}
+
+	// Unchanged files are left alone so native builds do not redo them
+	codegen::FileCodeOutput output(outputDirectory);
+	auto write = [&](const Str& filename, const Str& contents) {
+		output.open(filename).write(contents);
+		output.close();
+	};
+
+	write(codegen::MetadataWriter::METADATA_FILENAME, engine_.metadataImage());
+
+	const auto& files = engine_.runtimeCode();
+	for (const auto& file : files) {
+		write(file.filename, file.contents);
+	}
+
+	// The runtime interprets methods from the bytecode first, it must match the metadata just written
+	const auto& bytecode = engine_.bytecodeImage();
+	if (bytecode.empty()) {
+		throw RequestError{ INTERNAL_ERROR, "Failed to generate bytecode" };
+	}
+
+	write(codegen::BytecodeWriter::BYTECODE_FILENAME, bytecode);
+
+	if (!output.good()) {
+		throw RequestError{ INTERNAL_ERROR, std::format("Failed to write output files to {}", outputDirectory.string()) };
+	}
+
+	// Everything except the shared header, the registration unit and the source map is a function unit
+	auto unitCount = std::count_if(files.begin(), files.end(), [](const auto& file) {
+		return file.filename != codegen::CodeGenerator::HEADER_FILENAME &&
+			file.filename != codegen::CodeGenerator::REGISTRATION_FILENAME &&
+			file.filename != codegen::CodeGenerator::SOURCE_MAP_FILENAME;
+	});
+
+	if (!files.empty()) {
+		codegen::CodeGenerator::removeStaleUnits(outputDirectory, unitCount);
+	}
+
+	if (!output.saveManifest()) {
+		throw RequestError{ INTERNAL_ERROR, "Failed to write the code manifest" };
+	}
+
+	JsonValue::Array outputs;
+	for (const auto& path : output.getPaths()) {
+		outputs.push_back(path);
+	}
+
+	result.set("outputs", Move(outputs));
+	result.set("changed", static_cast<uint64_t>(output.getChangedCount()));
+	return result;
+}
+
+JsonValue CompilerServer::handleStats() {
+	auto& stats = engine_.getStats();
+
+	JsonValue result(JsonValue::Object{});
+	result.set("revision", engine_.getRevision());
+	result.set("lexes", stats.lexes);
+	result.set("parses", stats.parses);
+	result.set("analyses", stats.analyses);
+	result.set("incrementalAnalyses", stats.incrementalAnalyses);
+	result.set("metadataBuilds", stats.metadataBuilds);
+	result.set("functionCodegens", stats.functionCodegens);
+	result.set("runtimeCodegens", stats.runtimeCodegens);
+	result.set("hits", stats.hits);
+	return result;
+}
+
+JsonValue CompilerServer::handleShutdown() {
+	running_ = false;
+	return JsonValue();
+}
+
+void CompilerServer::syncFiles(const JsonValue& params) {
+	auto files = params.get("files");
+	if (!files) {
+		return;
+	}
+
+	if (!files->isArray()) {
+		throw RequestError{ INVALID_PARAMS, "Expected 'files' to be an array" };
+	}
+
+	Vec<Str> filenames;
+	for (const auto& file : files->asArray()) {
+		if (!file.isString()) {
+			throw RequestError{ INVALID_PARAMS, "Expected 'files' to contain strings" };
+		}
+
+		filenames.push_back(file.asString());
+	}
+
+	// Drop files that are no longer part of the compilation, the injected global file stays
+	auto current = engine_.getFiles();
+	for (size_t i = 1; i < current.size(); i++) {
+		if (std::find(filenames.begin(), filenames.end(), current[i]) == filenames.end()) {
+			engine_.removeFile(current[i]);
+		}
+	}
+
+	// Unchanged contents do not invalidate anything
+	for (const auto& filename : filenames) {
+		if (!engine_.loadFile(filename)) {
+			throw RequestError{ INVALID_PARAMS, std::format("Failed to open file: {}", filename) };
+		}
+	}
+}
+
+JsonValue CompilerServer::collectDiagnostics() const {
+	auto files = engine_.getFiles();
+	auto fileIndex = [&](const SourceFile* file) {
+		return std::find(files.begin(), files.end(), file->filename) - files.begin();
+	};
+
+	Vec<const CompilerError*> errors;
+	for (const auto& [file, fileErrors] : ErrorReporter::instance().getErrors()) {
+		for (const auto& err : fileErrors) {
+			errors.push_back(err.get());
+		}
+	}
+
+	std::stable_sort(errors.begin(), errors.end(), [&](const CompilerError* a, const CompilerError* b) {
+		auto ai = fileIndex(a->file);
+		auto bi = fileIndex(b->file);
+
+		if (ai != bi) return ai < bi;
+		if (a->line != b->line) return a->line < b->line;
+		return a->column < b->column;
+	});
+
+	JsonValue::Array diagnostics;
+	for (auto err : errors) {
+		JsonValue diagnostic(JsonValue::Object{});
+		diagnostic.set("file", err->file->filename);
+		diagnostic.set("stage", toString(err->stage));
+		diagnostic.set("line", err->line);
+		diagnostic.set("column", err->column);
+		diagnostic.set("length", err->length);
+		diagnostic.set("message", err->message);
+		diagnostics.push_back(Move(diagnostic));
+	}
+
+	return JsonValue(Move(diagnostics));
+}
+
+JsonValue CompilerServer::createCheckResult() {
+	auto hasErrors = engine_.hasErrors();
+
+	JsonValue result(JsonValue::Object{});
+	result.set("success", !hasErrors);
+	result.set("revision", engine_.getRevision());
+	result.set("diagnostics", collectDiagnostics());
+	return result;
+}
+
+const Str& CompilerServer::getStringParam(const JsonValue& params, const Str& name) {
+	auto value = params.get(name);
+	if (!value) {
+		throw RequestError{ INVALID_PARAMS, std::format("Missing parameter '{}'", name) };
+	}
+
+	if (!value->isString()) {
+		throw RequestError{ INVALID_PARAMS, std::format("Expected '{}' to be a string", name) };
+	}
+
+	return value->asString();
+}
+
+JsonValue CompilerServer::createResponse(const JsonValue& id, JsonValue result) {
+	JsonValue response(JsonValue::Object{});
+	response.set("jsonrpc", "2.0");
+	response.set("id", id);
+	response.set("result", Move(result));
+	return response;
+}
+
+JsonValue CompilerServer::createErrorResponse(const JsonValue& id, ErrorCode code, const Str& message) {
+	JsonValue error(JsonValue::Object{});
+	error.set("code", static_cast<int>(code));
+	error.set("message", message);
+
+	JsonValue response(JsonValue::Object{});
+	response.set("jsonrpc", "2.0");
+	response.set("id", id);
+	response.set("error", Move(error));
+	return response;
+}
+
+MRK_NS_END
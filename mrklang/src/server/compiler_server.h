@@ -0,0 +1,82 @@
+#pragma once
+
+#include "common/types.h"
+#include "core/query_engine.h"
+#include "json.h"
+
+#include <iostream>
+
+MRK_NS_BEGIN_MODULE(server)
+
+/// Long-running compiler daemon, started with `mrklang --server`
+/// Keeps a QueryEngine resident so repeated compiles only pay for what changed
+///
+/// Speaks JSON-RPC 2.0 over stdio, one message per line in both directions
+/// Logs go to stderr, stdout only ever carries responses
+///
+///		setFile		{ path, contents? }			Add or update a file, reads it from disk if contents is omitted
+///		removeFile	{ path }					Remove a file
+///		check		{ files? }					Analyze and return diagnostics
+///		emit		{ files?, function? }		Check, then return the runtime files or the code of a single function
+///		compile		{ files?, outputDirectory? }	Check, then write the runtime_generated files, runtime_metadata.mrkmeta and runtime_bytecode.mrkbc
+///													Only files whose contents changed are replaced
+///		stats		{}							Query engine counters
+///		shutdown	{}							Stop serving
+///
+/// When files is given, the engine is synced to exactly that list, every file is re-read from disk
+class CompilerServer {
+public:
+	CompilerServer(std::istream& input, std::ostream& output);
+
+	/// Serve requests until shutdown or end of input
+	int run();
+
+	/// Handle a single raw message, returns the serialized response or an empty string for notifications
+	Str handleMessage(const Str& message);
+
+private:
+	/// JSON-RPC error codes
+	enum ErrorCode {
+		PARSE_ERROR = -32700,
+		INVALID_REQUEST = -32600,
+		METHOD_NOT_FOUND = -32601,
+		INVALID_PARAMS = -32602,
+		INTERNAL_ERROR = -32603
+	};
+
+	/// Thrown by method handlers, turned into an error response
+	struct RequestError {
+		ErrorCode code;
+		Str message;
+	};
+
+	std::istream& input_;
+	std::ostream& output_;
+	QueryEngine engine_;
+	bool running_;
+
+	JsonValue dispatch(const Str& method, const JsonValue& params);
+
+	JsonValue handleSetFile(const JsonValue& params);
+	JsonValue handleRemoveFile(const JsonValue& params);
+	JsonValue handleCheck(const JsonValue& params);
+	JsonValue handleEmit(const JsonValue& params);
+	JsonValue handleCompile(const JsonValue& params);
+	JsonValue handleStats();
+	JsonValue handleShutdown();
+
+	/// Sync the engine to the files param if present
+	void syncFiles(const JsonValue& params);
+
+	/// Current diagnostics in file order
+	JsonValue collectDiagnostics() const;
+
+	/// Result skeleton shared by check, emit and compile
+	JsonValue createCheckResult();
+
+	static const Str& getStringParam(const JsonValue& params, const Str& name);
+	static JsonValue createResponse(const JsonValue& id, JsonValue result);
+	static JsonValue createErrorResponse(const JsonValue& id, ErrorCode code, const Str& message);
+};
+
+MRK_NS_END
@@ -0,0 +1,361 @@
+#include "json.h"
+
+#include <charconv>
+#include <cmath>
+#include <format>
+
+MRK_NS_BEGIN_MODULE(server)
+
+/// Recursive descent parser over the raw text
+class JsonParser {
+public:
+	JsonParser(const Str& text) : text_(text), pos_(0) {}
+
+	JsonValue parseDocument() {
+		auto value = parseValue();
+
+		skipWhitespace();
+		if (pos_ != text_.size()) {
+			fail("Unexpected trailing characters");
+		}
+
+		return value;
+	}
+
+private:
+	const Str& text_;
+	size_t pos_;
+
+	[[noreturn]] void fail(const char* message) const {
+		throw std::runtime_error(std::format("{} at offset {}", message, pos_));
+	}
+
+	void skipWhitespace() {
+		while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+			pos_++;
+		}
+	}
+
+	char peek() const {
+		return pos_ < text_.size() ? text_[pos_] : '\0';
+	}
+
+	void expect(char c) {
+		if (peek() != c) {
+			fail("Unexpected character");
+		}
+
+		pos_++;
+	}
+
+	void expectLiteral(const char* literal) {
+		for (; *literal; literal++) {
+			expect(*literal);
+		}
+	}
+
+	JsonValue parseValue() {
+		skipWhitespace();
+
+		switch (peek()) {
+			case '{':
+				return parseObject();
+
+			case '[':
+				return parseArray();
+
+			case '"':
+				return JsonValue(parseString());
+
+			case 't':
+				expectLiteral("true");
+				return JsonValue(true);
+
+			case 'f':
+				expectLiteral("false");
+				return JsonValue(false);
+
+			case 'n':
+				expectLiteral("null");
+				return JsonValue();
+
+			default:
+				return parseNumber();
+		}
+	}
+
+	JsonValue parseObject() {
+		expect('{');
+
+		JsonValue::Object members;
+		skipWhitespace();
+
+		if (peek() == '}') {
+			pos_++;
+			return JsonValue(Move(members));
+		}
+
+		while (true) {
+			skipWhitespace();
+			auto key = parseString();
+
+			skipWhitespace();
+			expect(':');
+
+			auto value = parseValue();
+			members.emplace_back(Move(key), Move(value));
+
+			skipWhitespace();
+			if (peek() == ',') {
+				pos_++;
+				continue;
+			}
+
+			expect('}');
+			return JsonValue(Move(members));
+		}
+	}
+
+	JsonValue parseArray() {
+		expect('[');
+
+		JsonValue::Array elements;
+		skipWhitespace();
+
+		if (peek() == ']') {
+			pos_++;
+			return JsonValue(Move(elements));
+		}
+
+		while (true) {
+			elements.push_back(parseValue());
+
+			skipWhitespace();
+			if (peek() == ',') {
+				pos_++;
+				continue;
+			}
+
+			expect(']');
+			return JsonValue(Move(elements));
+		}
+	}
+
+	uint32_t parseHex4() {
+		if (pos_ + 4 > text_.size()) {
+			fail("Truncated unicode escape");
+		}
+
+		uint32_t value = 0;
+		auto result = std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, value, 16);
+		if (result.ptr != text_.data() + pos_ + 4) {
+			fail("Invalid unicode escape");
+		}
+
+		pos_ += 4;
+		return value;
+	}
+
+	static void appendUtf8(Str& out, uint32_t codepoint) {
+		if (codepoint < 0x80) {
+			out += static_cast<char>(codepoint);
+		}
+		else if (codepoint < 0x800) {
+			out += static_cast<char>(0xC0 | (codepoint >> 6));
+			out += static_cast<char>(0x80 | (codepoint & 0x3F));
+		}
+		else if (codepoint < 0x10000) {
+			out += static_cast<char>(0xE0 | (codepoint >> 12));
+			out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codepoint & 0x3F));
+		}
+		else {
+			out += static_cast<char>(0xF0 | (codepoint >> 18));
+			out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+			out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+			out += static_cast<char>(0x80 | (codepoint & 0x3F));
+		}
+	}
+
+	Str parseString() {
+		expect('"');
+
+		Str result;
+		while (true) {
+			if (pos_ >= text_.size()) {
+				fail("Unterminated string");
+			}
+
+			char c = text_[pos_++];
+			if (c == '"') {
+				return result;
+			}
+
+			if (c != '\\') {
+				result += c;
+				continue;
+			}
+
+			if (pos_ >= text_.size()) {
+				fail("Unterminated escape sequence");
+			}
+
+			switch (text_[pos_++]) {
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+
+				case 'u': {
+					auto codepoint = parseHex4();
+
+					// Surrogate pair
+					if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+						expect('\\');
+						expect('u');
+
+						auto low = parseHex4();
+						if (low < 0xDC00 || low > 0xDFFF) {
+							fail("Invalid surrogate pair");
+						}
+
+						codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+
+					appendUtf8(result, codepoint);
+					break;
+				}
+
+				default:
+					fail("Invalid escape sequence");
+			}
+		}
+	}
+
+	JsonValue parseNumber() {
+		auto start = pos_;
+
+		if (peek() == '-') {
+			pos_++;
+		}
+
+		while (pos_ < text_.size() && std::strchr("0123456789.eE+-", text_[pos_])) {
+			pos_++;
+		}
+
+		double value = 0;
+		auto result = std::from_chars(text_.data() + start, text_.data() + pos_, value);
+		if (start == pos_ || result.ptr != text_.data() + pos_) {
+			pos_ = start;
+			fail("Invalid value");
+		}
+
+		return JsonValue(value);
+	}
+};
+
+const JsonValue* JsonValue::get(const Str& key) const {
+	for (const auto& [name, value] : object_) {
+		if (name == key) {
+			return &value;
+		}
+	}
+
+	return nullptr;
+}
+
+void JsonValue::set(Str key, JsonValue value) {
+	object_.emplace_back(Move(key), Move(value));
+}
+
+Str JsonValue::toString() const {
+	Str out;
+	write(out);
+	return out;
+}
+
+JsonValue JsonValue::parse(const Str& text) {
+	return JsonParser(text).parseDocument();
+}
+
+void JsonValue::write(Str& out) const {
+	switch (type_) {
+		case Type::NUL:
+			out += "null";
+			break;
+
+		case Type::BOOLEAN:
+			out += boolean_ ? "true" : "false";
+			break;
+
+		case Type::NUMBER:
+			// Ids, lines and counters are integers, keep them that way
+			if (std::isfinite(number_) && number_ == std::floor(number_) && std::abs(number_) < 1e15) {
+				out += std::format("{}", static_cast<int64_t>(number_));
+			}
+			else if (std::isfinite(number_)) {
+				out += std::format("{}", number_);
+			}
+			else {
+				out += "null";
+			}
+			break;
+
+		case Type::STRING:
+			out += '"';
+
+			for (unsigned char c : string_) {
+				switch (c) {
+					case '"': out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\b': out += "\\b"; break;
+					case '\f': out += "\\f"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+
+					default:
+						if (c < 0x20) {
+							out += std::format("\\u{:04x}", c);
+						}
+						else {
+							out += static_cast<char>(c);
+						}
+				}
+			}
+
+			out += '"';
+			break;
+
+		case Type::ARRAY:
+			out += '[';
+
+			for (size_t i = 0; i < array_.size(); i++) {
+				if (i > 0) out += ',';
+				array_[i].write(out);
+			}
+
+			out += ']';
+			break;
+
+		case Type::OBJECT:
+			out += '{';
+
+			for (size_t i = 0; i < object_.size(); i++) {
+				if (i > 0) out += ',';
+
+				JsonValue(object_[i].first).write(out);
+				out += ':';
+				object_[i].second.write(out);
+			}
+
+			out += '}';
+			break;
+	}
+}
+
+MRK_NS_END
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <stdexcept>
+
+MRK_NS_BEGIN_MODULE(server)
+
+/// Minimal JSON document model for the compiler server protocol
+/// Objects keep their insertion order so responses serialize deterministically
+class JsonValue {
+public:
+	enum class Type {
+		NUL,
+		BOOLEAN,
+		NUMBER,
+		STRING,
+		ARRAY,
+		OBJECT
+	};
+
+	using Array = Vec<JsonValue>;
+	using Object = Vec<std::pair<Str, JsonValue>>;
+
+	JsonValue() : type_(Type::NUL), boolean_(false), number_(0) {}
+	JsonValue(std::nullptr_t) : JsonValue() {}
+	JsonValue(bool value) : type_(Type::BOOLEAN), boolean_(value), number_(0) {}
+	JsonValue(double value) : type_(Type::NUMBER), boolean_(false), number_(value) {}
+	JsonValue(int value) : JsonValue(static_cast<double>(value)) {}
+	JsonValue(uint32_t value) : JsonValue(static_cast<double>(value)) {}
+	JsonValue(uint64_t value) : JsonValue(static_cast<double>(value)) {}
+	JsonValue(Str value) : type_(Type::STRING), boolean_(false), number_(0), string_(Move(value)) {}
+	JsonValue(const char* value) : JsonValue(Str(value)) {}
+	JsonValue(Array value) : type_(Type::ARRAY), boolean_(false), number_(0), array_(Move(value)) {}
+	JsonValue(Object value) : type_(Type::OBJECT), boolean_(false), number_(0), object_(Move(value)) {}
+
+	Type getType() const { return type_; }
+	bool isNull() const { return type_ == Type::NUL; }
+	bool isBoolean() const { return type_ == Type::BOOLEAN; }
+	bool isNumber() const { return type_ == Type::NUMBER; }
+	bool isString() const { return type_ == Type::STRING; }
+	bool isArray() const { return type_ == Type::ARRAY; }
+	bool isObject() const { return type_ == Type::OBJECT; }
+
+	bool asBoolean() const { return boolean_; }
+	double asNumber() const { return number_; }
+	const Str& asString() const { return string_; }
+	const Array& asArray() const { return array_; }
+	const Object& asObject() const { return object_; }
+
+	/// Member lookup, nullptr if this is not an object or the key does not exist
+	const JsonValue* get(const Str& key) const;
+
+	/// Append a member to an object
+	void set(Str key, JsonValue value);
+
+	/// Serialize into compact JSON, never contains raw newlines
+	Str toString() const;
+
+	/// Parse a JSON document, throws std::runtime_error on malformed input
+	static JsonValue parse(const Str& text);
+
+private:
+	Type type_;
+	bool boolean_;
+	double number_;
+	Str string_;
+	Array array_;
+	Object object_;
+
+	void write(Str& out) const;
+};
+
+MRK_NS_END
@@ -6,17 +6,23 @@
 
 MRK_NS_BEGIN_MODULE(runtime)
 
-void registerInternalCall(const Str& sig, InternalCall call) { 
-	Runtime::instance().registerInternalCall(sig, call); 
+template<typename Ret, typename ...Args>
+void registerInternalCall(const Str& sig, Ret(*call)(Args...)) {
+	Runtime::instance().registerInternalCall(sig, call);
 }
 
-bool mrk__web__Http__request(const Str& url, int method) {
+bool mrk__web__Http__request(const String& url, int method) {
 	std::cout << "mrk__web__http_request: " << url << ", " << method << std::endl;
 	return true;
 }
 
+void __globalType__testNative() {
+	std::cout << "__globalType__testNative" << std::endl;
+}
+
 void registerInternalCalls() {
-	registerInternalCall("__global__mrk__web__Http_request", (InternalCall)mrk__web__Http__request);
+	registerInternalCall("__global__mrk__web__Http_request", mrk__web__Http__request);
+	registerInternalCall("__global____globalType_testNative", __globalType__testNative);
 }
 
 MRK_NS_END
\ No newline at end of file
@@ -1,3 +1,70 @@
 #pragma once
 
-typedef void*(*InternalCall)(...);
\ No newline at end of file
+#include "common/types.h"
+#include "runtime_string.h"
+
+#include <type_traits>
+
+MRK_NS_BEGIN_MODULE(runtime)
+
+/// Untyped storage for a bound internal call
+/// Always cast back to its exact signature before being called
+using InternalCall = void(*)();
+
+/// mrklang type that a C++ internal call parameter or return type stands for
+/// Only types with a fixed mapping are specialized, any other type fails to compile
+template<typename T>
+struct InternalCallType;
+
+#define MRK_INTERNAL_CALL_TYPE(type, name) \
+	template<> struct InternalCallType<type> { static constexpr const char* NAME = name; };
+
+MRK_INTERNAL_CALL_TYPE(void, "void")
+MRK_INTERNAL_CALL_TYPE(bool, "bool")
+MRK_INTERNAL_CALL_TYPE(char, "char")
+MRK_INTERNAL_CALL_TYPE(int8_t, "i8")
+MRK_INTERNAL_CALL_TYPE(uint8_t, "byte")
+MRK_INTERNAL_CALL_TYPE(int16_t, "short")
+MRK_INTERNAL_CALL_TYPE(uint16_t, "ushort")
+MRK_INTERNAL_CALL_TYPE(int32_t, "int")
+MRK_INTERNAL_CALL_TYPE(uint32_t, "uint")
+MRK_INTERNAL_CALL_TYPE(int64_t, "long")
+MRK_INTERNAL_CALL_TYPE(uint64_t, "ulong")
+MRK_INTERNAL_CALL_TYPE(float, "float")
+MRK_INTERNAL_CALL_TYPE(double, "double")
+MRK_INTERNAL_CALL_TYPE(const String&, "string") // Strings are only ever passed by const reference
+MRK_INTERNAL_CALL_TYPE(void*, "object")
+
+#undef MRK_INTERNAL_CALL_TYPE
+
+/// How a parameter of the given generated type is passed to an internal call
+template<typename T>
+using InternalCallParameter = std::conditional_t<std::is_same_v<T, String>, const String&, T>;
+
+/// Signature of an internal call as mrklang type names, checked against the metadata when binding
+struct InternalCallSignature {
+	const char* returnType;
+	Vec<const char*> parameterTypes;
+
+	template<typename Ret, typename ...Args>
+	static InternalCallSignature of() {
+		return { InternalCallType<Ret>::NAME, { InternalCallType<Args>::NAME... } };
+	}
+};
+
+struct InternalCallBinding {
+	InternalCall call;
+	InternalCallSignature signature;
+};
+
+/// Pointer type of an internal call, from the function type of the native method it implements
+template<typename Signature>
+struct InternalCallTraits;
+
+template<typename Ret, typename ...Params>
+struct InternalCallTraits<Ret(Params...)> {
+	using Return = Ret;
+	using Pointer = Ret(*)(InternalCallParameter<Params>...);
+};
+
+MRK_NS_END
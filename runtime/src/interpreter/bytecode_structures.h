@@ -0,0 +1,167 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <cstdint>
+
+MRK_NS_BEGIN_MODULE(runtime::interpreter)
+
+constexpr uint32_t BYTECODE_VERSION = 2;
+constexpr uint32_t BYTECODE_MAGIC = 0x4D524B42; // MRKB
+
+/// Kinds of values the bytecode computes with, the primitive types
+enum class ValueKind : uint8_t {
+	VOID,
+	BOOL,
+	CHAR,
+	I8,
+	U8,
+	I16,
+	U16,
+	I32,
+	U32,
+	I64,
+	U64,
+	F32,
+	F64,
+};
+
+// Registers are 64 bits wide, integers are kept sign or zero extended from the width of their kind
+// and f32 values are kept as doubles rounded to float precision
+// a, b and c are registers unless noted, imm is b and c as one 32 bit operand
+#define BYTECODE_OPCODES \
+	X(MOVE)         /* a = b */ \
+	X(CONSTANT)     /* a = constants[imm] */ \
+	X(CONVERT)      /* a = b converted from kind c to kind */ \
+	X(ADD)          /* a = b + c, integers wrap to their kind */ \
+	X(SUB) \
+	X(MUL) \
+	X(DIV)          /* Signed division */ \
+	X(DIV_UN)       /* Unsigned division */ \
+	X(REM) \
+	X(REM_UN) \
+	X(AND) \
+	X(OR) \
+	X(XOR) \
+	X(SHL) \
+	X(SHR) \
+	X(SHR_UN) \
+	X(NEG)          /* a = -b */ \
+	X(NOT)          /* a = !b */ \
+	X(BIT_NOT)      /* a = ~b */ \
+	X(ADD_F) \
+	X(SUB_F) \
+	X(MUL_F) \
+	X(DIV_F) \
+	X(NEG_F) \
+	X(EQ)           /* a = b == c, greater than is emitted as less than with its operands swapped */ \
+	X(NE) \
+	X(LT) \
+	X(LE) \
+	X(LT_UN) \
+	X(LE_UN) \
+	X(EQ_F) \
+	X(NE_F) \
+	X(LT_F) \
+	X(LE_F) \
+	X(JUMP)         /* Continue at instruction imm */ \
+	X(JUMP_IF)      /* Continue at instruction imm if a is true */ \
+	X(JUMP_UNLESS)  /* Continue at instruction imm if a is false */ \
+	X(LOAD_STATIC)  /* a = fields[imm] */ \
+	X(STORE_STATIC) /* fields[imm] = a */ \
+	X(LOAD_FIELD)   /* a = instance->fields[imm] */ \
+	X(STORE_FIELD)  /* instance->fields[imm] = a */ \
+	X(CALL)         /* a = calls[imm](...), a is unused if kind is void */ \
+	X(RETURN)       /* Return a */ \
+	X(RETURN_VOID)
+
+enum class Opcode : uint8_t {
+	#define X(name) name,
+	BYTECODE_OPCODES
+	#undef X
+	COUNT
+};
+
+struct Instruction {
+	Opcode opcode;
+	ValueKind kind; // Kind of the result, of the operands for comparisons, of the value for stores and returns
+	uint16_t a;
+	uint16_t b;
+	uint16_t c;
+
+	uint32_t getImmediate() const { return b | (static_cast<uint32_t>(c) << 16); }
+
+	void setImmediate(uint32_t value) {
+		b = static_cast<uint16_t>(value);
+		c = static_cast<uint16_t>(value >> 16);
+	}
+};
+
+static_assert(sizeof(Instruction) == 8, "Instructions are packed into 8 bytes");
+
+struct FieldReference {
+	uint32_t token;
+	uint32_t isStatic;
+};
+
+struct CallArgument {
+	uint16_t reg;
+	ValueKind kind;
+	uint8_t reserved;
+};
+
+struct CallSite {
+	uint32_t methodToken;
+	uint32_t argumentStart; // Index into the method's arguments
+	uint32_t argumentCount;
+};
+
+// Method flags
+enum BytecodeMethodFlags : uint8_t {
+	BYTECODE_METHOD_INSTANCE = 1 << 0, // Called with an instance, its fields are read through it
+};
+
+struct MethodHeader {
+	uint32_t token;
+	uint16_t registerCount;
+	uint16_t parameterCount; // Parameters are passed in the first registers
+	ValueKind returnKind;
+	uint8_t flags;
+	uint16_t reserved;
+	uint32_t instructionCount;
+	uint32_t constantCount;
+	uint32_t fieldCount;
+	uint32_t callCount;
+	uint32_t argumentCount;
+};
+
+// Static field value flags
+enum StaticFieldValueFlags : uint8_t {
+	STATIC_FIELD_RUNTIME_INITIALIZER = 1 << 0, // Only the generated code computes the value, bits are unused
+};
+
+/// Constant a static field starts out with, for static fields without native storage
+struct StaticFieldValue {
+	uint32_t fieldToken;
+	ValueKind kind;
+	uint8_t flags;
+	uint8_t reserved[2];
+	uint64_t bits; // Register representation of the value
+};
+
+// Bytecode format:
+// [uint32_t version] <-- BYTECODE VERSION
+// [uint32_t magic] <-- MAGIC NUMBER
+// [uint32_t methodCount] <-- NUMBER OF METHODS
+// For every method:
+//   [MethodHeader header]
+//   [ValueKind* parameterKinds] <-- header.parameterCount
+//   [Instruction* instructions] <-- header.instructionCount
+//   [uint64_t* constants] <-- header.constantCount, in their register representation
+//   [FieldReference* fields] <-- header.fieldCount
+//   [CallSite* calls] <-- header.callCount
+//   [CallArgument* arguments] <-- header.argumentCount
+// [uint32_t staticFieldValueCount] <-- NUMBER OF STATIC FIELD VALUES
+// [StaticFieldValue* staticFieldValues] <-- STATIC FIELD VALUES
+
+MRK_NS_END
@@ -0,0 +1,699 @@
+#include "interpreter.h"
+#include "runtime.h"
+#include "type_system/field.h"
+#include "type_system/method.h"
+#include "common/logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Handlers jump straight to the next one through a table of label addresses where the compiler supports it
+#if defined(__GNUC__) || defined(__clang__)
+#define MRK_INTERPRETER_THREADED_DISPATCH 1
+#endif
+
+MRK_NS_BEGIN_MODULE(runtime::interpreter)
+
+using namespace type_system;
+
+namespace {
+	/// Registers shared by the frames of a thread, a call takes its frame from the top
+	constexpr size_t STACK_SIZE = 1 << 16;
+	constexpr uint32_t MAX_CALL_DEPTH = 1024;
+
+	struct Stack {
+		Vec<Register> registers = Vec<Register>(STACK_SIZE);
+		Register* top = registers.data();
+		uint32_t depth = 0;
+
+		Register* end() { return registers.data() + registers.size(); }
+	};
+
+	/// Frame of the running method, the stack top is past its registers until it returns
+	struct FrameScope {
+		Stack& stack;
+		Register* previousTop;
+
+		FrameScope(Stack& stack, Register* frameEnd) : stack(stack), previousTop(stack.top) {
+			stack.top = frameEnd;
+			stack.depth++;
+		}
+
+		~FrameScope() {
+			stack.top = previousTop;
+			stack.depth--;
+		}
+	};
+
+	Stack& getStack() {
+		thread_local Stack stack;
+		return stack;
+	}
+
+	struct KindInfo {
+		uint8_t shift; // Bits above the width of the kind in a register
+		bool isSigned;
+	};
+
+	// Indexed by ValueKind
+	constexpr KindInfo KIND_INFO[] = {
+		{ 0, false },  // VOID
+		{ 63, false }, // BOOL
+		{ 56, true },  // CHAR
+		{ 56, true },  // I8
+		{ 56, false }, // U8
+		{ 48, true },  // I16
+		{ 48, false }, // U16
+		{ 32, true },  // I32
+		{ 32, false }, // U32
+		{ 0, true },   // I64
+		{ 0, false },  // U64
+		{ 0, false },  // F32
+		{ 0, false },  // F64
+	};
+
+	/// Sign or zero extend the low bits of an integer kind
+	inline int64_t normalize(ValueKind kind, uint64_t value) {
+		const auto& info = KIND_INFO[static_cast<uint8_t>(kind)];
+		value <<= info.shift;
+		return info.isSigned ? static_cast<int64_t>(value) >> info.shift : static_cast<int64_t>(value >> info.shift);
+	}
+
+	/// Shift counts are masked to the width of the kind
+	inline uint64_t getShiftCount(ValueKind kind, Register count) {
+		return count.u & (63 - KIND_INFO[static_cast<uint8_t>(kind)].shift);
+	}
+
+	inline double roundFloat(ValueKind kind, double value) {
+		return kind == ValueKind::F32 ? static_cast<double>(static_cast<float>(value)) : value;
+	}
+
+	/// Plain load and store rather than a locked increment, counters are hit on every loop iteration
+	inline uint32_t increment(std::atomic<uint32_t>& counter) {
+		auto value = counter.load(std::memory_order_relaxed) + 1;
+		counter.store(value, std::memory_order_relaxed);
+		return value;
+	}
+
+	inline bool isFloating(ValueKind kind) {
+		return kind == ValueKind::F32 || kind == ValueKind::F64;
+	}
+
+	Register convertValue(ValueKind kind, ValueKind sourceKind, Register value) {
+		Register result{};
+
+		if (kind == ValueKind::BOOL) {
+			result.u = isFloating(sourceKind) ? value.f != 0 : value.u != 0;
+		}
+		else if (isFloating(kind)) {
+			double converted = isFloating(sourceKind) ? value.f :
+				KIND_INFO[static_cast<uint8_t>(sourceKind)].isSigned ? static_cast<double>(value.i) : static_cast<double>(value.u);
+			result.f = roundFloat(kind, converted);
+		}
+		else if (isFloating(sourceKind)) {
+			auto truncated = KIND_INFO[static_cast<uint8_t>(kind)].isSigned ? static_cast<uint64_t>(static_cast<int64_t>(value.f)) : static_cast<uint64_t>(value.f);
+			result.i = normalize(kind, truncated);
+		}
+		else {
+			result.i = normalize(kind, value.u);
+		}
+
+		return result;
+	}
+
+	Register loadValue(ValueKind kind, const void* address) {
+		Register value{};
+
+		switch (kind) {
+			case ValueKind::BOOL: value.u = *static_cast<const bool*>(address); break;
+			case ValueKind::CHAR:
+			case ValueKind::I8: value.i = *static_cast<const int8_t*>(address); break;
+			case ValueKind::U8: value.u = *static_cast<const uint8_t*>(address); break;
+			case ValueKind::I16: value.i = *static_cast<const int16_t*>(address); break;
+			case ValueKind::U16: value.u = *static_cast<const uint16_t*>(address); break;
+			case ValueKind::I32: value.i = *static_cast<const int32_t*>(address); break;
+			case ValueKind::U32: value.u = *static_cast<const uint32_t*>(address); break;
+			case ValueKind::I64: value.i = *static_cast<const int64_t*>(address); break;
+			case ValueKind::U64: value.u = *static_cast<const uint64_t*>(address); break;
+			case ValueKind::F32: value.f = *static_cast<const float*>(address); break;
+			case ValueKind::F64: value.f = *static_cast<const double*>(address); break;
+			default: break;
+		}
+
+		return value;
+	}
+
+	void storeValue(ValueKind kind, void* address, Register value) {
+		switch (kind) {
+			case ValueKind::BOOL: *static_cast<bool*>(address) = value.u != 0; break;
+			case ValueKind::CHAR:
+			case ValueKind::I8: *static_cast<int8_t*>(address) = static_cast<int8_t>(value.i); break;
+			case ValueKind::U8: *static_cast<uint8_t*>(address) = static_cast<uint8_t>(value.u); break;
+			case ValueKind::I16: *static_cast<int16_t*>(address) = static_cast<int16_t>(value.i); break;
+			case ValueKind::U16: *static_cast<uint16_t*>(address) = static_cast<uint16_t>(value.u); break;
+			case ValueKind::I32: *static_cast<int32_t*>(address) = static_cast<int32_t>(value.i); break;
+			case ValueKind::U32: *static_cast<uint32_t*>(address) = static_cast<uint32_t>(value.u); break;
+			case ValueKind::I64: *static_cast<int64_t*>(address) = value.i; break;
+			case ValueKind::U64: *static_cast<uint64_t*>(address) = value.u; break;
+			case ValueKind::F32: *static_cast<float*>(address) = static_cast<float>(value.f); break;
+			case ValueKind::F64: *static_cast<double*>(address) = value.f; break;
+			default: break;
+		}
+	}
+
+	/// Operands in range of the method's registers and tables, so running it never reads past them
+	bool verify(const BytecodeMethod& method) {
+		if (method.code.empty() || method.parameterKinds.size() > method.registerCount) {
+			return false;
+		}
+
+		auto isRegister = [&](uint16_t reg) { return reg < method.registerCount; };
+		auto isKind = [](ValueKind kind) { return kind <= ValueKind::F64; };
+
+		if (!isKind(method.returnKind) || !std::all_of(method.parameterKinds.begin(), method.parameterKinds.end(), isKind)) {
+			return false;
+		}
+
+		for (const auto& call : method.calls) {
+			if (static_cast<uint64_t>(call.argumentStart) + call.argumentCount > method.arguments.size()) {
+				return false;
+			}
+		}
+
+		for (const auto& argument : method.arguments) {
+			if (!isRegister(argument.reg) || !isKind(argument.kind)) {
+				return false;
+			}
+		}
+
+		for (const auto& instruction : method.code) {
+			auto immediate = instruction.getImmediate();
+			if (!isKind(instruction.kind) || (instruction.opcode == Opcode::CONVERT && instruction.c > static_cast<uint16_t>(ValueKind::F64))) {
+				return false;
+			}
+
+			switch (instruction.opcode) {
+				case Opcode::CONSTANT:
+					if (!isRegister(instruction.a) || immediate >= method.constants.size()) return false;
+					break;
+
+				case Opcode::JUMP:
+					if (immediate >= method.code.size()) return false;
+					break;
+
+				case Opcode::JUMP_IF:
+				case Opcode::JUMP_UNLESS:
+					if (!isRegister(instruction.a) || immediate >= method.code.size()) return false;
+					break;
+
+				case Opcode::LOAD_STATIC:
+				case Opcode::STORE_STATIC:
+				case Opcode::LOAD_FIELD:
+				case Opcode::STORE_FIELD:
+					if (!isRegister(instruction.a) || immediate >= method.fieldReferences.size()) return false;
+					break;
+
+				case Opcode::CALL:
+					if ((instruction.kind != ValueKind::VOID && !isRegister(instruction.a)) || immediate >= method.calls.size()) return false;
+					break;
+
+				case Opcode::RETURN_VOID:
+					break;
+
+				case Opcode::MOVE:
+				case Opcode::CONVERT:
+				case Opcode::NEG:
+				case Opcode::NOT:
+				case Opcode::BIT_NOT:
+				case Opcode::NEG_F:
+				case Opcode::RETURN:
+					if (!isRegister(instruction.a) || !isRegister(instruction.b)) return false;
+					break;
+
+				default:
+					if (instruction.opcode >= Opcode::COUNT ||
+						!isRegister(instruction.a) || !isRegister(instruction.b) || !isRegister(instruction.c)) return false;
+					break;
+			}
+		}
+
+		// The last instruction leaves the method, execution never runs off the end
+		auto last = method.code.back().opcode;
+		return last == Opcode::JUMP || last == Opcode::RETURN || last == Opcode::RETURN_VOID;
+	}
+
+	/// Reads the sections of the bytecode image, failing once it runs past the end
+	struct Reader {
+		const uint8_t* position;
+		const uint8_t* end;
+
+		bool read(void* destination, size_t size) {
+			if (size > static_cast<size_t>(end - position)) {
+				return false;
+			}
+
+			if (size > 0) {
+				std::memcpy(destination, position, size);
+			}
+
+			position += size;
+			return true;
+		}
+
+		template<typename T>
+		bool read(Vec<T>& values, size_t count) {
+			values.resize(count);
+			return read(values.data(), count * sizeof(T));
+		}
+	};
+}
+
+Interpreter& Interpreter::instance() {
+	static Interpreter instance;
+	return instance;
+}
+
+bool Interpreter::loadFromFile(const Str& filename) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return false;
+	}
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	Vec<char> buffer(size);
+	if (!file.read(buffer.data(), size)) {
+		return false;
+	}
+
+	return loadFromMemory(buffer.data(), buffer.size());
+}
+
+bool Interpreter::loadFromMemory(const void* data, size_t size) {
+	// See bytecode_structures.h for the format
+	auto bytes = static_cast<const uint8_t*>(data);
+	Reader reader{ bytes, bytes + size };
+
+	uint32_t version, magic, methodCount;
+	if (!reader.read(&version, sizeof(version)) || version != BYTECODE_VERSION ||
+		!reader.read(&magic, sizeof(magic)) || magic != BYTECODE_MAGIC ||
+		!reader.read(&methodCount, sizeof(methodCount))) {
+		return false;
+	}
+
+	methods_.clear();
+	methodCount_ = 0;
+
+	for (uint32_t i = 0; i < methodCount; i++) {
+		MethodHeader header;
+		if (!reader.read(&header, sizeof(header))) {
+			return false;
+		}
+
+		auto method = MakeUnique<BytecodeMethod, false>();
+		method->token = header.token;
+		method->registerCount = header.registerCount;
+		method->returnKind = header.returnKind;
+		method->hasInstance = header.flags & BYTECODE_METHOD_INSTANCE;
+
+		Vec<uint64_t> constants;
+		if (!reader.read(method->parameterKinds, header.parameterCount) ||
+			!reader.read(method->code, header.instructionCount) ||
+			!reader.read(constants, header.constantCount) ||
+			!reader.read(method->fieldReferences, header.fieldCount) ||
+			!reader.read(method->calls, header.callCount) ||
+			!reader.read(method->arguments, header.argumentCount)) {
+			return false;
+		}
+
+		for (auto bits : constants) {
+			Register constant;
+			constant.u = bits;
+			method->constants.push_back(constant);
+		}
+
+		if (!verify(*method)) {
+			MRK_ERROR("Invalid bytecode for method {}", header.token);
+			return false;
+		}
+
+		if (header.token >= methods_.size()) {
+			methods_.resize(header.token + 1);
+		}
+
+		methods_[header.token] = Move(method);
+		methodCount_++;
+	}
+
+	uint32_t staticFieldValueCount;
+	return reader.read(&staticFieldValueCount, sizeof(staticFieldValueCount)) &&
+		reader.read(staticFieldValues_, staticFieldValueCount);
+}
+
+bool Interpreter::bind() {
+	auto& typeRegistry = TypeRegistry::instance();
+
+	auto allocateStorage = [this](Field* field) {
+		auto& storage = staticFieldStorage_.emplace_back(MakeUnique<uint64_t>());
+		field->setNativeField(storage.get());
+	};
+
+	bool bound = true;
+
+	// The generated code initializes the static fields it declares
+	for (const auto& value : staticFieldValues_) {
+		auto* field = typeRegistry.getFieldByToken(value.fieldToken);
+		if (!field || field->getValue()) {
+			continue;
+		}
+
+		// Reading the field would silently give 0 instead of its initializer
+		if (value.flags & STATIC_FIELD_RUNTIME_INITIALIZER) {
+			MRK_ERROR("Static field {} has a runtime initializer and no native storage", value.fieldToken);
+			bound = false;
+			continue;
+		}
+
+		allocateStorage(field);
+
+		Register bits;
+		bits.u = value.bits;
+		storeValue(value.kind, field->getValue(), bits);
+	}
+
+	for (auto& method : methods_) {
+		if (!method) {
+			continue;
+		}
+
+		method->fields.clear();
+		for (const auto& reference : method->fieldReferences) {
+			auto* field = typeRegistry.getFieldByToken(reference.token);
+			if (!field) {
+				MRK_ERROR("Field not found for token: {}", reference.token);
+				bound = false;
+				method->fields.push_back(0);
+				continue;
+			}
+
+			if (reference.isStatic && !field->getValue()) {
+				allocateStorage(field);
+			}
+
+			method->fields.push_back(reference.isStatic ? reinterpret_cast<uintptr_t>(field->getValue()) : field->getOffset());
+		}
+
+		method->callTargets.clear();
+		for (const auto& call : method->calls) {
+			method->callTargets.push_back(getMethod(call.methodToken));
+		}
+
+		auto* runtimeMethod = typeRegistry.getMethodByToken(method->token);
+		method->hasNativeTier = runtimeMethod && runtimeMethod->getInvoker();
+	}
+
+	return bound;
+}
+
+bool Interpreter::countInvocation(const BytecodeMethod& method) const {
+	auto& counters = method.counters;
+	if (counters.tier.load(std::memory_order_relaxed) == ExecutionTier::NATIVE) {
+		return true;
+	}
+
+	auto invocations = increment(counters.invocations);
+	auto backEdges = counters.backEdges.load(std::memory_order_relaxed);
+	if (!method.hasNativeTier || (invocations < invocationThreshold_ && backEdges < backEdgeThreshold_)) {
+		return false;
+	}
+
+	counters.tier.store(ExecutionTier::NATIVE, std::memory_order_relaxed);
+	MRK_INFO("Promoted method {} to native code after {} calls and {} loop iterations", method.token, invocations, backEdges);
+	return true;
+}
+
+bool Interpreter::execute(const BytecodeMethod& method, void* instance, const Vec<void*>& args, void* result) const {
+	if (args.size() < method.parameterKinds.size()) {
+		MRK_ERROR("Method {} expects {} arguments, got {}", method.token, method.parameterKinds.size(), args.size());
+		return false;
+	}
+
+	if (method.hasInstance && !instance) {
+		MRK_ERROR("Method {} requires an instance", method.token);
+		return false;
+	}
+
+	auto& stack = getStack();
+	if (method.registerCount > stack.end() - stack.top) {
+		MRK_ERROR("Interpreter stack overflow in method {}", method.token);
+		return false;
+	}
+
+	auto* frame = stack.top;
+	for (size_t i = 0; i < method.parameterKinds.size(); i++) {
+		frame[i] = loadValue(method.parameterKinds[i], args[i]);
+	}
+
+	Register value{};
+	if (!run(method, instance, frame, &value)) {
+		return false;
+	}
+
+	if (result && method.returnKind != ValueKind::VOID) {
+		storeValue(method.returnKind, result, value);
+	}
+
+	return true;
+}
+
+bool Interpreter::run(const BytecodeMethod& method, void* instance, Register* frame, Register* result) const {
+	auto& stack = getStack();
+	FrameScope scope(stack, frame + method.registerCount);
+
+	const auto* code = method.code.data();
+	const auto* constants = method.constants.data();
+	const auto* fields = method.fields.data();
+	const auto* ip = code;
+
+	#define R(operand) frame[ip->operand]
+
+	#ifdef MRK_INTERPRETER_THREADED_DISPATCH
+	static const void* const dispatchTable[] = {
+		#define X(name) &&OP_##name,
+		BYTECODE_OPCODES
+		#undef X
+	};
+
+	#define HANDLER(name) OP_##name:
+	#define DISPATCH() goto *dispatchTable[static_cast<uint8_t>(ip->opcode)]
+	#else
+	#define HANDLER(name) case Opcode::name:
+	#define DISPATCH() continue
+	#endif
+
+	#define NEXT() ip++; DISPATCH()
+	// Jumping back closes a loop iteration, which counts towards promoting the method
+	#define JUMP_TO(target) { \
+		const auto* destination = code + (target); \
+		if (destination <= ip) increment(method.counters.backEdges); \
+		ip = destination; \
+		DISPATCH(); \
+	}
+
+	#define INTEGER_BINARY(name, expression) \
+		HANDLER(name) { R(a).i = normalize(ip->kind, expression); NEXT(); }
+
+	#define FLOAT_BINARY(name, op) \
+		HANDLER(name) { R(a).f = roundFloat(ip->kind, R(b).f op R(c).f); NEXT(); }
+
+	#define COMPARISON(name, member, op) \
+		HANDLER(name) { R(a).u = R(b).member op R(c).member; NEXT(); }
+
+	#define CHECK_DIVISOR() \
+		if (R(c).u == 0) { \
+			MRK_ERROR("Division by zero in method {}", method.token); \
+			return false; \
+		}
+
+	#ifdef MRK_INTERPRETER_THREADED_DISPATCH
+	DISPATCH();
+	{
+	#else
+	for (;;) {
+		switch (ip->opcode) {
+	#endif
+			HANDLER(MOVE) { R(a) = R(b); NEXT(); }
+			HANDLER(CONSTANT) { R(a) = constants[ip->getImmediate()]; NEXT(); }
+			HANDLER(CONVERT) { R(a) = convertValue(ip->kind, static_cast<ValueKind>(ip->c), R(b)); NEXT(); }
+
+			// Integer arithmetic wraps, done on the raw bits and extended back from the width of the kind
+			INTEGER_BINARY(ADD, R(b).u + R(c).u)
+			INTEGER_BINARY(SUB, R(b).u - R(c).u)
+			INTEGER_BINARY(MUL, R(b).u * R(c).u)
+
+			HANDLER(DIV) {
+				CHECK_DIVISOR();
+
+				// Dividing the smallest value by -1 overflows, it wraps like negation
+				R(a).i = normalize(ip->kind, R(c).i == -1 ? 0 - R(b).u : static_cast<uint64_t>(R(b).i / R(c).i));
+				NEXT();
+			}
+
+			HANDLER(DIV_UN) {
+				CHECK_DIVISOR();
+				R(a).i = normalize(ip->kind, R(b).u / R(c).u);
+				NEXT();
+			}
+
+			HANDLER(REM) {
+				CHECK_DIVISOR();
+				R(a).i = R(c).i == -1 ? 0 : normalize(ip->kind, static_cast<uint64_t>(R(b).i % R(c).i));
+				NEXT();
+			}
+
+			HANDLER(REM_UN) {
+				CHECK_DIVISOR();
+				R(a).i = normalize(ip->kind, R(b).u % R(c).u);
+				NEXT();
+			}
+
+			// Both operands are extended the same way already
+			HANDLER(AND) { R(a).u = R(b).u & R(c).u; NEXT(); }
+			HANDLER(OR) { R(a).u = R(b).u | R(c).u; NEXT(); }
+			HANDLER(XOR) { R(a).u = R(b).u ^ R(c).u; NEXT(); }
+
+			INTEGER_BINARY(SHL, R(b).u << getShiftCount(ip->kind, R(c)))
+			HANDLER(SHR) { R(a).i = R(b).i >> getShiftCount(ip->kind, R(c)); NEXT(); }
+			HANDLER(SHR_UN) { R(a).u = R(b).u >> getShiftCount(ip->kind, R(c)); NEXT(); }
+
+			HANDLER(NEG) { R(a).i = normalize(ip->kind, 0 - R(b).u); NEXT(); }
+			HANDLER(NOT) { R(a).u = R(b).u ^ 1; NEXT(); }
+			HANDLER(BIT_NOT) { R(a).i = normalize(ip->kind, ~R(b).u); NEXT(); }
+
+			FLOAT_BINARY(ADD_F, +)
+			FLOAT_BINARY(SUB_F, -)
+			FLOAT_BINARY(MUL_F, *)
+			FLOAT_BINARY(DIV_F, /)
+			HANDLER(NEG_F) { R(a).f = -R(b).f; NEXT(); }
+
+			COMPARISON(EQ, u, ==)
+			COMPARISON(NE, u, !=)
+			COMPARISON(LT, i, <)
+			COMPARISON(LE, i, <=)
+			COMPARISON(LT_UN, u, <)
+			COMPARISON(LE_UN, u, <=)
+			COMPARISON(EQ_F, f, ==)
+			COMPARISON(NE_F, f, !=)
+			COMPARISON(LT_F, f, <)
+			COMPARISON(LE_F, f, <=)
+
+			HANDLER(JUMP) { JUMP_TO(ip->getImmediate()); }
+
+			HANDLER(JUMP_IF) {
+				if (R(a).u) {
+					JUMP_TO(ip->getImmediate());
+				}
+
+				NEXT();
+			}
+
+			HANDLER(JUMP_UNLESS) {
+				if (!R(a).u) {
+					JUMP_TO(ip->getImmediate());
+				}
+
+				NEXT();
+			}
+
+			HANDLER(LOAD_STATIC) { R(a) = loadValue(ip->kind, reinterpret_cast<const void*>(fields[ip->getImmediate()])); NEXT(); }
+			HANDLER(STORE_STATIC) { storeValue(ip->kind, reinterpret_cast<void*>(fields[ip->getImmediate()]), R(a)); NEXT(); }
+			HANDLER(LOAD_FIELD) { R(a) = loadValue(ip->kind, static_cast<uint8_t*>(instance) + fields[ip->getImmediate()]); NEXT(); }
+			HANDLER(STORE_FIELD) { storeValue(ip->kind, static_cast<uint8_t*>(instance) + fields[ip->getImmediate()], R(a)); NEXT(); }
+
+			HANDLER(CALL) {
+				auto index = ip->getImmediate();
+				const auto& call = method.calls[index];
+				const auto* target = method.callTargets[index];
+
+				Register value{};
+				if (target && !countInvocation(*target)) {
+					// The callee's frame starts past the caller's, its arguments are copied into its first registers
+					auto* calleeFrame = stack.top;
+					if (target->registerCount > stack.end() - calleeFrame || stack.depth >= MAX_CALL_DEPTH) {
+						MRK_ERROR("Interpreter stack overflow in method {}", target->token);
+						return false;
+					}
+
+					for (uint32_t i = 0; i < call.argumentCount; i++) {
+						calleeFrame[i] = frame[method.arguments[call.argumentStart + i].reg];
+					}
+
+					if (!run(*target, nullptr, calleeFrame, &value)) {
+						return false;
+					}
+				}
+				else if (!callNative(method, call, ip->kind, frame, &value)) {
+					return false;
+				}
+
+				if (ip->kind != ValueKind::VOID) {
+					R(a) = value;
+				}
+
+				NEXT();
+			}
+
+			HANDLER(RETURN) {
+				*result = R(a);
+				return true;
+			}
+
+			HANDLER(RETURN_VOID) {
+				return true;
+			}
+	#ifdef MRK_INTERPRETER_THREADED_DISPATCH
+	}
+	#else
+			default:
+				MRK_ERROR("Invalid opcode {} in method {}", static_cast<uint8_t>(ip->opcode), method.token);
+				return false;
+		}
+	}
+	#endif
+
+	#undef R
+	#undef HANDLER
+	#undef DISPATCH
+	#undef NEXT
+	#undef JUMP_TO
+	#undef INTEGER_BINARY
+	#undef FLOAT_BINARY
+	#undef COMPARISON
+	#undef CHECK_DIVISOR
+}
+
+bool Interpreter::callNative(const BytecodeMethod& caller, const CallSite& call, ValueKind returnKind, Register* frame, Register* result) const {
+	// Every argument gets a full register of storage, written in the representation of its kind
+	Vec<uint64_t> storage(call.argumentCount);
+	Vec<void*> args(call.argumentCount);
+	for (uint32_t i = 0; i < call.argumentCount; i++) {
+		const auto& argument = caller.arguments[call.argumentStart + i];
+		storeValue(argument.kind, &storage[i], frame[argument.reg]);
+		args[i] = &storage[i];
+	}
+
+	uint64_t returnStorage = 0;
+	if (!Runtime::instance().executeMethod(call.methodToken, nullptr, args, returnKind != ValueKind::VOID ? &returnStorage : nullptr)) {
+		return false;
+	}
+
+	if (returnKind != ValueKind::VOID) {
+		*result = loadValue(returnKind, &returnStorage);
+	}
+
+	return true;
+}
+
+MRK_NS_END
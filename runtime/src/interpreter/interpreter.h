@@ -0,0 +1,113 @@
+#pragma once
+
+#include "common/types.h"
+#include "bytecode_structures.h"
+
+#include <atomic>
+
+MRK_NS_BEGIN_MODULE(runtime::interpreter)
+
+/// Register representation of a value, see BYTECODE_OPCODES
+union Register {
+	int64_t i;
+	uint64_t u;
+	double f;
+};
+
+/// Where calls of a method that has both bytecode and native code go
+enum class ExecutionTier : uint8_t {
+	INTERPRETED,
+	NATIVE,
+};
+
+/// Profile of a method's interpreted runs, it stops counting once the method is promoted
+/// Updated without synchronization, concurrent runs may lose counts
+struct MethodCounters {
+	std::atomic<uint32_t> invocations = 0;
+	std::atomic<uint32_t> backEdges = 0;
+	std::atomic<ExecutionTier> tier = ExecutionTier::INTERPRETED;
+};
+
+/// Bytecode of a method, its fields and callees resolved once bound
+struct BytecodeMethod {
+	uint32_t token;
+	uint16_t registerCount;
+	ValueKind returnKind;
+	bool hasInstance;
+	Vec<ValueKind> parameterKinds;
+	Vec<Instruction> code;
+	Vec<Register> constants;
+	Vec<FieldReference> fieldReferences;
+	Vec<CallSite> calls;
+	Vec<CallArgument> arguments;
+
+	/// Address of static fields, offset of instance fields
+	Vec<uintptr_t> fields;
+
+	/// Bytecode of the callees, nullptr for callees without any, those are called through the runtime
+	Vec<const BytecodeMethod*> callTargets;
+
+	/// Native code the runtime can call in place of the bytecode, the method is promoted to it once hot
+	bool hasNativeTier = false;
+
+	mutable MethodCounters counters;
+};
+
+/// Runs methods from the bytecode the compiler emits next to the metadata
+/// Lets a program run without its generated code being compiled, methods the bytecode lacks are called through the runtime
+class Interpreter {
+public:
+	static Interpreter& instance();
+
+	Interpreter(const Interpreter&) = delete;
+	Interpreter& operator=(const Interpreter&) = delete;
+
+	bool loadFromFile(const Str& filename);
+	bool loadFromMemory(const void* data, size_t size);
+
+	/// Resolve the fields and callees of the loaded methods, once the metadata and native code are registered
+	/// Static fields without native storage are given storage here, starting out with their constant value
+	/// Fails for static fields with a runtime initializer and no native storage, only the generated code can run it
+	bool bind();
+
+	/// nullptr if the method has no bytecode
+	const BytecodeMethod* getMethod(uint32_t methodToken) const {
+		return methodToken < methods_.size() ? methods_[methodToken].get() : nullptr;
+	}
+
+	size_t getMethodCount() const { return methodCount_; }
+
+	/// Interpreted calls and loop iterations after which a method is promoted to its native code
+	void setTierUpThresholds(uint32_t invocations, uint32_t backEdges) {
+		invocationThreshold_ = invocations;
+		backEdgeThreshold_ = backEdges;
+	}
+
+	/// Count a call of the method, true if it runs its native code rather than the bytecode
+	bool countInvocation(const BytecodeMethod& method) const;
+
+	/// Same contract as Runtime::executeMethod, args point to the parameters and result receives the return value
+	bool execute(const BytecodeMethod& method, void* instance, const Vec<void*>& args, void* result) const;
+
+private:
+	/// Indexed by method token
+	Vec<UniquePtr<BytecodeMethod>> methods_;
+	size_t methodCount_ = 0;
+	uint32_t invocationThreshold_ = UINT32_MAX;
+	uint32_t backEdgeThreshold_ = UINT32_MAX;
+	Vec<StaticFieldValue> staticFieldValues_;
+
+	/// Storage of static fields the generated code does not provide
+	Vec<UniquePtr<uint64_t>> staticFieldStorage_;
+
+	Interpreter() = default;
+	~Interpreter() = default;
+
+	/// Run a method in the frame starting at the given registers, its parameters already in place
+	bool run(const BytecodeMethod& method, void* instance, Register* frame, Register* result) const;
+
+	/// Call a method without bytecode through the runtime, arguments are passed in their native representation
+	bool callNative(const BytecodeMethod& caller, const CallSite& call, ValueKind returnKind, Register* frame, Register* result) const;
+};
+
+MRK_NS_END
@@ -61,6 +61,7 @@ struct FieldDefinition {
 	StringHandle name;
 	TypeDefinitionHandle typeHandle;
 	MemberFlags flags;
+	uint32_t offset; // From the start of the object, instance fields only
 	uint32_t token;
 };
 
@@ -80,6 +81,11 @@ struct MethodDefinition {
 	uint32_t token; // Method token
 };
 
+// Method implementation flags
+enum MethodImplFlags : uint32_t {
+	METHOD_IMPL_INTERNAL_CALL = 1 << 0, // Implemented by the runtime, bound to an internal call at startup
+};
+
 struct TypeFlags {
 	uint32_t isPrimitive : 1;     // Is a fundamental type
 	uint32_t isValueType : 1;     // Value vs reference type
@@ -183,11 +189,13 @@ struct MetadataRegistrationBase {
 template<typename TypeT, typename FieldT, typename MethodT, bool ReverseLookup = false>
 struct MetadataRegistration : MetadataRegistrationBase<TypeT, FieldT, MethodT> {};
 
+// Tokens are dense and 1-based, the runtime indexes them directly, slot 0 is always empty
+// Objects know their own token, so there is no forward direction to keep
 template<typename TypeT, typename FieldT, typename MethodT>
-struct MetadataRegistration<TypeT, FieldT, MethodT, true> : MetadataRegistrationBase<TypeT, FieldT, MethodT> {
-	Dict<uint32_t, TypeT*> typeTokenReverseMap;
-	Dict<uint32_t, FieldT*> fieldTokenReverseMap;
-	Dict<uint32_t, MethodT*> methodTokenReverseMap;
+struct MetadataRegistration<TypeT, FieldT, MethodT, true> {
+	Vec<TypeT*> typesByToken;
+	Vec<FieldT*> fieldsByToken;
+	Vec<MethodT*> methodsByToken;
 };
 
 
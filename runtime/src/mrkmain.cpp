@@ -2,16 +2,23 @@
 #include "common/logging.h"
 #include "runtime.h"
 
+#include <cstring>
+
 #define RUNTIME_VERSION "0.1"
 
 using namespace mrklang::runtime;
 
 // CONSOLE ENTRYPOINT
-int main() {
+int main(int argc, char** argv) {
 	MRK_INFO("RUNTIME STARTED, mrklang v" RUNTIME_VERSION);
 
+	// --interpret runs the program from its bytecode alone, the generated code does not need to be rebuilt
+	bool interpretOnly = argc > 1 && std::strcmp(argv[1], "--interpret") == 0;
+
 	auto result = Runtime::instance().initialize(RuntimeOptions{
 			.metadataPath = "runtime_metadata.mrkmeta",
+			.bytecodePath = "runtime_bytecode.mrkbc",
+			.interpretOnly = interpretOnly,
 	});
 
 	if (!result) {
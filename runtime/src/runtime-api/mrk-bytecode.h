@@ -0,0 +1,3 @@
+#pragma once
+
+#include "../interpreter/bytecode_structures.h"
\ No newline at end of file
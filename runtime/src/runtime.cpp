@@ -14,6 +14,7 @@ extern void registerInternalCalls();
 
 namespace generated {
 	extern void registerMetadata();
+	extern void initializeStaticFields();
 }
 
 using namespace type_system;
@@ -50,10 +51,36 @@ bool Runtime::initialize(const RuntimeOptions& options) {
 	typeRegistry.dumpTree();
 	initialized_ = true;
 
-	MRK_INFO("Runtime initialized, registering metadata...");
-	generated::registerMetadata();
+	if (!options.interpretOnly) {
+		MRK_INFO("Runtime initialized, registering metadata...");
+		generated::registerMetadata();
+	}
 
 	registerInternalCalls();
+	if (!bindInternalCalls()) {
+		initialized_ = false;
+		return false;
+	}
+
+	// Bound once the native code is registered, static fields it already stores are left to it
+	if (!options.bytecodePath.empty()) {
+		auto& interpreter = interpreter::Interpreter::instance();
+		interpreter.setTierUpThresholds(options.tierUpInvocations, options.tierUpBackEdges);
+
+		if (!interpreter.loadFromFile(options.bytecodePath) || !interpreter.bind()) {
+			MRK_ERROR("Failed to load bytecode from: {}", options.bytecodePath);
+			initialized_ = false;
+			return false;
+		}
+
+		MRK_INFO("Loaded bytecode of {} methods from: {}", interpreter.getMethodCount(), options.bytecodePath);
+	}
+
+	// Initializers may call natives, so they run once those are bound
+	if (!options.interpretOnly) {
+		std::call_once(staticFieldsInitialized_, generated::initializeStaticFields);
+	}
+
 	return true;
 }
 
@@ -80,10 +107,26 @@ bool Runtime::executeMethod(uint32_t methodToken, void* instance, const Vec<void
 		return false;
 	}
 
-	if (method->getNativeMethod()) {
-		using NativeMethodPtr = void (*)();
-		auto nativeMethod = reinterpret_cast<NativeMethodPtr>(method->getNativeMethod());
-		nativeMethod();
+	// Both tiers pass the instance straight through as the method's first parameter
+	if (!instance && !method->isStatic()) {
+		MRK_ERROR("Cannot execute instance method {} without an instance", method->getName());
+		return false;
+	}
+
+	// Methods start out interpreted when they have bytecode, switching to their native code once hot
+	auto& interpreter = interpreter::Interpreter::instance();
+	auto* bytecode = interpreter.getMethod(methodToken);
+	if (bytecode && !interpreter.countInvocation(*bytecode)) {
+		return interpreter.execute(*bytecode, instance, args, result);
+	}
+
+	if (auto invoker = method->getInvoker()) {
+		if (args.size() < method->getParameters().size()) {
+			MRK_ERROR("Method {} expects {} arguments, got {}", method->getName(), method->getParameters().size(), args.size());
+			return false;
+		}
+
+		invoker(instance, const_cast<void**>(args.data()), result);
 		return true;
 	}
 
@@ -91,6 +134,11 @@ bool Runtime::executeMethod(uint32_t methodToken, void* instance, const Vec<void
 	return false;
 }
 
+const interpreter::MethodCounters* Runtime::getMethodCounters(uint32_t methodToken) const {
+	auto* bytecode = interpreter::Interpreter::instance().getMethod(methodToken);
+	return bytecode ? &bytecode->counters : nullptr;
+}
+
 bool Runtime::runProgram(const Str& assemblyName) {
 	if (!initialized_) {
 		MRK_ERROR("Cannot run program: Runtime not initialized");
@@ -123,11 +171,11 @@ bool Runtime::runProgram(const Str& assemblyName) {
 	return executeMethod(image.entryPointToken, nullptr, Vec<void*>(), nullptr);
 }
 
-void Runtime::registerInternalCall(const Str& signature, InternalCall call) {
-	internalCalls_[signature] = call;
+void Runtime::registerInternalCall(const Str& signature, InternalCallBinding binding) {
+	internalCalls_[signature] = Move(binding);
 }
 
-void Runtime::registerNativeMethod(uint32_t methodToken, void* nativeMethod) {
+void Runtime::registerNativeMethod(uint32_t methodToken, void* nativeMethod, MethodInvoker invoker) {
 	if (!initialized_) {
 		MRK_ERROR("Cannot register native method: Runtime not initialized");
 		return;
@@ -140,11 +188,7 @@ void Runtime::registerNativeMethod(uint32_t methodToken, void* nativeMethod) {
 	}
 
 	method->setNativeMethod(nativeMethod);
-}
-
-void Runtime::registerStaticField(uint32_t fieldToken, void* nativeField, void* staticInit) {
-	registerNativeField(fieldToken, nativeField);
-	registerStaticFieldInit(fieldToken, staticInit);
+	method->setInvoker(invoker);
 }
 
 void Runtime::registerNativeField(uint32_t fieldToken, void* nativeField) {
@@ -162,19 +206,46 @@ void Runtime::registerNativeField(uint32_t fieldToken, void* nativeField) {
 	field->setNativeField(nativeField);
 }
 
-void Runtime::registerStaticFieldInit(uint32_t fieldToken, void* nativeMethod) {
-	if (!initialized_) {
-		MRK_ERROR("Cannot register static field init: Runtime not initialized");
-		return;
+bool Runtime::bindInternalCalls() {
+	const auto* root = MetadataLoader::instance().getMetadataRoot();
+	if (!root) {
+		return true;
 	}
 
-	auto* field = getTypeRegistry().getFieldByToken(fieldToken);
-	if (!field) {
-		MRK_ERROR("Field not found for token: {}", fieldToken);
-		return;
+	internalCallTable_.assign(root->methodDefinitionCount + 1, nullptr);
+
+	bool bound = true;
+	for (uint32_t i = 0; i < root->methodDefinitionCount; i++) {
+		const auto& methodDef = root->methodDefinitions[i];
+		if (!(methodDef.implFlags & METHOD_IMPL_INTERNAL_CALL)) {
+			continue;
+		}
+
+		auto* method = getTypeRegistry().getMethodByToken(methodDef.token);
+		if (!method || methodDef.token >= internalCallTable_.size()) {
+			MRK_ERROR("Invalid native method token: {}", methodDef.token);
+			bound = false;
+			continue;
+		}
+
+		auto sig = getInternalCallSignature(method);
+		auto it = internalCalls_.find(sig);
+		if (it == internalCalls_.end()) {
+			MRK_ERROR("Internal call not found: {}", sig);
+			bound = false;
+			continue;
+		}
+
+		if (!matchesInternalCall(method, it->second.signature)) {
+			MRK_ERROR("Internal call {} does not match the signature of {}", sig, method->getName());
+			bound = false;
+			continue;
+		}
+
+		internalCallTable_[methodDef.token] = it->second.call;
 	}
 
-	field->setStaticInit(nativeMethod);
+	return bound;
 }
 
 Str Runtime::getInternalCallSignature(const Method* method) const {
@@ -183,4 +254,23 @@ Str Runtime::getInternalCallSignature(const Method* method) const {
 	return typeName + "_" + method->getName();
 }
 
+bool Runtime::matchesInternalCall(const Method* method, const InternalCallSignature& signature) const {
+	if (method->getReturnType()->getName() != signature.returnType) {
+		return false;
+	}
+
+	const auto& parameters = method->getParameters();
+	if (parameters.size() != signature.parameterTypes.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < parameters.size(); i++) {
+		if (parameters[i].getType()->getName() != signature.parameterTypes[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 MRK_NS_END
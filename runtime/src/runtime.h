@@ -2,9 +2,13 @@
 
 #include "metadata/metadata_loader.h"
 #include "type_system/type_registry.h"
+#include "type_system/method.h"
 #include "common/logging.h"
 #include "runtime_object.h"
 #include "icalls.h"
+#include "interpreter/interpreter.h"
+
+#include <mutex>
 
 MRK_NS_BEGIN_MODULE(runtime)
 
@@ -16,6 +20,18 @@ struct RuntimeOptions {
 
 	// Whether to preload all types or load on demand
 	bool preloadTypes = true;
+
+	// Path to the bytecode file, methods without native code are interpreted from it
+	Str bytecodePath;
+
+	// Leave the generated native code out and run everything the bytecode covers through the interpreter
+	bool interpretOnly = false;
+
+	// Interpreted calls after which a method with native code is promoted to it, 0 runs native code from the start
+	uint32_t tierUpInvocations = 1000;
+
+	// Interpreted loop iterations after which a method with native code is promoted to it
+	uint32_t tierUpBackEdges = 10000;
 };
 
 /// Main runtime class
@@ -39,48 +55,58 @@ public:
     /// Execute a method by its metadata token
     bool executeMethod(uint32_t methodToken, void* instance, const Vec<void*>& args, void* result);
 
+    /// Execution profile of a method, nullptr if it has no bytecode
+    const interpreter::MethodCounters* getMethodCounters(uint32_t methodToken) const;
+
     /// Run a program starting from its entry point
     bool runProgram(const Str& assemblyName);
 
-	void registerInternalCall(const Str& signature, InternalCall call);
+	/// Register the implementation of a native method
+	/// Its C++ signature is recorded and has to match the method's metadata when binding
+	template<typename Ret, typename ...Args>
+	void registerInternalCall(const Str& signature, Ret(*call)(Args...)) {
+		registerInternalCall(signature, InternalCallBinding{ reinterpret_cast<InternalCall>(call), InternalCallSignature::of<Ret, Args...>() });
+	}
 
-	template<typename ...Args>
-	void* invokeInternalCall(uint32_t methodToken, Args... args) {
-		auto method = getTypeRegistry().getMethodByToken(methodToken);
-		if (!method) {
-			MRK_ERROR("Method not found for token: {}", methodToken);
-			return nullptr;
-		}
+	void registerInternalCall(const Str& signature, InternalCallBinding binding);
 
-		auto sig = getInternalCallSignature(method);
-		auto it = internalCalls_.find(sig);
-		if (it == internalCalls_.end()) {
-			MRK_ERROR("Internal call not found: {}", sig);
-			return nullptr;
-		}
+	/// Internal call bound to a native method, resolved once at startup
+	static InternalCall getInternalCall(uint32_t methodToken) { return internalCallTable_[methodToken]; }
 
-		return it->second(args...);
+	/// Call a native method through its bound internal call
+	/// Signature is the function type of the generated native method
+	/// The call stays indirect, the pointer is only known to match it once bindInternalCalls checked it against the metadata
+	template<typename Signature, typename ...Args>
+	static typename InternalCallTraits<Signature>::Return invokeInternalCall(uint32_t methodToken, Args&&... args) {
+		using Pointer = typename InternalCallTraits<Signature>::Pointer;
+		return reinterpret_cast<Pointer>(internalCallTable_[methodToken])(std::forward<Args>(args)...);
 	}
 	
 	// Runtime externals
 	// Method
-	void registerNativeMethod(uint32_t methodToken, void* nativeMethod);
+	void registerNativeMethod(uint32_t methodToken, void* nativeMethod, MethodInvoker invoker);
 	
 	// Field
-	void registerStaticField(uint32_t fieldToken, void* nativeField, void* staticInit);
 	void registerNativeField(uint32_t fieldToken, void* nativeField);
-	void registerStaticFieldInit(uint32_t fieldToken, void* nativeMethod);
 
 private:
 	bool initialized_ = false;
 	RuntimeOptions options_;
-	Dict<Str, InternalCall> internalCalls_;
+	Dict<Str, InternalCallBinding> internalCalls_;
+	std::once_flag staticFieldsInitialized_;
+
+	// Indexed by method token, only native methods have an entry
+	inline static Vec<InternalCall> internalCallTable_;
 
     Runtime() = default;
     ~Runtime() = default;
 
 	TypeRegistry& getTypeRegistry() { return TypeRegistry::instance(); }
 	Str getInternalCallSignature(const Method* method) const;
+	bool matchesInternalCall(const Method* method, const InternalCallSignature& signature) const;
+
+	/// Resolve the internal call of every native method, false if any is missing
+	bool bindInternalCalls();
 };
 
 MRK_NS_END
\ No newline at end of file
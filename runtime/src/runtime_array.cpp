@@ -0,0 +1,13 @@
+#include "runtime_array.h"
+#include "common/logging.h"
+
+#include <cstdlib>
+
+MRK_NS_BEGIN_MODULE(runtime)
+
+void failBoundsCheck(size_t index, size_t length) {
+	MRK_FATAL("Index {} is out of range of an array of length {}", index, length);
+	std::abort();
+}
+
+MRK_NS_END
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <atomic>
+#include <new>
+#include <utility>
+
+MRK_NS_BEGIN_MODULE(runtime)
+
+/// Reports an out of range array access and terminates, there is nothing to unwind to
+[[noreturn]] void failBoundsCheck(size_t index, size_t length);
+
+/// Single dimensional array of the generated code, a type_system::ArrayType at runtime
+/// The array is a reference to one block holding its length followed by its elements,
+/// copies share the elements like any other reference type does
+template<typename T>
+class Array {
+	struct Header {
+		std::atomic<uint32_t> references;
+		size_t length;
+
+		T* elements() { return reinterpret_cast<T*>(this + 1); }
+	};
+
+	static_assert(alignof(T) <= alignof(Header), "Array elements cannot be aligned past the header");
+
+public:
+	constexpr Array() : header_(nullptr) {}
+
+	/// Value initialized elements
+	explicit Array(size_t length) : header_(allocate(length)) {
+		for (size_t i = 0; i < length; i++) {
+			new (header_->elements() + i) T();
+		}
+	}
+
+	template<typename ...Elements>
+	static Array of(Elements&&... elements) {
+		Array result;
+		result.header_ = allocate(sizeof...(Elements));
+
+		auto data = result.header_->elements();
+		(new (data++) T(static_cast<T>(std::forward<Elements>(elements))), ...);
+		return result;
+	}
+
+	Array(const Array& other) : header_(other.header_) {
+		if (header_) {
+			header_->references.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	Array(Array&& other) noexcept : header_(std::exchange(other.header_, nullptr)) {}
+
+	Array& operator=(Array other) noexcept {
+		std::swap(header_, other.header_);
+		return *this;
+	}
+
+	~Array() {
+		if (header_ && header_->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			destroy(header_);
+		}
+	}
+
+	size_t length() const { return header_ ? header_->length : 0; }
+	T* data() const { return header_ ? header_->elements() : nullptr; }
+
+	/// Unchecked, for accesses already known to be in range
+	T& operator[](size_t index) const { return header_->elements()[index]; }
+
+	T& at(size_t index) const {
+		if (index >= length()) {
+			failBoundsCheck(index, length());
+		}
+
+		return header_->elements()[index];
+	}
+
+	bool operator==(const Array& other) const { return header_ == other.header_; }
+
+private:
+	Header* header_;
+
+	static Header* allocate(size_t length) {
+		auto memory = ::operator new(sizeof(Header) + length * sizeof(T));
+		return new (memory) Header{ 1, length };
+	}
+
+	static void destroy(Header* header) {
+		for (size_t i = 0; i < header->length; i++) {
+			header->elements()[i].~T();
+		}
+
+		header->~Header();
+		::operator delete(header);
+	}
+};
+
+MRK_NS_END
@@ -1,19 +1,37 @@
 #pragma once
 
+#include <charconv>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <type_traits>
 
-typedef void (*NativeMethodPtr)(void**, void*);
+#include "runtime_array.h"
+#include "runtime_string.h"
+#include "runtime_invoker.h"
 
 // Macros for method registration and execution
+// The runtime calls the method through its invoker, with the arguments and result passed by address
 #define MRK_RUNTIME_REGISTER_CODE(token, method) \
-    Runtime::instance().registerNativeMethod(token, reinterpret_cast<void*>(method))
+    Runtime::instance().registerNativeMethod(token, reinterpret_cast<void*>(method), &__mrkinvoker<decltype(method)>::invoke<false, method>)
 
-#define MRK_RUNTIME_REGISTER_STATIC_FIELD(token, field, init) \
-    Runtime::instance().registerStaticField(token, reinterpret_cast<void*>(&field), reinterpret_cast<void*>(init))
+#define MRK_RUNTIME_REGISTER_INSTANCE_CODE(token, method) \
+    Runtime::instance().registerNativeMethod(token, reinterpret_cast<void*>(method), &__mrkinvoker<decltype(method)>::invoke<true, method>)
+
+// Static fields are initialized by the generated initialization table, only their storage is registered
+#define MRK_RUNTIME_REGISTER_STATIC_FIELD(token, field) \
+    Runtime::instance().registerNativeField(token, reinterpret_cast<void*>(&field))
 
 #define MRK_RUNTIME_REGISTER_TYPE(token, type)
 
+// Reflection reads fields at the offsets in the metadata, the native layout has to agree
+#define MRK_CHECK_TYPE_SIZE(type, size) \
+    static_assert(sizeof(type) == size, "Size of " #type " differs from the metadata")
+
+#define MRK_CHECK_FIELD_OFFSET(type, field, offset) \
+    static_assert(offsetof(type, field) == offset, "Offset of " #type "::" #field " differs from the metadata")
+
 // Helper macros for method calls
 #define MRK_CALL_METHOD(methodToken, instance, args, result) \
     Runtime::instance().executeMethod(methodToken, instance, args, result)
@@ -85,8 +103,96 @@ typedef void (*NativeMethodPtr)(void**, void*);
 #define MRK_CREATE_REFERENCE_OBJECT(type) \
     new ReferenceTypeObject(type)
 
-#define MRK_INVOKE_ICALL(token, ...) \
-    Runtime::instance().invokeInternalCall(token __VA_OPT__(,) __VA_ARGS__)
+#define MRK_INVOKE_ICALL(token, signature, ...) \
+    Runtime::invokeInternalCall<signature>(token __VA_OPT__(,) __VA_ARGS__)
+
+// Virtual calls, signature is the function type of the method declaring the slot, instance included
+template<typename Signature>
+struct __mrkvirtual;
+
+template<typename Ret, typename Instance, typename ...Params>
+struct __mrkvirtual<Ret(Instance, Params...)> {
+    // The instance is evaluated once, it is both the vtable holder and the first argument
+    template<typename ...Args>
+    static Ret call(size_t slot, Instance instance, Args&&... args) {
+        return reinterpret_cast<Ret(*)(Instance, Params...)>(instance->__vtable[slot])(instance, std::forward<Args>(args)...);
+    }
+};
+
+#define MRK_VIRTUAL_CALL(signature, slot, instance, ...) \
+    __mrkvirtual<signature>::call(slot, instance __VA_OPT__(,) __VA_ARGS__)
+
+// Interpolated strings, built in a single allocation
+// Literal segments are measured by the compiler, any other part is reserved for at its longest
+template<typename T>
+size_t __mrkinterpolationCapacity(const T& part) {
+    if constexpr (std::is_array_v<T>) {
+        return 0;
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        return 5;
+    }
+    else if constexpr (std::is_same_v<T, char>) {
+        return 1;
+    }
+    else if constexpr (std::is_integral_v<T>) {
+        return std::numeric_limits<T>::digits10 + 2; // Sign and the partial leading digit
+    }
+    else if constexpr (std::is_floating_point_v<T>) {
+        return std::numeric_limits<T>::max_digits10 + 7; // Sign, point and exponent of the shortest round trip form
+    }
+    else {
+        return part.size();
+    }
+}
+
+template<typename T>
+void __mrkinterpolationAppend(mrklang::runtime::String::Builder& result, const T& part) {
+    if constexpr (std::is_array_v<T>) {
+        result.append(part, std::extent_v<T> - 1);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        result.append(part ? "true" : "false", part ? 4 : 5);
+    }
+    else if constexpr (std::is_same_v<T, char>) {
+        result.append(part);
+    }
+    else if constexpr (std::is_arithmetic_v<T>) {
+        char buffer[32];
+        auto end = std::to_chars(buffer, buffer + sizeof(buffer), part).ptr;
+        result.append(buffer, end - buffer);
+    }
+    else {
+        result.append(part.data(), part.size());
+    }
+}
+
+template<typename ...Parts>
+mrklang::runtime::String __mrkinterpolate(size_t literalSize, const Parts&... parts) {
+    mrklang::runtime::String::Builder result((literalSize + ... + __mrkinterpolationCapacity(parts)));
+    (__mrkinterpolationAppend(result, parts), ...);
+    return result.finish();
+}
+
+#define MRK_INTERPOLATE(literalSize, ...) \
+    __mrkinterpolate(literalSize, __VA_ARGS__)
+
+// Interned string literal, the size is measured by the compiler
+#define MRK_STRING_LITERAL(value, size) \
+    __mrkprimitive_string::literal(value, size)
+
+// Array elements, checked only when MRK_BOUNDS_CHECKS is defined
+// Foreach loops never go through here, their loop condition already keeps them in range
+#ifdef MRK_BOUNDS_CHECKS
+#define MRK_ARRAY_ELEMENT(array, index) \
+    (array).at(index)
+#else
+#define MRK_ARRAY_ELEMENT(array, index) \
+    (array)[index]
+#endif
+
+template<typename T>
+using __mrkarray = mrklang::runtime::Array<T>;
 
 using __mrkprimitive_void = void;
 using __mrkprimitive_bool = bool;
@@ -101,7 +207,7 @@ using __mrkprimitive_long = int64_t;
 using __mrkprimitive_ulong = uint64_t;
 using __mrkprimitive_float = float;
 using __mrkprimitive_double = double;
-using __mrkprimitive_string = std::string;
+using __mrkprimitive_string = mrklang::runtime::String;
 using __mrkprimitive_object = void*;
 
 #define __mrk_null nullptr
\ No newline at end of file
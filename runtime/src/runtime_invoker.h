@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Typed entry of a generated method for the runtime, one per signature, instantiated for each registered method
+// Signature is the function type of the generated method, an instance method takes its instance as the first parameter
+// args point to the parameters, ret is uninitialized storage the return value is constructed in, nullptr to drop it
+template<typename Signature>
+struct __mrkinvoker;
+
+template<typename Ret, typename ...Params>
+struct __mrkinvoker<Ret(Params...)> {
+    template<bool HasInstance, Ret(*Method)(Params...)>
+    static void invoke(void* instance, void** args, void* ret) {
+        call<HasInstance, Method>(instance, args, ret, std::index_sequence_for<Params...>{});
+    }
+
+private:
+    template<bool HasInstance, size_t Index, typename Param>
+    static Param argument(void* instance, void** args) {
+        if constexpr (HasInstance && Index == 0) {
+            return static_cast<Param>(instance);
+        }
+        else {
+            return *static_cast<std::remove_cvref_t<Param>*>(args[Index - HasInstance]);
+        }
+    }
+
+    template<bool HasInstance, Ret(*Method)(Params...), size_t ...Indices>
+    static void call(void* instance, void** args, void* ret, std::index_sequence<Indices...>) {
+        if constexpr (std::is_void_v<Ret>) {
+            Method(argument<HasInstance, Indices, Params>(instance, args)...);
+        }
+        else {
+            Ret value = Method(argument<HasInstance, Indices, Params>(instance, args)...);
+            if (ret) {
+                new (ret) Ret(std::move(value));
+            }
+        }
+    }
+};
@@ -0,0 +1,137 @@
+#include "runtime_string.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+MRK_NS_BEGIN_MODULE(runtime)
+
+struct String::SharedBuffer {
+	std::atomic<uint32_t> references;
+
+	/// The characters and their terminator follow the header
+	char* chars() { return reinterpret_cast<char*>(this + 1); }
+
+	static SharedBuffer* allocate(size_t capacity) {
+		auto memory = ::operator new(sizeof(SharedBuffer) + capacity + 1);
+		return new (memory) SharedBuffer{ 1 };
+	}
+
+	void destroy() {
+		this->~SharedBuffer();
+		::operator delete(this);
+	}
+};
+
+String::String(std::string_view str) : data_(small_), size_(str.size()), small_{} {
+	if (size_ <= SMALL_CAPACITY) {
+		str.copy(small_, size_);
+		return;
+	}
+
+	shared_ = SharedBuffer::allocate(size_);
+
+	auto chars = shared_->chars();
+	str.copy(chars, size_);
+	chars[size_] = '\0';
+	data_ = chars;
+}
+
+String::String(String&& other) noexcept : data_(other.data_), size_(other.size_), shared_(nullptr) {
+	if (other.isSmall()) {
+		copySmall(other);
+		return;
+	}
+
+	shared_ = other.shared_;
+
+	// The buffer changed hands, the moved from string is left empty
+	other.data_ = other.small_;
+	other.size_ = 0;
+	other.small_[0] = '\0';
+}
+
+String& String::operator=(const String& other) {
+	return *this = String(other);
+}
+
+String& String::operator=(String&& other) noexcept {
+	if (this != &other) {
+		this->~String();
+		new (this) String(Move(other));
+	}
+
+	return *this;
+}
+
+void String::retain() {
+	shared_->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void String::release() {
+	if (shared_->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		shared_->destroy();
+	}
+}
+
+String operator+(const String& lhs, const String& rhs) {
+	String::Builder builder(lhs.size_ + rhs.size_);
+	builder.append(lhs.data_, lhs.size_);
+	builder.append(rhs.data_, rhs.size_);
+	return builder.finish();
+}
+
+String::Builder::Builder(size_t capacity) : buffer_(nullptr), chars_(small_), size_(0), capacity_(SMALL_CAPACITY) {
+	if (capacity > SMALL_CAPACITY) {
+		grow(capacity);
+	}
+}
+
+String::Builder::~Builder() {
+	if (buffer_) {
+		buffer_->destroy();
+	}
+}
+
+void String::Builder::append(const char* data, size_t size) {
+	// Only reached when the reserved capacity was underestimated
+	if (size_ + size > capacity_) {
+		grow(std::max(size_ + size, capacity_ * 2));
+	}
+
+	std::memcpy(chars_ + size_, data, size);
+	size_ += size;
+}
+
+String String::Builder::finish() {
+	String result;
+
+	if (buffer_) {
+		// Handed over as is, the builder's reference becomes the string's
+		chars_[size_] = '\0';
+		result = String(chars_, size_, std::exchange(buffer_, nullptr));
+	}
+	else {
+		result = String(std::string_view(chars_, size_));
+	}
+
+	chars_ = small_;
+	size_ = 0;
+	capacity_ = SMALL_CAPACITY;
+	return result;
+}
+
+void String::Builder::grow(size_t capacity) {
+	auto buffer = SharedBuffer::allocate(capacity);
+	std::memcpy(buffer->chars(), chars_, size_);
+
+	if (buffer_) {
+		buffer_->destroy();
+	}
+
+	buffer_ = buffer;
+	chars_ = buffer->chars();
+	capacity_ = capacity;
+}
+
+MRK_NS_END
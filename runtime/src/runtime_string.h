@@ -0,0 +1,123 @@
+#pragma once
+
+#include "common/types.h"
+
+#include <atomic>
+#include <compare>
+#include <ostream>
+#include <string_view>
+
+MRK_NS_BEGIN_MODULE(runtime)
+
+/// Immutable string of the generated code
+/// Short strings are stored inline, longer ones share a reference counted buffer and literals
+/// point at static data, so copying a string never allocates
+class String {
+	struct SharedBuffer;
+
+public:
+	/// Longest string stored inline, the terminator takes the last byte
+	static constexpr size_t SMALL_CAPACITY = 15;
+
+	constexpr String() : data_(small_), size_(0), small_{} {}
+	String(std::string_view str);
+	String(const char* str) : String(std::string_view(str)) {}
+	String(const Str& str) : String(std::string_view(str)) {}
+
+	/// Refers to NUL terminated data with static storage duration without copying it
+	static constexpr String literal(const char* data, size_t size) { return String(data, size, nullptr); }
+
+	constexpr String(const String& other) : data_(other.data_), size_(other.size_), shared_(nullptr) {
+		if (other.isSmall()) {
+			copySmall(other);
+		}
+		else if ((shared_ = other.shared_)) {
+			retain();
+		}
+	}
+
+	String(String&& other) noexcept;
+	String& operator=(const String& other);
+	String& operator=(String&& other) noexcept;
+
+	constexpr ~String() {
+		if (isShared()) {
+			release();
+		}
+	}
+
+	/// Always NUL terminated
+	const char* data() const { return data_; }
+	const char* c_str() const { return data_; }
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	operator std::string_view() const { return { data_, size_ }; }
+	Str str() const { return Str(data_, size_); }
+
+	friend String operator+(const String& lhs, const String& rhs);
+
+	friend bool operator==(const String& lhs, const String& rhs) {
+		return std::string_view(lhs) == std::string_view(rhs);
+	}
+
+	friend std::strong_ordering operator<=>(const String& lhs, const String& rhs) {
+		return std::string_view(lhs).compare(std::string_view(rhs)) <=> 0;
+	}
+
+	friend std::ostream& operator<<(std::ostream& stream, const String& str) {
+		return stream.write(str.data_, str.size_);
+	}
+
+	/// Writes a string in place, reserving its storage upfront
+	class Builder {
+	public:
+		explicit Builder(size_t capacity);
+		~Builder();
+
+		Builder(const Builder&) = delete;
+		Builder& operator=(const Builder&) = delete;
+
+		void append(const char* data, size_t size);
+		void append(char c) { append(&c, 1); }
+
+		/// The builder is empty afterwards
+		String finish();
+
+	private:
+		SharedBuffer* buffer_;
+		char* chars_;
+		size_t size_;
+		size_t capacity_;
+		char small_[SMALL_CAPACITY + 1];
+
+		void grow(size_t capacity);
+	};
+
+private:
+	const char* data_;
+	size_t size_;
+
+	union {
+		char small_[SMALL_CAPACITY + 1];
+		SharedBuffer* shared_; // nullptr for literals
+	};
+
+	constexpr String(const char* data, size_t size, SharedBuffer* shared) : data_(data), size_(size), shared_(shared) {}
+
+	constexpr bool isSmall() const { return data_ == small_; }
+	constexpr bool isShared() const { return !isSmall() && shared_; }
+
+	constexpr void copySmall(const String& other) {
+		for (size_t i = 0; i <= other.size_; i++) {
+			small_[i] = other.small_[i];
+		}
+
+		data_ = small_;
+	}
+
+	void retain();
+	void release();
+};
+
+MRK_NS_END
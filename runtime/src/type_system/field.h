@@ -9,40 +9,27 @@ class Type;
 class Field {
 public:
 	Field(const Str& name, Type* fieldType, size_t offset, bool isStatic)
-		: name_(name), fieldType_(fieldType), offset_(offset), isStatic_(isStatic),
-		staticInit_(nullptr), initialized_(false), nativeField_(nullptr) {}
+		: name_(name), fieldType_(fieldType), offset_(offset), isStatic_(isStatic), nativeField_(nullptr) {}
 
 	const Str& getName() const { return name_; }
 	Type* getFieldType() const { return fieldType_; }
 	size_t getOffset() const { return offset_; }
 
 	bool isStatic() const { return isStatic_; }
-	void setStaticInit(void* staticInit) { staticInit_ = staticInit; }
 
 	void setNativeField(void* nativeField) { nativeField_ = nativeField; }
 
-	void* getValue() {
-		if (isStatic_) {
-			if (!initialized_) {
-				initialized_ = true;
+	/// Static fields are initialized once the runtime is, no check needed on access
+	void* getValue() const { return nativeField_; }
 
-				// Call static init
-				if (staticInit_) {
-					((void(*)())staticInit_)();
-				}
-			}
-		}
-
-		return nativeField_;
-	}
+	/// Instance fields live at their offset in the object, laid out by the compiler
+	void* getValue(void* instance) const { return static_cast<uint8_t*>(instance) + offset_; }
 
 private:
 	Str name_;
 	Type* fieldType_;
 	size_t offset_;
 	bool isStatic_;
-	void* staticInit_;
-	bool initialized_;
 
 	void* nativeField_;
 };
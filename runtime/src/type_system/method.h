@@ -2,6 +2,7 @@
 
 #include "common/types.h"
 #include "parameter.h"
+#include "metadata/metadata_structures.h"
 #include <utility>
 #include <span>
 
@@ -11,15 +12,22 @@ class Type;
 
 using MethodPtr = void*;
 
+/// Calls a method with its arguments and result passed by address, see __mrkinvoker
+using MethodInvoker = void(*)(void* instance, void** args, void* ret);
+
 class Method {
 public:
-	Method(const Str& name, Type* returnType, Type* enclosingType, MemberFlags flags = {}, Vec<Parameter> parameters = {})
-		: name_(name), returnType_(returnType), enclosingType_(enclosingType), parameters_(parameters), nativeMethod_(nullptr) {}
+	Method(const Str& name, Type* returnType, Type* enclosingType, MemberFlags flags = {}, Vec<Parameter> parameters = {}, uint32_t implFlags = 0)
+		: name_(name), returnType_(returnType), enclosingType_(enclosingType), flags_(flags), implFlags_(implFlags), parameters_(parameters),
+		nativeMethod_(nullptr), invoker_(nullptr) {}
 
 	const Str& getName() const { return name_; }
 	Type* getReturnType() const { return returnType_; }
 	bool isStatic() const { return flags_.STATIC; }
 
+	/// Implemented by the runtime rather than generated code
+	bool isInternalCall() const { return implFlags_ & metadata::METHOD_IMPL_INTERNAL_CALL; }
+
 	Type* getEnclosingType() const { return enclosingType_; }
 
 	void addParameter(const Str& name, Type* paramType, uint32_t flags = 0) {
@@ -36,13 +44,23 @@ public:
 		nativeMethod_ = nativeMethod;
 	}
 
+	MethodInvoker getInvoker() const {
+		return invoker_;
+	}
+
+	void setInvoker(MethodInvoker invoker) {
+		invoker_ = invoker;
+	}
+
 private:
 	Str name_;
 	Type* returnType_;
 	Type* enclosingType_;
 	MemberFlags flags_;
+	uint32_t implFlags_;
 	Vec<Parameter> parameters_;
 	MethodPtr nativeMethod_;
+	MethodInvoker invoker_;
 };
 
 MRK_NS_END
@@ -11,6 +11,16 @@
 
 MRK_NS_BEGIN_MODULE(runtime::type_system)
 
+/// Grows the table up to the token, entries without a registered object stay null
+template<typename T>
+static void setByToken(Vec<T*>& byToken, uint32_t token, T* value) {
+	if (token >= byToken.size()) {
+		byToken.resize(token + 1, nullptr);
+	}
+
+	byToken[token] = value;
+}
+
 TypeRegistry& TypeRegistry::instance() {
 	static TypeRegistry instance;
 	return instance;
@@ -78,6 +88,9 @@ void TypeRegistry::initializeMetadata(const MetadataRoot* root) {
 
 	// Alloc registration
 	registration_ = MakeUnique<RuntimeMetadataRegistration, false>();
+	registration_->typesByToken.reserve(root->typeDefinitionCount + 1);
+	registration_->fieldsByToken.reserve(root->fieldDefinitionCount + 1);
+	registration_->methodsByToken.reserve(root->methodDefinitionCount + 1);
 
 	MRK_INFO("Initializing metadata types");
 
@@ -133,8 +146,7 @@ Type* TypeRegistry::registerTypeFromMetadata(const TypeDefinition& typeDef) {
 		// Update token for cross-referencing
 		existingType->setToken(typeDef.token);
 
-		registration_->typeTokenMap[existingType] = typeDef.token;
-		registration_->typeTokenReverseMap[typeDef.token] = existingType;
+		setByToken(registration_->typesByToken, typeDef.token, existingType);
 		return existingType;
 	}
 
@@ -169,8 +181,7 @@ Type* TypeRegistry::registerTypeFromMetadata(const TypeDefinition& typeDef) {
 	newType->setToken(typeDef.token);
 	registerType(newType);
 
-	registration_->typeTokenMap[newType] = typeDef.token;
-	registration_->typeTokenReverseMap[typeDef.token] = newType;
+	setByToken(registration_->typesByToken, typeDef.token, newType);
 
 	return newType;
 }
@@ -207,12 +218,11 @@ Field* TypeRegistry::registerFieldFromMetadata(const TypeDefinition& typeDef,
 	}
 
 	// Create and add the field
-	Field* field = new Field(fieldName, fieldType, 0, fieldDef.flags.STATIC);
+	Field* field = new Field(fieldName, fieldType, fieldDef.offset, fieldDef.flags.STATIC);
 	classType->addField(field);
 
 	// Register field
-	registration_->fieldTokenMap[field] = fieldDef.token;
-	registration_->fieldTokenReverseMap[fieldDef.token] = field;
+	setByToken(registration_->fieldsByToken, fieldDef.token, field);
 
 	return field;
 }
@@ -280,12 +290,11 @@ Method* TypeRegistry::registerMethodFromMetadata(const TypeDefinition& typeDef,
 	}
 
 	// Create and add the method
-	Method* method = new Method(methodName, returnType, containingType, methodDef.flags, Move(parameters));
+	Method* method = new Method(methodName, returnType, containingType, methodDef.flags, Move(parameters), methodDef.implFlags);
 	classType->addMethod(method);
 
 	// Register method
-	registration_->methodTokenMap[method] = methodDef.token;
-	registration_->methodTokenReverseMap[methodDef.token] = method;
+	setByToken(registration_->methodsByToken, methodDef.token, method);
 
 	return method;
 }
@@ -430,18 +439,30 @@ void TypeRegistry::dumpType(Type* type, int indent) const {
 }
 
 Type* TypeRegistry::getTypeByToken(uint32_t token) const {
-	auto it = registration_->typeTokenReverseMap.find(token);
-	return it != registration_->typeTokenReverseMap.end() ? it->second : nullptr;
+	if (!registration_) {
+		return nullptr;
+	}
+
+	const auto& types = registration_->typesByToken;
+	return token < types.size() ? types[token] : nullptr;
 }
 
 Field* TypeRegistry::getFieldByToken(uint32_t token) const {
-	auto it = registration_->fieldTokenReverseMap.find(token);
-	return it != registration_->fieldTokenReverseMap.end() ? it->second : nullptr;
+	if (!registration_) {
+		return nullptr;
+	}
+
+	const auto& fields = registration_->fieldsByToken;
+	return token < fields.size() ? fields[token] : nullptr;
 }
 
 Method* TypeRegistry::getMethodByToken(uint32_t token) const {
-	auto it = registration_->methodTokenReverseMap.find(token);
-	return it != registration_->methodTokenReverseMap.end() ? it->second : nullptr;
+	if (!registration_) {
+		return nullptr;
+	}
+
+	const auto& methods = registration_->methodsByToken;
+	return token < methods.size() ? methods[token] : nullptr;
 }
 
 MRK_NS_END
\ No newline at end of file
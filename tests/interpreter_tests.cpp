@@ -0,0 +1,246 @@
+#include "CppUnitTest.h"
+#include "interpreter/interpreter.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MRK_NS;
+using namespace MRK_NS::runtime::interpreter;
+
+namespace InterpreterTests {
+    /// A method of a bytecode image, the header counts are filled in from the sections
+    struct MethodImage {
+        uint32_t token = 0;
+        uint16_t registerCount = 0;
+        ValueKind returnKind = ValueKind::VOID;
+        Vec<ValueKind> parameterKinds;
+        Vec<Instruction> code;
+        Vec<uint64_t> constants;
+        Vec<CallSite> calls;
+        Vec<CallArgument> arguments;
+    };
+
+    template<typename T>
+    void append(Vec<uint8_t>& image, const T* values, size_t count) {
+        auto bytes = reinterpret_cast<const uint8_t*>(values);
+        image.insert(image.end(), bytes, bytes + count * sizeof(T));
+    }
+
+    template<typename T>
+    void append(Vec<uint8_t>& image, const T& value) {
+        append(image, &value, 1);
+    }
+
+    /// See bytecode_structures.h for the format
+    Vec<uint8_t> buildImage(const Vec<MethodImage>& methods) {
+        Vec<uint8_t> image;
+        append(image, BYTECODE_VERSION);
+        append(image, BYTECODE_MAGIC);
+        append(image, static_cast<uint32_t>(methods.size()));
+
+        for (const auto& method : methods) {
+            MethodHeader header{};
+            header.token = method.token;
+            header.registerCount = method.registerCount;
+            header.parameterCount = static_cast<uint16_t>(method.parameterKinds.size());
+            header.returnKind = method.returnKind;
+            header.instructionCount = static_cast<uint32_t>(method.code.size());
+            header.constantCount = static_cast<uint32_t>(method.constants.size());
+            header.callCount = static_cast<uint32_t>(method.calls.size());
+            header.argumentCount = static_cast<uint32_t>(method.arguments.size());
+
+            append(image, header);
+            append(image, method.parameterKinds.data(), method.parameterKinds.size());
+            append(image, method.code.data(), method.code.size());
+            append(image, method.constants.data(), method.constants.size());
+            append(image, method.calls.data(), method.calls.size());
+            append(image, method.arguments.data(), method.arguments.size());
+        }
+
+        append(image, static_cast<uint32_t>(0));
+        return image;
+    }
+
+    Instruction instruction(Opcode opcode, ValueKind kind, uint16_t a = 0, uint16_t b = 0, uint16_t c = 0) {
+        return { opcode, kind, a, b, c };
+    }
+
+    Instruction immediate(Opcode opcode, ValueKind kind, uint16_t a, uint32_t value) {
+        auto result = instruction(opcode, kind, a);
+        result.setImmediate(value);
+        return result;
+    }
+
+    bool load(const Vec<MethodImage>& methods) {
+        auto image = buildImage(methods);
+        return Interpreter::instance().loadFromMemory(image.data(), image.size());
+    }
+
+    /// r2 = r0 op r1, for both parameters and the result of the same kind
+    MethodImage binaryMethod(Opcode opcode, ValueKind kind) {
+        MethodImage method;
+        method.registerCount = 3;
+        method.returnKind = kind;
+        method.parameterKinds = { kind, kind };
+        method.code = {
+            instruction(opcode, kind, 2, 0, 1),
+            instruction(Opcode::RETURN, kind, 2),
+        };
+
+        return method;
+    }
+
+    template<typename Result, typename Argument>
+    bool execute(const Vec<Argument>& arguments, Result& result) {
+        Vec<Argument> values = arguments;
+        Vec<void*> args;
+        for (auto& value : values) {
+            args.push_back(&value);
+        }
+
+        auto method = Interpreter::instance().getMethod(0);
+        return method && Interpreter::instance().execute(*method, nullptr, args, &result);
+    }
+
+    TEST_CLASS(InterpreterTests) {
+public:
+    TEST_METHOD(TestVerifierRejectsOutOfRangeOperands) {
+        auto valid = binaryMethod(Opcode::ADD, ValueKind::I32);
+        Assert::IsTrue(load({ valid }));
+
+        auto registerPastFrame = valid;
+        registerPastFrame.code[0].c = 3;
+        Assert::IsFalse(load({ registerPastFrame }));
+
+        auto missingConstant = valid;
+        missingConstant.code[0] = immediate(Opcode::CONSTANT, ValueKind::I32, 2, 0);
+        Assert::IsFalse(load({ missingConstant }));
+
+        auto jumpPastCode = valid;
+        jumpPastCode.code[0] = immediate(Opcode::JUMP, ValueKind::VOID, 0, 2);
+        Assert::IsFalse(load({ jumpPastCode }));
+
+        auto missingCall = valid;
+        missingCall.code[0] = immediate(Opcode::CALL, ValueKind::VOID, 0, 0);
+        Assert::IsFalse(load({ missingCall }));
+
+        auto argumentPastFrame = valid;
+        argumentPastFrame.calls = { { 0, 0, 1 } };
+        argumentPastFrame.arguments = { { 3, ValueKind::I32, 0 } };
+        Assert::IsFalse(load({ argumentPastFrame }));
+
+        auto runsOffTheEnd = valid;
+        runsOffTheEnd.code.pop_back();
+        Assert::IsFalse(load({ runsOffTheEnd }));
+    }
+
+    TEST_METHOD(TestIntegerArithmeticWrapsToItsKind) {
+        int8_t i8 = 0;
+        Assert::IsTrue(load({ binaryMethod(Opcode::ADD, ValueKind::I8) }));
+        Assert::IsTrue(execute<int8_t, int8_t>({ 127, 1 }, i8));
+        Assert::AreEqual(-128, static_cast<int>(i8));
+
+        int32_t i32 = 0;
+        Assert::IsTrue(load({ binaryMethod(Opcode::MUL, ValueKind::I32) }));
+        Assert::IsTrue(execute<int32_t, int32_t>({ 0x10000, 0x10000 }, i32));
+        Assert::AreEqual(0, i32);
+
+        Assert::IsTrue(load({ binaryMethod(Opcode::SUB, ValueKind::I32) }));
+        Assert::IsTrue(execute<int32_t, int32_t>({ std::numeric_limits<int32_t>::min(), 1 }, i32));
+        Assert::AreEqual(std::numeric_limits<int32_t>::max(), i32);
+    }
+
+    TEST_METHOD(TestRegistersAreSignExtended) {
+        // The wrapped sum is read back as a 64 bit value, only sign extension keeps it negative
+        auto method = binaryMethod(Opcode::ADD, ValueKind::I32);
+        method.returnKind = ValueKind::I64;
+        method.code = {
+            instruction(Opcode::ADD, ValueKind::I32, 2, 0, 1),
+            instruction(Opcode::CONVERT, ValueKind::I64, 2, 2, static_cast<uint16_t>(ValueKind::I32)),
+            instruction(Opcode::RETURN, ValueKind::I64, 2),
+        };
+
+        int64_t result = 0;
+        Assert::IsTrue(load({ method }));
+        Assert::IsTrue(execute<int64_t, int32_t>({ std::numeric_limits<int32_t>::max(), 1 }, result));
+        Assert::AreEqual(static_cast<int64_t>(std::numeric_limits<int32_t>::min()), result);
+
+        // Narrowing keeps the low bits and extends them again
+        method.parameterKinds = { ValueKind::I32, ValueKind::I32 };
+        method.code = {
+            instruction(Opcode::CONVERT, ValueKind::I8, 2, 0, static_cast<uint16_t>(ValueKind::I32)),
+            instruction(Opcode::RETURN, ValueKind::I64, 2),
+        };
+
+        Assert::IsTrue(load({ method }));
+        Assert::IsTrue(execute<int64_t, int32_t>({ 200, 0 }, result));
+        Assert::AreEqual(static_cast<int64_t>(-56), result);
+
+        // Unsigned kinds are zero extended
+        method.code[0].kind = ValueKind::U8;
+        Assert::IsTrue(load({ method }));
+        Assert::IsTrue(execute<int64_t, int32_t>({ -1, 0 }, result));
+        Assert::AreEqual(static_cast<int64_t>(255), result);
+    }
+
+    TEST_METHOD(TestDivisionByMinusOneAndZero) {
+        constexpr auto min = std::numeric_limits<int32_t>::min();
+        int32_t result = 0;
+
+        // The quotient overflows and wraps, the remainder is 0
+        Assert::IsTrue(load({ binaryMethod(Opcode::DIV, ValueKind::I32) }));
+        Assert::IsTrue(execute<int32_t, int32_t>({ min, -1 }, result));
+        Assert::AreEqual(min, result);
+        Assert::IsTrue(execute<int32_t, int32_t>({ 7, -1 }, result));
+        Assert::AreEqual(-7, result);
+        Assert::IsFalse(execute<int32_t, int32_t>({ 7, 0 }, result));
+
+        Assert::IsTrue(load({ binaryMethod(Opcode::REM, ValueKind::I32) }));
+        Assert::IsTrue(execute<int32_t, int32_t>({ min, -1 }, result));
+        Assert::AreEqual(0, result);
+        Assert::IsTrue(execute<int32_t, int32_t>({ -7, 2 }, result));
+        Assert::AreEqual(-1, result);
+        Assert::IsFalse(execute<int32_t, int32_t>({ 7, 0 }, result));
+
+        Assert::IsTrue(load({ binaryMethod(Opcode::DIV_UN, ValueKind::U32) }));
+        Assert::IsFalse(execute<int32_t, int32_t>({ 7, 0 }, result));
+    }
+
+    TEST_METHOD(TestCallChainPastDepthLimitFails) {
+        // countdown(n) = n == 0 ? 0 : countdown(n - 1), each call one frame deeper
+        MethodImage countdown;
+        countdown.registerCount = 4;
+        countdown.returnKind = ValueKind::I32;
+        countdown.parameterKinds = { ValueKind::I32 };
+        countdown.constants = { 0, 1 };
+        countdown.calls = { { 0, 0, 1 } };
+        countdown.arguments = { { 3, ValueKind::I32, 0 } };
+        countdown.code = {
+            immediate(Opcode::CONSTANT, ValueKind::I32, 1, 0),
+            instruction(Opcode::EQ, ValueKind::I32, 3, 0, 1),
+            immediate(Opcode::JUMP_UNLESS, ValueKind::VOID, 3, 4),
+            instruction(Opcode::RETURN, ValueKind::I32, 0),
+            immediate(Opcode::CONSTANT, ValueKind::I32, 2, 1),
+            instruction(Opcode::SUB, ValueKind::I32, 3, 0, 2),
+            immediate(Opcode::CALL, ValueKind::I32, 3, 0),
+            instruction(Opcode::RETURN, ValueKind::I32, 3),
+        };
+
+        Assert::IsTrue(load({ countdown }));
+        Assert::IsTrue(Interpreter::instance().bind());
+
+        int32_t result = -1;
+        Assert::IsTrue(execute<int32_t, int32_t>({ 100 }, result));
+        Assert::AreEqual(0, result);
+
+        // Well within the register stack, only the depth limit stops it
+        Assert::IsFalse(execute<int32_t, int32_t>({ 5000 }, result));
+
+        // The failed chain unwound its frames
+        Assert::IsTrue(execute<int32_t, int32_t>({ 100 }, result));
+        Assert::AreEqual(0, result);
+    }
+    };
+}
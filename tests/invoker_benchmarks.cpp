@@ -0,0 +1,93 @@
+#include "CppUnitTest.h"
+#include "runtime_invoker.h"
+
+#include <chrono>
+#include <cstdint>
+#include <format>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InvokerBenchmarks {
+    struct Counter {
+        int32_t value;
+    };
+
+    int32_t add(int32_t a, int32_t b) {
+        return a + b;
+    }
+
+    int64_t increment(Counter* __instance, int64_t amount) {
+        __instance->value += static_cast<int32_t>(amount);
+        return __instance->value;
+    }
+
+    using AddInvoker = __mrkinvoker<decltype(add)>;
+    using IncrementInvoker = __mrkinvoker<decltype(increment)>;
+
+    constexpr int32_t ITERATIONS = 10'000'000;
+
+    // Both sides call through a pointer the optimizer cannot see through, as the runtime does
+    template<typename Call>
+    double measureNanoseconds(Call call) {
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < ITERATIONS; i++) {
+            call(i);
+        }
+
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / ITERATIONS;
+    }
+
+    TEST_CLASS(InvokerBenchmarks) {
+public:
+    TEST_METHOD(TestInvokeStatic) {
+        int32_t a = 40, b = 2, result = 0;
+        void* args[] = { &a, &b };
+
+        AddInvoker::invoke<false, add>(nullptr, args, &result);
+        Assert::AreEqual(42, result);
+    }
+
+    TEST_METHOD(TestInvokeInstance) {
+        Counter counter{ 1 };
+        int64_t amount = 5, result = 0;
+        void* args[] = { &amount };
+
+        IncrementInvoker::invoke<true, increment>(&counter, args, &result);
+        Assert::AreEqual(6ll, result);
+        Assert::AreEqual(6, counter.value);
+    }
+
+    TEST_METHOD(TestInvokeDropsResult) {
+        Counter counter{ 1 };
+        int64_t amount = 2;
+        void* args[] = { &amount };
+
+        IncrementInvoker::invoke<true, increment>(&counter, args, nullptr);
+        Assert::AreEqual(3, counter.value);
+    }
+
+    TEST_METHOD(BenchmarkInvokeThroughput) {
+        int32_t (* volatile direct)(int32_t, int32_t) = add;
+        void (* volatile invoker)(void*, void**, void*) = &AddInvoker::invoke<false, add>;
+
+        int64_t directSum = 0;
+        auto directTime = measureNanoseconds([&](int32_t i) {
+            directSum += direct(i, 1);
+        });
+
+        int64_t invokedSum = 0;
+        auto invokedTime = measureNanoseconds([&](int32_t i) {
+            int32_t b = 1, result;
+            void* args[] = { &i, &b };
+            invoker(nullptr, args, &result);
+            invokedSum += result;
+        });
+
+        Logger::WriteMessage(std::format("Direct call: {:.2f} ns, invoker: {:.2f} ns ({:.2f}x) over {} calls\n",
+            directTime, invokedTime, invokedTime / directTime, ITERATIONS).c_str());
+
+        Assert::AreEqual(directSum, invokedSum);
+    }
+    };
+}
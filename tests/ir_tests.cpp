@@ -0,0 +1,195 @@
+#include "CppUnitTest.h"
+#include "ir/passes.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MRK_NS;
+using namespace MRK_NS::ir;
+
+namespace IrTests {
+    FunctionSymbol makeFunctionSymbol(const Str& name) {
+        return FunctionSymbol(name, "int", {}, true, nullptr, nullptr);
+    }
+
+    /// Functions are built by hand, the passes only look at their structure and never at types
+    Instruction& emit(Function& function, BlockId block, Opcode opcode, bool hasResult = false) {
+        auto& instruction = function.blocks[block].instructions.emplace_back();
+        instruction.opcode = opcode;
+        if (hasResult) {
+            instruction.result = function.addValue(nullptr);
+        }
+
+        return instruction;
+    }
+
+    ValueId emitConstant(Function& function, BlockId block, int64_t value) {
+        auto& instruction = emit(function, block, Opcode::CONSTANT, true);
+        instruction.constant.kind = TypeKind::I32;
+        instruction.constant.integer = value;
+        return instruction.result;
+    }
+
+    ValueId emitLoad(Function& function, BlockId block, SlotId slot) {
+        auto& instruction = emit(function, block, Opcode::LOAD, true);
+        instruction.slot = slot;
+        return instruction.result;
+    }
+
+    void emitStore(Function& function, BlockId block, SlotId slot, ValueId value) {
+        auto& instruction = emit(function, block, Opcode::STORE);
+        instruction.slot = slot;
+        instruction.operands = { value };
+    }
+
+    ValueId emitLoadField(Function& function, BlockId block, const Symbol* field) {
+        auto& instruction = emit(function, block, Opcode::LOAD_FIELD, true);
+        instruction.symbol = field;
+        return instruction.result;
+    }
+
+    void emitReturn(Function& function, BlockId block, ValueId value) {
+        emit(function, block, Opcode::RETURN).operands = { value };
+    }
+
+    void emitJump(Function& function, BlockId block, BlockId target) {
+        emit(function, block, Opcode::JUMP).target = target;
+    }
+
+    size_t countOpcode(const Function& function, Opcode opcode) {
+        size_t count = 0;
+        for (const auto& block : function.blocks) {
+            for (const auto& instruction : block.instructions) {
+                count += instruction.opcode == opcode;
+            }
+        }
+
+        return count;
+    }
+
+    TEST_CLASS(IrTests) {
+public:
+    TEST_METHOD(TestFieldForwardingStopsAtCall) {
+        auto symbol = makeFunctionSymbol("read");
+        auto callee = makeFunctionSymbol("touch");
+        VariableSymbol field("count", "int", nullptr, nullptr);
+
+        // a = count; touch(); b = count; return a + b
+        Function function(&symbol, nullptr);
+        function.addBlock();
+
+        auto first = emitLoadField(function, 0, &field);
+        emit(function, 0, Opcode::CALL).symbol = &callee;
+        auto second = emitLoadField(function, 0, &field);
+
+        auto& sum = emit(function, 0, Opcode::BINARY, true);
+        sum.op = TokenType::OP_PLUS;
+        sum.operands = { first, second };
+        emitReturn(function, 0, sum.result);
+
+        // The callee may have stored to the field, the second load stays
+        Assert::IsFalse(CopyPropagationPass().run(function));
+        Assert::AreEqual<size_t>(2, countOpcode(function, Opcode::LOAD_FIELD));
+
+        // Without the call in between it is forwarded
+        std::erase_if(function.blocks[0].instructions, [](const Instruction& instruction) { return instruction.opcode == Opcode::CALL; });
+        Assert::IsTrue(CopyPropagationPass().run(function));
+        Assert::AreEqual<size_t>(1, countOpcode(function, Opcode::LOAD_FIELD));
+
+        const auto& operands = function.blocks[0].instructions[1].operands;
+        Assert::IsTrue(operands[0] == first && operands[1] == first);
+    }
+
+    TEST_METHOD(TestStoreReadInAnotherBlockIsKept) {
+        auto symbol = makeFunctionSymbol("f");
+
+        // x = 1; goto next; next: return x
+        Function function(&symbol, nullptr);
+        auto x = function.addSlot(nullptr, nullptr);
+        function.addBlock();
+        function.addBlock();
+
+        emitStore(function, 0, x, emitConstant(function, 0, 1));
+        emitJump(function, 0, 1);
+        emitReturn(function, 1, emitLoad(function, 1, x));
+
+        Assert::IsFalse(DeadStoreEliminationPass().run(function));
+        Assert::AreEqual<size_t>(1, countOpcode(function, Opcode::STORE));
+
+        // A store overwritten before the end of its block is still removed
+        auto jump = Move(function.blocks[0].instructions.back());
+        function.blocks[0].instructions.pop_back();
+        auto two = emitConstant(function, 0, 2);
+        emitStore(function, 0, x, two);
+        function.blocks[0].instructions.push_back(Move(jump));
+
+        Assert::IsTrue(DeadStoreEliminationPass().run(function));
+        Assert::AreEqual<size_t>(1, countOpcode(function, Opcode::STORE));
+
+        const auto& instructions = function.blocks[0].instructions;
+        Assert::IsTrue(instructions[instructions.size() - 2].operands[0] == two);
+    }
+
+    TEST_METHOD(TestInlineCalleeWithMultipleReturns) {
+        auto calleeSymbol = makeFunctionSymbol("clamp");
+        auto callerSymbol = makeFunctionSymbol("main");
+
+        // clamp(p) { if (p == 0) return 0; return p; }
+        Function callee(&calleeSymbol, nullptr);
+        auto parameter = callee.addSlot(nullptr, nullptr, true);
+        callee.addBlock();
+        callee.addBlock();
+        callee.addBlock();
+
+        auto value = emitLoad(callee, 0, parameter);
+        auto zero = emitConstant(callee, 0, 0);
+
+        auto& condition = emit(callee, 0, Opcode::BINARY, true);
+        condition.op = TokenType::OP_EQ;
+        condition.operands = { value, zero };
+        auto isZero = condition.result;
+
+        auto& branch = emit(callee, 0, Opcode::BRANCH);
+        branch.operands = { isZero };
+        branch.target = 1;
+        branch.elseTarget = 2;
+
+        emitReturn(callee, 1, emitConstant(callee, 1, 0));
+        emitReturn(callee, 2, emitLoad(callee, 2, parameter));
+
+        // return clamp(5)
+        Function caller(&callerSymbol, nullptr);
+        caller.addBlock();
+
+        auto argument = emitConstant(caller, 0, 5);
+        auto& call = emit(caller, 0, Opcode::CALL, true);
+        call.symbol = &calleeSymbol;
+        call.operands = { argument };
+        auto result = call.result;
+        emitReturn(caller, 0, result);
+
+        InlinePass pass([&](const FunctionSymbol* function) { return function == &calleeSymbol ? &callee : nullptr; });
+        Assert::IsTrue(pass.run(caller));
+        Assert::IsFalse(caller.hasCalls());
+
+        // The call block, a copy of each callee block and the continuation
+        Assert::AreEqual<size_t>(5, caller.blocks.size());
+        BlockId continuation = 4;
+
+        const auto& copiedBranch = caller.blocks[1].getTerminator();
+        Assert::IsTrue(copiedBranch.opcode == Opcode::BRANCH && copiedBranch.target == 2 && copiedBranch.elseTarget == 3);
+
+        // Both returns store to the same temporary and continue after the call
+        auto resultSlot = static_cast<SlotId>(caller.slots.size() - 1);
+        for (BlockId block : { 2u, 3u }) {
+            const auto& instructions = caller.blocks[block].instructions;
+            const auto& store = instructions[instructions.size() - 2];
+            Assert::IsTrue(store.opcode == Opcode::STORE && store.slot == resultSlot);
+            Assert::IsTrue(instructions.back().opcode == Opcode::JUMP && instructions.back().target == continuation);
+        }
+
+        // The call result keeps its value, loaded back from the temporary
+        const auto& rest = caller.blocks[continuation].instructions;
+        Assert::IsTrue(rest[0].opcode == Opcode::LOAD && rest[0].slot == resultSlot && rest[0].result == result);
+        Assert::IsTrue(rest[1].opcode == Opcode::RETURN && rest[1].operands[0] == result);
+    }
+    };
+}
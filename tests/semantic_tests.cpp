@@ -0,0 +1,120 @@
+#include "CppUnitTest.h"
+#include "core/query_engine.h"
+#include "core/error_reporter.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MRK_NS;
+using namespace MRK_NS::semantic;
+
+namespace SemanticTests {
+    const Symbol* findSymbol(const Vec<const Symbol*>& symbols, const Str& qualifiedName) {
+        for (auto symbol : symbols) {
+            if (symbol->qualifiedName == qualifiedName) {
+                return symbol;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const TypeSymbol* typeOfMember(const Symbol* scope, const Str& name) {
+        auto it = scope->members.find(name);
+        if (it == scope->members.end() || it->second->kind != SymbolKind::VARIABLE) {
+            return nullptr;
+        }
+
+        return static_cast<const VariableSymbol*>(it->second.get())->resolver.type;
+    }
+
+    TEST_CLASS(SemanticTests) {
+public:
+    TEST_METHOD_INITIALIZE(Reset) {
+        ErrorReporter::instance().clearErrors();
+    }
+
+    TEST_METHOD(TestNamespaceReopenedAcrossFiles) {
+        QueryEngine engine;
+        engine.setFile("a.mrk", "namespace mrk::web { class Request {} }");
+        engine.setFile("b.mrk", "namespace mrk::web { class Response {} }");
+
+        Assert::IsNotNull(engine.symbolTable());
+        Assert::IsFalse(engine.hasErrors());
+
+        Assert::IsNotNull(findSymbol(engine.symbolsOf("a.mrk"), "__global::mrk::web::Request"));
+        Assert::IsNotNull(findSymbol(engine.symbolsOf("b.mrk"), "__global::mrk::web::Response"));
+    }
+
+    TEST_METHOD(TestBodyEditIsAppliedInPlace) {
+        QueryEngine engine;
+        engine.setFile("a.mrk", "func f() -> int {\n    return 1;\n}\n\nfunc g() -> int {\n    return f();\n}\n");
+        engine.setFile("b.mrk", "func h() -> int {\n    return 2;\n}\n");
+
+        Assert::IsFalse(engine.hasErrors());
+        auto f = engine.findFunction("__global::__globalType::f");
+        auto g = engine.findFunction("__global::__globalType::g");
+        auto symbolsOfB = engine.symbolsOf("b.mrk");
+
+        // The body gains a line, everything after it moves down
+        engine.setFile("a.mrk", "func f() -> int {\n    var a = 2;\n    return a;\n}\n\nfunc g() -> int {\n    return f();\n}\n");
+
+        Assert::IsFalse(engine.hasErrors());
+        Assert::AreEqual(1u, engine.getStats().analyses);
+        Assert::AreEqual(1u, engine.getStats().incrementalAnalyses);
+
+        Assert::IsTrue(f == engine.findFunction("__global::__globalType::f"));
+        Assert::IsNotNull(typeOfMember(f, "a"));
+        Assert::AreEqual(Str("int"), typeOfMember(f, "a")->name);
+        Assert::AreEqual(6u, g->declNode->startToken.position.line);
+
+        // Symbols of the untouched file are kept as they are
+        Assert::IsTrue(symbolsOfB == engine.symbolsOf("b.mrk"));
+    }
+
+    TEST_METHOD(TestBodyEditReportsErrorsAtTheEdit) {
+        QueryEngine engine;
+        engine.setFile("a.mrk", "func f() -> int {\n    return 1;\n}\n");
+        Assert::IsFalse(engine.hasErrors());
+
+        engine.setFile("a.mrk", "func f() -> int {\n\n    return missing;\n}\n");
+        Assert::IsTrue(engine.hasErrors());
+        Assert::AreEqual(1u, engine.getStats().incrementalAnalyses);
+
+        const auto& errors = ErrorReporter::instance().getErrors();
+        Assert::AreEqual(size_t(1), errors.size());
+        Assert::AreEqual(3u, errors.begin()->second.front()->line);
+
+        // An analysis with errors is rebuilt, so that none of them are left behind
+        engine.setFile("a.mrk", "func f() -> int {\n    return 1;\n}\n");
+        Assert::IsFalse(engine.hasErrors());
+        Assert::AreEqual(2u, engine.getStats().analyses);
+    }
+
+    TEST_METHOD(TestSignatureEditPropagatesInferredTypes) {
+        QueryEngine engine;
+        engine.setFile("a.mrk",
+            "func f() -> int {\n    return 1;\n}\n\n"
+            "var x = f();\n\n"
+            "func g() {\n    var y = x;\n}\n");
+
+        Assert::IsFalse(engine.hasErrors());
+        auto x = findSymbol(engine.symbolsOf("a.mrk"), "__global::__globalType::x");
+        auto g = engine.findFunction("__global::__globalType::g");
+
+        Assert::IsNotNull(x);
+        Assert::AreEqual(Str("int"), static_cast<const VariableSymbol*>(x)->resolver.type->name);
+
+        engine.setFile("a.mrk",
+            "func f() -> string {\n    return \"one\";\n}\n\n"
+            "var x = f();\n\n"
+            "func g() {\n    var y = x;\n}\n");
+
+        Assert::IsFalse(engine.hasErrors());
+        Assert::AreEqual(1u, engine.getStats().analyses);
+        Assert::AreEqual(1u, engine.getStats().incrementalAnalyses);
+
+        // f's dependent x changes type, so x's dependent g is resolved again too
+        Assert::AreEqual(Str("string"), static_cast<const VariableSymbol*>(x)->resolver.type->name);
+        Assert::AreEqual(Str("string"), typeOfMember(g, "y")->name);
+    }
+    };
+}
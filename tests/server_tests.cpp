@@ -0,0 +1,170 @@
+#include "CppUnitTest.h"
+#include "server/compiler_server.h"
+#include "core/error_reporter.h"
+
+#include <filesystem>
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace MRK_NS;
+using namespace MRK_NS::server;
+
+namespace ServerTests {
+    /// Send a raw message and parse the response
+    JsonValue send(CompilerServer& server, const Str& message) {
+        auto response = server.handleMessage(message);
+        Assert::IsFalse(response.empty());
+        return JsonValue::parse(response);
+    }
+
+    int getErrorCode(const JsonValue& response) {
+        auto error = response.get("error");
+        Assert::IsNotNull(error);
+        return static_cast<int>(error->get("code")->asNumber());
+    }
+
+    JsonValue getResult(const JsonValue& response) {
+        Assert::IsNull(response.get("error"));
+        auto result = response.get("result");
+        Assert::IsNotNull(result);
+        return *result;
+    }
+
+    TEST_CLASS(ServerTests) {
+public:
+    std::stringstream input;
+    std::stringstream output;
+
+    TEST_METHOD_INITIALIZE(Reset) {
+        ErrorReporter::instance().clearErrors();
+    }
+
+    TEST_METHOD(TestMalformedMessageIsParseError) {
+        CompilerServer server(input, output);
+
+        auto response = send(server, R"({"jsonrpc": "2.0", "id": 1, "method": )");
+        Assert::AreEqual(-32700, getErrorCode(response));
+        Assert::IsTrue(response.get("id")->isNull());
+    }
+
+    TEST_METHOD(TestUnknownMethod) {
+        CompilerServer server(input, output);
+
+        auto response = send(server, R"({"jsonrpc": "2.0", "id": 7, "method": "format"})");
+        Assert::AreEqual(-32601, getErrorCode(response));
+        Assert::AreEqual(7.0, response.get("id")->asNumber());
+    }
+
+    TEST_METHOD(TestNotificationGetsNoResponse) {
+        CompilerServer server(input, output);
+
+        auto message = R"({"jsonrpc": "2.0", "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() {}"}})";
+        Assert::IsTrue(server.handleMessage(message).empty());
+
+        // Failing notifications stay silent as well
+        Assert::IsTrue(server.handleMessage(R"({"jsonrpc": "2.0", "method": "format"})").empty());
+
+        // The notification was still handled, sending the same contents again changes nothing
+        auto result = getResult(send(server,
+            R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() {}"}})"));
+        Assert::IsFalse(result.get("changed")->asBoolean());
+    }
+
+    TEST_METHOD(TestCheckReportsDiagnostics) {
+        CompilerServer server(input, output);
+
+        auto setFile = getResult(send(server,
+            R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() -> int {\n    return missing;\n}\n"}})"));
+        Assert::IsTrue(setFile.get("changed")->asBoolean());
+
+        auto check = getResult(send(server, R"({"jsonrpc": "2.0", "id": 2, "method": "check"})"));
+        Assert::IsFalse(check.get("success")->asBoolean());
+
+        const auto& diagnostics = check.get("diagnostics")->asArray();
+        Assert::AreEqual(size_t(1), diagnostics.size());
+        Assert::AreEqual(Str("a.mrk"), diagnostics[0].get("file")->asString());
+        Assert::AreEqual(2.0, diagnostics[0].get("line")->asNumber());
+
+        // Fixing the file clears them
+        send(server, R"({"jsonrpc": "2.0", "id": 3, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() -> int {\n    return 1;\n}\n"}})");
+
+        auto fixed = getResult(send(server, R"({"jsonrpc": "2.0", "id": 4, "method": "check"})"));
+        Assert::IsTrue(fixed.get("success")->asBoolean());
+        Assert::IsTrue(fixed.get("diagnostics")->asArray().empty());
+    }
+
+    TEST_METHOD(TestCheckReportsSyntaxErrors) {
+        CompilerServer server(input, output);
+
+        send(server, R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() {\n    var<int> x;\n"}})");
+
+        // The parser recovers, the server keeps running and reports the missing brace
+        auto check = getResult(send(server, R"({"jsonrpc": "2.0", "id": 2, "method": "check"})"));
+        Assert::IsFalse(check.get("success")->asBoolean());
+
+        const auto& diagnostics = check.get("diagnostics")->asArray();
+        Assert::IsFalse(diagnostics.empty());
+        Assert::AreEqual(Str("a.mrk"), diagnostics[0].get("file")->asString());
+    }
+
+    TEST_METHOD(TestEmitSingleFunction) {
+        CompilerServer server(input, output);
+
+        send(server, R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() -> int {\n    return 42;\n}\n"}})");
+
+        auto result = getResult(send(server,
+            R"({"jsonrpc": "2.0", "id": 2, "method": "emit", "params": {"function": "__global::__globalType::f"}})"));
+        Assert::IsTrue(result.get("success")->asBoolean());
+        Assert::IsNull(result.get("files"));
+
+        const auto& code = result.get("code")->asString();
+        Assert::IsTrue(code.find("42") != Str::npos);
+
+        auto unknown = send(server, R"({"jsonrpc": "2.0", "id": 3, "method": "emit", "params": {"function": "__global::__globalType::g"}})");
+        Assert::AreEqual(-32602, getErrorCode(unknown));
+    }
+
+    TEST_METHOD(TestCompileWritesBytecode) {
+        CompilerServer server(input, output);
+
+        send(server, R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "func f() -> int {\n    return 42;\n}\n"}})");
+
+        auto directory = std::filesystem::temp_directory_path() / "mrk_server_tests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        // Built through JsonValue, the path may contain backslashes
+        JsonValue params(JsonValue::Object{});
+        params.set("outputDirectory", directory.string());
+
+        JsonValue request(JsonValue::Object{});
+        request.set("jsonrpc", "2.0");
+        request.set("id", 2);
+        request.set("method", "compile");
+        request.set("params", Move(params));
+
+        auto result = getResult(send(server, request.toString()));
+        Assert::IsTrue(result.get("success")->asBoolean());
+
+        // The runtime loads the bytecode next to the metadata, both come from the same build
+        Assert::IsTrue(std::filesystem::exists(directory / "runtime_metadata.mrkmeta"));
+        Assert::IsTrue(std::filesystem::file_size(directory / "runtime_bytecode.mrkbc") > 0);
+
+        std::filesystem::remove_all(directory);
+    }
+
+    TEST_METHOD(TestEmitFunctionCallingInstanceMethod) {
+        CompilerServer server(input, output);
+
+        send(server, R"({"jsonrpc": "2.0", "id": 1, "method": "setFile", "params": {"path": "a.mrk", "contents": "class Counter {\n    func get() -> int {\n        return 1;\n    }\n\n    func twice() -> int {\n        return get() + get();\n    }\n}\n"}})");
+
+        // Instance calls need the class hierarchy, which emitting a single function builds as well
+        auto result = getResult(send(server,
+            R"({"jsonrpc": "2.0", "id": 2, "method": "emit", "params": {"function": "__global::Counter::twice"}})"));
+        Assert::IsTrue(result.get("success")->asBoolean());
+
+        const auto& code = result.get("code")->asString();
+        Assert::IsTrue(code.find("__instance") != Str::npos);
+    }
+    };
+}